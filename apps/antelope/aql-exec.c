@@ -51,6 +51,88 @@
 
 static aql_adt_t adt;
 
+#if DB_FEATURE_JOIN
+static unsigned long
+log2_cost(tuple_id_t cardinality)
+{
+  unsigned long cost;
+
+  for(cost = 1; cardinality > 1; cardinality >>= 1) {
+    cost++;
+  }
+  return cost;
+}
+
+/*
+ * Choose a join method by estimating the number of row reads that each
+ * applicable method requires, based on the relation cardinalities and
+ * the indexes available for the join attribute.
+ */
+static db_join_method_t
+plan_join(db_handle_t *handle, aql_adt_t *adt)
+{
+  attribute_t *left_attr;
+  attribute_t *right_attr;
+  index_t *left_index;
+  index_t *right_index;
+  tuple_id_t left_card;
+  tuple_id_t right_card;
+  unsigned long cost;
+  unsigned long best_cost;
+  db_join_method_t method;
+
+  left_attr = relation_attribute_get(handle->left_rel, adt->attributes[0].name);
+  right_attr = relation_attribute_get(handle->right_rel, adt->attributes[0].name);
+  left_card = relation_cardinality(handle->left_rel);
+  right_card = relation_cardinality(handle->right_rel);
+  if(left_attr == NULL || right_attr == NULL ||
+     left_card == INVALID_TUPLE || right_card == INVALID_TUPLE) {
+    /* Let relation_join() report the error. */
+    return DB_JOIN_NESTED_LOOP;
+  }
+
+  method = DB_JOIN_NESTED_LOOP;
+  best_cost = left_card + (unsigned long)left_card * right_card;
+
+  right_index = index_exists(right_attr) ? right_attr->index : NULL;
+  if(right_index != NULL) {
+    if(right_index->type == INDEX_INLINE) {
+      cost = left_card + left_card * log2_cost(right_card);
+    } else {
+      cost = left_card + left_card * (unsigned long)DB_JOIN_INDEX_PROBE_COST;
+    }
+    if(cost < best_cost) {
+      method = DB_JOIN_INDEX;
+      best_cost = cost;
+    }
+  }
+
+  cost = (unsigned long)left_card + right_card;
+  if(MIN(left_card, right_card) <= relation_join_hash_capacity() &&
+     cost < best_cost) {
+    method = DB_JOIN_HASH;
+    best_cost = cost;
+  }
+
+  left_index = index_exists(left_attr) ? left_attr->index : NULL;
+  if(left_index != NULL && left_index->type == INDEX_INLINE &&
+     right_index != NULL && right_index->type == INDEX_INLINE &&
+     cost <= best_cost) {
+    /* Both relations are sorted on the join attribute, so they can be
+       merged without using any additional RAM. */
+    method = DB_JOIN_MERGE;
+    best_cost = cost;
+  }
+
+  PRINTF("DB: Join plan for %s (%lu) and %s (%lu): method %d, cost %lu\n",
+         handle->left_rel->name, (unsigned long)left_card,
+         handle->right_rel->name, (unsigned long)right_card,
+         (int)method, best_cost);
+
+  return method;
+}
+#endif /* DB_FEATURE_JOIN */
+
 static void
 clear_handle(db_handle_t *handle)
 {
@@ -171,6 +253,7 @@ aql_execute(db_handle_t *handle, aql_adt_t *adt)
       relation_release(handle->left_rel);
       break;
     }
+    handle->join_method = plan_join(handle, adt);
     result = relation_join(handle, adt);
     break;
 #endif /* DB_FEATURE_JOIN */
@@ -208,6 +208,29 @@
 
 /*----------------------------------------------------------------------------*/
 
+/* Join options. */
+
+/* The amount of RAM (in bytes) that may be used for the in-memory hash
+   table of a hash join. The join planner chooses a hash join only if
+   the smaller relation fits within this budget. Set to 0 to disable
+   hash joins. */
+#ifndef DB_JOIN_HASH_BUDGET
+#define DB_JOIN_HASH_BUDGET		512
+#endif /* DB_JOIN_HASH_BUDGET */
+
+/* The number of buckets in the hash join table. */
+#ifndef DB_JOIN_HASH_BUCKETS
+#define DB_JOIN_HASH_BUCKETS		31
+#endif /* DB_JOIN_HASH_BUCKETS */
+
+/* The estimated number of row reads needed for an index lookup
+   in a non-inline index. Used by the join planner. */
+#ifndef DB_JOIN_INDEX_PROBE_COST
+#define DB_JOIN_INDEX_PROBE_COST	2
+#endif /* DB_JOIN_INDEX_PROBE_COST */
+
+/*----------------------------------------------------------------------------*/
+
 /* LVM options. */
 
 /* The maximum length of a variable in LVM. This value should preferably
@@ -227,5 +250,16 @@
 #define LVM_USE_FLOATS			DB_FEATURE_FLOATS
 #endif /* LVM_USE_FLOATS */
 
+/* Compile the LVM code of a query into a predicate tree with folded
+   constants before processing the tuples. */
+#ifndef LVM_USE_COMPILATION
+#define LVM_USE_COMPILATION		1
+#endif /* LVM_USE_COMPILATION */
+
+/* The maximum number of nodes in a compiled predicate tree. */
+#ifndef LVM_MAX_NODES
+#define LVM_MAX_NODES			16
+#endif /* LVM_MAX_NODES */
+
 
 #endif /* !DB_OPTIONS_H */
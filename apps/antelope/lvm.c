@@ -51,24 +51,17 @@
  * operations that are arranged in prefix (Polish) notation.
  */
 
-/* Default option values. */
-#ifndef LVM_MAX_NAME_LENGTH
-#define LVM_MAX_NAME_LENGTH		16
-#endif
-
-#ifndef LVM_MAX_VARIABLE_ID
-#define LVM_MAX_VARIABLE_ID		8
-#endif
-
-#ifndef LVM_USE_FLOATS
-#define LVM_USE_FLOATS			0
-#endif
+/* The option values are defined in db-options.h. */
 
 #define IS_CONNECTIVE(op) ((op) & LVM_CONNECTIVE)
 
 struct variable {
   operand_type_t type;
   operand_value_t value;
+#if LVM_USE_COMPILATION
+  unsigned char *bound_ptr;
+  uint8_t bound_size;
+#endif /* LVM_USE_COMPILATION */
   char name[LVM_MAX_NAME_LENGTH + 1];
 };
 typedef struct variable variable_t;
@@ -87,6 +80,44 @@ static variable_t variables[LVM_MAX_VARIABLE_ID - 1];
 /* Range derivations of variables that are used for index searches. */
 static derivation_t derivations[LVM_MAX_VARIABLE_ID - 1];
 
+#if LVM_USE_COMPILATION
+/*
+ * A compiled predicate is a tree of nodes, in which constant
+ * subexpressions have been folded and the operands of logical
+ * connectives have been ordered so that the operand that is cheapest
+ * to evaluate and most likely to decide the result comes first.
+ * The tree is evaluated with short-circuiting, and variables may be
+ * bound directly to the physical representation of the attribute
+ * values in a row, so that they need not be set for each tuple.
+ */
+enum node_kind {
+  NODE_CONSTANT,
+  NODE_VARIABLE,
+  NODE_ARITH,
+  NODE_CMP,
+  NODE_AND,
+  NODE_OR,
+  NODE_NOT
+};
+
+struct node {
+  long value;
+  uint8_t kind;
+  uint8_t op;
+  uint8_t left;
+  uint8_t right;
+};
+typedef struct node node_t;
+
+#define NODE_NONE	0xff
+
+static node_t nodes[LVM_MAX_NODES];
+static uint8_t node_count;
+static uint8_t root_node;
+static lvm_instance_t *compiled_instance;
+static uint8_t eval_error;
+#endif /* LVM_USE_COMPILATION */
+
 #if DEBUG
 static void
 print_derivations(derivation_t *d)
@@ -309,6 +340,9 @@ lvm_reset(lvm_instance_t *p, unsigned char *code, lvm_ip_t size)
 
   memset(variables, 0, sizeof(variables));
   memset(derivations, 0, sizeof(derivations));
+#if LVM_USE_COMPILATION
+  compiled_instance = NULL;
+#endif /* LVM_USE_COMPILATION */
 }
 
 lvm_ip_t
@@ -376,6 +410,115 @@ lvm_set_type(lvm_instance_t *p, node_type_t type)
   p->end += sizeof(type);
 }
 
+#if LVM_USE_COMPILATION
+static long
+eval_node_expr(node_t *node)
+{
+  variable_t *var;
+  unsigned char *ptr;
+  long l1, l2;
+
+  switch(node->kind) {
+  case NODE_CONSTANT:
+    return node->value;
+  case NODE_VARIABLE:
+    var = &variables[node->value];
+    ptr = var->bound_ptr;
+    if(ptr == NULL) {
+      return var->value.l;
+    } else if(var->bound_size == 2) {
+      return ptr[0] << 8 | ptr[1];
+    }
+    return (uint32_t)ptr[0] << 24 | (uint32_t)ptr[1] << 16 |
+           (uint32_t)ptr[2] << 8 | ptr[3];
+  case NODE_ARITH:
+    l1 = eval_node_expr(&nodes[node->left]);
+    l2 = eval_node_expr(&nodes[node->right]);
+    switch(node->op) {
+    case LVM_ADD & 0xff:
+      return l1 + l2;
+    case LVM_SUB & 0xff:
+      return l1 - l2;
+    case LVM_MUL & 0xff:
+      return l1 * l2;
+    case LVM_DIV & 0xff:
+      if(l2 != 0) {
+        return l1 / l2;
+      }
+      break;
+    default:
+      break;
+    }
+    break;
+  default:
+    break;
+  }
+
+  eval_error = MATH_ERROR;
+  return 0;
+}
+
+static lvm_status_t
+eval_node(node_t *node)
+{
+  lvm_status_t r;
+  long l1, l2;
+
+  switch(node->kind) {
+  case NODE_CONSTANT:
+    return node->value ? TRUE : FALSE;
+  case NODE_AND:
+    r = eval_node(&nodes[node->left]);
+    if(r != TRUE) {
+      return r;
+    }
+    return eval_node(&nodes[node->right]);
+  case NODE_OR:
+    r = eval_node(&nodes[node->left]);
+    if(r != FALSE) {
+      return r;
+    }
+    return eval_node(&nodes[node->right]);
+  case NODE_NOT:
+    r = eval_node(&nodes[node->left]);
+    if(LVM_ERROR(r)) {
+      return r;
+    }
+    return r == TRUE ? FALSE : TRUE;
+  case NODE_CMP:
+    break;
+  default:
+    return EXECUTION_ERROR;
+  }
+
+  eval_error = 0;
+  l1 = eval_node_expr(&nodes[node->left]);
+  l2 = eval_node_expr(&nodes[node->right]);
+  if(eval_error) {
+    return eval_error;
+  }
+
+  switch(node->op) {
+  case LVM_EQ & 0xff:
+    return l1 == l2;
+  case LVM_NEQ & 0xff:
+    return l1 != l2;
+  case LVM_GE & 0xff:
+    return l1 > l2;
+  case LVM_GEQ & 0xff:
+    return l1 >= l2;
+  case LVM_LE & 0xff:
+    return l1 < l2;
+  case LVM_LEQ & 0xff:
+    return l1 <= l2;
+  default:
+    break;
+  }
+
+  return EXECUTION_ERROR;
+}
+#endif /* LVM_USE_COMPILATION */
+
 lvm_status_t
 lvm_execute(lvm_instance_t *p)
 {
@@ -383,6 +526,12 @@ lvm_execute(lvm_instance_t *p)
   operator_t *operator;
   lvm_status_t status;
 
+#if LVM_USE_COMPILATION
+  if(p == compiled_instance) {
+    return eval_node(&nodes[root_node]);
+  }
+#endif /* LVM_USE_COMPILATION */
+
   p->ip = 0;
   status = EXECUTION_ERROR;
   type = get_type(p);
@@ -472,6 +621,28 @@ lvm_set_variable_value(char *name, operand_value_t value)
   return TRUE;
 }
 
+lvm_status_t
+lvm_bind_variable(char *name, unsigned char *ptr, unsigned size)
+{
+#if LVM_USE_COMPILATION
+  variable_id_t id;
+
+  if(size != 2 && size != 4) {
+    return TYPE_ERROR;
+  }
+
+  id = lookup(name);
+  if(id == LVM_MAX_VARIABLE_ID) {
+    return INVALID_IDENTIFIER;
+  }
+  variables[id].bound_ptr = ptr;
+  variables[id].bound_size = size;
+  return TRUE;
+#else
+  return INVALID_IDENTIFIER;
+#endif /* LVM_USE_COMPILATION */
+}
+
 void
 lvm_set_variable(lvm_instance_t *p, char *name)
 {
@@ -683,9 +854,387 @@ derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
   return TRUE;
 }
 
+#if LVM_USE_COMPILATION
+static int
+new_node(uint8_t kind, uint8_t op, long value, int left, int right)
+{
+  node_t *node;
+
+  if(left < 0 || right < 0 || node_count >= LVM_MAX_NODES) {
+    return -1;
+  }
+
+  node = &nodes[node_count];
+  node->kind = kind;
+  node->op = op;
+  node->value = value;
+  node->left = left;
+  node->right = right;
+  return node_count++;
+}
+
+static int
+new_constant(long value, int first_freed)
+{
+  /* The nodes of a folded subexpression are always the most
+     recently allocated ones, so they can be reclaimed. */
+  node_count = first_freed;
+  return new_node(NODE_CONSTANT, 0, value, NODE_NONE, NODE_NONE);
+}
+
+static int
+compile_expr(lvm_instance_t *p)
+{
+  operand_t operand;
+  operator_t operator;
+  int left, right;
+  long l1, l2;
+
+  switch(get_type(p)) {
+  case LVM_OPERAND:
+    get_operand(p, &operand);
+#if LVM_USE_FLOATS
+    /* Nodes hold long values: leave float operands to the
+       interpreter rather than truncating them. */
+    if(operand.type == LVM_FLOAT ||
+       (operand.type == LVM_VARIABLE &&
+        operand.value.id < LVM_MAX_VARIABLE_ID &&
+        variables[operand.value.id].type == LVM_FLOAT)) {
+      return -1;
+    }
+#endif /* LVM_USE_FLOATS */
+    if(operand.type == LVM_VARIABLE) {
+      if(operand.value.id >= LVM_MAX_VARIABLE_ID) {
+        return -1;
+      }
+      return new_node(NODE_VARIABLE, 0, operand.value.id, NODE_NONE, NODE_NONE);
+    }
+    return new_node(NODE_CONSTANT, 0, operand_to_long(&operand),
+                    NODE_NONE, NODE_NONE);
+  case LVM_ARITH_OP:
+    operator = *get_operator(p);
+    left = compile_expr(p);
+    right = compile_expr(p);
+    if(left < 0 || right < 0) {
+      return -1;
+    }
+    if(nodes[left].kind == NODE_CONSTANT && nodes[right].kind == NODE_CONSTANT) {
+      l1 = nodes[left].value;
+      l2 = nodes[right].value;
+      switch(operator) {
+      case LVM_ADD:
+        return new_constant(l1 + l2, left);
+      case LVM_SUB:
+        return new_constant(l1 - l2, left);
+      case LVM_MUL:
+        return new_constant(l1 * l2, left);
+      case LVM_DIV:
+        if(l2 != 0) {
+          return new_constant(l1 / l2, left);
+        }
+        /* Leave the division by zero to be reported at execution. */
+        break;
+      default:
+        return -1;
+      }
+    }
+    return new_node(NODE_ARITH, operator & 0xff, 0, left, right);
+  default:
+    return -1;
+  }
+}
+
+/* Estimate the percentage of tuples for which a condition is true. */
+static unsigned
+selectivity(node_t *node)
+{
+  unsigned s1, s2;
+
+  switch(node->kind) {
+  case NODE_CONSTANT:
+    return node->value ? 100 : 0;
+  case NODE_AND:
+  case NODE_OR:
+    s1 = selectivity(&nodes[node->left]);
+    s2 = selectivity(&nodes[node->right]);
+    if(node->kind == NODE_AND) {
+      return s1 * s2 / 100;
+    }
+    return s1 + s2 - s1 * s2 / 100;
+  case NODE_NOT:
+    return 100 - selectivity(&nodes[node->left]);
+  case NODE_CMP:
+    switch(node->op) {
+    case LVM_EQ & 0xff:
+      return 10;
+    case LVM_NEQ & 0xff:
+      return 90;
+    default:
+      return 33;
+    }
+  default:
+    return 50;
+  }
+}
+
+/* Estimate the evaluation cost of a subtree by its number of nodes. */
+static unsigned
+cost(node_t *node)
+{
+  unsigned c;
+
+  c = 1;
+  if(node->left != NODE_NONE) {
+    c += cost(&nodes[node->left]);
+  }
+  if(node->right != NODE_NONE) {
+    c += cost(&nodes[node->right]);
+  }
+  return c;
+}
+
+static void
+order_operands(node_t *node)
+{
+  unsigned c1, c2;
+  unsigned s1, s2;
+  uint8_t tmp;
+
+  c1 = cost(&nodes[node->left]);
+  c2 = cost(&nodes[node->right]);
+  s1 = selectivity(&nodes[node->left]);
+  s2 = selectivity(&nodes[node->right]);
+
+  if(node->kind == NODE_AND) {
+    /* Evaluate first the operand that is most likely to be false. */
+    s1 = 100 - s1;
+    s2 = 100 - s2;
+  }
+
+  /* Swap the operands if the right one decides the result
+     more cheaply. */
+  if(c2 * s1 < c1 * s2) {
+    tmp = node->left;
+    node->left = node->right;
+    node->right = tmp;
+  }
+}
+
+static int
+compile_condition(lvm_instance_t *p)
+{
+  operator_t operator;
+  int left, right;
+  long l1, l2;
+  long result;
+  uint8_t kind;
+
+  if(get_type(p) != LVM_CMP_OP) {
+    return -1;
+  }
+  operator = *get_operator(p);
+
+  if(operator == LVM_NOT) {
+    left = compile_condition(p);
+    if(left < 0) {
+      return -1;
+    }
+    if(nodes[left].kind == NODE_CONSTANT) {
+      return new_constant(!nodes[left].value, left);
+    }
+    return new_node(NODE_NOT, 0, 0, left, NODE_NONE);
+  } else if(IS_CONNECTIVE(operator)) {
+    left = compile_condition(p);
+    right = compile_condition(p);
+    if(left < 0 || right < 0) {
+      return -1;
+    }
+    kind = operator == LVM_AND ? NODE_AND : NODE_OR;
+    if(nodes[left].kind == NODE_CONSTANT || nodes[right].kind == NODE_CONSTANT) {
+      /* x /\ false = false and x \/ true = true, whereas
+         x /\ true = x and x \/ false = x. */
+      if(nodes[left].kind == NODE_CONSTANT &&
+         (nodes[left].value != 0) == (kind == NODE_OR)) {
+        return new_constant(kind == NODE_OR, left);
+      }
+      if(nodes[right].kind == NODE_CONSTANT) {
+        if((nodes[right].value != 0) == (kind == NODE_OR)) {
+          return new_constant(kind == NODE_OR, left);
+        }
+        node_count = right;
+        return left;
+      }
+      return right;
+    }
+    right = new_node(kind, 0, 0, left, right);
+    if(right >= 0) {
+      order_operands(&nodes[right]);
+    }
+    return right;
+  }
+
+  left = compile_expr(p);
+  right = compile_expr(p);
+  if(left < 0 || right < 0) {
+    return -1;
+  }
+  if(nodes[left].kind == NODE_CONSTANT && nodes[right].kind == NODE_CONSTANT) {
+    l1 = nodes[left].value;
+    l2 = nodes[right].value;
+    switch(operator) {
+    case LVM_EQ:
+      result = l1 == l2;
+      break;
+    case LVM_NEQ:
+      result = l1 != l2;
+      break;
+    case LVM_GE:
+      result = l1 > l2;
+      break;
+    case LVM_GEQ:
+      result = l1 >= l2;
+      break;
+    case LVM_LE:
+      result = l1 < l2;
+      break;
+    case LVM_LEQ:
+      result = l1 <= l2;
+      break;
+    default:
+      return -1;
+    }
+    return new_constant(result, left);
+  }
+  return new_node(NODE_CMP, operator & 0xff, 0, left, right);
+}
+
+static lvm_status_t
+derive_node(node_t *node, derivation_t *local_derivations)
+{
+  derivation_t d1[LVM_MAX_VARIABLE_ID];
+  derivation_t d2[LVM_MAX_VARIABLE_ID];
+  derivation_t *derivation;
+  node_t *variable;
+  node_t *constant;
+  uint8_t op;
+
+  switch(node->kind) {
+  case NODE_AND:
+  case NODE_OR:
+    memset(d1, 0, sizeof(d1));
+    memset(d2, 0, sizeof(d2));
+
+    if(LVM_ERROR(derive_node(&nodes[node->left], d1)) ||
+       LVM_ERROR(derive_node(&nodes[node->right], d2))) {
+      return DERIVATION_ERROR;
+    }
+
+    if(node->kind == NODE_AND) {
+      create_intersection(local_derivations, d1, d2);
+    } else {
+      create_union(local_derivations, d1, d2);
+    }
+    return TRUE;
+  case NODE_CMP:
+    break;
+  default:
+    return DERIVATION_ERROR;
+  }
+
+  op = node->op;
+  variable = &nodes[node->left];
+  constant = &nodes[node->right];
+  if(variable->kind != NODE_VARIABLE) {
+    /* The variable is on the right side, so the
+       comparison must be mirrored. */
+    variable = &nodes[node->right];
+    constant = &nodes[node->left];
+    switch(op) {
+    case LVM_GE & 0xff:
+      op = LVM_LE & 0xff;
+      break;
+    case LVM_GEQ & 0xff:
+      op = LVM_LEQ & 0xff;
+      break;
+    case LVM_LE & 0xff:
+      op = LVM_GE & 0xff;
+      break;
+    case LVM_LEQ & 0xff:
+      op = LVM_GEQ & 0xff;
+      break;
+    default:
+      break;
+    }
+  }
+
+  if(variable->kind != NODE_VARIABLE || constant->kind != NODE_CONSTANT) {
+    return DERIVATION_ERROR;
+  }
+
+  derivation = local_derivations + variable->value;
+  derivation->max.l = LONG_MAX;
+  derivation->min.l = LONG_MIN;
+
+  switch(op) {
+  case LVM_EQ & 0xff:
+    derivation->max.l = derivation->min.l = constant->value;
+    break;
+  case LVM_GE & 0xff:
+    derivation->min.l = constant->value + 1;
+    break;
+  case LVM_GEQ & 0xff:
+    derivation->min.l = constant->value;
+    break;
+  case LVM_LE & 0xff:
+    derivation->max.l = constant->value - 1;
+    break;
+  case LVM_LEQ & 0xff:
+    derivation->max.l = constant->value;
+    break;
+  default:
+    return DERIVATION_ERROR;
+  }
+
+  derivation->derived = 1;
+
+  return TRUE;
+}
+#endif /* LVM_USE_COMPILATION */
+
+lvm_status_t
+lvm_compile(lvm_instance_t *p)
+{
+#if LVM_USE_COMPILATION
+  int root;
+
+  compiled_instance = NULL;
+  node_count = 0;
+  p->ip = 0;
+
+  root = compile_condition(p);
+  if(root < 0) {
+    PRINTF("Unable to compile the LVM code\n");
+    return EXECUTION_ERROR;
+  }
+
+  root_node = root;
+  compiled_instance = p;
+  PRINTF("Compiled the LVM code into %u nodes\n", (unsigned)node_count);
+  return TRUE;
+#else
+  return EXECUTION_ERROR;
+#endif /* LVM_USE_COMPILATION */
+}
+
 lvm_status_t
 lvm_derive(lvm_instance_t *p)
 {
+#if LVM_USE_COMPILATION
+  if(p == compiled_instance) {
+    return derive_node(&nodes[root_node], derivations);
+  }
+#endif /* LVM_USE_COMPILATION */
+  p->ip = 0;
   return derive_relation(p, derivations);
 }
 
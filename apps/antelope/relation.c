@@ -677,6 +677,7 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
   relation_t *result_rel;
   unsigned attribute_count;
   attribute_t *attr;
+  struct source_dest_map *attr_map_ptr;
 
   result_rel = handle->result_rel;
 
@@ -697,6 +698,22 @@ generate_selection_result(db_handle_t *handle, relation_t *rel, aql_adt_t *adt)
   }
 
   if(adt->lvm_instance != NULL) {
+    /* Compile the predicate, and bind its variables directly to the
+       attribute values in the row buffer. */
+    if(!LVM_ERROR(lvm_compile(adt->lvm_instance))) {
+      handle->flags |= DB_HANDLE_FLAG_BOUND_PREDICATE;
+      for(attr_map_ptr = attr_map;
+          attr_map_ptr < attr_map + attribute_count;
+          attr_map_ptr++) {
+        attr = attr_map_ptr->from_attr;
+        if(attr->domain == DOMAIN_INT || attr->domain == DOMAIN_LONG) {
+          /* Attributes that are not used in the predicate are ignored. */
+          lvm_bind_variable(attr->name, row + attr_map_ptr->from_offset,
+                            attr->element_size);
+        }
+      }
+    }
+
     /* Try to establish acceptable ranges for the attribute values. */
     if(!LVM_ERROR(lvm_derive(adt->lvm_instance))) {
       select_index(handle, adt->lvm_instance);
@@ -788,8 +805,11 @@ relation_process_select(void *handle_ptr)
     from_ptr = row + attr_map_ptr->from_offset;
     result_attr = attr_map_ptr->to_attr;
 
-    /* Update the internal state of the PLE. */
-    if(result_attr->domain == DOMAIN_INT) {
+    /* Update the internal state of the PLE, unless the predicate
+       reads the values directly from the row. */
+    if(handle->flags & DB_HANDLE_FLAG_BOUND_PREDICATE) {
+      /* Nothing to update. */
+    } else if(result_attr->domain == DOMAIN_INT) {
       operand_value.l = from_ptr[0] << 8 | from_ptr[1];
       lvm_set_variable_value(result_attr->name, operand_value);
     } else if(result_attr->domain == DOMAIN_LONG) {
@@ -959,24 +979,59 @@ relation_select(void *handle_ptr, relation_t *rel, void *adt_ptr)
 }
 
 #if DB_FEATURE_JOIN
-db_result_t
-relation_process_join(void *handle_ptr)
+static long
+get_join_key(attribute_t *attr, unsigned char *ptr)
+{
+  attribute_value_t value;
+
+  if(DB_ERROR(db_phy_to_value(&value, attr, ptr))) {
+    return 0;
+  }
+  return db_value_to_long(&value);
+}
+
+static db_result_t
+emit_join_row(db_handle_t *handle)
 {
-  db_handle_t *handle;
-  db_result_t result;
-  relation_t *left_rel;
-  relation_t *right_rel;
   relation_t *join_rel;
   unsigned char *join_next_attribute_ptr;
   size_t element_size;
+  int i;
+
+  join_rel = handle->join_rel;
+
+  /* Use the source attribute map to fill in the physical representation
+     of the resulting tuple. */
+  join_next_attribute_ptr = join_row;
+
+  for(i = 0; i < join_rel->attribute_count; i++) {
+    element_size = source_map[i].attr->element_size;
+
+    memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
+    join_next_attribute_ptr += element_size;
+  }
+
+  if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
+    if(DB_ERROR(storage_put_row(join_rel, join_row))) {
+      return DB_STORAGE_ERROR;
+    }
+  }
+
+  handle->current_row++;
+  return DB_GOT_ROW;
+}
+
+static db_result_t
+process_index_join(db_handle_t *handle)
+{
+  db_result_t result;
+  relation_t *left_rel;
+  relation_t *right_rel;
   tuple_id_t right_tuple_id;
   attribute_value_t value;
-  int i;
 
-  handle = (db_handle_t *)handle_ptr;
   left_rel = handle->left_rel;
   right_rel = handle->right_rel;
-  join_rel = handle->join_rel;
 
   if(!(handle->flags & DB_HANDLE_FLAG_INDEX_STEP)) {
     goto inner_loop;
@@ -1030,31 +1085,311 @@ inner_loop:
         return DB_IMPLEMENTATION_ERROR;
       }
 
-      /* Use the source attribute map to fill in the physical representation
-	 of the resulting tuple. */
-      join_next_attribute_ptr = join_row;
+      return emit_join_row(handle);
+    }
+  }
 
-      for(i = 0; i < join_rel->attribute_count; i++) {
-	element_size = source_map[i].attr->element_size;
+  return DB_OK;
+}
 
-	memcpy(join_next_attribute_ptr, source_map[i].from_ptr, element_size);
-	join_next_attribute_ptr += element_size;
-      }
+/*
+ * The join key offsets are calculated when setting up a join, so that
+ * the join processors can extract keys from rows without walking
+ * the attribute lists of the relations.
+ */
+static unsigned left_key_offset;
+static unsigned right_key_offset;
+static long outer_key;
 
-      if(((aql_adt_t *)handle->adt)->flags & AQL_FLAG_ASSIGN) {
-        if(DB_ERROR(storage_put_row(join_rel, join_row))) {
-          return DB_STORAGE_ERROR;
-        }
+static db_result_t
+process_nested_loop_join(db_handle_t *handle)
+{
+  db_result_t result;
+
+  /* Full scan of the right relation for each tuple in the left relation.
+     This method is used when no index or enough RAM is available. */
+  if(handle->flags & DB_HANDLE_FLAG_INDEX_STEP) {
+    result = storage_get_row(handle->left_rel, &handle->tuple_id, left_row);
+    if(DB_ERROR(result)) {
+      PRINTF("DB: Failed to get a row in left relation %s!\n",
+             handle->left_rel->name);
+      return result;
+    } else if(result == DB_FINISHED) {
+      return DB_FINISHED;
+    }
+    handle->tuple_id++;
+    outer_key = get_join_key(handle->left_join_attr,
+                             left_row + left_key_offset);
+    handle->inner_tuple_id = 0;
+    handle->flags &= ~DB_HANDLE_FLAG_INDEX_STEP;
+  }
+
+  result = storage_get_row(handle->right_rel, &handle->inner_tuple_id,
+                           right_row);
+  if(DB_ERROR(result)) {
+    PRINTF("DB: Failed to get a row in right relation %s!\n",
+           handle->right_rel->name);
+    return result;
+  } else if(result == DB_FINISHED) {
+    handle->flags |= DB_HANDLE_FLAG_INDEX_STEP;
+    return DB_OK;
+  }
+  handle->inner_tuple_id++;
+
+  if(get_join_key(handle->right_join_attr,
+                  right_row + right_key_offset) == outer_key) {
+    return emit_join_row(handle);
+  }
+
+  return DB_OK;
+}
+
+#if DB_JOIN_HASH_BUDGET > 0
+/*
+ * The hash join builds a chained hash table over the join keys of
+ * the smaller relation, and then scans the larger relation once,
+ * probing the table for each tuple. Only keys and tuple IDs are kept
+ * in RAM; matching tuples of the build relation are read from storage
+ * when producing a result row.
+ */
+struct join_hash_entry {
+  long key;
+  tuple_id_t tuple_id;
+  uint16_t next;
+};
+
+#define JOIN_HASH_ENTRIES (DB_JOIN_HASH_BUDGET / sizeof(struct join_hash_entry))
+#define JOIN_HASH_NONE    0xffff
+#define JOIN_HASH(key)    ((unsigned long)(key) % DB_JOIN_HASH_BUCKETS)
+
+static struct join_hash_entry join_hash_entries[JOIN_HASH_ENTRIES];
+static uint16_t join_hash_buckets[DB_JOIN_HASH_BUCKETS];
+static uint16_t join_hash_cursor;
+static uint8_t join_build_left;
+
+static db_result_t
+build_join_hash(db_handle_t *handle)
+{
+  relation_t *build_rel;
+  attribute_t *build_attr;
+  unsigned char *build_row;
+  unsigned build_offset;
+  tuple_id_t tuple_id;
+  struct join_hash_entry *entry;
+  db_result_t result;
+  unsigned i;
+
+  if(relation_cardinality(handle->left_rel) <=
+     relation_cardinality(handle->right_rel)) {
+    join_build_left = 1;
+    build_rel = handle->left_rel;
+    build_attr = handle->left_join_attr;
+    build_row = left_row;
+    build_offset = left_key_offset;
+  } else {
+    join_build_left = 0;
+    build_rel = handle->right_rel;
+    build_attr = handle->right_join_attr;
+    build_row = right_row;
+    build_offset = right_key_offset;
+  }
+
+  for(i = 0; i < DB_JOIN_HASH_BUCKETS; i++) {
+    join_hash_buckets[i] = JOIN_HASH_NONE;
+  }
+
+  for(tuple_id = 0;; tuple_id++) {
+    result = storage_get_row(build_rel, &tuple_id, build_row);
+    if(DB_ERROR(result)) {
+      return result;
+    } else if(result == DB_FINISHED) {
+      break;
+    }
+
+    if(tuple_id >= JOIN_HASH_ENTRIES) {
+      PRINTF("DB: The relation %s does not fit in the hash join table\n",
+             build_rel->name);
+      return DB_LIMIT_ERROR;
+    }
+
+    entry = &join_hash_entries[tuple_id];
+    entry->key = get_join_key(build_attr, build_row + build_offset);
+    entry->tuple_id = tuple_id;
+    entry->next = join_hash_buckets[JOIN_HASH(entry->key)];
+    join_hash_buckets[JOIN_HASH(entry->key)] = tuple_id;
+  }
+
+  PRINTF("DB: Built a hash join table with %lu entries over relation %s\n",
+         (unsigned long)tuple_id, build_rel->name);
+
+  return DB_OK;
+}
+
+static db_result_t
+process_hash_join(db_handle_t *handle)
+{
+  db_result_t result;
+  relation_t *probe_rel;
+  relation_t *build_rel;
+  unsigned char *probe_row;
+  unsigned char *build_row;
+  struct join_hash_entry *entry;
+  tuple_id_t tuple_id;
+
+  if(join_build_left) {
+    build_rel = handle->left_rel;
+    build_row = left_row;
+    probe_rel = handle->right_rel;
+    probe_row = right_row;
+  } else {
+    build_rel = handle->right_rel;
+    build_row = right_row;
+    probe_rel = handle->left_rel;
+    probe_row = left_row;
+  }
+
+  if(handle->flags & DB_HANDLE_FLAG_INDEX_STEP) {
+    result = storage_get_row(probe_rel, &handle->tuple_id, probe_row);
+    if(DB_ERROR(result)) {
+      PRINTF("DB: Failed to get a row in relation %s!\n", probe_rel->name);
+      return result;
+    } else if(result == DB_FINISHED) {
+      return DB_FINISHED;
+    }
+    handle->tuple_id++;
+    if(join_build_left) {
+      outer_key = get_join_key(handle->right_join_attr,
+                               right_row + right_key_offset);
+    } else {
+      outer_key = get_join_key(handle->left_join_attr,
+                               left_row + left_key_offset);
+    }
+    join_hash_cursor = join_hash_buckets[JOIN_HASH(outer_key)];
+    handle->flags &= ~DB_HANDLE_FLAG_INDEX_STEP;
+  }
+
+  while(join_hash_cursor != JOIN_HASH_NONE) {
+    entry = &join_hash_entries[join_hash_cursor];
+    join_hash_cursor = entry->next;
+    if(entry->key == outer_key) {
+      tuple_id = entry->tuple_id;
+      result = storage_get_row(build_rel, &tuple_id, build_row);
+      if(DB_ERROR(result)) {
+        return result;
+      } else if(result == DB_FINISHED) {
+        return DB_INCONSISTENCY_ERROR;
       }
+      return emit_join_row(handle);
+    }
+  }
 
-      handle->current_row++;
-      return DB_GOT_ROW;
+  handle->flags |= DB_HANDLE_FLAG_INDEX_STEP;
+  return DB_OK;
+}
+#endif /* DB_JOIN_HASH_BUDGET > 0 */
+
+/*
+ * The merge join requires that both relations are stored in ascending
+ * order of the join attribute, which is the case when the attribute has
+ * an inline index in both relations. Each relation is then scanned only
+ * once, except for runs of duplicate keys in the right relation, which
+ * are rescanned for each left tuple with the same key.
+ */
+static tuple_id_t merge_run_start;
+static long merge_run_key;
+static uint8_t merge_run_valid;
+
+static db_result_t
+process_merge_join(db_handle_t *handle)
+{
+  db_result_t result;
+  long right_key;
+
+  if(handle->flags & DB_HANDLE_FLAG_INDEX_STEP) {
+    result = storage_get_row(handle->left_rel, &handle->tuple_id, left_row);
+    if(DB_ERROR(result)) {
+      PRINTF("DB: Failed to get a row in left relation %s!\n",
+             handle->left_rel->name);
+      return result;
+    } else if(result == DB_FINISHED) {
+      return DB_FINISHED;
+    }
+    handle->tuple_id++;
+    outer_key = get_join_key(handle->left_join_attr,
+                             left_row + left_key_offset);
+    if(merge_run_valid && merge_run_key == outer_key) {
+      /* Duplicate key in the left relation: join with the same run
+         of tuples in the right relation again. */
+      handle->inner_tuple_id = merge_run_start;
     }
+    handle->flags &= ~DB_HANDLE_FLAG_INDEX_STEP;
+  }
+
+  result = storage_get_row(handle->right_rel, &handle->inner_tuple_id,
+                           right_row);
+  if(DB_ERROR(result)) {
+    PRINTF("DB: Failed to get a row in right relation %s!\n",
+           handle->right_rel->name);
+    return result;
+  } else if(result == DB_FINISHED) {
+    handle->flags |= DB_HANDLE_FLAG_INDEX_STEP;
+    return DB_OK;
+  }
+
+  right_key = get_join_key(handle->right_join_attr,
+                           right_row + right_key_offset);
+  if(right_key < outer_key) {
+    handle->inner_tuple_id++;
+  } else if(right_key > outer_key) {
+    handle->flags |= DB_HANDLE_FLAG_INDEX_STEP;
+  } else {
+    if(!merge_run_valid || merge_run_key != outer_key) {
+      merge_run_start = handle->inner_tuple_id;
+      merge_run_key = outer_key;
+      merge_run_valid = 1;
+    }
+    handle->inner_tuple_id++;
+    return emit_join_row(handle);
   }
 
   return DB_OK;
 }
 
+db_result_t
+relation_process_join(void *handle_ptr)
+{
+  db_handle_t *handle;
+
+  handle = (db_handle_t *)handle_ptr;
+
+  switch(handle->join_method) {
+  case DB_JOIN_INDEX:
+    return process_index_join(handle);
+#if DB_JOIN_HASH_BUDGET > 0
+  case DB_JOIN_HASH:
+    return process_hash_join(handle);
+#endif /* DB_JOIN_HASH_BUDGET > 0 */
+  case DB_JOIN_MERGE:
+    return process_merge_join(handle);
+  case DB_JOIN_NESTED_LOOP:
+    return process_nested_loop_join(handle);
+  default:
+    break;
+  }
+
+  return DB_IMPLEMENTATION_ERROR;
+}
+
+tuple_id_t
+relation_join_hash_capacity(void)
+{
+#if DB_JOIN_HASH_BUDGET > 0
+  return JOIN_HASH_ENTRIES;
+#else
+  return 0;
+#endif /* DB_JOIN_HASH_BUDGET > 0 */
+}
+
 static db_result_t
 generate_join_result(db_handle_t *handle)
 {
@@ -1158,9 +1493,40 @@ relation_join(void *query_result, void *adt_ptr)
     return DB_RELATIONAL_ERROR;
   }
 
-  if(!index_exists(handle->right_join_attr)) {
-    PRINTF("DB: The attribute to join on is not indexed\n");
-    return DB_INDEX_ERROR;
+  if((handle->left_join_attr->domain != DOMAIN_INT &&
+      handle->left_join_attr->domain != DOMAIN_LONG) ||
+     (handle->right_join_attr->domain != DOMAIN_INT &&
+      handle->right_join_attr->domain != DOMAIN_LONG)) {
+    PRINTF("DB: Cannot join on a non-number attribute\n");
+    return DB_TYPE_ERROR;
+  }
+
+  left_key_offset = get_attribute_value_offset(left_rel, handle->left_join_attr);
+  right_key_offset = get_attribute_value_offset(right_rel, handle->right_join_attr);
+
+  switch(handle->join_method) {
+  case DB_JOIN_INDEX:
+    if(!index_exists(handle->right_join_attr)) {
+      PRINTF("DB: The attribute to join on is not indexed\n");
+      return DB_INDEX_ERROR;
+    }
+    break;
+  case DB_JOIN_HASH:
+#if DB_JOIN_HASH_BUDGET > 0
+    if(DB_SUCCESS(build_join_hash(handle))) {
+      break;
+    }
+#endif /* DB_JOIN_HASH_BUDGET > 0 */
+    PRINTF("DB: Unable to build a hash join table; using a nested-loop join\n");
+    handle->join_method = DB_JOIN_NESTED_LOOP;
+    break;
+  case DB_JOIN_MERGE:
+    merge_run_valid = 0;
+    handle->inner_tuple_id = 0;
+    break;
+  default:
+    handle->join_method = DB_JOIN_NESTED_LOOP;
+    break;
   }
 
   /*
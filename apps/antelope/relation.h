@@ -54,6 +54,13 @@ typedef enum db_direction {
   DB_STORAGE = 1
 } db_direction_t;
 
+typedef enum db_join_method {
+  DB_JOIN_NESTED_LOOP = 0,
+  DB_JOIN_INDEX = 1,
+  DB_JOIN_HASH = 2,
+  DB_JOIN_MERGE = 3
+} db_join_method_t;
+
 #define RELATION_HAS_TUPLES(rel) ((rel)->tuple_storage >= 0)
 
 /*
@@ -97,6 +104,7 @@ db_result_t relation_remove(char *, int);
 db_result_t relation_insert(relation_t *, attribute_value_t *);
 db_result_t relation_select(void *, relation_t *, void *);
 db_result_t relation_join(void *, void *);
+tuple_id_t relation_join_hash_capacity(void);
 tuple_id_t relation_cardinality(relation_t *);
 
 #endif /* RELATION_H */
@@ -49,10 +49,12 @@ typedef unsigned char *tuple_t;
 #define DB_HANDLE_FLAG_INDEX_STEP	0x01
 #define DB_HANDLE_FLAG_SEARCH_INDEX	0x02
 #define DB_HANDLE_FLAG_PROCESSING	0x04
+#define DB_HANDLE_FLAG_BOUND_PREDICATE	0x08
 
 struct db_handle {
   index_iterator_t index_iterator;
   tuple_id_t tuple_id;
+  tuple_id_t inner_tuple_id;
   tuple_id_t current_row;
   relation_t *rel;
   relation_t *left_rel;
@@ -64,6 +66,7 @@ struct db_handle {
   tuple_t tuple;
   uint8_t flags;
   uint8_t ncolumns;
+  uint8_t join_method;
   void *adt;
 };
 typedef struct db_handle db_handle_t;
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Reconstruction of code modules from deltas.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "lib/crc16.h"
+
+#include "codeprop-delta.h"
+
+#ifdef CODEPROP_DELTA_CONF_BUFFER_SIZE
+#define BUFFER_SIZE CODEPROP_DELTA_CONF_BUFFER_SIZE
+#else
+#define BUFFER_SIZE 32
+#endif
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+#define CMD_COPY      0x80
+#define CMD_COPY_LONG 0x40
+
+static unsigned char buf[BUFFER_SIZE];
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get16(const unsigned char *p)
+{
+  return ((uint16_t)p[0] << 8) | p[1];
+}
+/*---------------------------------------------------------------------------*/
+static int
+file_crc(int fd, uint16_t len, uint16_t *crc)
+{
+  int n;
+
+  *crc = 0;
+  cfs_seek(fd, 0, CFS_SEEK_SET);
+  while(len > 0) {
+    n = len < sizeof(buf) ? len : sizeof(buf);
+    if(cfs_read(fd, buf, n) != n) {
+      return -1;
+    }
+    *crc = crc16_data(buf, n, *crc);
+    len -= n;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Copy len bytes from the current position of fromfd to outfd. */
+static int
+copy_bytes(int fromfd, int outfd, uint16_t len)
+{
+  int n;
+
+  while(len > 0) {
+    n = len < sizeof(buf) ? len : sizeof(buf);
+    if(cfs_read(fromfd, buf, n) != n || cfs_write(outfd, buf, n) != n) {
+      return -1;
+    }
+    len -= n;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+codeprop_delta_check(int fd)
+{
+  unsigned char magic[2];
+
+  cfs_seek(fd, 0, CFS_SEEK_SET);
+  return cfs_read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+    magic[0] == 'C' && magic[1] == 'D';
+}
+/*---------------------------------------------------------------------------*/
+int
+codeprop_delta_apply(int basefd, int deltafd, int outfd)
+{
+  unsigned char hdr[CODEPROP_DELTA_HEADER_SIZE];
+  unsigned char cmd[4];
+  uint16_t base_len, new_len;
+  uint16_t crc;
+  uint16_t written;
+  uint16_t offset;
+  uint16_t len;
+
+  cfs_seek(deltafd, 0, CFS_SEEK_SET);
+  if(cfs_read(deltafd, hdr, sizeof(hdr)) != sizeof(hdr) ||
+     hdr[0] != 'C' || hdr[1] != 'D') {
+    return CODEPROP_DELTA_BAD_HEADER;
+  }
+  base_len = get16(&hdr[2]);
+  new_len = get16(&hdr[6]);
+
+  /* Only patch the image the delta was generated against. */
+  if(file_crc(basefd, base_len, &crc) < 0 || crc != get16(&hdr[4])) {
+    PRINTF("codeprop-delta: base image mismatch\n");
+    return CODEPROP_DELTA_BASE_MISMATCH;
+  }
+
+  cfs_seek(outfd, 0, CFS_SEEK_SET);
+  for(written = 0; written < new_len; written += len) {
+    if(cfs_read(deltafd, cmd, 1) != 1) {
+      return CODEPROP_DELTA_BAD_COMMAND;
+    }
+
+    if((cmd[0] & CMD_COPY) == 0) {
+      len = (cmd[0] & 0x7f) + 1;
+      if((uint32_t)written + len > new_len ||
+         copy_bytes(deltafd, outfd, len) < 0) {
+        return CODEPROP_DELTA_BAD_COMMAND;
+      }
+    } else {
+      if(cmd[0] & CMD_COPY_LONG) {
+        if(cfs_read(deltafd, &cmd[1], 3) != 3) {
+          return CODEPROP_DELTA_BAD_COMMAND;
+        }
+        len = (((uint16_t)(cmd[0] & 0x3f) << 8) | cmd[1]) + 4;
+        offset = get16(&cmd[2]);
+      } else {
+        if(cfs_read(deltafd, &cmd[1], 2) != 2) {
+          return CODEPROP_DELTA_BAD_COMMAND;
+        }
+        len = (cmd[0] & 0x3f) + 4;
+        offset = get16(&cmd[1]);
+      }
+      if((uint32_t)written + len > new_len ||
+         (uint32_t)offset + len > base_len) {
+        return CODEPROP_DELTA_BAD_COMMAND;
+      }
+      cfs_seek(basefd, offset, CFS_SEEK_SET);
+      if(copy_bytes(basefd, outfd, len) < 0) {
+        return CODEPROP_DELTA_BAD_COMMAND;
+      }
+    }
+  }
+
+  if(file_crc(outfd, new_len, &crc) < 0 || crc != get16(&hdr[8])) {
+    PRINTF("codeprop-delta: checksum error in new image\n");
+    return CODEPROP_DELTA_BAD_CHECKSUM;
+  }
+
+  PRINTF("codeprop-delta: %u byte image reconstructed\n", new_len);
+  return CODEPROP_DELTA_OK;
+}
+/*---------------------------------------------------------------------------*/
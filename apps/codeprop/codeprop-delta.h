@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Delta updates of code modules.
+ *
+ *         A delta describes a new module image in terms of the module
+ *         image that a node already has, so that only the changed
+ *         parts need to be sent over the radio. Deltas are generated
+ *         on the host with tools/codeprop-delta.
+ *
+ *         A delta starts with a 10 byte header, all fields in network
+ *         byte order:
+ *
+ *           magic (2)  'C' 'D'
+ *           base length (2), base CRC16 (2)
+ *           new length (2), new CRC16 (2)
+ *
+ *         The header is followed by commands that produce the new
+ *         image from front to back:
+ *
+ *           0lllllll                       insert the l + 1 bytes
+ *                                          that follow
+ *           10llllll oooooooo oooooooo     copy l + 4 bytes from base
+ *                                          offset o
+ *           11llllll llllllll oooooooo oooooooo
+ *                                          copy l + 4 bytes from base
+ *                                          offset o
+ */
+
+#ifndef CODEPROP_DELTA_H_
+#define CODEPROP_DELTA_H_
+
+#define CODEPROP_DELTA_HEADER_SIZE 10
+
+#define CODEPROP_DELTA_OK            0
+#define CODEPROP_DELTA_BAD_HEADER    1
+#define CODEPROP_DELTA_BASE_MISMATCH 2
+#define CODEPROP_DELTA_BAD_COMMAND   3
+#define CODEPROP_DELTA_BAD_CHECKSUM  4
+
+/**
+ * \brief      Check whether a file holds a delta.
+ * \param fd   The file.
+ * \return     Non-zero if the file starts with a delta header.
+ */
+int codeprop_delta_check(int fd);
+
+/**
+ * \brief         Reconstruct a module image from a delta.
+ * \param basefd  The image the delta was generated against.
+ * \param deltafd The delta.
+ * \param outfd   The file the new image is written to.
+ * \return        CODEPROP_DELTA_OK, or an error code.
+ *
+ *                The base image is verified against the length and
+ *                checksum in the delta header before anything is
+ *                written, and the new image is verified after it has
+ *                been written.
+ */
+int codeprop_delta_apply(int basefd, int deltafd, int outfd);
+
+#endif /* CODEPROP_DELTA_H_ */
@@ -47,6 +47,7 @@
  *    Point-to-point download over TCP
  *    Point-to-multipoint delivery over UDP broadcasts
  *    Versioning of code modules
+ *    Delta updates against the previously loaded module
  *
  * Procedure:
  *
@@ -62,6 +63,14 @@
  *
  *  Receiving code header -> receiving code -> sending code
  *
+ * Delta updates:
+ *
+ *    A received image that starts with a delta header (see
+ *    codeprop-delta.h) is applied to an unrelocated copy of the last
+ *    loaded module before loading. The delta itself is what gets
+ *    propagated, so the airtime is proportional to the size of the
+ *    change rather than to the size of the module.
+ *
  */
 
 #include <stdio.h>
@@ -72,10 +81,28 @@
 #include "loader/elfloader.h"
 #include <string.h>
 
+#ifdef CODEPROP_CONF_DELTA
+#define CODEPROP_DELTA CODEPROP_CONF_DELTA
+#else
+#define CODEPROP_DELTA 1
+#endif
+
+#if CODEPROP_DELTA
+#include "codeprop-delta.h"
+
+/* The unrelocated image of the loaded module, which deltas are
+   applied to, and the module reconstructed from a delta. */
+#define BASE_FILE   "codeprop-base"
+#define MODULE_FILE "codeprop-module"
+#endif /* CODEPROP_DELTA */
+
+/* Returned by codeprop_start_program() after the elfloader errors. */
+#define CODEPROP_DELTA_FAILED 8
+
 static const char *err_msgs[] =
   {"OK\r\n", "Bad ELF header\r\n", "No symtab\r\n", "No strtab\r\n",
    "No text\r\n", "Symbol not found\r\n", "Segment not found\r\n",
-   "No startpoint\r\n" };
+   "No startpoint\r\n", "Delta failed\r\n" };
 
 #define CODEPROP_DATA_PORT 6510
 
@@ -457,14 +484,89 @@ codeprop_exit_program(void)
   }
 }
 /*---------------------------------------------------------------------*/
+#if CODEPROP_DELTA
+/* Keep up to len bytes of the module in fromfd as the base for the
+   next delta. This must be done before the module is loaded, since
+   the loader relocates the file in place. */
+static void
+save_base(int fromfd, uint16_t len)
+{
+  static uint8_t buf[32];
+  int basefd;
+  int n;
+
+  cfs_remove(BASE_FILE);
+  basefd = cfs_open(BASE_FILE, CFS_WRITE);
+  if(basefd < 0) {
+    PRINTF(("codeprop: could not save the base image\n"));
+    return;
+  }
+  cfs_seek(fromfd, 0, CFS_SEEK_SET);
+  while(len > 0) {
+    n = cfs_read(fromfd, buf, len < sizeof(buf) ? len : sizeof(buf));
+    if(n <= 0) {
+      break;
+    }
+    cfs_write(basefd, buf, n);
+    len -= n;
+  }
+  cfs_close(basefd);
+}
+/*---------------------------------------------------------------------*/
+static int
+apply_delta(void)
+{
+  int basefd;
+  int modulefd;
+  int err;
+
+  basefd = cfs_open(BASE_FILE, CFS_READ);
+  if(basefd < 0) {
+    PRINTF(("codeprop: no base image for delta\n"));
+    return -1;
+  }
+  cfs_remove(MODULE_FILE);
+  modulefd = cfs_open(MODULE_FILE, CFS_READ | CFS_WRITE);
+  if(modulefd < 0) {
+    cfs_close(basefd);
+    return -1;
+  }
+  err = codeprop_delta_apply(basefd, fd, modulefd);
+  cfs_close(basefd);
+  if(err != CODEPROP_DELTA_OK) {
+    PRINTF(("codeprop: delta failed (%d)\n", err));
+    cfs_close(modulefd);
+    return -1;
+  }
+  return modulefd;
+}
+#endif /* CODEPROP_DELTA */
+/*---------------------------------------------------------------------*/
 int
 codeprop_start_program(void)
 {
   int err;
+  int loadfd;
 
   codeprop_exit_program();
 
-  err = elfloader_load(fd);
+  loadfd = fd;
+#if CODEPROP_DELTA
+  if(codeprop_delta_check(fd)) {
+    loadfd = apply_delta();
+    if(loadfd < 0) {
+      return CODEPROP_DELTA_FAILED;
+    }
+    save_base(loadfd, 0xffff);
+  } else {
+    save_base(fd, s.len);
+  }
+#endif /* CODEPROP_DELTA */
+
+  err = elfloader_load(loadfd);
+  if(loadfd != fd) {
+    cfs_close(loadfd);
+  }
   if(err == ELFLOADER_OK) {
     PRINTF(("codeprop: starting %s\n",
 	    elfloader_autostart_processes[0]->name));
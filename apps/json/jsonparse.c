@@ -37,10 +37,14 @@
 static int
 push(struct jsonparse_state *state, char c)
 {
+  if(state->depth >= JSONPARSE_MAX_DEPTH) {
+    state->error = JSON_ERROR_TOO_DEEP;
+    return 0;
+  }
   state->stack[state->depth] = c;
   state->depth++;
   state->vtype = 0;
-  return state->depth < JSONPARSE_MAX_DEPTH;
+  return 1;
 }
 /*--------------------------------------------------------------------*/
 static void
@@ -62,6 +66,12 @@ pop(struct jsonparse_state *state)
   return state->stack[state->depth];
 }
 /*--------------------------------------------------------------------*/
+static int
+is_ws(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+/*--------------------------------------------------------------------*/
 /* will pass by the value and store the start and length of the value for
    atomic types */
 /*--------------------------------------------------------------------*/
@@ -105,7 +115,7 @@ atomic(struct jsonparse_state *state, char type)
     default:              str = "";      break;
     }
 
-    while ((c = state->json[state->pos]) && c != ' ' && c != ',' && c != ']' && c != '}') {
+    while ((c = state->json[state->pos]) && !is_ws(c) && c != ',' && c != ']' && c != '}') {
       state->pos++;
     }
 
@@ -126,10 +136,7 @@ atomic(struct jsonparse_state *state, char type)
 static void
 skip_ws(struct jsonparse_state *state)
 {
-  char c;
-
-  while(state->pos < state->len &&
-        ((c = state->json[state->pos]) == ' ' || c == '\n')) {
+  while(state->pos < state->len && is_ws(state->json[state->pos])) {
     state->pos++;
   }
 }
@@ -173,7 +180,9 @@ jsonparse_next(struct jsonparse_state *state)
   switch(c) {
   case '{':
     if((s == 0 && v == 0) || s == '[' || s == ':') {
-      push(state, c);
+      if(!push(state, c)) {
+        return JSON_TYPE_ERROR;
+      }
     } else {
       state->error = JSON_ERROR_UNEXPECTED_OBJECT;
       return JSON_TYPE_ERROR;
@@ -225,7 +234,9 @@ jsonparse_next(struct jsonparse_state *state)
     return c;
   case '[':
     if((s == 0 && v == 0) || s == '[' || s == ':') {
-      push(state, c);
+      if(!push(state, c)) {
+        return JSON_TYPE_ERROR;
+      }
     } else {
       state->error = JSON_ERROR_UNEXPECTED_ARRAY;
       return JSON_TYPE_ERROR;
@@ -347,3 +358,159 @@ jsonparse_has_next(struct jsonparse_state *state)
   return state->pos < state->len;
 }
 /*--------------------------------------------------------------------*/
+/* Returns the position just after the token that starts at pos, or -1
+   if the token does not end before len. A ':' is taken together with
+   the value that follows it, as jsonparse_next() reads both at once. */
+/*--------------------------------------------------------------------*/
+static int
+token_end(const char *json, int pos, int len)
+{
+  char c;
+
+  if(json[pos] == ':') {
+    for(pos++; pos < len && is_ws(json[pos]); pos++);
+    if(pos >= len) {
+      return -1;
+    }
+  }
+
+  c = json[pos++];
+  switch(c) {
+  case '{':
+  case '}':
+  case '[':
+  case ']':
+  case ',':
+    return pos;
+  case '"':
+    while(pos < len) {
+      c = json[pos++];
+      if(c == '\\') {
+        pos++;
+      } else if(c == '"') {
+        return pos;
+      }
+    }
+    return -1;
+  default:
+    /* Numbers and literals end at the next delimiter */
+    for(; pos < len; pos++) {
+      c = json[pos];
+      if(is_ws(c) || c == ',' || c == ']' || c == '}') {
+        return pos;
+      }
+    }
+    return -1;
+  }
+}
+/*--------------------------------------------------------------------*/
+void
+jsonparse_stream_setup(struct jsonparse_stream *stream)
+{
+  jsonparse_setup(&stream->state, "", 0);
+  stream->chunk = "";
+  stream->chunk_len = 0;
+  stream->chunk_pos = 0;
+  stream->carry_len = 0;
+  stream->last = 0;
+}
+/*--------------------------------------------------------------------*/
+void
+jsonparse_stream_feed(struct jsonparse_stream *stream, const char *data,
+                      int len)
+{
+  stream->chunk = data;
+  stream->chunk_len = len;
+  stream->chunk_pos = 0;
+}
+/*--------------------------------------------------------------------*/
+void
+jsonparse_stream_finish(struct jsonparse_stream *stream)
+{
+  stream->last = 1;
+}
+/*--------------------------------------------------------------------*/
+int
+jsonparse_stream_next(struct jsonparse_stream *stream)
+{
+  struct jsonparse_state *state = &stream->state;
+  int start, end, avail, n;
+
+  if(stream->carry_len == 0) {
+    state->json = stream->chunk;
+    state->pos = stream->chunk_pos;
+    state->len = stream->chunk_len;
+    skip_ws(state);
+    start = state->pos;
+    stream->chunk_pos = start;
+
+    if(start >= state->len) {
+      if(!stream->last) {
+        return JSONPARSE_NEED_MORE;
+      }
+      /* End of the document */
+      state->json = "";
+      state->pos = 0;
+      state->len = 0;
+      return jsonparse_next(state);
+    }
+
+    end = token_end(state->json, start, state->len);
+    if(end >= 0) {
+      /* The common case: the whole token is in this chunk */
+      n = jsonparse_next(state);
+      stream->chunk_pos = state->pos;
+      return n;
+    }
+
+    /* The token continues in the next chunk: carry over what we have */
+    n = state->len - start;
+    if(n > JSONPARSE_STREAM_VALUE_SIZE) {
+      state->error = JSON_ERROR_TOO_LONG;
+      return JSON_TYPE_ERROR;
+    }
+    memcpy(stream->carry, &state->json[start], n);
+    stream->carry_len = n;
+    stream->chunk_pos = state->len;
+    if(!stream->last) {
+      return JSONPARSE_NEED_MORE;
+    }
+    end = n;
+  } else {
+    /* Complete the carried token from the new chunk */
+    avail = stream->chunk_len - stream->chunk_pos;
+    n = JSONPARSE_STREAM_VALUE_SIZE - stream->carry_len;
+    if(n > avail) {
+      n = avail;
+    }
+    memcpy(&stream->carry[stream->carry_len],
+           &stream->chunk[stream->chunk_pos], n);
+
+    end = token_end(stream->carry, 0, stream->carry_len + n);
+    if(end < 0) {
+      if(n < avail) {
+        state->error = JSON_ERROR_TOO_LONG;
+        return JSON_TYPE_ERROR;
+      }
+      stream->carry_len += n;
+      stream->chunk_pos += n;
+      if(!stream->last) {
+        return JSONPARSE_NEED_MORE;
+      }
+      /* The end of the input ends the token */
+      end = stream->carry_len;
+    } else {
+      stream->chunk_pos += end - stream->carry_len;
+    }
+  }
+
+  /* Parse the token from the carry buffer, where its value stays
+     available until the next call. */
+  stream->carry[end] = '\0';
+  stream->carry_len = 0;
+  state->json = stream->carry;
+  state->pos = 0;
+  state->len = end;
+  return jsonparse_next(state);
+}
+/*--------------------------------------------------------------------*/
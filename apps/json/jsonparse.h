@@ -41,6 +41,15 @@
 #define JSONPARSE_MAX_DEPTH 10
 #endif
 
+#ifdef JSONPARSE_CONF_STREAM_VALUE_SIZE
+#define JSONPARSE_STREAM_VALUE_SIZE JSONPARSE_CONF_STREAM_VALUE_SIZE
+#else
+#define JSONPARSE_STREAM_VALUE_SIZE 64
+#endif
+
+/* returned by jsonparse_stream_next() when it needs the next chunk */
+#define JSONPARSE_NEED_MORE (-1)
+
 struct jsonparse_state {
   const char *json;
   int pos;
@@ -54,6 +63,23 @@ struct jsonparse_state {
   char stack[JSONPARSE_MAX_DEPTH];
 };
 
+/*
+ * A JSON parser that takes its input in chunks, e.g. as TCP segments or
+ * CoAP blocks arrive. Values are read with the usual jsonparse_*()
+ * functions on &stream->state. A token that is split between two chunks
+ * is copied to the carry buffer, so a single string or number must fit
+ * in JSONPARSE_STREAM_VALUE_SIZE bytes.
+ */
+struct jsonparse_stream {
+  struct jsonparse_state state;
+  const char *chunk;
+  int chunk_len;
+  int chunk_pos;
+  int carry_len;
+  char last;
+  char carry[JSONPARSE_STREAM_VALUE_SIZE + 1];
+};
+
 /**
  * \brief      Initialize a JSON parser state.
  * \param state A pointer to a JSON parser state
@@ -88,4 +114,37 @@ int jsonparse_get_type(struct jsonparse_state *state);
 /* compare the JSON value with the specified string */
 int jsonparse_strcmp_value(struct jsonparse_state *state, const char *str);
 
+/**
+ * \brief      Initialize a chunked JSON parser.
+ * \param stream A pointer to a chunked JSON parser
+ */
+void jsonparse_stream_setup(struct jsonparse_stream *stream);
+
+/**
+ * \brief      Give the parser the next chunk of input.
+ * \param stream A pointer to a chunked JSON parser
+ * \param data The chunk, which must stay valid until
+ *             jsonparse_stream_next() returns JSONPARSE_NEED_MORE
+ * \param len  The length of the chunk
+ *
+ *             Call this after jsonparse_stream_setup() and whenever
+ *             jsonparse_stream_next() returns JSONPARSE_NEED_MORE.
+ */
+void jsonparse_stream_feed(struct jsonparse_stream *stream, const char *data,
+                           int len);
+
+/**
+ * \brief      Tell the parser that the current chunk is the last one.
+ * \param stream A pointer to a chunked JSON parser
+ */
+void jsonparse_stream_finish(struct jsonparse_stream *stream);
+
+/**
+ * \brief      Move to the next JSON element of a chunked document.
+ * \param stream A pointer to a chunked JSON parser
+ * \return     The same as jsonparse_next(), or JSONPARSE_NEED_MORE
+ *             when the current chunk has been used up.
+ */
+int jsonparse_stream_next(struct jsonparse_stream *stream);
+
 #endif /* JSONPARSE_H_ */
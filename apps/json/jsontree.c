@@ -50,32 +50,110 @@
 #define PRINTF(...)
 #endif
 
+/* The buffer behind jsontree_buffer_putchar(), for callbacks that call
+   js_ctx->putchar() themselves. */
+static struct jsontree_buffer *active_buffer;
+/*---------------------------------------------------------------------------*/
+static void
+buffer_write(struct jsontree_buffer *buffer, const char *data, int len)
+{
+  int n;
+
+  buffer->total += len;
+  if(buffer->skip >= len) {
+    buffer->skip -= len;
+    return;
+  }
+  data += buffer->skip;
+  len -= buffer->skip;
+  buffer->skip = 0;
+
+  while(len > 0 && !buffer->full) {
+    if(buffer->len == buffer->size) {
+      if(buffer->flush == NULL || !buffer->flush(buffer)) {
+        buffer->full = 1;
+        break;
+      }
+      buffer->len = 0;
+    }
+    n = buffer->size - buffer->len;
+    if(n > len) {
+      n = len;
+    }
+    memcpy(&buffer->data[buffer->len], data, n);
+    buffer->len += n;
+    data += n;
+    len -= n;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+jsontree_buffer_putchar(int c)
+{
+  char ch = c;
+
+  if(active_buffer == NULL) {
+    return 0;
+  }
+  buffer_write(active_buffer, &ch, 1);
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_char(const struct jsontree_context *js_ctx, char c)
+{
+  struct jsontree_buffer *buffer = js_ctx->buffer;
+
+  if(buffer != NULL) {
+    if(buffer->len < buffer->size && buffer->skip == 0 && !buffer->full) {
+      buffer->data[buffer->len++] = c;
+      buffer->total++;
+    } else {
+      buffer_write(buffer, &c, 1);
+    }
+  } else {
+    js_ctx->putchar(c);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+jsontree_write_bytes(const struct jsontree_context *js_ctx, const char *data,
+                     int len)
+{
+  if(js_ctx->buffer != NULL) {
+    buffer_write(js_ctx->buffer, data, len);
+  } else {
+    while(len-- > 0) {
+      js_ctx->putchar(*data++);
+    }
+  }
+}
 /*---------------------------------------------------------------------------*/
 void
 jsontree_write_atom(const struct jsontree_context *js_ctx, const char *text)
 {
   if(text == NULL) {
-    js_ctx->putchar('0');
+    write_char(js_ctx, '0');
   } else {
-    while(*text != '\0') {
-      js_ctx->putchar(*text++);
-    }
+    jsontree_write_bytes(js_ctx, text, strlen(text));
   }
 }
 /*---------------------------------------------------------------------------*/
 void
 jsontree_write_string(const struct jsontree_context *js_ctx, const char *text)
 {
-  js_ctx->putchar('"');
+  const char *quote;
+
+  write_char(js_ctx, '"');
   if(text != NULL) {
-    while(*text != '\0') {
-      if(*text == '"') {
-        js_ctx->putchar('\\');
-      }
-      js_ctx->putchar(*text++);
+    while((quote = strchr(text, '"')) != NULL) {
+      jsontree_write_bytes(js_ctx, text, quote - text);
+      jsontree_write_bytes(js_ctx, "\\\"", 2);
+      text = quote + 1;
     }
+    jsontree_write_atom(js_ctx, text);
   }
-  js_ctx->putchar('"');
+  write_char(js_ctx, '"');
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -90,16 +168,15 @@ jsontree_write_uint(const struct jsontree_context *js_ctx, unsigned int value)
     value /= 10;
   } while(value > 0 && l >= 0);
 
-  while(++l < sizeof(buf)) {
-    js_ctx->putchar(buf[l]);
-  }
+  l++;
+  jsontree_write_bytes(js_ctx, &buf[l], sizeof(buf) - l);
 }
 /*---------------------------------------------------------------------------*/
 void
 jsontree_write_int(const struct jsontree_context *js_ctx, int value)
 {
   if(value < 0) {
-    js_ctx->putchar('-');
+    write_char(js_ctx, '-');
     value = -value;
   }
 
@@ -112,6 +189,7 @@ jsontree_setup(struct jsontree_context *js_ctx, struct jsontree_value *root,
 {
   js_ctx->values[0] = root;
   js_ctx->putchar = putchar;
+  js_ctx->buffer = NULL;
   js_ctx->path = 0;
   jsontree_reset(js_ctx);
 }
@@ -121,6 +199,49 @@ jsontree_reset(struct jsontree_context *js_ctx)
 {
   js_ctx->depth = 0;
   js_ctx->index[0] = 0;
+  if(js_ctx->buffer != NULL) {
+    js_ctx->putchar = js_ctx->buffer->putchar;
+    js_ctx->buffer = NULL;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+jsontree_buffer_init(struct jsontree_buffer *buffer, char *data,
+                     uint16_t size, int (* flush)(struct jsontree_buffer *))
+{
+  memset(buffer, 0, sizeof(*buffer));
+  buffer->data = data;
+  buffer->size = size;
+  buffer->flush = flush;
+}
+/*---------------------------------------------------------------------------*/
+/* Send the output of the context to a buffer instead of putchar(). Call
+   after jsontree_setup() or jsontree_reset(), which go back to putchar(). */
+void
+jsontree_set_buffer(struct jsontree_context *js_ctx,
+                    struct jsontree_buffer *buffer)
+{
+  if(js_ctx->buffer != NULL) {
+    buffer->putchar = js_ctx->buffer->putchar;
+  } else {
+    buffer->putchar = js_ctx->putchar;
+  }
+  js_ctx->buffer = buffer;
+  js_ctx->putchar = jsontree_buffer_putchar;
+  active_buffer = buffer;
+}
+/*---------------------------------------------------------------------------*/
+/* Pass on the last, partly filled chunk. */
+int
+jsontree_buffer_flush(struct jsontree_buffer *buffer)
+{
+  int r = 1;
+
+  if(buffer->len > 0 && buffer->flush != NULL) {
+    r = buffer->flush(buffer);
+    buffer->len = 0;
+  }
+  return r;
 }
 /*---------------------------------------------------------------------------*/
 const char *
@@ -142,6 +263,13 @@ jsontree_print_next(struct jsontree_context *js_ctx)
   int indent;
 #endif
 
+  if(js_ctx->buffer != NULL) {
+    if(js_ctx->buffer->full) {
+      return 0;
+    }
+    active_buffer = js_ctx->buffer;
+  }
+
   v = js_ctx->values[js_ctx->depth];
 
   /* Default operation after switch is to back up one level */
@@ -153,46 +281,46 @@ jsontree_print_next(struct jsontree_context *js_ctx)
 
     index = js_ctx->index[js_ctx->depth];
     if(index == 0) {
-      js_ctx->putchar(v->type);
+      write_char(js_ctx, v->type);
 #if JSONTREE_PRETTY
-      js_ctx->putchar('\n');
+      write_char(js_ctx, '\n');
 #endif
     }
     if(index >= o->count) {
 #if JSONTREE_PRETTY
-      js_ctx->putchar('\n');
+      write_char(js_ctx, '\n');
       indent = js_ctx->depth;
       while (indent--) {
-        js_ctx->putchar(' ');
-        js_ctx->putchar(' ');
+        write_char(js_ctx, ' ');
+        write_char(js_ctx, ' ');
       }
 #endif
-      js_ctx->putchar(v->type + 2);
+      write_char(js_ctx, v->type + 2);
       /* Default operation: back up one level! */
       break;
     }
 
     if(index > 0) {
-      js_ctx->putchar(',');
+      write_char(js_ctx, ',');
 #if JSONTREE_PRETTY
-      js_ctx->putchar('\n');
+      write_char(js_ctx, '\n');
 #endif
     }
 
 #if JSONTREE_PRETTY
     indent = js_ctx->depth + 1;
     while (indent--) {
-      js_ctx->putchar(' ');
-      js_ctx->putchar(' ');
+      write_char(js_ctx, ' ');
+      write_char(js_ctx, ' ');
     }
 #endif
 
     if(v->type == JSON_TYPE_OBJECT) {
       jsontree_write_string(js_ctx,
                             ((struct jsontree_object *)o)->pairs[index].name);
-      js_ctx->putchar(':');
+      write_char(js_ctx, ':');
 #if JSONTREE_PRETTY
-      js_ctx->putchar(' ');
+      write_char(js_ctx, ' ');
 #endif
       ov = ((struct jsontree_object *)o)->pairs[index].value;
     } else {
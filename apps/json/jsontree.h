@@ -55,10 +55,34 @@
 #define JSONTREE_PRETTY 0
 #endif /* JSONTREE_CONF_PRETTY */
 
+/*
+ * A caller-provided output chunk. Output is copied into data[] in runs
+ * instead of going through putchar() a character at a time. When the
+ * chunk is full, flush() is called to pass it on (e.g. to http-socket
+ * or a TCP send buffer); if there is no flush() or it returns 0, the
+ * output stops and full is set. The first skip bytes of output are
+ * dropped, so a CoAP block2 handler can produce block n of a document
+ * with skip = n * size and a NULL flush(); full then means there are
+ * more blocks.
+ */
+struct jsontree_buffer {
+  char *data;
+  uint16_t size;
+  uint16_t len;
+  uint32_t skip;
+  uint32_t total;
+  int (* flush)(struct jsontree_buffer *buffer);
+  /* The putchar() of the context, restored by jsontree_reset() */
+  int (* putchar)(int);
+  void *ptr;
+  uint8_t full;
+};
+
 struct jsontree_context {
   struct jsontree_value *values[JSONTREE_MAX_DEPTH];
   uint16_t index[JSONTREE_MAX_DEPTH];
   int (* putchar)(int);
+  struct jsontree_buffer *buffer;
   uint8_t depth;
   uint8_t path;
   int callback_state;
@@ -143,12 +167,21 @@ void jsontree_setup(struct jsontree_context *js_ctx,
                     struct jsontree_value *root, int (* putchar)(int));
 void jsontree_reset(struct jsontree_context *js_ctx);
 
+void jsontree_buffer_init(struct jsontree_buffer *buffer, char *data,
+                          uint16_t size,
+                          int (* flush)(struct jsontree_buffer *buffer));
+void jsontree_set_buffer(struct jsontree_context *js_ctx,
+                         struct jsontree_buffer *buffer);
+int jsontree_buffer_flush(struct jsontree_buffer *buffer);
+
 const char *jsontree_path_name(const struct jsontree_context *js_ctx,
                                int depth);
 
 void jsontree_write_uint(const struct jsontree_context *js_ctx,
                          unsigned int value);
 void jsontree_write_int(const struct jsontree_context *js_ctx, int value);
+void jsontree_write_bytes(const struct jsontree_context *js_ctx,
+                          const char *data, int len);
 void jsontree_write_atom(const struct jsontree_context *js_ctx,
                          const char *text);
 void jsontree_write_string(const struct jsontree_context *js_ctx,
@@ -81,6 +81,48 @@
 #define ORCHESTRA_UNICAST_SENDER_BASED            0
 #endif /* ORCHESTRA_CONF_UNICAST_SENDER_BASED */
 
+/* Traffic-adaptive unicast slotframe (rule unicast_adaptive): maximum number
+ * of cells a node uses to transmit to its parent, in addition to its own
+ * sender-based cell. The extra cells are spread evenly over the
+ * ORCHESTRA_UNICAST_PERIOD-long slotframe. */
+#ifdef ORCHESTRA_CONF_UNICAST_MAX_EXTRA_CELLS
+#define ORCHESTRA_UNICAST_MAX_EXTRA_CELLS         ORCHESTRA_CONF_UNICAST_MAX_EXTRA_CELLS
+#else /* ORCHESTRA_CONF_UNICAST_MAX_EXTRA_CELLS */
+#define ORCHESTRA_UNICAST_MAX_EXTRA_CELLS         3
+#endif /* ORCHESTRA_CONF_UNICAST_MAX_EXTRA_CELLS */
+
+/* Rule unicast_adaptive: one extra cell is used per this many packets
+ * queued for the parent (peak backlog over an adaptation interval) */
+#ifdef ORCHESTRA_CONF_UNICAST_PACKETS_PER_CELL
+#define ORCHESTRA_UNICAST_PACKETS_PER_CELL        ORCHESTRA_CONF_UNICAST_PACKETS_PER_CELL
+#else /* ORCHESTRA_CONF_UNICAST_PACKETS_PER_CELL */
+#define ORCHESTRA_UNICAST_PACKETS_PER_CELL        2
+#endif /* ORCHESTRA_CONF_UNICAST_PACKETS_PER_CELL */
+
+/* Rule unicast_adaptive: how often the number of extra cells is
+ * re-evaluated. Cells are added at once, but removed one per interval. */
+#ifdef ORCHESTRA_CONF_UNICAST_ADAPT_INTERVAL
+#define ORCHESTRA_UNICAST_ADAPT_INTERVAL          ORCHESTRA_CONF_UNICAST_ADAPT_INTERVAL
+#else /* ORCHESTRA_CONF_UNICAST_ADAPT_INTERVAL */
+#define ORCHESTRA_UNICAST_ADAPT_INTERVAL          (8 * CLOCK_SECOND)
+#endif /* ORCHESTRA_CONF_UNICAST_ADAPT_INTERVAL */
+
+/* Rule unicast_adaptive: number of children whose extra cells we can
+ * listen to at the same time */
+#ifdef ORCHESTRA_CONF_UNICAST_MAX_BUSY_CHILDREN
+#define ORCHESTRA_UNICAST_MAX_BUSY_CHILDREN       ORCHESTRA_CONF_UNICAST_MAX_BUSY_CHILDREN
+#else /* ORCHESTRA_CONF_UNICAST_MAX_BUSY_CHILDREN */
+#define ORCHESTRA_UNICAST_MAX_BUSY_CHILDREN       4
+#endif /* ORCHESTRA_CONF_UNICAST_MAX_BUSY_CHILDREN */
+
+/* Do nodes also listen to the EBs of their RPL children? Needed by the
+ * unicast_adaptive rule, where children advertise their extra cells in EBs. */
+#ifdef ORCHESTRA_CONF_EBSF_RX_FROM_CHILDREN
+#define ORCHESTRA_EBSF_RX_FROM_CHILDREN           ORCHESTRA_CONF_EBSF_RX_FROM_CHILDREN
+#else /* ORCHESTRA_CONF_EBSF_RX_FROM_CHILDREN */
+#define ORCHESTRA_EBSF_RX_FROM_CHILDREN           0
+#endif /* ORCHESTRA_CONF_EBSF_RX_FROM_CHILDREN */
+
 /* The hash function used to assign timeslot to a given node (based on its link-layer address) */
 #ifdef ORCHESTRA_CONF_LINKADDR_HASH
 #define ORCHESTRA_LINKADDR_HASH                   ORCHESTRA_CONF_LINKADDR_HASH
@@ -33,12 +33,16 @@
  *         Orchestra: a slotframe dedicated to transmission of EBs.
  *         Nodes transmit at a timeslot defined as hash(MAC) % ORCHESTRA_EBSF_PERIOD
  *         Nodes listen at a timeslot defined as hash(time_source.MAC) % ORCHESTRA_EBSF_PERIOD
+ *         With ORCHESTRA_EBSF_RX_FROM_CHILDREN, nodes also listen at hash(child.MAC) % ORCHESTRA_EBSF_PERIOD
  * \author Simon Duquennoy <simonduq@sics.se>
  */
 
 #include "contiki.h"
 #include "orchestra.h"
 #include "net/packetbuf.h"
+#if ORCHESTRA_EBSF_RX_FROM_CHILDREN
+#include "net/ipv6/uip-ds6-route.h"
+#endif /* ORCHESTRA_EBSF_RX_FROM_CHILDREN */
 
 static uint16_t slotframe_handle = 0;
 static uint16_t channel_offset = 0;
@@ -71,38 +75,89 @@ select_packet(uint16_t *slotframe, uint16_t *timeslot)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+static uint8_t
+get_link_options(uint16_t timeslot, const linkaddr_t *time_source)
+{
+  uint8_t link_options = 0;
+  if(timeslot == get_node_timeslot(&linkaddr_node_addr)) {
+    /* Our own EB timeslot */
+    link_options |= LINK_OPTION_TX;
+  }
+  if(time_source != NULL && timeslot == get_node_timeslot(time_source)) {
+    /* Listen to the time source's EBs */
+    link_options |= LINK_OPTION_RX;
+  }
+#if ORCHESTRA_EBSF_RX_FROM_CHILDREN
+  if(!(link_options & LINK_OPTION_RX)) {
+    /* Listen to our children's EBs (lookup all route next hops) */
+    nbr_table_item_t *item = nbr_table_head(nbr_routes);
+    while(item != NULL) {
+      if(timeslot == get_node_timeslot(nbr_table_get_lladdr(nbr_routes, item))) {
+        link_options |= LINK_OPTION_RX;
+        break;
+      }
+      item = nbr_table_next(nbr_routes, item);
+    }
+  }
+#endif /* ORCHESTRA_EBSF_RX_FROM_CHILDREN */
+  return link_options;
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_link(uint16_t timeslot, const linkaddr_t *time_source)
+{
+  uint8_t link_options;
+  struct tsch_link *l;
+
+  if(timeslot == 0xffff) {
+    return;
+  }
+  link_options = get_link_options(timeslot, time_source);
+  l = tsch_schedule_get_link_by_timeslot(sf_eb, timeslot);
+  if(link_options == 0) {
+    if(l != NULL) {
+      /* Nobody needs this timeslot any longer */
+      tsch_schedule_remove_link(sf_eb, l);
+    }
+  } else if(l == NULL || l->link_options != link_options) {
+    /* Add/update link */
+    tsch_schedule_add_link(sf_eb, link_options, LINK_TYPE_ADVERTISING_ONLY,
+      &tsch_broadcast_address, timeslot, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
 static void
 new_time_source(const struct tsch_neighbor *old, const struct tsch_neighbor *new)
 {
+  const linkaddr_t *new_addr = new != NULL ? &new->addr : NULL;
   uint16_t old_ts = old != NULL ? get_node_timeslot(&old->addr) : 0xffff;
-  uint16_t new_ts = new != NULL ? get_node_timeslot(&new->addr) : 0xffff;
+  uint16_t new_ts = new_addr != NULL ? get_node_timeslot(new_addr) : 0xffff;
 
   if(new_ts == old_ts) {
     return;
   }
 
-  if(old_ts != 0xffff) {
-    /* Stop listening to the old time source's EBs */
-    if(old_ts == get_node_timeslot(&linkaddr_node_addr)) {
-      /* This was the same timeslot as slot. Reset original link options */
-      tsch_schedule_add_link(sf_eb, LINK_OPTION_TX, LINK_TYPE_ADVERTISING_ONLY,
-        &tsch_broadcast_address, old_ts, 0);
-    } else {
-      /* Remove slot */
-      tsch_schedule_remove_link_by_timeslot(sf_eb, old_ts);
-    }
-  }
-  if(new_ts != 0xffff) {
-    uint8_t link_options = LINK_OPTION_RX;
-    if(new_ts == get_node_timeslot(&linkaddr_node_addr)) {
-      /* This is also our timeslot, add necessary flags */
-      link_options |= LINK_OPTION_TX;
-    }
-    /* Listen to the time source's EBs */
-    tsch_schedule_add_link(sf_eb, link_options, LINK_TYPE_ADVERTISING_ONLY,
-      &tsch_broadcast_address, new_ts, 0);
-  }
+  /* Stop listening to the old time source's EBs, listen to the new one's */
+  update_link(old_ts, new_addr);
+  update_link(new_ts, new_addr);
 }
+#if ORCHESTRA_EBSF_RX_FROM_CHILDREN
+/*---------------------------------------------------------------------------*/
+static void
+child_added(const linkaddr_t *addr)
+{
+  struct tsch_neighbor *n = tsch_queue_get_time_source();
+  update_link(get_node_timeslot(addr), n != NULL ? &n->addr : NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_removed(const linkaddr_t *addr)
+{
+  /* Called once the child is no longer in nbr_routes */
+  struct tsch_neighbor *n = tsch_queue_get_time_source();
+  update_link(get_node_timeslot(addr), n != NULL ? &n->addr : NULL);
+}
+#endif /* ORCHESTRA_EBSF_RX_FROM_CHILDREN */
 /*---------------------------------------------------------------------------*/
 static void
 init(uint16_t sf_handle)
@@ -121,6 +176,13 @@ struct orchestra_rule eb_per_time_source = {
   init,
   new_time_source,
   select_packet,
+#if ORCHESTRA_EBSF_RX_FROM_CHILDREN
+  child_added,
+  child_removed,
+#else /* ORCHESTRA_EBSF_RX_FROM_CHILDREN */
+  NULL,
+  NULL,
+#endif /* ORCHESTRA_EBSF_RX_FROM_CHILDREN */
   NULL,
   NULL,
 };
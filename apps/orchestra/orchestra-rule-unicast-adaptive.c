@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+/**
+ * \file
+ *         Orchestra: a traffic-adaptive, sender-based slotframe for unicast
+ *         data transmission.
+ *           Each node owns 1 + ORCHESTRA_UNICAST_MAX_EXTRA_CELLS cells, the
+ *           i-th one at (hash(MAC) + i * CELL_STRIDE) % ORCHESTRA_UNICAST_PERIOD.
+ *           Nodes always transmit in their first cell. Depending on the
+ *           backlog of packets queued for their parent, they also want some
+ *           of their extra cells, and advertise how many in their EBs.
+ *           Nodes listen at the first cell of their RPL preferred parent, and
+ *           at the first and advertised extra cells of their RPL children.
+ *           As EBs are not acknowledged, parents echo in their own EBs how
+ *           many extra cells they listen to for one of their busy children
+ *           (in turns), and nodes only transmit in extra cells their parent
+ *           has confirmed this way.
+ *         Requires ORCHESTRA_EBSF_RX_FROM_CHILDREN, so that parents hear
+ *         their children's EBs.
+ */
+
+#include "contiki.h"
+#include "orchestra.h"
+#include "net/ipv6/uip-ds6-route.h"
+#include "net/packetbuf.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include <string.h>
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+#if ORCHESTRA_COLLISION_FREE_HASH
+#define UNICAST_SLOT_SHARED_FLAG    ((ORCHESTRA_UNICAST_PERIOD < (ORCHESTRA_MAX_HASH + 1)) ? LINK_OPTION_SHARED : 0)
+#else
+#define UNICAST_SLOT_SHARED_FLAG      LINK_OPTION_SHARED
+#endif
+
+/* Distance between two consecutive cells of a node */
+#define CELL_STRIDE (ORCHESTRA_UNICAST_PERIOD / (ORCHESTRA_UNICAST_MAX_EXTRA_CELLS + 1))
+#if ORCHESTRA_UNICAST_MAX_EXTRA_CELLS > 0 && CELL_STRIDE == 0
+#error "ORCHESTRA_UNICAST_PERIOD too short for ORCHESTRA_UNICAST_MAX_EXTRA_CELLS"
+#endif
+#if ORCHESTRA_UNICAST_MAX_EXTRA_CELLS > 0x0f
+#error "ORCHESTRA_UNICAST_MAX_EXTRA_CELLS must fit in 4 bits"
+#endif
+
+/* Our vendor-specific EB IE:
+ * byte 0: EB_IE_EXTRA_CELLS in the high nibble, the number of extra cells
+ *         we want in the low nibble,
+ * bytes 1-2 (optional): short address of a child we listen to,
+ * byte 3 (optional): number of its extra cells we listen to. */
+#define EB_IE_EXTRA_CELLS 0x1
+#define EB_IE_LEN         1
+#define EB_IE_CONFIRM_LEN 4
+
+static uint16_t slotframe_handle = 0;
+static uint16_t channel_offset = 0;
+static struct tsch_slotframe *sf_unicast;
+
+/* Number of extra cells we want (advertised in EBs), that our parent has
+ * confirmed listening to, and that we actually use */
+static uint8_t extra_cells;
+static uint8_t confirmed_cells;
+static uint8_t tx_cells;
+/* The busy child whose extra cells we confirm in our next EB */
+static uint8_t confirm_index;
+/* Peak backlog to our parent since the last adaptation */
+static uint8_t max_backlog;
+static struct ctimer adapt_timer;
+
+/* Extra cells in use by our children, as advertised in their EBs */
+struct child_cells {
+  struct child_cells *next;
+  linkaddr_t addr;
+  uint8_t extra;
+};
+MEMB(child_cells_memb, struct child_cells, ORCHESTRA_UNICAST_MAX_BUSY_CHILDREN);
+LIST(child_cells_list);
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+get_node_timeslot(const linkaddr_t *addr, uint8_t cell)
+{
+  if(addr != NULL && ORCHESTRA_UNICAST_PERIOD > 0) {
+    return (ORCHESTRA_LINKADDR_HASH(addr) + cell * CELL_STRIDE) % ORCHESTRA_UNICAST_PERIOD;
+  } else {
+    return 0xffff;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+short_addr(const linkaddr_t *addr)
+{
+  return (addr->u8[LINKADDR_SIZE - 2] << 8) | addr->u8[LINKADDR_SIZE - 1];
+}
+/*---------------------------------------------------------------------------*/
+static struct child_cells *
+child_cells_lookup(const linkaddr_t *addr)
+{
+  struct child_cells *c;
+  for(c = list_head(child_cells_list); c != NULL; c = list_item_next(c)) {
+    if(linkaddr_cmp(&c->addr, addr)) {
+      return c;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_cells_remove(const linkaddr_t *addr)
+{
+  struct child_cells *c = child_cells_lookup(addr);
+  if(c != NULL) {
+    list_remove(child_cells_list, c);
+    memb_free(&child_cells_memb, c);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+get_child_extra_cells(const linkaddr_t *addr)
+{
+  struct child_cells *c = child_cells_lookup(addr);
+  return c != NULL ? c->extra : 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+neighbor_has_uc_link(const linkaddr_t *linkaddr)
+{
+  if(linkaddr != NULL && !linkaddr_cmp(linkaddr, &linkaddr_null)) {
+    if(orchestra_parent_knows_us
+       && linkaddr_cmp(&orchestra_parent_linkaddr, linkaddr)) {
+      return 1;
+    }
+    if(nbr_table_get_from_lladdr(nbr_routes, (linkaddr_t *)linkaddr) != NULL) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Compute the link options of every timeslot from our current state and
+ * only touch the links that changed */
+static void
+update_links(void)
+{
+  static uint8_t options[ORCHESTRA_UNICAST_PERIOD];
+  nbr_table_item_t *item;
+  uint16_t timeslot;
+  uint8_t i;
+
+  memset(options, 0, sizeof(options));
+
+  /* Our own cells */
+  for(i = 0; i <= tx_cells; i++) {
+    options[get_node_timeslot(&linkaddr_node_addr, i)] |= LINK_OPTION_TX | UNICAST_SLOT_SHARED_FLAG;
+  }
+  /* Our parent sends to us in its first cell */
+  if(!linkaddr_cmp(&orchestra_parent_linkaddr, &linkaddr_null)) {
+    options[get_node_timeslot(&orchestra_parent_linkaddr, 0)] |= LINK_OPTION_RX;
+  }
+  /* Our children send to us in their first and extra cells
+   * (lookup all route next hops) */
+  item = nbr_table_head(nbr_routes);
+  while(item != NULL) {
+    linkaddr_t *addr = nbr_table_get_lladdr(nbr_routes, item);
+    uint8_t extra = get_child_extra_cells(addr);
+    for(i = 0; i <= extra; i++) {
+      options[get_node_timeslot(addr, i)] |= LINK_OPTION_RX;
+    }
+    item = nbr_table_next(nbr_routes, item);
+  }
+
+  for(timeslot = 0; timeslot < ORCHESTRA_UNICAST_PERIOD; timeslot++) {
+    struct tsch_link *l = tsch_schedule_get_link_by_timeslot(sf_unicast, timeslot);
+    if(options[timeslot] == 0) {
+      if(l != NULL) {
+        tsch_schedule_remove_link(sf_unicast, l);
+      }
+    } else if(l == NULL || l->link_options != options[timeslot]) {
+      /* Add/update link */
+      tsch_schedule_add_link(sf_unicast, options[timeslot], LINK_TYPE_NORMAL, &tsch_broadcast_address,
+            timeslot, channel_offset);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+adapt(void *ptr)
+{
+  uint8_t wanted = max_backlog / ORCHESTRA_UNICAST_PACKETS_PER_CELL;
+  if(wanted > ORCHESTRA_UNICAST_MAX_EXTRA_CELLS) {
+    wanted = ORCHESTRA_UNICAST_MAX_EXTRA_CELLS;
+  }
+
+  /* Grow at once, shrink slowly to absorb bursts */
+  if(wanted > extra_cells) {
+    extra_cells = wanted;
+  } else if(wanted < extra_cells) {
+    extra_cells--;
+  }
+
+  /* Stop using cells before advertising that we no longer want them,
+   * our parent may stop listening to them any time from now on */
+  confirmed_cells = MIN(confirmed_cells, extra_cells);
+  if(tx_cells != confirmed_cells) {
+    tx_cells = confirmed_cells;
+    PRINTF("Orchestra: %u extra cells to parent\n", tx_cells);
+  }
+  max_backlog = 0;
+  update_links();
+
+  ctimer_reset(&adapt_timer);
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_added(const linkaddr_t *linkaddr)
+{
+  update_links();
+}
+/*---------------------------------------------------------------------------*/
+static void
+child_removed(const linkaddr_t *linkaddr)
+{
+  /* Called once the child is no longer in nbr_routes */
+  child_cells_remove(linkaddr);
+  update_links();
+}
+/*---------------------------------------------------------------------------*/
+static void
+eb_create(struct ieee802154_ies *ies)
+{
+  struct child_cells *c;
+  uint8_t i;
+
+  if(ORCHESTRA_UNICAST_MAX_EXTRA_CELLS == 0
+     || FRAME802154E_IE_MAX_VENDOR_LEN < EB_IE_CONFIRM_LEN) {
+    return;
+  }
+
+  ies->ie_vendor_data[0] = (EB_IE_EXTRA_CELLS << 4) | extra_cells;
+  ies->ie_vendor_len = EB_IE_LEN;
+
+  /* Confirm the extra cells of our busy children in turns */
+  c = list_head(child_cells_list);
+  for(i = 0; c != NULL && i < confirm_index; i++) {
+    c = list_item_next(c);
+  }
+  if(c == NULL) {
+    c = list_head(child_cells_list);
+  }
+  if(c != NULL) {
+    uint16_t addr = short_addr(&c->addr);
+    ies->ie_vendor_data[1] = addr >> 8;
+    ies->ie_vendor_data[2] = addr & 0xff;
+    ies->ie_vendor_data[3] = c->extra;
+    ies->ie_vendor_len = EB_IE_CONFIRM_LEN;
+    confirm_index = list_item_next(c) != NULL ? i + 1 : 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+confirmation_received(uint8_t extra)
+{
+  /* Our parent listens to this many of our extra cells */
+  confirmed_cells = MIN(extra, extra_cells);
+  if(tx_cells != confirmed_cells) {
+    tx_cells = confirmed_cells;
+    PRINTF("Orchestra: %u extra cells to parent\n", tx_cells);
+    update_links();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+eb_received(const linkaddr_t *src, const struct ieee802154_ies *ies)
+{
+  struct child_cells *c;
+  uint8_t extra;
+
+  if(ies->ie_vendor_len < EB_IE_LEN
+     || (ies->ie_vendor_data[0] >> 4) != EB_IE_EXTRA_CELLS) {
+    return;
+  }
+
+  if(ies->ie_vendor_len >= EB_IE_CONFIRM_LEN
+     && linkaddr_cmp(&orchestra_parent_linkaddr, src)
+     && ((ies->ie_vendor_data[1] << 8) | ies->ie_vendor_data[2])
+        == short_addr(&linkaddr_node_addr)) {
+    confirmation_received(ies->ie_vendor_data[3]);
+  }
+
+  extra = MIN(ies->ie_vendor_data[0] & 0x0f, ORCHESTRA_UNICAST_MAX_EXTRA_CELLS);
+  c = child_cells_lookup(src);
+  if(extra == 0 || nbr_table_get_from_lladdr(nbr_routes, (linkaddr_t *)src) == NULL) {
+    /* Not (or no longer) a busy child */
+    if(c == NULL) {
+      return;
+    }
+    child_cells_remove(src);
+  } else if(c != NULL) {
+    if(c->extra == extra) {
+      return;
+    }
+    c->extra = extra;
+  } else {
+    c = memb_alloc(&child_cells_memb);
+    if(c == NULL) {
+      PRINTF("Orchestra: no room for extra cells of busy child\n");
+      return;
+    }
+    linkaddr_copy(&c->addr, src);
+    c->extra = extra;
+    list_add(child_cells_list, c);
+  }
+  update_links();
+}
+/*---------------------------------------------------------------------------*/
+static int
+select_packet(uint16_t *slotframe, uint16_t *timeslot)
+{
+  /* Select data packets we have a unicast link to */
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  if(packetbuf_attr(PACKETBUF_ATTR_FRAME_TYPE) == FRAME802154_DATAFRAME
+     && neighbor_has_uc_link(dest)) {
+    if(slotframe != NULL) {
+      *slotframe = slotframe_handle;
+    }
+    if(linkaddr_cmp(&orchestra_parent_linkaddr, dest)) {
+      /* Keep track of our backlog to the parent, this packet included */
+      int backlog = tsch_queue_packet_count(dest) + 1;
+      if(backlog > max_backlog) {
+        max_backlog = MIN(backlog, 0xff);
+      }
+      /* Any of our cells will do */
+      if(timeslot != NULL) {
+        *timeslot = 0xffff;
+      }
+    } else if(timeslot != NULL) {
+      *timeslot = get_node_timeslot(&linkaddr_node_addr, 0);
+    }
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+new_time_source(const struct tsch_neighbor *old, const struct tsch_neighbor *new)
+{
+  if(new != old) {
+    const linkaddr_t *new_addr = new != NULL ? &new->addr : NULL;
+    if(new_addr != NULL) {
+      linkaddr_copy(&orchestra_parent_linkaddr, new_addr);
+    } else {
+      linkaddr_copy(&orchestra_parent_linkaddr, &linkaddr_null);
+    }
+    /* The new parent does not know about our extra cells yet */
+    confirmed_cells = 0;
+    tx_cells = 0;
+    update_links();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(uint16_t sf_handle)
+{
+  slotframe_handle = sf_handle;
+  channel_offset = sf_handle;
+  memb_init(&child_cells_memb);
+  list_init(child_cells_list);
+  /* Slotframe for unicast transmissions */
+  sf_unicast = tsch_schedule_add_slotframe(slotframe_handle, ORCHESTRA_UNICAST_PERIOD);
+  update_links();
+  ctimer_set(&adapt_timer, ORCHESTRA_UNICAST_ADAPT_INTERVAL, adapt, NULL);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+orchestra_unicast_adaptive_num_tx_cells(void)
+{
+  return tx_cells;
+}
+/*---------------------------------------------------------------------------*/
+struct orchestra_rule unicast_adaptive = {
+  init,
+  new_time_source,
+  select_packet,
+  child_added,
+  child_removed,
+  eb_create,
+  eb_received,
+};
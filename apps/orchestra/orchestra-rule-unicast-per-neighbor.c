@@ -208,4 +208,6 @@ struct orchestra_rule unicast_per_neighbor = {
   select_packet,
   child_added,
   child_removed,
+  NULL,
+  NULL,
 };
@@ -106,6 +106,30 @@ orchestra_callback_child_removed(const linkaddr_t *addr)
 }
 /*---------------------------------------------------------------------------*/
 void
+orchestra_callback_eb_create(struct ieee802154_ies *ies)
+{
+  /* Let the rules add their information to the EB */
+  int i;
+  for(i = 0; i < NUM_RULES; i++) {
+    if(all_rules[i]->eb_create != NULL) {
+      all_rules[i]->eb_create(ies);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+orchestra_callback_eb_received(const linkaddr_t *src, const struct ieee802154_ies *ies)
+{
+  /* Notify all Orchestra rules that an EB was received */
+  int i;
+  for(i = 0; i < NUM_RULES; i++) {
+    if(all_rules[i]->eb_received != NULL) {
+      all_rules[i]->eb_received(src, ies);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
 orchestra_callback_packet_ready(void)
 {
   int i;
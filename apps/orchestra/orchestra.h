@@ -41,6 +41,7 @@
 #include "net/mac/tsch/tsch.h"
 #include "net/mac/tsch/tsch-conf.h"
 #include "net/mac/tsch/tsch-schedule.h"
+#include "net/mac/frame802154e-ie.h"
 #include "orchestra-conf.h"
 
 /* The structure of an Orchestra rule */
@@ -50,10 +51,13 @@ struct orchestra_rule {
   int  (* select_packet)(uint16_t *slotframe, uint16_t *timeslot);
   void (* child_added)(const linkaddr_t *addr);
   void (* child_removed)(const linkaddr_t *addr);
+  void (* eb_create)(struct ieee802154_ies *ies);
+  void (* eb_received)(const linkaddr_t *src, const struct ieee802154_ies *ies);
 };
 
 struct orchestra_rule eb_per_time_source;
 struct orchestra_rule unicast_per_neighbor;
+struct orchestra_rule unicast_adaptive;
 struct orchestra_rule default_common;
 
 extern linkaddr_t orchestra_parent_linkaddr;
@@ -70,5 +74,12 @@ void orchestra_callback_new_time_source(const struct tsch_neighbor *old, const s
 void orchestra_callback_child_added(const linkaddr_t *addr);
 /* Set with #define NETSTACK_CONF_ROUTING_NEIGHBOR_REMOVED_CALLBACK orchestra_callback_child_removed */
 void orchestra_callback_child_removed(const linkaddr_t *addr);
+/* Set with #define TSCH_CALLBACK_EB_CREATE orchestra_callback_eb_create */
+void orchestra_callback_eb_create(struct ieee802154_ies *ies);
+/* Set with #define TSCH_CALLBACK_EB_RECEIVED orchestra_callback_eb_received */
+void orchestra_callback_eb_received(const linkaddr_t *src, const struct ieee802154_ies *ies);
+
+/* Rule unicast_adaptive: number of extra cells in use to our parent */
+uint8_t orchestra_unicast_adaptive_num_tx_cells(void);
 
 #endif /* __ORCHESTRA_H__ */
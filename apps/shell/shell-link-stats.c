@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Contiki shell command that dumps the link statistics
+ */
+
+#include "contiki.h"
+#include "shell.h"
+#include "net/link-stats.h"
+
+#include <stdio.h>
+
+#define BUFLEN 80
+
+/*---------------------------------------------------------------------------*/
+PROCESS(shell_link_stats_process, "link-stats");
+SHELL_COMMAND(link_stats_command,
+	      "link-stats",
+	      "link-stats: show the link statistics of all neighbors",
+	      &shell_link_stats_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(shell_link_stats_process, ev, data)
+{
+  char buf[BUFLEN];
+  const struct link_stats *stats;
+  const linkaddr_t *lladdr;
+  clock_time_t now;
+
+  PROCESS_BEGIN();
+
+  now = clock_time();
+  shell_output_str(&link_stats_command,
+                   "neighbor etx/128 rssi lqi fresh tx ack rx last-rx(s)", "");
+  for(stats = link_stats_head(); stats != NULL;
+      stats = link_stats_next(stats)) {
+    lladdr = link_stats_get_lladdr(stats);
+    snprintf(buf, BUFLEN, "%u.%u %u %d %u %c %u %u %u %lu",
+             lladdr->u8[LINKADDR_SIZE - 2], lladdr->u8[LINKADDR_SIZE - 1],
+             stats->etx, stats->rssi, stats->lqi,
+             link_stats_is_fresh(stats) ? 'y' : 'n',
+             stats->tx_count, stats->ack_count, stats->rx_count,
+             stats->rx_count == 0 ? 0UL :
+             (unsigned long)((now - stats->last_rx_time) / CLOCK_SECOND));
+    shell_output_str(&link_stats_command, buf, "");
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+shell_link_stats_init(void)
+{
+  shell_register_command(&link_stats_command);
+}
+/*---------------------------------------------------------------------------*/
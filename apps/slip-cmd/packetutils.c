@@ -29,6 +29,8 @@
 
 #include "contiki.h"
 #include "net/packetbuf.h"
+#include "lib/crc16.h"
+#include "packetutils.h"
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
 
@@ -88,3 +90,29 @@ packetutils_deserialize_atts(const uint8_t *data, int size)
   return pos;
 }
 /*---------------------------------------------------------------------------*/
+/* Append the CRC of the len first bytes of a batch to it. */
+void
+packetutils_batch_add_crc(uint8_t *data, int len)
+{
+  unsigned short crc;
+
+  crc = crc16_data(data, len, 0);
+  data[len] = crc >> 8;
+  data[len + 1] = crc & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns non-zero if the CRC at the end of a batch of len bytes,
+   CRC included, is correct. */
+int
+packetutils_batch_check_crc(const uint8_t *data, int len)
+{
+  unsigned short crc;
+
+  if(len < PACKETUTILS_BATCH_HDR_LEN + PACKETUTILS_BATCH_CRC_LEN) {
+    return 0;
+  }
+  len -= PACKETUTILS_BATCH_CRC_LEN;
+  crc = crc16_data(data, len, 0);
+  return data[len] == (crc >> 8) && data[len + 1] == (crc & 0xff);
+}
+/*---------------------------------------------------------------------------*/
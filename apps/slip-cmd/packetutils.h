@@ -34,4 +34,30 @@ int packetutils_serialize_atts(uint8_t *data, int size);
 
 int packetutils_deserialize_atts(const uint8_t *data, int size);
 
+/*
+ * Windowed slip-radio protocol. The host asks for the window with
+ * "?W" and a radio that supports it answers
+ *
+ *   !W <window> <mtu high> <mtu low>
+ *
+ * where window is the number of frames the radio can have outstanding
+ * and mtu the largest command it can receive. The host then sends
+ * frames in batches,
+ *
+ *   !B <count> { <sid> <length high> <length low> <atts + frame> } * count
+ *      <crc high> <crc low>
+ *
+ * protected by a CRC-16 over everything before the CRC. Each frame is
+ * acknowledged with the usual "!R <sid> <status> <tx>", which also
+ * returns its window slot to the host. Radios that do not answer "?W"
+ * keep being driven with "!S" commands.
+ */
+#define PACKETUTILS_BATCH_HDR_LEN       3
+#define PACKETUTILS_BATCH_FRAME_HDR_LEN 3
+#define PACKETUTILS_BATCH_CRC_LEN       2
+
+void packetutils_batch_add_crc(uint8_t *data, int len);
+
+int packetutils_batch_check_crc(const uint8_t *data, int len);
+
 #endif /* PACKETUTILS_H_ */
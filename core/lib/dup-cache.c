@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup dup-cache
+ * @{
+ */
+
+/**
+ * \file
+ *         Duplicate detection cache, built from one Bloom filter per
+ *         generation
+ *
+ *         Generations are aged lazily, when the cache is used, so a
+ *         cache needs no timer and costs nothing while idle.
+ */
+
+#include <string.h>
+#include "lib/dup-cache.h"
+
+#define GENERATION(c, g) (&(c)->bits[(g) * ((c)->size / 8)])
+/*---------------------------------------------------------------------------*/
+/* Retire generations whose lifetime has run out */
+static void
+age(struct dup_cache *c)
+{
+  clock_time_t elapsed;
+  uint8_t n;
+
+  elapsed = clock_time() - c->start;
+  if(elapsed < c->lifetime) {
+    return;
+  }
+
+  if(elapsed / c->lifetime >= c->generations) {
+    /* Everything has expired */
+    memset(c->bits, 0, c->size / 8 * c->generations);
+    c->start = clock_time();
+    c->stats.rotations += c->generations;
+  } else {
+    for(n = elapsed / c->lifetime; n > 0; n--) {
+      c->current = (c->current + 1) % c->generations;
+      memset(GENERATION(c, c->current), 0, c->size / 8);
+      c->start += c->lifetime;
+      c->stats.rotations++;
+    }
+  }
+  c->fill = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+dup_cache_init(struct dup_cache *c)
+{
+  memset(c->bits, 0, c->size / 8 * c->generations);
+  memset(&c->stats, 0, sizeof(c->stats));
+  c->current = 0;
+  c->fill = 0;
+  c->start = clock_time();
+}
+/*---------------------------------------------------------------------------*/
+/* FNV-1a */
+uint32_t
+dup_cache_hash(uint32_t hash, const void *data, uint16_t len)
+{
+  const uint8_t *p = data;
+
+  while(len-- > 0) {
+    hash ^= *p++;
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The bit positions come from double hashing: h1 + i * h2, with the two
+ * halves of the hash. h2 is odd, so the positions are distinct
+ */
+int
+dup_cache_lookup(struct dup_cache *c, uint32_t hash)
+{
+  uint16_t h1, h2, bit;
+  uint8_t g, i;
+  uint8_t *gen;
+
+  age(c);
+  c->stats.lookups++;
+
+  h1 = (uint16_t)hash;
+  h2 = (uint16_t)(hash >> 16) | 1;
+  for(g = 0; g < c->generations; g++) {
+    gen = GENERATION(c, g);
+    for(i = 0, bit = h1; i < DUP_CACHE_HASHES; i++, bit += h2) {
+      bit &= c->size - 1;
+      if(!(gen[bit >> 3] & (1 << (bit & 7)))) {
+        break;
+      }
+    }
+    if(i == DUP_CACHE_HASHES) {
+      c->stats.hits++;
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+dup_cache_add(struct dup_cache *c, uint32_t hash)
+{
+  uint16_t h1, h2, bit;
+  uint8_t i;
+  uint8_t *gen;
+
+  age(c);
+
+  /* Past half full the false positive rate climbs fast, move on */
+  if(c->fill >= c->size / 2) {
+    c->current = (c->current + 1) % c->generations;
+    memset(GENERATION(c, c->current), 0, c->size / 8);
+    c->start = clock_time();
+    c->fill = 0;
+    c->stats.overflows++;
+  }
+
+  c->stats.inserts++;
+
+  gen = GENERATION(c, c->current);
+  h1 = (uint16_t)hash;
+  h2 = (uint16_t)(hash >> 16) | 1;
+  for(i = 0, bit = h1; i < DUP_CACHE_HASHES; i++, bit += h2) {
+    bit &= c->size - 1;
+    if(!(gen[bit >> 3] & (1 << (bit & 7)))) {
+      gen[bit >> 3] |= 1 << (bit & 7);
+      c->fill++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+dup_cache_check(struct dup_cache *c, uint32_t hash)
+{
+  if(dup_cache_lookup(c, hash)) {
+    return 1;
+  }
+  dup_cache_add(c, hash);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * A new key hits a generation with probability (set bits / size) ^ hashes,
+ * and misses the cache only if it misses every generation
+ */
+uint16_t
+dup_cache_false_positive_rate(struct dup_cache *c)
+{
+  uint32_t miss, p, pk;
+  uint16_t set, j;
+  uint8_t g, i, byte;
+  uint8_t *gen;
+
+  age(c);
+
+  miss = 1000;
+  for(g = 0; g < c->generations; g++) {
+    gen = GENERATION(c, g);
+    set = 0;
+    for(j = 0; j < c->size / 8; j++) {
+      for(byte = gen[j]; byte != 0; byte &= byte - 1) {
+        set++;
+      }
+    }
+    p = (uint32_t)set * 1000 / c->size;
+    pk = 1000;
+    for(i = 0; i < DUP_CACHE_HASHES; i++) {
+      pk = pk * p / 1000;
+    }
+    miss = miss * (1000 - pk) / 1000;
+  }
+  return 1000 - miss;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
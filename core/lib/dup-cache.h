@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         Header file for the duplicate detection cache
+ */
+
+/** \addtogroup lib
+ * @{ */
+
+/**
+ * \defgroup dup-cache Duplicate detection cache
+ * @{
+ *
+ *         A duplicate cache remembers which packets have been seen
+ *         recently, keyed by a hash of whatever identifies a packet
+ *         (originator and sequence number, or the packet contents).
+ *         It is a set of Bloom filters, one per generation. New keys
+ *         go into the current generation. A lookup checks all of
+ *         them. When a generation's lifetime is up, or when it has
+ *         filled half of its bits, the oldest generation is cleared
+ *         and becomes the current one. Keys are thus forgotten after
+ *         between (generations - 1) and generations lifetimes.
+ *
+ *         Lookups can return false positives, but never false
+ *         negatives for keys younger than that. The memory cost is
+ *         bits / 8 * generations bytes per cache.
+ *
+ *         Netflood keys its cache on the originator and sequence
+ *         number of a flood. SMRF, whose datagrams have no sequence
+ *         number, can key one on the datagram contents.
+ */
+
+#ifndef DUP_CACHE_H_
+#define DUP_CACHE_H_
+
+#include "contiki-conf.h"
+#include "sys/cc.h"
+#include "sys/clock.h"
+
+/* Number of bit positions each key sets and tests */
+#ifdef DUP_CACHE_CONF_HASHES
+#define DUP_CACHE_HASHES DUP_CACHE_CONF_HASHES
+#else
+#define DUP_CACHE_HASHES 3
+#endif
+
+/* Initial value for dup_cache_hash() */
+#define DUP_CACHE_HASH_INIT 2166136261UL
+
+struct dup_cache_stats {
+  uint32_t lookups;
+  uint32_t hits;          /* Lookups that found the key, false positives included */
+  uint32_t inserts;
+  uint16_t rotations;     /* Generations retired because their lifetime ran out */
+  uint16_t overflows;     /* Generations retired early because they filled up */
+};
+
+struct dup_cache {
+  uint8_t *bits;
+  uint16_t size;          /* Bits per generation, a power of two */
+  uint8_t generations;
+  clock_time_t lifetime;  /* Lifetime of one generation */
+  uint8_t current;
+  uint16_t fill;          /* Bits set in the current generation */
+  clock_time_t start;     /* When the current generation started */
+  struct dup_cache_stats stats;
+};
+
+/**
+ * \brief Declare a duplicate cache
+ * \param name The name of the cache
+ * \param nbits Bits per generation, a power of two of at least 8
+ * \param ngenerations Number of generations, at least 2
+ * \param genlifetime Lifetime of one generation, in clock ticks
+ *
+ * The cache starts out empty and needs no initialization.
+ */
+#define DUP_CACHE(name, nbits, ngenerations, genlifetime)               \
+  static uint8_t CC_CONCAT(name,_dup_cache_bits)[(nbits) / 8 * (ngenerations)]; \
+  static struct dup_cache name = { CC_CONCAT(name,_dup_cache_bits),    \
+                                   (nbits), (ngenerations), (genlifetime) }
+
+/**
+ * \brief Forget all keys and reset the statistics
+ * \param c The cache
+ */
+void dup_cache_init(struct dup_cache *c);
+
+/**
+ * \brief Hash a key, or add more bytes to a key's hash
+ * \param hash DUP_CACHE_HASH_INIT, or the hash of the previous part of the key
+ * \param data The key bytes
+ * \param len Number of bytes
+ * \return The hash to pass on to the other functions
+ */
+uint32_t dup_cache_hash(uint32_t hash, const void *data, uint16_t len);
+
+/**
+ * \brief Has this key been seen?
+ * \param c The cache
+ * \param hash The key's hash
+ * \retval 1 The key is in the cache, or this is a false positive
+ * \retval 0 The key is not in the cache
+ */
+int dup_cache_lookup(struct dup_cache *c, uint32_t hash);
+
+/**
+ * \brief Remember a key
+ * \param c The cache
+ * \param hash The key's hash
+ */
+void dup_cache_add(struct dup_cache *c, uint32_t hash);
+
+/**
+ * \brief Look up a key and remember it if it was not there
+ * \param c The cache
+ * \param hash The key's hash
+ * \retval 1 The key was seen before: a duplicate
+ * \retval 0 The key is new and has now been added
+ */
+int dup_cache_check(struct dup_cache *c, uint32_t hash);
+
+/**
+ * \brief Estimate the current false positive rate
+ * \param c The cache
+ * \return The probability, in per mille, that a lookup of a new key hits
+ *
+ * This counts the bits set in all generations and is meant for
+ * statistics, not for the packet path.
+ */
+uint16_t dup_cache_false_positive_rate(struct dup_cache *c);
+
+#endif /* DUP_CACHE_H_ */
+
+/** @} */
+/** @} */
@@ -274,6 +274,13 @@ fire(void *ptr)
      */
     PRINTF("trickle_timer fire: Suppression Status %u (%u < %u)\n",
            TRICKLE_TIMER_PROTO_TX_ALLOW(loctt), loctt->c, loctt->k);
+#if TRICKLE_TIMER_STATS
+    if(TRICKLE_TIMER_PROTO_TX_ALLOW(loctt)) {
+      loctt->tx++;
+    } else {
+      loctt->suppressed++;
+    }
+#endif /* TRICKLE_TIMER_STATS */
     loctt->cb(loctt->cb_arg, TRICKLE_TIMER_PROTO_TX_ALLOW(loctt));
   }
 
@@ -321,11 +328,40 @@ trickle_timer_inconsistency(struct trickle_timer *tt)
   if(tt->i_cur != tt->i_min) {
     PRINTF("trickle_timer inconsistency\n");
     tt->i_cur = tt->i_min;
+#if TRICKLE_TIMER_STATS
+    tt->resets++;
+#endif /* TRICKLE_TIMER_STATS */
 
     new_interval(tt);
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+trickle_timer_set_density(struct trickle_timer *tt, uint16_t density)
+{
+  uint16_t k;
+
+  if(tt->k_max == TRICKLE_TIMER_INFINITE_REDUNDANCY) {
+    return;
+  }
+
+  k = tt->k_max;
+  if(density > TRICKLE_TIMER_ADAPTIVE_DENSITY) {
+    k = ((uint32_t)k * TRICKLE_TIMER_ADAPTIVE_DENSITY + density - 1) / density;
+    if(k < TRICKLE_TIMER_ADAPTIVE_K_MIN) {
+      k = TRICKLE_TIMER_ADAPTIVE_K_MIN;
+    }
+    if(k > tt->k_max) {
+      k = tt->k_max;
+    }
+  }
+
+  if(k != tt->k) {
+    PRINTF("trickle_timer density: %u neighbors, k=%u\n", density, k);
+    tt->k = k;
+  }
+}
+/*---------------------------------------------------------------------------*/
 uint8_t
 trickle_timer_config(struct trickle_timer *tt, clock_time_t i_min,
                      uint8_t i_max, uint8_t k)
@@ -341,7 +377,7 @@ trickle_timer_config(struct trickle_timer *tt, clock_time_t i_min,
     return TRICKLE_TIMER_ERROR;
   }
 
-  if(tt == NULL || i_max == 0 || k == 0) {
+  if(tt == NULL || i_max == 0) {
     PRINTF("trickle_timer config: Bad arguments\n");
     return TRICKLE_TIMER_ERROR;
   }
@@ -366,6 +402,7 @@ trickle_timer_config(struct trickle_timer *tt, clock_time_t i_min,
   tt->i_max = i_max;
   tt->i_max_abs = i_min << i_max;
   tt->k = k;
+  tt->k_max = k;
 
   PRINTF("trickle_timer config: Imin=%lu, Imax=%u, k=%u\n",
          (unsigned long)tt->i_min, tt->i_max, tt->k);
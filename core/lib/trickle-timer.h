@@ -204,6 +204,46 @@
 #define TRICKLE_TIMER_ERROR_CHECKING 1
 #endif
 /*---------------------------------------------------------------------------*/
+/**
+ * \brief Enables/Disables per-timer statistics
+ *
+ * 1: Each timer counts the transmissions it allowed, the transmissions it
+ *    suppressed and the number of times it was reset to Imin. The counters are
+ *    stored in the ::trickle_timer structure and are never cleared by the
+ *    library.
+ *
+ * 0: Disabled (default). This saves a few bytes of RAM per timer.
+ */
+#ifdef TRICKLE_TIMER_CONF_STATS
+#define TRICKLE_TIMER_STATS TRICKLE_TIMER_CONF_STATS
+#else
+#define TRICKLE_TIMER_STATS 0
+#endif
+/*---------------------------------------------------------------------------*/
+/**
+ * \brief Neighbor density up to which trickle_timer_set_density() keeps the
+ *        configured redundancy constant
+ *
+ * Above this density, k is scaled down in inverse proportion to the number
+ * of neighbors, so that the number of transmissions per interval within a
+ * neighborhood goes down as the neighborhood grows.
+ */
+#ifdef TRICKLE_TIMER_CONF_ADAPTIVE_DENSITY
+#define TRICKLE_TIMER_ADAPTIVE_DENSITY TRICKLE_TIMER_CONF_ADAPTIVE_DENSITY
+#else
+#define TRICKLE_TIMER_ADAPTIVE_DENSITY 4
+#endif
+
+/**
+ * \brief The smallest redundancy constant that trickle_timer_set_density()
+ *        will select
+ */
+#ifdef TRICKLE_TIMER_CONF_ADAPTIVE_K_MIN
+#define TRICKLE_TIMER_ADAPTIVE_K_MIN TRICKLE_TIMER_CONF_ADAPTIVE_K_MIN
+#else
+#define TRICKLE_TIMER_ADAPTIVE_K_MIN 1
+#endif
+/*---------------------------------------------------------------------------*/
 /* Trickle Timer Library Macros */
 /*---------------------------------------------------------------------------*/
 /**
@@ -374,8 +414,16 @@ struct trickle_timer {
                                within the current interval */
   void *cb_arg;           /**< Opaque pointer to be used as the argument of the
                                protocol's callback */
+#if TRICKLE_TIMER_STATS
+  uint16_t tx;            /**< Number of transmissions allowed */
+  uint16_t suppressed;    /**< Number of transmissions suppressed */
+  uint16_t resets;        /**< Number of resets to Imin */
+#endif /* TRICKLE_TIMER_STATS */
   uint8_t i_max;          /**< Imax: Max number of doublings */
   uint8_t k;              /**< k: Redundancy Constant */
+  uint8_t k_max;          /**< The configured k. When the protocol reports
+                               the neighbor density, k is adapted within
+                               [#TRICKLE_TIMER_ADAPTIVE_K_MIN, k_max] */
   uint8_t c;              /**< c: Consistency Counter */
 };
 /** @} */
@@ -497,6 +545,28 @@ void trickle_timer_inconsistency(struct trickle_timer *tt);
  */
 #define trickle_timer_reset_event(tt) trickle_timer_inconsistency(tt)
 
+/**
+ * \brief         Adapt a timer's redundancy constant to the neighbor density
+ * \param tt      A pointer to a ::trickle_timer structure
+ * \param density The number of neighbors currently taking part in the
+ *                protocol, as observed by the protocol
+ *
+ * With a fixed k, every neighborhood carries up to k transmissions per
+ * interval, regardless of how many nodes share it. Protocols that want
+ * control overhead to decrease in dense deployments can call this function
+ * whenever their estimate of the density changes, e.g. once per interval.
+ *
+ * As long as the density does not exceed #TRICKLE_TIMER_ADAPTIVE_DENSITY, the
+ * timer uses the k it was configured with. Beyond that, k is scaled down by
+ * #TRICKLE_TIMER_ADAPTIVE_DENSITY / density, but never below
+ * #TRICKLE_TIMER_ADAPTIVE_K_MIN. Timers configured with
+ * #TRICKLE_TIMER_INFINITE_REDUNDANCY are not affected.
+ *
+ * The new k takes effect immediately. trickle_timer_config() restores the
+ * configured k.
+ */
+void trickle_timer_set_density(struct trickle_timer *tt, uint16_t density);
+
 /**
  * \brief      To be called in order to determine whether a trickle timer is
  *             running
@@ -32,6 +32,7 @@
 #include "elfloader-arch.h"
 #include <sys/mman.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <stdio.h>
 
 #define R_386_NONE          0
@@ -62,6 +63,8 @@ elfloader_arch_allocate_rom(int size)
 {
   int fd = open("/dev/zero", O_RDWR);
   char *mem = mmap(0, ELFLOADER_TEXTMEMORY_SIZE, PROT_WRITE | PROT_EXEC, MAP_PRIVATE, fd, 0);
+  /* The mapping stays valid after the descriptor is closed. */
+  close(fd);
   return mem;
 }
 /*---------------------------------------------------------------------------*/
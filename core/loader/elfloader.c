@@ -163,6 +163,70 @@ seek_read(int fd, unsigned int offset, char *buf, int len)
 #endif /* DEBUG */
 }
 /*---------------------------------------------------------------------------*/
+#if ELFLOADER_SYMTAB_CACHE_SIZE > 0
+/* The symbol and string tables of the module being loaded. They are
+   read into RAM in one pass by cache_tables() so that the symbol
+   lookups done for every relocation do not go through the file
+   system. */
+static char symtab_cache[ELFLOADER_SYMTAB_CACHE_SIZE];
+
+static struct cached_table {
+  unsigned int offset;
+  unsigned int size;
+  char *data;
+} cached_tables[2];
+
+/*---------------------------------------------------------------------------*/
+static void
+cache_tables(int fd,
+	     unsigned int symtab, unsigned short symtabsize,
+	     unsigned int strtab, unsigned short strtabsize)
+{
+  cached_tables[0].size = cached_tables[1].size = 0;
+
+  if((unsigned long)symtabsize + strtabsize > sizeof(symtab_cache)) {
+    PRINTF("elfloader: %u bytes of symbols do not fit in the cache\n",
+	   symtabsize + strtabsize);
+    return;
+  }
+
+  seek_read(fd, symtab, symtab_cache, symtabsize);
+  seek_read(fd, strtab, symtab_cache + symtabsize, strtabsize);
+
+  cached_tables[0].offset = symtab;
+  cached_tables[0].size = symtabsize;
+  cached_tables[0].data = symtab_cache;
+  cached_tables[1].offset = strtab;
+  cached_tables[1].size = strtabsize;
+  cached_tables[1].data = symtab_cache + symtabsize;
+}
+#endif /* ELFLOADER_SYMTAB_CACHE_SIZE > 0 */
+/*---------------------------------------------------------------------------*/
+/* Read from the symbol or string table, using the cache if possible. */
+static void
+table_read(int fd, unsigned int offset, char *buf, int len)
+{
+#if ELFLOADER_SYMTAB_CACHE_SIZE > 0
+  struct cached_table *t;
+  unsigned int avail;
+
+  for(t = cached_tables; t < cached_tables + 2; t++) {
+    if(offset >= t->offset && offset - t->offset < t->size) {
+      avail = t->size - (offset - t->offset);
+      if(avail < (unsigned int)len) {
+	/* Names are read with a fixed length that may go past the end
+	   of the table. */
+	memset(buf + avail, 0, len - avail);
+	len = avail;
+      }
+      memcpy(buf, t->data + (offset - t->offset), len);
+      return;
+    }
+  }
+#endif /* ELFLOADER_SYMTAB_CACHE_SIZE > 0 */
+  seek_read(fd, offset, buf, len);
+}
+/*---------------------------------------------------------------------------*/
 /*
 static void
 seek_write(int fd, unsigned int offset, char *buf, int len)
@@ -183,10 +247,10 @@ find_local_symbol(int fd, const char *symbol,
   struct relevant_section *sect;
   
   for(a = symtab; a < symtab + symtabsize; a += sizeof(s)) {
-    seek_read(fd, a, (char *)&s, sizeof(s));
+    table_read(fd, a, (char *)&s, sizeof(s));
 
     if(s.st_name != 0) {
-      seek_read(fd, strtab + s.st_name, name, sizeof(name));
+      table_read(fd, strtab + s.st_name, name, sizeof(name));
       if(strcmp(name, symbol) == 0) {
 	if(s.st_shndx == bss.number) {
 	  sect = &bss;
@@ -234,11 +298,11 @@ relocate_section(int fd,
   
   for(a = section; a < section + size; a += rel_size) {
     seek_read(fd, a, (char *)&rela, rel_size);
-    seek_read(fd,
-	      symtab + sizeof(struct elf32_sym) * ELF32_R_SYM(rela.r_info),
-	      (char *)&s, sizeof(s));
+    table_read(fd,
+	       symtab + sizeof(struct elf32_sym) * ELF32_R_SYM(rela.r_info),
+	       (char *)&s, sizeof(s));
     if(s.st_name != 0) {
-      seek_read(fd, strtab + s.st_name, name, sizeof(name));
+      table_read(fd, strtab + s.st_name, name, sizeof(name));
       PRINTF("name: %s\n", name);
       addr = (char *)symtab_lookup(name);
       /* ADDED */
@@ -300,10 +364,10 @@ find_program_processes(int fd,
   char name[30];
   
   for(a = symtab; a < symtab + size; a += sizeof(s)) {
-    seek_read(fd, a, (char *)&s, sizeof(s));
+    table_read(fd, a, (char *)&s, sizeof(s));
 
     if(s.st_name != 0) {
-      seek_read(fd, strtab + s.st_name, name, sizeof(name));
+      table_read(fd, strtab + s.st_name, name, sizeof(name));
       if(strcmp(name, "autostart_processes") == 0) {
 	return &data.address[s.st_value];
       }
@@ -438,7 +502,10 @@ elfloader_load(int fd)
       PRINTF("symtab\n");
       symtaboff = shdr.sh_offset;
       symtabsize = shdr.sh_size;
-    } else if(shdr.sh_type == SHT_STRTAB/*strncmp(name, ".strtab", 7) == 0*/) {
+    } else if(shdr.sh_type == SHT_STRTAB/*strncmp(name, ".strtab", 7) == 0*/ &&
+	      i != ehdr.e_shstrndx) {
+      /* The section name table is a string table too, but holds no
+	 symbol names. */
       PRINTF("strtab\n");
       strtaboff = shdr.sh_offset;
       strtabsize = shdr.sh_size;
@@ -504,6 +571,10 @@ elfloader_load(int fd)
     return ELFLOADER_NO_TEXT;
   }
 
+#if ELFLOADER_SYMTAB_CACHE_SIZE > 0
+  cache_tables(fd, symtaboff, symtabsize, strtaboff, strtabsize);
+#endif /* ELFLOADER_SYMTAB_CACHE_SIZE > 0 */
+
   PRINTF("before allocate ram\n");
   bss.address = (char *)elfloader_arch_allocate_ram(bsssize + datasize);
   data.address = (char *)bss.address + bsssize;
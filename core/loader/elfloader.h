@@ -77,6 +77,8 @@
 
 #include "cfs/cfs.h"
 
+#include <stdint.h>
+
 /**
  * Return value from elfloader_load() indicating that loading worked.
  */
@@ -175,11 +177,26 @@ extern char elfloader_unknown[30];
 #endif
 #endif /* ELFLOADER_TEXTMEMORY_SIZE */
 
-typedef unsigned long  elf32_word;
-typedef   signed long  elf32_sword;
-typedef unsigned short elf32_half;
-typedef unsigned long  elf32_off;
-typedef unsigned long  elf32_addr;
+/**
+ * Size of the RAM buffer into which elfloader_load() reads the
+ * symbol and string tables of a module in one pass. Symbol lookups
+ * during relocation are then served from RAM instead of through one
+ * file system seek and read per symbol. Modules whose tables do not
+ * fit are loaded directly from the file system. Set to 0 to disable.
+ */
+#ifndef ELFLOADER_SYMTAB_CACHE_SIZE
+#ifdef ELFLOADER_CONF_SYMTAB_CACHE_SIZE
+#define ELFLOADER_SYMTAB_CACHE_SIZE ELFLOADER_CONF_SYMTAB_CACHE_SIZE
+#else
+#define ELFLOADER_SYMTAB_CACHE_SIZE 0
+#endif
+#endif /* ELFLOADER_SYMTAB_CACHE_SIZE */
+
+typedef uint32_t elf32_word;
+typedef  int32_t elf32_sword;
+typedef uint16_t elf32_half;
+typedef uint32_t elf32_off;
+typedef uint32_t elf32_addr;
 
 struct elf32_rela {
   elf32_addr      r_offset;       /* Location to be relocated. */
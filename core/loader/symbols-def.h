@@ -41,4 +41,11 @@ extern const int symbols_nelts;
 
 extern const struct symbols symbols[/* symbols_nelts */];
 
+/* Perfect hash over the names in symbols[], see tools/make-symbols-hash.
+   Only referenced when SYMTAB_CONF_HASH is enabled. */
+extern const unsigned short symbols_hash_nbuckets;
+extern const unsigned short symbols_hash_nslots;
+extern const unsigned short symbols_hash_displacement[];
+extern const unsigned short symbols_hash_slots[];
+
 #endif /* SYMBOLS_DEF_H_ */
@@ -41,8 +41,49 @@
 #define SYMTAB_CONF_BINARY_SEARCH 1
 #endif
 
+/* Use the perfect hash generated by tools/make-symbols-hash. Only the
+   make-symbols-nm and empty-symbols generators emit the hash tables. */
+#ifndef SYMTAB_CONF_HASH
+#define SYMTAB_CONF_HASH 0
+#endif
+
+/*---------------------------------------------------------------------------*/
+#if SYMTAB_CONF_HASH
+/* Must be kept in sync with symtab_hash() in tools/make-symbols-hash. */
+static unsigned short
+symtab_hash(const char *name, unsigned short seed)
+{
+  unsigned short mult;
+  unsigned short h;
+
+  mult = 31 + 2 * seed;
+  h = seed;
+  while(*name != '\0') {
+    h = (unsigned)h * mult + (unsigned char)*name++;
+  }
+  return h ^ (h >> 8);
+}
 /*---------------------------------------------------------------------------*/
-#if SYMTAB_CONF_BINARY_SEARCH
+void *
+symtab_lookup(const char *name)
+{
+  unsigned short bucket;
+  unsigned short i;
+
+  if(symbols_hash_nslots == 0) {
+    return NULL;
+  }
+
+  bucket = symtab_hash(name, 0) % symbols_hash_nbuckets;
+  i = symbols_hash_slots[symtab_hash(name,
+                                     symbols_hash_displacement[bucket]) %
+                         symbols_hash_nslots];
+  if(i != 0xffff && strcmp(name, symbols[i].name) == 0) {
+    return symbols[i].value;
+  }
+  return NULL;
+}
+#elif SYMTAB_CONF_BINARY_SEARCH
 void *
 symtab_lookup(const char *name)
 {
@@ -66,7 +107,7 @@ symtab_lookup(const char *name)
   }
   return NULL;
 }
-#else /* SYMTAB_CONF_BINARY_SEARCH */
+#else /* SYMTAB_CONF_HASH */
 void *
 symtab_lookup(const char *name)
 {
@@ -78,5 +119,5 @@ symtab_lookup(const char *name)
   }
   return 0;
 }
-#endif /* SYMTAB_CONF_BINARY_SEARCH */
+#endif /* SYMTAB_CONF_HASH */
 /*---------------------------------------------------------------------------*/
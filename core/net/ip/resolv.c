@@ -56,6 +56,12 @@
  * function. New hostnames can be resolved using the resolv_query()
  * function.
  *
+ * Answers are kept in a cache separate from the outstanding queries.
+ * Each address is kept for the TTL of its record, failures are cached
+ * too (for the SOA minimum on NXDOMAIN, RFC 2308), and the least
+ * recently used entry is replaced when the cache is full. Concurrent
+ * queries for the same name share one request.
+ *
  * The event resolv_event_found is posted when a hostname has been
  * resolved. It is up to the receiving process to determine if the
  * correct hostname has been found by calling the resolv_lookup()
@@ -178,6 +184,7 @@ strcasecmp(const char *s1, const char *s2)
 
 #define DNS_TYPE_A      1
 #define DNS_TYPE_CNAME  5
+#define DNS_TYPE_SOA    6
 #define DNS_TYPE_PTR   12
 #define DNS_TYPE_MX    15
 #define DNS_TYPE_TXT   16
@@ -243,22 +250,17 @@ struct dns_answer {
 #endif
 };
 
+/** \internal An outstanding query. Queries live here only until they
+ * are answered or give up; results are kept in the answer cache. */
 struct namemap {
 #define STATE_UNUSED 0
-#define STATE_ERROR  1
 #define STATE_NEW    2
 #define STATE_ASKING 3
-#define STATE_DONE   4
   uint8_t state;
   uint8_t tmr;
   uint16_t id;
   uint8_t retries;
   uint8_t seqno;
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-  unsigned long expiration;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-  uip_ipaddr_t ipaddr;
-  uint8_t err;
   uint8_t server;
 #if RESOLV_CONF_SUPPORTS_MDNS
   int is_mdns:1, is_probe:1;
@@ -272,8 +274,64 @@ struct namemap {
 #define RESOLV_ENTRIES UIP_CONF_RESOLV_ENTRIES
 #endif /* UIP_CONF_RESOLV_ENTRIES */
 
+/** The number of names kept in the answer cache. */
+#ifdef RESOLV_CONF_CACHE_ENTRIES
+#define RESOLV_CACHE_ENTRIES RESOLV_CONF_CACHE_ENTRIES
+#else
+#define RESOLV_CACHE_ENTRIES RESOLV_ENTRIES
+#endif
+
+/** The number of addresses kept for each cached name. */
+#ifdef RESOLV_CONF_ADDRS_PER_NAME
+#define RESOLV_ADDRS_PER_NAME RESOLV_CONF_ADDRS_PER_NAME
+#else
+#define RESOLV_ADDRS_PER_NAME 2
+#endif
+
+/** Upper bound on the TTL of cached records, in seconds. */
+#ifdef RESOLV_CONF_MAX_TTL
+#define RESOLV_MAX_TTL RESOLV_CONF_MAX_TTL
+#else
+#define RESOLV_MAX_TTL 86400UL
+#endif
+
+/** How long a failure is cached when the server does not say, in seconds. */
+#ifdef RESOLV_CONF_NEGATIVE_TTL
+#define RESOLV_NEGATIVE_TTL RESOLV_CONF_NEGATIVE_TTL
+#else
+#define RESOLV_NEGATIVE_TTL 30
+#endif
+
+/** \internal A cached answer: up to RESOLV_ADDRS_PER_NAME addresses,
+ * each with the expiration time of its own record, or a cached failure.
+ * For failures, expiration[0] holds the expiration time. */
+struct cache_entry {
+#define CACHE_UNUSED    0
+#define CACHE_FOUND     1
+#define CACHE_NOT_FOUND 2
+#define CACHE_ERROR     3
+  uint8_t state;
+  uint8_t naddrs;
+  uint16_t used;
+  unsigned long expiration[RESOLV_ADDRS_PER_NAME];
+  uip_ipaddr_t ipaddr[RESOLV_ADDRS_PER_NAME];
+  char name[RESOLV_CONF_MAX_DOMAIN_NAME_SIZE + 1];
+};
+
 static struct namemap names[RESOLV_ENTRIES];
 
+static struct cache_entry cache[RESOLV_CACHE_ENTRIES];
+
+/* Stamp for least-recently-used replacement in the cache. */
+static uint16_t lru_clock;
+
+#if RESOLV_CONF_STATS
+struct resolv_stats resolv_stats;
+#define RESOLV_STAT(code) (code)
+#else
+#define RESOLV_STAT(code)
+#endif
+
 static uint8_t seqno;
 
 static struct uip_udp_conn *resolv_conn = NULL;
@@ -443,6 +501,26 @@ skip_name(unsigned char *query)
   return query + 1;
 }
 /*---------------------------------------------------------------------------*/
+/** \internal
+ * Like skip_name(), but never reads at or beyond `end`. Returns NULL if
+ * the name does not end before `end`.
+ */
+static unsigned char *
+skip_name_bounded(unsigned char *query, const unsigned char *end)
+{
+  while(query < end) {
+    if(*query & 0xc0) {
+      /* A compression pointer ends the name */
+      return query + 2 <= end ? query + 2 : NULL;
+    }
+    if(*query == 0) {
+      return query + 1;
+    }
+    query += *query + 1;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
 /** \internal
  */
 static unsigned char *
@@ -643,6 +721,276 @@ try_next_server(struct namemap *namemapptr)
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+static uint8_t
+is_expired(unsigned long expiration)
+{
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+  return clock_seconds() > expiration;
+#else /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  return 0;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns the outstanding query for a name, if there is one.
+ */
+static struct namemap *
+query_find(const char *name)
+{
+  uint8_t i;
+
+  for(i = 0; i < RESOLV_ENTRIES; ++i) {
+    if(names[i].state != STATE_UNUSED &&
+       strcasecmp(names[i].name, name) == 0) {
+      return &names[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct cache_entry *
+cache_find(const char *name)
+{
+  uint8_t i;
+
+  for(i = 0; i < RESOLV_CACHE_ENTRIES; ++i) {
+    if(cache[i].state != CACHE_UNUSED &&
+       strcasecmp(cache[i].name, name) == 0) {
+      return &cache[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Drops the expired addresses of an entry. When all of them have
+ * expired they are all kept, so that resolv_lookup() can still return
+ * a stale address along with RESOLV_STATUS_EXPIRED.
+ *
+ * \return 1 if the entry still holds a fresh answer, 0 otherwise.
+ */
+static uint8_t
+cache_refresh(struct cache_entry *e)
+{
+  uint8_t i, j;
+
+  if(e->state != CACHE_FOUND) {
+    return !is_expired(e->expiration[0]);
+  }
+
+  for(i = j = 0; i < e->naddrs; ++i) {
+    if(!is_expired(e->expiration[i])) {
+      if(i != j) {
+        uip_ipaddr_copy(&e->ipaddr[j], &e->ipaddr[i]);
+        e->expiration[j] = e->expiration[i];
+      }
+      ++j;
+    }
+  }
+  if(j == 0) {
+    return 0;
+  }
+  e->naddrs = j;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns the cache entry for a name, allocating one if needed. Unused
+ * and expired entries are taken first. If `evict` is set and the cache
+ * is full of fresh answers, the least recently used one is replaced;
+ * otherwise NULL is returned.
+ */
+static struct cache_entry *
+cache_alloc(const char *name, uint8_t evict)
+{
+  struct cache_entry *e, *victim;
+  uint16_t age, oldest;
+  uint8_t i;
+
+  victim = cache_find(name);
+  if(victim != NULL) {
+    return victim;
+  }
+
+  oldest = 0;
+  for(i = 0; i < RESOLV_CACHE_ENTRIES; ++i) {
+    e = &cache[i];
+    if(e->state == CACHE_UNUSED) {
+      victim = e;
+      break;
+    }
+    if(!cache_refresh(e)) {
+      age = 0xffff;
+    } else if(evict) {
+      age = lru_clock - e->used;
+    } else {
+      continue;
+    }
+    if(victim == NULL || age > oldest) {
+      victim = e;
+      oldest = age;
+    }
+  }
+
+  if(victim == NULL) {
+    return NULL;
+  }
+  if(victim->state != CACHE_UNUSED && cache_refresh(victim)) {
+    PRINTF("resolver: Evicting \"%s\" from the cache.\n", victim->name);
+    RESOLV_STAT(resolv_stats.evictions++);
+  }
+
+  memset(victim, 0, sizeof(*victim));
+  strncpy(victim->name, name, sizeof(victim->name) - 1);
+  victim->used = ++lru_clock;
+  return victim;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Adds an address record to an entry, or refreshes it if the address
+ * is already there. A full entry replaces the record closest to expiry.
+ */
+static void
+cache_add_address(struct cache_entry *e, const uip_ipaddr_t *ipaddr,
+                  uint32_t ttl)
+{
+  uint8_t i, j;
+
+  if(e->state != CACHE_FOUND) {
+    e->state = CACHE_FOUND;
+    e->naddrs = 0;
+  }
+
+  for(i = 0; i < e->naddrs; ++i) {
+    if(uip_ipaddr_cmp(&e->ipaddr[i], ipaddr)) {
+      break;
+    }
+  }
+  if(i == e->naddrs) {
+    if(e->naddrs < RESOLV_ADDRS_PER_NAME) {
+      ++e->naddrs;
+    } else {
+      for(i = 0, j = 1; j < e->naddrs; ++j) {
+        if(e->expiration[j] < e->expiration[i]) {
+          i = j;
+        }
+      }
+    }
+  }
+
+  uip_ipaddr_copy(&e->ipaddr[i], ipaddr);
+  e->expiration[i] = clock_seconds() + ttl;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Caches a failure for a name, for `ttl` seconds. Failures are not
+ * cached when record expiration is disabled, as they would never go
+ * away.
+ */
+static struct cache_entry *
+cache_failure(const char *name, uint8_t state, uint32_t ttl)
+{
+#if RESOLV_SUPPORTS_RECORD_EXPIRATION
+  struct cache_entry *e;
+
+  e = cache_alloc(name, 1);
+  e->state = state;
+  e->naddrs = 0;
+  e->expiration[0] = clock_seconds() + ttl;
+  RESOLV_STAT(resolv_stats.failures++);
+  return e;
+#else /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  return NULL;
+#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns an aligned copy of the resource record at `queryptr`.
+ */
+static struct dns_answer *
+get_answer(unsigned char *queryptr)
+{
+  struct dns_answer *ans = (struct dns_answer *)skip_name(queryptr);
+
+#if !ARCH_DOESNT_NEED_ALIGNED_STRUCTS
+  static struct dns_answer aligned;
+  memcpy(&aligned, ans, sizeof(aligned));
+  ans = &aligned;
+#endif /* !ARCH_DOESNT_NEED_ALIGNED_STRUCTS */
+
+  return ans;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+answer_is_address(const struct dns_answer *ans)
+{
+  return ((uip_ntohs(ans->class) & 0x7FFF) == DNS_CLASS_IN) &&
+    ans->len == UIP_HTONS(sizeof(uip_ipaddr_t)) &&
+    ans->type == UIP_HTONS(NATIVE_DNS_TYPE);
+}
+/*---------------------------------------------------------------------------*/
+static uint32_t
+answer_ttl(const struct dns_answer *ans)
+{
+  uint32_t ttl;
+
+  ttl = ((uint32_t)uip_ntohs(ans->ttl[0]) << 16) | uip_ntohs(ans->ttl[1]);
+  return ttl > RESOLV_MAX_TTL ? RESOLV_MAX_TTL : ttl;
+}
+/*---------------------------------------------------------------------------*/
+/** \internal
+ * Returns how long a negative answer may be cached: the smaller of the
+ * TTL and the MINIMUM field of the SOA record in the authority section
+ * (RFC 2308), or RESOLV_NEGATIVE_TTL if the server sent no SOA.
+ * `queryptr` points at the first of `nanswers` answers, followed by
+ * the authority section.
+ */
+static uint32_t
+negative_ttl(unsigned char *queryptr, uint8_t nanswers, uint8_t nauthrr)
+{
+  unsigned char *end = (unsigned char *)uip_appdata + uip_datalen();
+  struct dns_answer ans;
+  uint32_t ttl, minimum;
+  unsigned char *rdata, *soa;
+  uint16_t len;
+
+  for(nauthrr += nanswers; nauthrr > 0; --nauthrr) {
+    rdata = skip_name_bounded(queryptr, end);
+    if(rdata == NULL || rdata + 10 > end) {
+      break;
+    }
+    /* Only the fixed part: the record need not hold an address. */
+    memcpy(&ans, rdata, 10);
+    rdata += 10;
+    len = uip_ntohs(ans.len);
+    if(rdata + len > end) {
+      break;
+    }
+    if(nanswers > 0) {
+      --nanswers;
+    } else if(ans.type == UIP_HTONS(DNS_TYPE_SOA)) {
+      /* Skip MNAME and RNAME, then SERIAL, REFRESH, RETRY and EXPIRE. */
+      soa = skip_name_bounded(rdata, rdata + len);
+      if(soa != NULL) {
+        soa = skip_name_bounded(soa, rdata + len);
+      }
+      if(soa == NULL || soa + 20 > rdata + len) {
+        break;
+      }
+      soa += 16;
+      minimum = ((uint32_t)soa[0] << 24) | ((uint32_t)soa[1] << 16) |
+        ((uint32_t)soa[2] << 8) | soa[3];
+      ttl = answer_ttl(&ans);
+      if(minimum < ttl) {
+        ttl = minimum;
+      }
+      return ttl > RESOLV_MAX_TTL ? RESOLV_MAX_TTL : ttl;
+    }
+    queryptr = rdata + len;
+  }
+  return RESOLV_NEGATIVE_TTL;
+}
+/*---------------------------------------------------------------------------*/
 /** \internal
  * Runs through the list of names to see if there are any that have
  * not yet been queried and, if so, sends out a query.
@@ -675,15 +1023,29 @@ check_entries(void)
             /* Try the next server (if possible) before failing. Otherwise
                simply mark the entry as failed. */
             if(try_next_server(namemapptr) == 0) {
-              /* STATE_ERROR basically means "not found". */
-              namemapptr->state = STATE_ERROR;
+              struct cache_entry *e = NULL;
 
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-              /* Keep the "not found" error valid for 30 seconds */
-              namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+              PRINTF("resolver: Query for \"%s\" timed out.\n",
+                     namemapptr->name);
+              RESOLV_STAT(resolv_stats.timeouts++);
+              namemapptr->state = STATE_UNUSED;
+
+#if RESOLV_CONF_SUPPORTS_MDNS
+              /* Nobody answering an mDNS query means "not found". Our own
+                 name, when probing, is never cached. */
+              if(namemapptr->is_mdns) {
+                if(!namemapptr->is_probe) {
+                  e = cache_failure(namemapptr->name, CACHE_NOT_FOUND,
+                                    RESOLV_NEGATIVE_TTL);
+                }
+              } else
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+              {
+                e = cache_failure(namemapptr->name, CACHE_ERROR,
+                                  RESOLV_NEGATIVE_TTL);
+              }
 
-              resolv_found(namemapptr->name, NULL);
+              resolv_found(e != NULL ? e->name : namemapptr->name, NULL);
               continue;
             }
           }
@@ -706,6 +1068,7 @@ check_entries(void)
         namemapptr->tmr = 1;
         namemapptr->retries = 0;
       }
+      RESOLV_STAT(resolv_stats.sent++);
       hdr = (struct dns_hdr *)uip_appdata;
       memset(hdr, 0, sizeof(struct dns_hdr));
       hdr->id = random_rand();
@@ -777,18 +1140,86 @@ check_entries(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if RESOLV_CONF_SUPPORTS_MDNS
+/** \internal
+ * Handles the answers of an mDNS response. Each address record is
+ * cached on its own, and completes the outstanding query for its name,
+ * if any. Unsolicited answers are cached only when they do not push
+ * out a fresh entry. A TTL of zero is a "goodbye" and removes the
+ * record.
+ */
+static void
+mdns_answers(unsigned char *queryptr, uint8_t nanswers)
+{
+  static char name[RESOLV_CONF_MAX_DOMAIN_NAME_SIZE + 1];
+  struct dns_answer *ans;
+  struct namemap *q;
+  struct cache_entry *e;
+  uint32_t ttl;
+  uint8_t i;
+
+  for(; nanswers > 0; --nanswers) {
+    ans = get_answer(queryptr);
+
+    if(answer_is_address(ans) && decode_name(queryptr, name, uip_appdata)) {
+      q = query_find(name);
+      ttl = answer_ttl(ans);
+
+      if(strcasecmp(name, resolv_hostname) == 0) {
+        /* Someone answered for our name. It is never cached, but
+         * resolv_found() has to check it for a collision. */
+        if(q != NULL) {
+          q->state = STATE_UNUSED;
+        }
+        resolv_found(resolv_hostname, (uip_ipaddr_t *)ans->ipaddr);
+      } else if(ttl == 0) {
+        e = cache_find(name);
+        if(e != NULL && e->state == CACHE_FOUND) {
+          for(i = 0; i < e->naddrs; ++i) {
+            if(uip_ipaddr_cmp(&e->ipaddr[i], (uip_ipaddr_t *)ans->ipaddr)) {
+              --e->naddrs;
+              uip_ipaddr_copy(&e->ipaddr[i], &e->ipaddr[e->naddrs]);
+              e->expiration[i] = e->expiration[e->naddrs];
+              break;
+            }
+          }
+          if(e->naddrs == 0) {
+            e->state = CACHE_UNUSED;
+          }
+        }
+      } else {
+        DEBUG_PRINTF("resolver: MDNS answer for \"%s\"%s.\n", name,
+                     q != NULL ? "" : " (unsolicited)");
+        e = cache_alloc(name, q != NULL);
+        if(e != NULL) {
+          cache_add_address(e, (uip_ipaddr_t *)ans->ipaddr, ttl);
+          if(q != NULL) {
+            q->state = STATE_UNUSED;
+            resolv_found(e->name, &e->ipaddr[0]);
+          }
+        }
+      }
+    }
+
+    queryptr = skip_name(queryptr) + 10 + uip_ntohs(ans->len);
+  }
+}
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+/*---------------------------------------------------------------------------*/
 /** \internal
  * Called when new UDP data arrives.
  */
 static void
 newdata(void)
 {
-  uint8_t nquestions, nanswers;
+  uint8_t nquestions, nanswers, err;
 
   int8_t i;
 
   register struct namemap *namemapptr = NULL;
 
+  struct cache_entry *e;
+
   struct dns_answer *ans;
 
   register struct dns_hdr const *hdr = (struct dns_hdr *)uip_appdata;
@@ -895,69 +1326,44 @@ newdata(void)
 
 /** ANSWER HANDLING SECTION **************************************************/
 
-  if(nanswers == 0) {
-    /* Skip responses with no answers. */
-    return;
-  }
-
 #if RESOLV_CONF_SUPPORTS_MDNS
   if(UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT) &&
      hdr->id == 0) {
     /* OK, this was from MDNS. Things get a little weird here,
-     * because we can't use the `id` field. We will look up the
-     * appropriate request in a later step. */
-
-    i = -1;
-    namemapptr = NULL;
-  } else
+     * because we can't use the `id` field. The answers are
+     * matched against our queries by name instead. */
+    mdns_answers(queryptr, nanswers);
+    return;
+  }
 #endif /* RESOLV_CONF_SUPPORTS_MDNS */
-  {
-    for(i = 0; i < RESOLV_ENTRIES; ++i) {
-      namemapptr = &names[i];
-      if(namemapptr->state == STATE_ASKING &&
-         namemapptr->id == hdr->id) {
-        break;
-      }
-    }
-
-    if(i >= RESOLV_ENTRIES || i < 0 || namemapptr->state != STATE_ASKING) {
-      PRINTF("resolver: DNS response has bad ID (%04X) \n", uip_ntohs(hdr->id));
-      return;
-    }
-
-    PRINTF("resolver: Incoming response for \"%s\".\n", namemapptr->name);
-
-    /* We'll change this to DONE when we find the record. */
-    namemapptr->state = STATE_ERROR;
-
-    namemapptr->err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
 
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    /* If we remain in the error state, keep it cached for 30 seconds. */
-    namemapptr->expiration = clock_seconds() + 30;
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
+  if(is_request) {
+    return;
+  }
 
-    /* Check for error. If so, call callback to inform. */
-    if(namemapptr->err != 0) {
-      namemapptr->state = STATE_ERROR;
-      resolv_found(namemapptr->name, NULL);
-      return;
+  for(i = 0; i < RESOLV_ENTRIES; ++i) {
+    namemapptr = &names[i];
+    if(namemapptr->state == STATE_ASKING &&
+       namemapptr->id == hdr->id) {
+      break;
     }
   }
 
-  i = 0;
+  if(i >= RESOLV_ENTRIES || i < 0 || namemapptr->state != STATE_ASKING) {
+    PRINTF("resolver: DNS response has bad ID (%04X) \n", uip_ntohs(hdr->id));
+    return;
+  }
 
-  /* Answer parsing loop */
-  while(nanswers > 0) {
-    ans = (struct dns_answer *)skip_name(queryptr);
+  PRINTF("resolver: Incoming response for \"%s\".\n", namemapptr->name);
 
-#if !ARCH_DOESNT_NEED_ALIGNED_STRUCTS
-    {
-      static struct dns_answer aligned;
-      memcpy(&aligned, ans, sizeof(aligned));
-      ans = &aligned;
-    }
-#endif /* !ARCH_DOESNT_NEED_ALIGNED_STRUCTS */
+  err = hdr->flags2 & DNS_FLAG2_ERR_MASK;
+  e = NULL;
+  i = 0;
+
+  /* Answer parsing loop. Every address in the answer is cached, each
+   * with its own TTL, so CNAME records in front of them do no harm. */
+  while(err == DNS_FLAG2_ERR_NONE && nanswers > 0) {
+    ans = get_answer(queryptr);
 
 #if VERBOSE_DEBUG
     char debug_name[40];
@@ -965,117 +1371,54 @@ newdata(void)
     DEBUG_PRINTF("resolver: Answer %d: \"%s\", type %d, class %d, ttl %d, length %d\n",
                  ++i, debug_name, uip_ntohs(ans->type),
                  uip_ntohs(ans->class) & 0x7FFF,
-                 (int)((uint32_t) uip_ntohs(ans->ttl[0]) << 16) | (uint32_t)
-                 uip_ntohs(ans->ttl[1]), uip_ntohs(ans->len));
+                 (int)answer_ttl(ans), uip_ntohs(ans->len));
 #endif /* VERBOSE_DEBUG */
 
-    /* Check the class and length of the answer to make sure
-     * it matches what we are expecting
-     */
-    if(((uip_ntohs(ans->class) & 0x7FFF) != DNS_CLASS_IN) ||
-       (ans->len != UIP_HTONS(sizeof(uip_ipaddr_t)))) {
-      goto skip_to_next_answer;
-    }
-
-    if(ans->type != UIP_HTONS(NATIVE_DNS_TYPE)) {
-      goto skip_to_next_answer;
-    }
-
-#if RESOLV_CONF_SUPPORTS_MDNS
-    if(UIP_UDP_BUF->srcport == UIP_HTONS(MDNS_PORT) &&
-       hdr->id == 0) {
-      int8_t available_i = RESOLV_ENTRIES;
-
-      DEBUG_PRINTF("resolver: MDNS query.\n");
-
-      /* For MDNS, we need to actually look up the name we
-       * are looking for.
-       */
-      for(i = 0; i < RESOLV_ENTRIES; ++i) {
-        namemapptr = &names[i];
-        if(dns_name_isequal(queryptr, namemapptr->name, uip_appdata)) {
-          break;
-        }
-        if((namemapptr->state == STATE_UNUSED)
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-          || (namemapptr->state == STATE_DONE && clock_seconds() > namemapptr->expiration)
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        ) {
-          available_i = i;
-        }
-      }
-      if(i == RESOLV_ENTRIES) {
-        DEBUG_PRINTF("resolver: Unsolicited MDNS response.\n");
-        i = available_i;
-        namemapptr = &names[i];
-        if(!decode_name(queryptr, namemapptr->name, uip_appdata)) {
-          DEBUG_PRINTF("resolver: MDNS name too big to cache.\n");
-          namemapptr = NULL;
-          goto skip_to_next_answer;
-        }
-      }
-      if(i == RESOLV_ENTRIES) {
-        DEBUG_PRINTF
-          ("resolver: Not enough room to keep track of unsolicited MDNS answer.\n");
-
-        if(dns_name_isequal(queryptr, resolv_hostname, uip_appdata)) {
-          /* Oh snap, they say they are us! We had better report them... */
-          resolv_found(resolv_hostname, (uip_ipaddr_t *) ans->ipaddr);
-        }
-        namemapptr = NULL;
-        goto skip_to_next_answer;
+    if(answer_is_address(ans)) {
+      if(e == NULL) {
+        /* The new answer replaces whatever we had for this name. */
+        e = cache_alloc(namemapptr->name, 1);
+        e->state = CACHE_FOUND;
+        e->naddrs = 0;
       }
-      namemapptr = &names[i];
-
-    } else
-#endif /* RESOLV_CONF_SUPPORTS_MDNS */
-    {
-      /* This will force us to stop even if there are more answers. */
-      nanswers = 1;
-    }
-
-/*  This is disabled for now, so that we don't fail on CNAME records.
-#if RESOLV_VERIFY_ANSWER_NAMES
-    if(namemapptr && !dns_name_isequal(queryptr, namemapptr->name, uip_appdata)) {
-      DEBUG_PRINTF("resolver: Answer name doesn't match question...!\n");
-      goto skip_to_next_answer;
+      cache_add_address(e, (uip_ipaddr_t *)ans->ipaddr, answer_ttl(ans));
     }
-#endif
-*/
-
-    DEBUG_PRINTF("resolver: Answer for \"%s\" is usable.\n", namemapptr->name);
-
-    namemapptr->state = STATE_DONE;
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-    namemapptr->expiration = ans->ttl[1] + (ans->ttl[0] << 8);
-    namemapptr->expiration += clock_seconds();
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
 
-    uip_ipaddr_copy(&namemapptr->ipaddr, (uip_ipaddr_t *) ans->ipaddr);
-
-    resolv_found(namemapptr->name, &namemapptr->ipaddr);
-    break;
-
-  skip_to_next_answer:
-    queryptr = (unsigned char *)skip_name(queryptr) + 10 + uip_htons(ans->len);
+    queryptr = skip_name(queryptr) + 10 + uip_ntohs(ans->len);
     --nanswers;
   }
 
-  /* Got to this point there's no answer, try next nameserver if available
-     since this one doesn't know the answer */
-#if RESOLV_CONF_SUPPORTS_MDNS
-  if(nanswers == 0 && UIP_UDP_BUF->srcport != UIP_HTONS(MDNS_PORT) 
-      && hdr->id != 0)
-#else
-  if(nanswers == 0) 
-#endif
-  {
+  if(e != NULL) {
+    DEBUG_PRINTF("resolver: Cached %d address(es) for \"%s\".\n",
+                 e->naddrs, e->name);
+    namemapptr->state = STATE_UNUSED;
+    resolv_found(e->name, &e->ipaddr[0]);
+    return;
+  }
+
+  if(err == DNS_FLAG2_ERR_NONE || err == DNS_FLAG2_ERR_NAME) {
+    /* No address for this name. Unless the name does not exist at
+       all, another server might know better. */
+    if(err == DNS_FLAG2_ERR_NONE && try_next_server(namemapptr)) {
+      namemapptr->state = STATE_ASKING;
+      process_post(&resolv_process, PROCESS_EVENT_TIMER, NULL);
+      return;
+    }
+    e = cache_failure(namemapptr->name, CACHE_NOT_FOUND,
+                      negative_ttl(queryptr, nanswers,
+                                   (uint8_t)uip_ntohs(hdr->numauthrr)));
+  } else {
+    /* The server failed or refused; try the next one before giving up. */
     if(try_next_server(namemapptr)) {
       namemapptr->state = STATE_ASKING;
       process_post(&resolv_process, PROCESS_EVENT_TIMER, NULL);
+      return;
     }
+    e = cache_failure(namemapptr->name, CACHE_ERROR, RESOLV_NEGATIVE_TTL);
   }
 
+  namemapptr->state = STATE_UNUSED;
+  resolv_found(e != NULL ? e->name : namemapptr->name, NULL);
 }
 /*---------------------------------------------------------------------------*/
 #if RESOLV_CONF_SUPPORTS_MDNS
@@ -1159,6 +1502,7 @@ PROCESS_THREAD(resolv_process, ev, data)
   PROCESS_BEGIN();
 
   memset(names, 0, sizeof(names));
+  memset(cache, 0, sizeof(cache));
 
   resolv_event_found = process_alloc_event();
 
@@ -1261,6 +1605,11 @@ remove_trailing_dots(const char *name) {
 /**
  * Queues a name so that a question for the name will be sent out.
  *
+ * If a query for the name is already outstanding, no new question is
+ * sent; every caller gets the same resolv_event_found event. If the
+ * cache holds a fresh answer or failure for the name, the event is
+ * posted right away.
+ *
  * \param name The hostname that is to be queried.
  */
 void
@@ -1272,6 +1621,8 @@ resolv_query(const char *name)
 
   register struct namemap *nameptr = 0;
 
+  struct cache_entry *e;
+
   init();
   
   lseq = lseqi = 0;
@@ -1279,19 +1630,34 @@ resolv_query(const char *name)
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
 
+  RESOLV_STAT(resolv_stats.queries++);
+
+  if(query_find(name) != NULL) {
+    PRINTF("resolver: Query for \"%s\" is already outstanding.\n", name);
+    RESOLV_STAT(resolv_stats.coalesced++);
+    return;
+  }
+
+#if RESOLV_CONF_SUPPORTS_MDNS
+  if(mdns_state != MDNS_STATE_PROBING || strcmp(name, resolv_hostname) != 0)
+#endif /* RESOLV_CONF_SUPPORTS_MDNS */
+  {
+    e = cache_find(name);
+    if(e != NULL && cache_refresh(e)) {
+      PRINTF("resolver: Answering \"%s\" from the cache.\n", name);
+      RESOLV_STAT(resolv_stats.hits++);
+      e->used = ++lru_clock;
+      resolv_found(e->name, e->state == CACHE_FOUND ? &e->ipaddr[0] : NULL);
+      return;
+    }
+  }
+
   for(i = 0; i < RESOLV_ENTRIES; ++i) {
     nameptr = &names[i];
-    if(0 == strcasecmp(nameptr->name, name)) {
+    if(nameptr->state == STATE_UNUSED) {
       break;
     }
-    if((nameptr->state == STATE_UNUSED)
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-      || (nameptr->state == STATE_DONE && clock_seconds() > nameptr->expiration)
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-    ) {
-      lseqi = i;
-      lseq = 255;
-    } else if(seqno - nameptr->seqno > lseq) {
+    if(seqno - nameptr->seqno > lseq) {
       lseq = seqno - nameptr->seqno;
       lseqi = i;
     }
@@ -1300,13 +1666,14 @@ resolv_query(const char *name)
   if(i == RESOLV_ENTRIES) {
     i = lseqi;
     nameptr = &names[i];
+    PRINTF("resolver: Dropping query for \"%s\".\n", nameptr->name);
   }
 
   PRINTF("resolver: Starting query for \"%s\".\n", name);
 
   memset(nameptr, 0, sizeof(*nameptr));
 
-  strncpy(nameptr->name, name, sizeof(nameptr->name));
+  strncpy(nameptr->name, name, sizeof(nameptr->name) - 1);
   nameptr->state = STATE_NEW;
   nameptr->seqno = seqno;
   ++seqno;
@@ -1344,18 +1711,36 @@ resolv_query(const char *name)
  */
 resolv_status_t
 resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
+{
+  return resolv_lookup_all(name, ipaddr, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * Look up all known addresses of a hostname.
+ *
+ * Works like resolv_lookup(), except that `*ipaddrs` points to an
+ * array of `*count` addresses. The array stays valid until the next
+ * call into the resolver.
+ */
+resolv_status_t
+resolv_lookup_all(const char *name, uip_ipaddr_t ** ipaddrs, uint8_t *count)
 {
   resolv_status_t ret = RESOLV_STATUS_UNCACHED;
 
-  uint8_t i;
-
-  struct namemap *nameptr;
+  struct cache_entry *e;
 
   /* Remove trailing dots, if present. */
   name = remove_trailing_dots(name);
 
+  if(ipaddrs) {
+    *ipaddrs = NULL;
+  }
+  if(count) {
+    *count = 0;
+  }
+
 #if UIP_CONF_LOOPBACK_INTERFACE
-  if(strcmp(name, "localhost")) {
+  if(strcmp(name, "localhost") == 0) {
     static uip_ipaddr_t loopback =
 #if NETSTACK_CONF_WITH_IPV6
     { { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -1363,57 +1748,56 @@ resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr)
 #else /* NETSTACK_CONF_WITH_IPV6 */
     { { 127, 0, 0, 1 } };
 #endif /* NETSTACK_CONF_WITH_IPV6 */
-    if(ipaddr) {
-      *ipaddr = &loopback;
+    if(ipaddrs) {
+      *ipaddrs = &loopback;
+    }
+    if(count) {
+      *count = 1;
     }
-    ret = RESOLV_STATUS_CACHED;
+    return RESOLV_STATUS_CACHED;
   }
 #endif /* UIP_CONF_LOOPBACK_INTERFACE */
 
-  /* Walk through the list to see if the name is in there. */
-  for(i = 0; i < RESOLV_ENTRIES; ++i) {
-    nameptr = &names[i];
-
-    if(strcasecmp(name, nameptr->name) == 0) {
-      switch (nameptr->state) {
-      case STATE_DONE:
-        ret = RESOLV_STATUS_CACHED;
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
-          ret = RESOLV_STATUS_EXPIRED;
-        }
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
-      case STATE_NEW:
-      case STATE_ASKING:
-        ret = RESOLV_STATUS_RESOLVING;
-        break;
-      /* Almost certainly a not-found error from server */
-      case STATE_ERROR:
-        ret = RESOLV_STATUS_NOT_FOUND;
-#if RESOLV_SUPPORTS_RECORD_EXPIRATION
-        if(clock_seconds() > nameptr->expiration) {
-          ret = RESOLV_STATUS_UNCACHED;
-        }
-#endif /* RESOLV_SUPPORTS_RECORD_EXPIRATION */
-        break;
+  e = cache_find(name);
+  if(e != NULL) {
+    e->used = ++lru_clock;
+    switch(e->state) {
+    case CACHE_FOUND:
+      ret = cache_refresh(e) ? RESOLV_STATUS_CACHED : RESOLV_STATUS_EXPIRED;
+      if(ipaddrs) {
+        *ipaddrs = e->ipaddr;
       }
-
-      if(ipaddr) {
-        *ipaddr = &nameptr->ipaddr;
+      if(count) {
+        *count = e->naddrs;
       }
-
-      /* Break out of for loop. */
+      break;
+    /* An expired failure is as good as nothing. */
+    case CACHE_NOT_FOUND:
+      ret = cache_refresh(e) ? RESOLV_STATUS_NOT_FOUND : RESOLV_STATUS_UNCACHED;
+      break;
+    case CACHE_ERROR:
+      ret = cache_refresh(e) ? RESOLV_STATUS_ERROR : RESOLV_STATUS_UNCACHED;
       break;
     }
   }
 
+  if(ret != RESOLV_STATUS_CACHED && query_find(name) != NULL) {
+    ret = RESOLV_STATUS_RESOLVING;
+  }
+
+  if(ret == RESOLV_STATUS_CACHED || ret == RESOLV_STATUS_NOT_FOUND ||
+     ret == RESOLV_STATUS_ERROR) {
+    RESOLV_STAT(resolv_stats.hits++);
+  } else {
+    RESOLV_STAT(resolv_stats.misses++);
+  }
+
 #if VERBOSE_DEBUG
   switch (ret) {
   case RESOLV_STATUS_CACHED:
-    if(ipaddr) {
+    if(ipaddrs) {
       PRINTF("resolver: Found \"%s\" in cache.\n", name);
-      const uip_ipaddr_t *addr = *ipaddr;
+      const uip_ipaddr_t *addr = *ipaddrs;
 
       DEBUG_PRINTF
         ("resolver: %02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x \n",
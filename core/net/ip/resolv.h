@@ -52,6 +52,13 @@
 #define RESOLV_CONF_SUPPORTS_MDNS     (1)
 #endif
 
+/** If RESOLV_CONF_STATS is set, the resolver counts queries, cache
+ *  hits and failures in resolv_stats.
+ */
+#ifndef RESOLV_CONF_STATS
+#define RESOLV_CONF_STATS             (0)
+#endif
+
 /**
  * Event that is broadcasted when a DNS name has been resolved.
  */
@@ -74,7 +81,7 @@ enum {
    *  This response is cached for the period described in the server.
    *  You may issue a new query at any time using resolv_query(), but
    *  you will generally want to wait until this domain's status becomes
-   *  RESOLV_STATUS_EXPIRED.
+   *  RESOLV_STATUS_UNCACHED.
    */
   RESOLV_STATUS_NOT_FOUND,
 
@@ -83,16 +90,36 @@ enum {
 
   /** Some sort of server error was encountered while trying to look up this
    *  record. This response is cached and will eventually expire to
-   *  RESOLV_STATUS_EXPIRED.
+   *  RESOLV_STATUS_UNCACHED.
    */
   RESOLV_STATUS_ERROR,
 };
 
 typedef uint8_t resolv_status_t;
 
+#if RESOLV_CONF_STATS
+/** Resolver statistics. */
+struct resolv_stats {
+  uint16_t queries;   /**< Calls to resolv_query(). */
+  uint16_t coalesced; /**< Queries that joined an outstanding one. */
+  uint16_t sent;      /**< Questions sent, retries included. */
+  uint16_t hits;      /**< Lookups and queries answered from the cache. */
+  uint16_t misses;    /**< Lookups that found no usable answer. */
+  uint16_t failures;  /**< Failures (not found, errors) cached. */
+  uint16_t timeouts;  /**< Queries that got no answer at all. */
+  uint16_t evictions; /**< Fresh cache entries pushed out by others. */
+};
+
+CCIF extern struct resolv_stats resolv_stats;
+#endif /* RESOLV_CONF_STATS */
+
 /* Functions. */
 CCIF resolv_status_t resolv_lookup(const char *name, uip_ipaddr_t ** ipaddr);
 
+CCIF resolv_status_t resolv_lookup_all(const char *name,
+                                       uip_ipaddr_t ** ipaddrs,
+                                       uint8_t *count);
+
 CCIF void resolv_query(const char *name);
 
 #if RESOLV_CONF_SUPPORTS_MDNS
@@ -1509,6 +1509,10 @@ struct uip_stats {
     uip_stats_t recv;     /**< Number of recived ND6 packets */
     uip_stats_t sent;     /**< Number of sent ND6 packets */
   } nd6;
+  struct {
+    uip_stats_t periodic; /**< Number of runs of the periodic
+                               maintenance of the data structures. */
+  } ds6;
 #endif /*NETSTACK_CONF_WITH_IPV6*/
 };
 
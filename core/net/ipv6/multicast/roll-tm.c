@@ -194,11 +194,15 @@ struct trickle_param {
 #define SEQ_VAL_ADD(s, n) (((s) + (n)) % 0x8000)
 /*---------------------------------------------------------------------------*/
 /* Sliding Windows */
+struct mcast_packet;
+
 struct sliding_window {
   seed_id_t seed_id;
   int16_t lower_bound;          /* lolipop */
   int16_t upper_bound;          /* lolipop */
   int16_t min_listed;           /* lolipop */
+  struct mcast_packet *head;    /* Buffered packets, lowest seq. val first */
+  struct mcast_packet *tail;    /* Buffered packet with the highest seq. val */
   uint8_t flags;                /* Is used, Trickle param, Is listed */
   uint8_t count;
 };
@@ -266,6 +270,7 @@ struct sliding_window {
 /*---------------------------------------------------------------------------*/
 /* Multicast Packet Buffers */
 struct mcast_packet {
+  struct mcast_packet *next;    /* Next in window (by seq. val) or free list */
 #if ROLL_TM_SHORT_SEEDS
   /* Short seeds are stored inside the message */
   seed_id_t seed_id;
@@ -443,6 +448,7 @@ static struct roll_tm_stats stats;
 static struct trickle_param t[2];
 static struct sliding_window windows[ROLL_TM_WINS];
 static struct mcast_packet buffered_msgs[ROLL_TM_BUFF_NUM];
+static struct mcast_packet *free_msgs;
 /*---------------------------------------------------------------------------*/
 /* Temporary Stores */
 /*---------------------------------------------------------------------------*/
@@ -470,7 +476,8 @@ extern uint16_t uip_slen;
 /*---------------------------------------------------------------------------*/
 static void icmp_input(void);
 static void icmp_output(void);
-static void window_update_bounds(void);
+static void buffer_free(struct sliding_window *, struct mcast_packet *,
+                        struct mcast_packet *);
 static void reset_trickle_timer(uint8_t);
 static void handle_timer(void *);
 /*---------------------------------------------------------------------------*/
@@ -536,6 +543,8 @@ static void
 handle_timer(void *ptr)
 {
   struct trickle_param *param;
+  struct mcast_packet *prev;
+  struct mcast_packet *next;
   clock_time_t diff_last;       /* Time diff from last pass */
   clock_time_t diff_start;      /* Time diff from interval start */
   uint8_t m;
@@ -572,11 +581,16 @@ handle_timer(void *ptr)
     ("ROLL TM: M=%u Periodic diff from last %lu, from start %lu\n", m,
      (unsigned long)diff_last, (unsigned long)diff_start);
 
-  /* Handle all buffered messages */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)
-       && (SLIDING_WINDOW_GET_M(locmpptr->sw) == m)) {
+  /* Handle all buffered messages of windows using this timer */
+  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
+      iterswptr--) {
+    if(!SLIDING_WINDOW_IS_USED(iterswptr) ||
+       SLIDING_WINDOW_GET_M(iterswptr) != m) {
+      continue;
+    }
+    prev = NULL;
+    for(locmpptr = iterswptr->head; locmpptr != NULL; locmpptr = next) {
+      next = locmpptr->next;
 
       /*
        * if()
@@ -604,17 +618,18 @@ handle_timer(void *ptr)
                      TRICKLE_ACTIVE(param));
 
       if(locmpptr->dwell > TRICKLE_DWELL(param)) {
-        locmpptr->sw->count--;
+        buffer_free(iterswptr, prev, locmpptr);
         PRINTF("ROLL TM: M=%u Free Packet %u (%lu > %lu), Window now at %u\n",
                m, locmpptr->seq_val, locmpptr->dwell,
-               TRICKLE_DWELL(param), locmpptr->sw->count);
-        if(locmpptr->sw->count == 0) {
+               TRICKLE_DWELL(param), iterswptr->count);
+        if(iterswptr->count == 0) {
           PRINTF("ROLL TM: M=%u Free Window ", m);
-          PRINT_SEED(&locmpptr->sw->seed_id);
+          PRINT_SEED(&iterswptr->seed_id);
           PRINTF("\n");
-          window_free(locmpptr->sw);
+          window_free(iterswptr);
         }
-        MCAST_PACKET_FREE(locmpptr);
+        /* prev stays where it is, it now links to next */
+        continue;
       } else if(MCAST_PACKET_TTL(locmpptr) > 0) {
         /* Handle multicast transmissions */
         if(locmpptr->active < TRICKLE_ACTIVE(param) &&
@@ -632,6 +647,7 @@ handle_timer(void *ptr)
           watchdog_periodic();
         }
       }
+      prev = locmpptr;
     }
   }
 
@@ -646,8 +662,6 @@ handle_timer(void *ptr)
   param->inconsistency = 0;
   param->c = 0;
 
-  window_update_bounds();
-
   /* Temporarily store 'now' in t_next */
   param->t_next = clock_time();
   if(param->t_next >= param->t_end) {
@@ -692,6 +706,8 @@ window_allocate()
       iterswptr->lower_bound = -1;
       iterswptr->upper_bound = -1;
       iterswptr->min_listed = -1;
+      iterswptr->head = NULL;
+      iterswptr->tail = NULL;
       return iterswptr;
     }
   }
@@ -714,31 +730,84 @@ window_lookup(seed_id_t *s, uint8_t m)
   return NULL;
 }
 /*---------------------------------------------------------------------------*/
-static void
-window_update_bounds()
+/*
+ * Find the buffered packet with sequence value seq_val in window w. The list
+ * is ordered, so we can stop as soon as we walk past seq_val
+ */
+static struct mcast_packet *
+window_find(struct sliding_window *w, uint16_t seq_val)
 {
-  for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
-      iterswptr--) {
-    iterswptr->lower_bound = -1;
-  }
+  struct mcast_packet *p;
 
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      iterswptr = locmpptr->sw;
-      VERBOSE_PRINTF("ROLL TM: Update Bounds: [%d - %d] vs %u\n",
-                     iterswptr->lower_bound, iterswptr->upper_bound,
-                     locmpptr->seq_val);
-      if(iterswptr->lower_bound < 0
-         || SEQ_VAL_IS_LT(locmpptr->seq_val, iterswptr->lower_bound)) {
-        iterswptr->lower_bound = locmpptr->seq_val;
-      }
-      if(iterswptr->upper_bound < 0 ||
-         SEQ_VAL_IS_GT(locmpptr->seq_val, iterswptr->upper_bound)) {
-        iterswptr->upper_bound = locmpptr->seq_val;
-      }
+  if(w->tail == NULL || SEQ_VAL_IS_GT(seq_val, w->tail->seq_val)) {
+    return NULL;
+  }
+  for(p = w->head; p != NULL; p = p->next) {
+    if(SEQ_VAL_IS_EQ(p->seq_val, seq_val)) {
+      return p;
+    }
+    if(SEQ_VAL_IS_GT(p->seq_val, seq_val)) {
+      break;
     }
   }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Link packet p into window w, keeping the list ordered by sequence value.
+ * New packets normally carry the highest value seen so far, so we check the
+ * tail first
+ */
+static void
+window_insert(struct sliding_window *w, struct mcast_packet *p)
+{
+  struct mcast_packet *prev;
+
+  p->sw = w;
+  p->next = NULL;
+  w->count++;
+
+  if(w->tail == NULL) {
+    w->head = w->tail = p;
+  } else if(SEQ_VAL_IS_GT(p->seq_val, w->tail->seq_val)) {
+    w->tail->next = p;
+    w->tail = p;
+  } else if(SEQ_VAL_IS_LT(p->seq_val, w->head->seq_val)) {
+    p->next = w->head;
+    w->head = p;
+  } else {
+    for(prev = w->head; SEQ_VAL_IS_LT(prev->next->seq_val, p->seq_val);
+        prev = prev->next);
+    p->next = prev->next;
+    prev->next = p;
+  }
+  w->lower_bound = w->head->seq_val;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Unlink packet p from window w and return it to the free list. prev is the
+ * packet before p in the window, or NULL if p is the first one. The lower
+ * bound follows the list head. The upper bound remains the highest sequence
+ * value we have seen for this window
+ */
+static void
+buffer_free(struct sliding_window *w, struct mcast_packet *prev,
+            struct mcast_packet *p)
+{
+  if(prev == NULL) {
+    w->head = p->next;
+  } else {
+    prev->next = p->next;
+  }
+  if(w->tail == p) {
+    w->tail = prev;
+  }
+  w->count--;
+  w->lower_bound = w->head != NULL ? w->head->seq_val : -1;
+
+  MCAST_PACKET_FREE(p);
+  p->next = free_msgs;
+  free_msgs = p;
 }
 /*---------------------------------------------------------------------------*/
 static struct mcast_packet *
@@ -754,7 +823,7 @@ buffer_reclaim()
     }
   }
 
-  if(largest->count == 1) {
+  if(largest->count <= 1) {
     /* Can't reclaim last entry for a window and this is the largest window */
     return NULL;
   }
@@ -763,36 +832,27 @@ buffer_reclaim()
   PRINT_SEED(&largest->seed_id);
   PRINTF(" M=%u, count was %u\n",
          SLIDING_WINDOW_GET_M(largest), largest->count);
-  /* Find the packet at the lowest bound for the largest window */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr) && (locmpptr->sw == largest) &&
-       SEQ_VAL_IS_EQ(locmpptr->seq_val, largest->lower_bound)) {
-      rv = locmpptr;
-      PRINTF("ROLL TM: Reclaim seq. val %u\n", locmpptr->seq_val);
-      MCAST_PACKET_FREE(rv);
-      largest->count--;
-      window_update_bounds();
-      VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%u , %u]\n",
-                     largest->lower_bound, largest->upper_bound);
-      return rv;
-    }
-  }
 
-  /* oops */
-  return NULL;
+  /* The packet at the lowest bound heads the largest window's list */
+  rv = largest->head;
+  PRINTF("ROLL TM: Reclaim seq. val %u\n", rv->seq_val);
+  buffer_free(largest, NULL, rv);
+  VERBOSE_PRINTF("ROLL TM: Reclaim - new bounds [%u , %u]\n",
+                 largest->lower_bound, largest->upper_bound);
+
+  /* buffer_free() put it on the free list, take it straight back */
+  free_msgs = rv->next;
+  return rv;
 }
 /*---------------------------------------------------------------------------*/
 static struct mcast_packet *
 buffer_allocate()
 {
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(!MCAST_PACKET_IS_USED(locmpptr)) {
-      return locmpptr;
-    }
+  locmpptr = free_msgs;
+  if(locmpptr != NULL) {
+    free_msgs = locmpptr->next;
   }
-  return NULL;
+  return locmpptr;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -832,18 +892,15 @@ icmp_output()
 
       buffer = (uint8_t *)sl + sizeof(struct sequence_list_header);
 
-      for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-          locmpptr >= buffered_msgs; locmpptr--) {
-        if(MCAST_PACKET_IS_USED(locmpptr) &&
-           locmpptr->active < TRICKLE_ACTIVE((&t[SLIDING_WINDOW_GET_M(iterswptr)]))) {
-          if(locmpptr->sw == iterswptr) {
-            sl->seq_len++;
-            PRINTF(", %u", locmpptr->seq_val);
-            *buffer = (uint8_t)(locmpptr->seq_val >> 8);
-            buffer++;
-            *buffer = (uint8_t)(locmpptr->seq_val & 0xFF);
-            buffer++;
-          }
+      for(locmpptr = iterswptr->head; locmpptr != NULL;
+          locmpptr = locmpptr->next) {
+        if(locmpptr->active < TRICKLE_ACTIVE((&t[SLIDING_WINDOW_GET_M(iterswptr)]))) {
+          sl->seq_len++;
+          PRINTF(", %u", locmpptr->seq_val);
+          *buffer = (uint8_t)(locmpptr->seq_val >> 8);
+          buffer++;
+          *buffer = (uint8_t)(locmpptr->seq_val & 0xFF);
+          buffer++;
         }
       }
       PRINTF(", Len=%u\n", sl->seq_len);
@@ -978,17 +1035,11 @@ accept(uint8_t in)
       UIP_MCAST6_STATS_ADD(mcast_dropped);
       return UIP_MCAST6_DROP;
     }
-    for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-        locmpptr >= buffered_msgs; locmpptr--) {
-      if(MCAST_PACKET_IS_USED(locmpptr) &&
-         locmpptr->sw == locswptr &&
-         SLIDING_WINDOW_GET_M(locmpptr->sw) == m &&
-         SEQ_VAL_IS_EQ(seq_val, locmpptr->seq_val)) {
-        /* Seen before , drop */
-        PRINTF("ROLL TM: Seen before\n");
-        UIP_MCAST6_STATS_ADD(mcast_dropped);
-        return UIP_MCAST6_DROP;
-      }
+    if(window_find(locswptr, seq_val) != NULL) {
+      /* Seen before , drop */
+      PRINTF("ROLL TM: Seen before\n");
+      UIP_MCAST6_STATS_ADD(mcast_dropped);
+      return UIP_MCAST6_DROP;
     }
   }
 
@@ -1020,9 +1071,9 @@ accept(uint8_t in)
     PRINTF("ROLL TM: Buffer reclaim failed\n");
     if(locswptr->count == 0) {
       window_free(locswptr);
-      UIP_MCAST6_STATS_ADD(mcast_dropped);
-      return UIP_MCAST6_DROP;
     }
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
   }
 #if UIP_MCAST6_STATS
   if(in == ROLL_TM_DGRAM_IN) {
@@ -1043,27 +1094,21 @@ accept(uint8_t in)
   PRINTF(" M=%u, count=%u\n",
          SLIDING_WINDOW_GET_M(locswptr), locswptr->count);
 
-  /* If this window was previously empty, set its lower bound to this packet */
-  if(locswptr->count == 0) {
-    locswptr->lower_bound = seq_val;
-    VERBOSE_PRINTF("ROLL TM: New Lower Bound %u\n", locswptr->lower_bound);
-  }
-
   /* If this is a new Seq Num, update the window upper bound */
   if(locswptr->count == 0 || SEQ_VAL_IS_GT(seq_val, locswptr->upper_bound)) {
     locswptr->upper_bound = seq_val;
     VERBOSE_PRINTF("ROLL TM: New Upper Bound %u\n", locswptr->upper_bound);
   }
 
-  locswptr->count++;
-
   memset(locmpptr, 0, sizeof(struct mcast_packet));
   memcpy(&locmpptr->buff, UIP_IP_BUF, uip_len);
-  locmpptr->sw = locswptr;
   locmpptr->buff_len = uip_len;
   locmpptr->seq_val = seq_val;
   MCAST_PACKET_USED_SET(locmpptr);
 
+  /* Link it in order. This also moves the lower bound if needed */
+  window_insert(locswptr, locmpptr);
+
   PRINTF("ROLL TM: Window for seed ");
   PRINT_SEED(&locswptr->seed_id);
   PRINTF(" M=%u, %u values within [%u , %u]\n",
@@ -1136,16 +1181,14 @@ icmp_input()
 
   ROLL_TM_STATS_ADD(icmp_in);
 
-  /* Reset Is-Listed bit for all windows */
+  /* Reset Is-Listed bit for all windows and their cached packets */
   for(iterswptr = &windows[ROLL_TM_WINS - 1]; iterswptr >= windows;
       iterswptr--) {
     SLIDING_WINDOW_LISTED_CLR(iterswptr);
-  }
-
-  /* Reset Is-Listed bit for all cached packets */
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    MCAST_PACKET_LISTED_CLR(locmpptr);
+    for(locmpptr = iterswptr->head; locmpptr != NULL;
+        locmpptr = locmpptr->next) {
+      MCAST_PACKET_LISTED_CLR(locmpptr);
+    }
   }
 
   locslhptr = (struct sequence_list_header *)UIP_ICMP_PAYLOAD;
@@ -1222,23 +1265,17 @@ icmp_input()
 
           inconsistency = 1;
           /* Check if the advertised sequence is in our buffer */
-          for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-              locmpptr >= buffered_msgs; locmpptr--) {
-            if(MCAST_PACKET_IS_USED(locmpptr) && locmpptr->sw == locswptr) {
-              if(SEQ_VAL_IS_EQ(locmpptr->seq_val, val)) {
-
-                inconsistency = 0;
-                MCAST_PACKET_LISTED_SET(locmpptr);
-                PRINTF("ROLL TM: ICMPv6 In, %u listed\n", locmpptr->seq_val);
-
-                /* Update lowest seq. num listed for this window
-                 * We need this to check for "we have new" */
-                if(locswptr->min_listed == -1 ||
-                   SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
-                  locswptr->min_listed = val;
-                }
-                break;
-              }
+          locmpptr = window_find(locswptr, val);
+          if(locmpptr != NULL) {
+            inconsistency = 0;
+            MCAST_PACKET_LISTED_SET(locmpptr);
+            PRINTF("ROLL TM: ICMPv6 In, %u listed\n", locmpptr->seq_val);
+
+            /* Update lowest seq. num listed for this window
+             * We need this to check for "we have new" */
+            if(locswptr->min_listed == -1 ||
+               SEQ_VAL_IS_LT(val, locswptr->min_listed)) {
+              locswptr->min_listed = val;
             }
           }
           if(inconsistency) {
@@ -1265,10 +1302,10 @@ icmp_input()
 
   /* Check for "We have new */
   PRINTF("ROLL TM: ICMPv6 In, Check our buffer\n");
-  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
-      locmpptr >= buffered_msgs; locmpptr--) {
-    if(MCAST_PACKET_IS_USED(locmpptr)) {
-      locswptr = locmpptr->sw;
+  for(locswptr = &windows[ROLL_TM_WINS - 1]; locswptr >= windows;
+      locswptr--) {
+    for(locmpptr = locswptr->head; locmpptr != NULL;
+        locmpptr = locmpptr->next) {
       PRINTF("ROLL TM: ICMPv6 In, ");
       PRINTF("Check %u, Seed L: %u, This L: %u Min L: %d\n",
              locmpptr->seq_val, SLIDING_WINDOW_IS_LISTED(locswptr),
@@ -1417,6 +1454,14 @@ init()
   memset(buffered_msgs, 0, sizeof(buffered_msgs));
   memset(t, 0, sizeof(t));
 
+  /* All buffers start on the free list */
+  free_msgs = NULL;
+  for(locmpptr = &buffered_msgs[ROLL_TM_BUFF_NUM - 1];
+      locmpptr >= buffered_msgs; locmpptr--) {
+    locmpptr->next = free_msgs;
+    free_msgs = locmpptr;
+  }
+
   ROLL_TM_STATS_INIT();
   UIP_MCAST6_STATS_INIT(&stats);
 
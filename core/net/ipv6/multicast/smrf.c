@@ -49,6 +49,7 @@
 #include "net/ipv6/multicast/smrf.h"
 #include "net/rpl/rpl.h"
 #include "net/netstack.h"
+#include "lib/dup-cache.h"
 #include <string.h>
 
 #define DEBUG DEBUG_NONE
@@ -69,6 +70,9 @@ static uint8_t mcast_len;
 static uip_buf_t mcast_buf;
 static uint8_t fwd_delay;
 static uint8_t fwd_spread;
+#if SMRF_DUP_CACHE_BITS
+DUP_CACHE(seen, SMRF_DUP_CACHE_BITS, 2, SMRF_DUP_CACHE_LIFETIME);
+#endif
 /*---------------------------------------------------------------------------*/
 /* uIPv6 Pointers */
 /*---------------------------------------------------------------------------*/
@@ -84,6 +88,25 @@ mcast_fwd(void *p)
   uip_clear_buf();
 }
 /*---------------------------------------------------------------------------*/
+#if SMRF_DUP_CACHE_BITS
+/*
+ * Hash the parts of the datagram that stay the same along the way: the
+ * addresses and everything after the extension headers. The hop limit and
+ * the RPL option change at every hop
+ */
+static int
+is_duplicate(void)
+{
+  uint32_t hash;
+
+  hash = dup_cache_hash(DUP_CACHE_HASH_INIT, &UIP_IP_BUF->srcipaddr,
+                        2 * sizeof(uip_ipaddr_t));
+  hash = dup_cache_hash(hash, &uip_buf[uip_l2_l3_hdr_len],
+                        uip_len - UIP_IPH_LEN - uip_ext_len);
+  return dup_cache_check(&seen, hash);
+}
+#endif
+/*---------------------------------------------------------------------------*/
 static uint8_t
 in()
 {
@@ -131,6 +154,15 @@ in()
   }
 
   UIP_MCAST6_STATS_ADD(mcast_in_all);
+
+#if SMRF_DUP_CACHE_BITS
+  if(is_duplicate()) {
+    PRINTF("SMRF: Duplicate, dropped\n");
+    UIP_MCAST6_STATS_ADD(mcast_dropped);
+    return UIP_MCAST6_DROP;
+  }
+#endif
+
   UIP_MCAST6_STATS_ADD(mcast_in_unique);
 
   /* If we have an entry in the mcast routing table, something with
@@ -69,6 +69,27 @@
 #else
 #define SMRF_MAX_SPREAD 4
 #endif
+
+/*
+ * Duplicate suppression, off by default. SMRF datagrams carry no
+ * sequence number, so a datagram is identified by its addresses and
+ * upper layer contents, and identical datagrams from the same seed
+ * within the cache lifetime are dropped. Only enable it (with a size in
+ * bits, e.g. 256) when the application makes its datagrams unique, for
+ * instance with a sequence number in the payload
+ */
+#ifdef SMRF_CONF_DUP_CACHE_BITS
+#define SMRF_DUP_CACHE_BITS SMRF_CONF_DUP_CACHE_BITS
+#else
+#define SMRF_DUP_CACHE_BITS 0
+#endif
+
+/* Datagrams are remembered for one to two of these */
+#ifdef SMRF_CONF_DUP_CACHE_LIFETIME
+#define SMRF_DUP_CACHE_LIFETIME SMRF_CONF_DUP_CACHE_LIFETIME
+#else
+#define SMRF_DUP_CACHE_LIFETIME (2 * CLOCK_SECOND)
+#endif
 /*---------------------------------------------------------------------------*/
 /* Stats datatype */
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \addtogroup sicslowpan
+ * @{
+ */
+
+/**
+ * \file
+ *    6LoWPAN Generic Header Compression (RFC 7400)
+ */
+
+#include "net/ipv6/sicslowpan-ghc.h"
+#include <string.h>
+
+/* Byte codes, RFC 7400 section 2 */
+#define GHC_LITERAL_MAX   0x5f /* 0kkkkkkk: k < 96 bytes follow */
+#define GHC_ZEROS         0x80 /* 1000nnnn: nnnn + 2 zero bytes */
+#define GHC_ZEROS_MAX     17
+#define GHC_STOP          0x90
+#define GHC_EXTEND        0xa0 /* 101nssss: sa += ssss << 3, na += n << 3 */
+#define GHC_EXTEND_N      0x10
+#define GHC_BACKREF       0xc0 /* 11nnnkkk: back reference */
+
+static const uint8_t static_dict[16] = {
+  0x16, 0xfe, 0xfd, 0x17, 0xfe, 0xfd, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00
+};
+
+/* Byte i of the dictionary followed by the data */
+#define HISTORY(dict, data, i) ((i) < SICSLOWPAN_GHC_DICT_LEN ? \
+    (dict)[i] : (data)[(i) - SICSLOWPAN_GHC_DICT_LEN])
+/*---------------------------------------------------------------------------*/
+void
+sicslowpan_ghc_dict(uint8_t *dict, const uip_ipaddr_t *src,
+                    const uip_ipaddr_t *dest)
+{
+  memcpy(dict, src, 16);
+  memcpy(dict + 16, dest, 16);
+  memcpy(dict + 32, static_dict, sizeof(static_dict));
+}
+/*---------------------------------------------------------------------------*/
+/* Bytes needed for a back reference of n bytes, ending d bytes before
+   the current position */
+static int
+backref_cost(int d, int n)
+{
+  int sa, na;
+
+  sa = ((d >> 3) + 14) / 15;
+  na = (n - 2) >> 3;
+  return 1 + (sa > na ? sa : na);
+}
+/*---------------------------------------------------------------------------*/
+static int
+flush_literal(const uint8_t *in, int start, int end, uint8_t *out, int o,
+              int out_max)
+{
+  int k;
+
+  while(start < end) {
+    k = end - start;
+    if(k > GHC_LITERAL_MAX) {
+      k = GHC_LITERAL_MAX;
+    }
+    if(o + 1 + k > out_max) {
+      return -1;
+    }
+    out[o++] = k;
+    memcpy(out + o, in + start, k);
+    o += k;
+    start += k;
+  }
+  return o;
+}
+/*---------------------------------------------------------------------------*/
+int
+sicslowpan_ghc_compress(const uint8_t *dict, const uint8_t *in, int in_len,
+                        uint8_t *out, int out_max)
+{
+  int pos, literal, o;
+  int cur, start, n, z;
+  int best_n, best_start, best_gain;
+  int d, m, sa, na, s4;
+
+  o = 0;
+  pos = 0;
+  literal = 0;
+  while(pos < in_len) {
+    /* Greedily take whichever code saves the most bytes here. */
+    best_n = 0;
+    best_start = 0;
+    best_gain = 0;
+    cur = pos + SICSLOWPAN_GHC_DICT_LEN;
+    for(start = 0; start + 2 <= cur; start++) {
+      for(n = 0; pos + n < in_len && start + n < cur &&
+            HISTORY(dict, in, start + n) == in[pos + n]; n++);
+      if(n >= 2 && n - backref_cost(cur - start - n, n) > best_gain) {
+        best_n = n;
+        best_start = start;
+        best_gain = n - backref_cost(cur - start - n, n);
+      }
+    }
+
+    for(z = 0; pos + z < in_len && z < GHC_ZEROS_MAX && in[pos + z] == 0; z++);
+    if(z >= 2 && z - 1 >= best_gain) {
+      if((o = flush_literal(in, literal, pos, out, o, out_max)) < 0 ||
+         o + 1 > out_max) {
+        return -1;
+      }
+      out[o++] = GHC_ZEROS | (z - 2);
+      pos += z;
+      literal = pos;
+    } else if(best_gain > 0) {
+      if((o = flush_literal(in, literal, pos, out, o, out_max)) < 0 ||
+         o + backref_cost(cur - best_start - best_n, best_n) > out_max) {
+        return -1;
+      }
+      /* s = d + n, with d split into sa + kkk and n - 2 into na + nnn */
+      d = cur - best_start - best_n;
+      m = best_n - 2;
+      sa = d >> 3;
+      na = m >> 3;
+      while(sa > 0 || na > 0) {
+        s4 = sa > 15 ? 15 : sa;
+        out[o++] = GHC_EXTEND | (na > 0 ? GHC_EXTEND_N : 0) | s4;
+        sa -= s4;
+        if(na > 0) {
+          na--;
+        }
+      }
+      out[o++] = GHC_BACKREF | ((m & 7) << 3) | (d & 7);
+      pos += best_n;
+      literal = pos;
+    } else {
+      pos++;
+    }
+  }
+  return flush_literal(in, literal, pos, out, o, out_max);
+}
+/*---------------------------------------------------------------------------*/
+int
+sicslowpan_ghc_decompress(const uint8_t *dict, const uint8_t *in, int in_len,
+                          uint8_t *out, int out_max)
+{
+  int i, o, n, s, sa, na;
+  uint8_t c;
+
+  i = 0;
+  o = 0;
+  sa = 0;
+  na = 0;
+  while(i < in_len) {
+    c = in[i++];
+    if(c <= GHC_LITERAL_MAX) {
+      if(i + c > in_len || o + c > out_max) {
+        return -1;
+      }
+      memcpy(out + o, in + i, c);
+      i += c;
+      o += c;
+    } else if((c & 0xf0) == GHC_ZEROS) {
+      n = (c & 0x0f) + 2;
+      if(o + n > out_max) {
+        return -1;
+      }
+      memset(out + o, 0, n);
+      o += n;
+    } else if(c == GHC_STOP) {
+      break;
+    } else if((c & 0xe0) == GHC_EXTEND) {
+      sa += (c & 0x0f) << 3;
+      na += (c & GHC_EXTEND_N) >> 1;
+    } else if((c & 0xc0) == GHC_BACKREF) {
+      n = na + ((c >> 3) & 7) + 2;
+      s = sa + (c & 7) + n;
+      sa = 0;
+      na = 0;
+      if(s > o + SICSLOWPAN_GHC_DICT_LEN || o + n > out_max) {
+        return -1;
+      }
+      /* s >= n, so the copy never reads bytes it writes itself */
+      for(s = o + SICSLOWPAN_GHC_DICT_LEN - s; n > 0; n--, s++) {
+        out[o++] = HISTORY(dict, out, s);
+      }
+    } else {
+      /* Reserved code */
+      return -1;
+    }
+  }
+  return o;
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
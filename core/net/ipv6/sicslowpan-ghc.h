@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+/**
+ * \addtogroup sicslowpan
+ * @{
+ */
+
+/**
+ * \file
+ *    6LoWPAN Generic Header Compression (RFC 7400)
+ *
+ *    GHC compresses the payload that follows the IPHC header with a
+ *    byte code of literals, zero runs and back references into the
+ *    data decompressed so far. Back references may also reach into a
+ *    dictionary made of the source and destination addresses and a
+ *    16-byte static dictionary, which is what makes GHC useful on
+ *    the short ICMPv6 and UDP messages of constrained networks.
+ */
+
+#ifndef SICSLOWPAN_GHC_H_
+#define SICSLOWPAN_GHC_H_
+
+#include "net/ip/uip.h"
+
+/** Length of the dictionary that precedes the data */
+#define SICSLOWPAN_GHC_DICT_LEN 48
+
+/**
+ * \brief Set up the dictionary for a packet
+ * \param dict Buffer of SICSLOWPAN_GHC_DICT_LEN bytes
+ * \param src The IPv6 source address of the packet
+ * \param dest The IPv6 destination address of the packet
+ */
+void sicslowpan_ghc_dict(uint8_t *dict, const uip_ipaddr_t *src,
+                         const uip_ipaddr_t *dest);
+
+/**
+ * \brief Compress data
+ * \param dict The dictionary of the packet
+ * \param in The data to compress
+ * \param in_len Length of the data
+ * \param out Buffer for the compressed data
+ * \param out_max Size of the buffer
+ * \return The length of the compressed data, or -1 if it did not fit
+ */
+int sicslowpan_ghc_compress(const uint8_t *dict, const uint8_t *in,
+                            int in_len, uint8_t *out, int out_max);
+
+/**
+ * \brief Decompress data
+ * \param dict The dictionary of the packet
+ * \param in The compressed data
+ * \param in_len Length of the compressed data
+ * \param out Buffer for the decompressed data
+ * \param out_max Size of the buffer
+ * \return The length of the decompressed data, or -1 if the data was
+ *         malformed or did not fit
+ */
+int sicslowpan_ghc_decompress(const uint8_t *dict, const uint8_t *in,
+                              int in_len, uint8_t *out, int out_max);
+
+#endif /* SICSLOWPAN_GHC_H_ */
+/** @} */
@@ -67,7 +67,10 @@
 #include "net/ipv6/uip-ds6.h"
 #include "net/rime/rime.h"
 #include "net/ipv6/sicslowpan.h"
+#include "net/ipv6/sicslowpan-ghc.h"
 #include "net/netstack.h"
+#include "net/nbr-table.h"
+#include "net/link-stats.h"
 
 #include <stdio.h>
 
@@ -100,6 +103,10 @@ void uip_log(char *msg);
 #endif /* SICSLOWPAN_CONF_COMPRESSION */
 #endif /* SICSLOWPAN_COMPRESSION */
 
+#if SICSLOWPAN_GHC && SICSLOWPAN_COMPRESSION != SICSLOWPAN_COMPRESSION_HC06
+#error "6LoWPAN-GHC is an extension of IPHC, use SICSLOWPAN_COMPRESSION_HC06"
+#endif
+
 #define GET16(ptr,index) (((uint16_t)((ptr)[index] << 8)) | ((ptr)[(index) + 1]))
 #define SET16(ptr,index,value) do {     \
   (ptr)[index] = ((value) >> 8) & 0xff; \
@@ -193,7 +200,7 @@ static int packetbuf_payload_len;
  * uncomp_hdr_len is the length of the headers before compression (if HC2
  * is used this includes the UDP header in addition to the IP header).
  */
-static uint8_t uncomp_hdr_len;
+static uint16_t uncomp_hdr_len;
 
 /**
  * the result of the last transmitted fragment
@@ -486,7 +493,40 @@ set_packet_attrs(void)
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
 static struct sicslowpan_addr_context
 addr_contexts[SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS];
-#endif
+
+/** Slot in addr_contexts plus one of each CID, 0 if the CID is unused. */
+static uint8_t context_index[16];
+
+/** Ticks once a minute while a context has a finite lifetime. */
+static struct ctimer context_timer;
+
+/** Changes whenever a context is added, removed or (de)activated. */
+static uint8_t context_version;
+
+#if SICSLOWPAN_CONTEXT_LEARNING
+/** Prefixes without a context, and how often they were seen recently. */
+#define LEARN_CANDIDATES 4
+static struct {
+  uint8_t prefix[8];
+  uint8_t count;
+} learn_candidates[LEARN_CANDIDATES];
+#endif /* SICSLOWPAN_CONTEXT_LEARNING */
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
+#if SICSLOWPAN_STATS
+struct sicslowpan_stats sicslowpan_stats;
+#endif /* SICSLOWPAN_STATS */
+
+#if SICSLOWPAN_GHC
+/** Frame space for the packet being compressed if its payload may be
+    GHC compressed, 0 otherwise. */
+static int ghc_out_max;
+
+#if !SICSLOWPAN_GHC_ALL_NEIGHBORS
+/** Neighbors known to support GHC. The entries carry no data. */
+NBR_TABLE(uint8_t, ghc_neighbors);
+#endif /* !SICSLOWPAN_GHC_ALL_NEIGHBORS */
+#endif /* SICSLOWPAN_GHC */
 
 /** pointer to an address context. */
 static struct sicslowpan_addr_context *context;
@@ -527,7 +567,7 @@ static const uint8_t ttl_values[] = {0, 1, 64, 255};
 /** \name IPHC related functions
  * @{                                                                 */
 /*--------------------------------------------------------------------*/
-/** \brief find the context corresponding to prefix ipaddr */
+/** \brief find the context that compresses the prefix of ipaddr */
 static struct sicslowpan_addr_context*
 addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
 {
@@ -536,6 +576,7 @@ addr_context_lookup_by_prefix(uip_ipaddr_t *ipaddr)
   int i;
   for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
     if((addr_contexts[i].used == 1) &&
+       (addr_contexts[i].flags & SICSLOWPAN_CONTEXT_FLAG_COMPRESS) &&
        uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, ipaddr, 64)) {
       return &addr_contexts[i];
     }
@@ -550,17 +591,329 @@ addr_context_lookup_by_number(uint8_t number)
 {
 /* Remove code to avoid warnings and save flash if no context is used */
 #if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  if(number < sizeof(context_index) && context_index[number] != 0) {
+    return &addr_contexts[context_index[number] - 1];
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+static void
+addr_context_remove(struct sicslowpan_addr_context *c)
+{
+  PRINTF("IPHC: removing context %u\n", c->number);
+  context_index[c->number] = 0;
+  c->used = 0;
+  context_version++;
+}
+/*--------------------------------------------------------------------*/
+static void context_timer_callback(void *ptr);
+
+static void
+context_timer_start(void)
+{
+  if(ctimer_expired(&context_timer)) {
+    ctimer_set(&context_timer, 60 * CLOCK_SECOND, context_timer_callback, NULL);
+  }
+}
+/*--------------------------------------------------------------------*/
+static void
+context_timer_callback(void *ptr)
+{
+  struct sicslowpan_addr_context *c;
+  uint8_t pending;
+
+  pending = 0;
+  for(c = addr_contexts; c < addr_contexts + SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; c++) {
+    if(!c->used || c->lifetime == SICSLOWPAN_CONTEXT_LIFETIME_INFINITE) {
+      continue;
+    }
+    if(c->lifetime > 1) {
+      c->lifetime--;
+      pending = 1;
+    } else if(c->flags & SICSLOWPAN_CONTEXT_FLAG_LOCAL) {
+      /* The activation delay of a learned context is over. */
+      PRINTF("IPHC: compressing with context %u\n", c->number);
+      c->flags |= SICSLOWPAN_CONTEXT_FLAG_COMPRESS;
+      c->lifetime = SICSLOWPAN_CONTEXT_LIFETIME_INFINITE;
+      context_version++;
+    } else if(c->flags & SICSLOWPAN_CONTEXT_FLAG_COMPRESS) {
+      /* Stop compressing, but keep decompressing packets from nodes
+         that still use the context for a while (RFC 6775, 7.2). */
+      c->flags &= ~SICSLOWPAN_CONTEXT_FLAG_COMPRESS;
+      c->lifetime = SICSLOWPAN_CONTEXT_LIFETIME;
+      context_version++;
+      pending = 1;
+    } else {
+      addr_context_remove(c);
+    }
+  }
+
+#if SICSLOWPAN_CONTEXT_LEARNING
+  {
+    int i;
+    /* Only prefixes seen often within the last minutes are learned. */
+    for(i = 0; i < LEARN_CANDIDATES; i++) {
+      learn_candidates[i].count >>= 1;
+      if(learn_candidates[i].count > 0) {
+        pending = 1;
+      }
+    }
+  }
+#endif /* SICSLOWPAN_CONTEXT_LEARNING */
+
+  if(pending) {
+    ctimer_reset(&context_timer);
+  }
+}
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_CONTEXT_LEARNING
+static void
+context_learn_observe(uip_ipaddr_t *ipaddr)
+{
+  int i, victim;
+
+  if(uip_is_addr_unspecified(ipaddr) || uip_is_addr_mcast(ipaddr) ||
+     uip_is_addr_linklocal(ipaddr)) {
+    return;
+  }
+
+  victim = 0;
+  for(i = 0; i < LEARN_CANDIDATES; i++) {
+    if(learn_candidates[i].count > 0 &&
+       memcmp(learn_candidates[i].prefix, ipaddr, 8) == 0) {
+      if(++learn_candidates[i].count >= SICSLOWPAN_CONTEXT_LEARN_THRESHOLD) {
+        learn_candidates[i].count = 0;
+        sicslowpan_context_learn(ipaddr);
+      }
+      return;
+    }
+    if(learn_candidates[i].count < learn_candidates[victim].count) {
+      victim = i;
+    }
+  }
+
+  memcpy(learn_candidates[victim].prefix, ipaddr, 8);
+  learn_candidates[victim].count = 1;
+  context_timer_start();
+}
+#endif /* SICSLOWPAN_CONTEXT_LEARNING */
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+/*--------------------------------------------------------------------*/
+const struct sicslowpan_addr_context *
+sicslowpan_context_get(uint8_t number)
+{
+  return addr_context_lookup_by_number(number);
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_set(uint8_t number, const uip_ipaddr_t *prefix,
+                       uint8_t length, uint8_t flags, uint16_t lifetime)
+{
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  struct sicslowpan_addr_context *c;
+  uint8_t bits[8];
   int i;
+
+  if(number >= sizeof(context_index) || length > 64) {
+    return 0;
+  }
+
+  c = addr_context_lookup_by_number(number);
+  if(c != NULL && (c->flags & SICSLOWPAN_CONTEXT_FLAG_LOCAL) &&
+     !(flags & SICSLOWPAN_CONTEXT_FLAG_LOCAL)) {
+    /* Our own configuration takes precedence. */
+    return 0;
+  }
+
+  if(lifetime == 0) {
+    if(c != NULL) {
+      addr_context_remove(c);
+    }
+    return 0;
+  }
+
+  if(c == NULL) {
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      if(!addr_contexts[i].used) {
+        break;
+      }
+    }
+    if(i == SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS) {
+      PRINTF("IPHC: no room for context %u\n", number);
+      return 0;
+    }
+    c = &addr_contexts[i];
+    memset(c, 0, sizeof(*c));
+    c->used = 1;
+    c->number = number;
+    context_index[number] = i + 1;
+    context_version++;
+  }
+
+  /* Bits beyond the prefix length are zero in compressed addresses. */
+  memset(bits, 0, sizeof(bits));
+  memcpy(bits, prefix, (length + 7) / 8);
+  if(length % 8) {
+    bits[length / 8] &= 0xff << (8 - length % 8);
+  }
+
+  if(memcmp(c->prefix, bits, sizeof(bits)) != 0 || c->length != length ||
+     (c->flags & SICSLOWPAN_CONTEXT_FLAG_COMPRESS) !=
+     (flags & SICSLOWPAN_CONTEXT_FLAG_COMPRESS)) {
+    PRINTF("IPHC: context %u set, length %u flags %u lifetime %u\n",
+           number, length, flags, lifetime);
+    context_version++;
+  }
+  memcpy(c->prefix, bits, sizeof(bits));
+  c->length = length;
+  c->flags = flags;
+  c->lifetime = lifetime;
+
+  if(lifetime != SICSLOWPAN_CONTEXT_LIFETIME_INFINITE) {
+    context_timer_start();
+  }
+  return 1;
+#else /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return 0;
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_learn(const uip_ipaddr_t *prefix)
+{
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  uint8_t number;
+  int i;
+
   for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
-    if((addr_contexts[i].used == 1) &&
-       addr_contexts[i].number == number) {
-      return &addr_contexts[i];
+    if(addr_contexts[i].used &&
+       uip_ipaddr_prefixcmp(&addr_contexts[i].prefix, prefix, 64)) {
+      return addr_contexts[i].number;
     }
   }
+
+  for(number = 1; number < sizeof(context_index); number++) {
+    if(context_index[number] == 0) {
+      break;
+    }
+  }
+  if(number == sizeof(context_index)) {
+    return -1;
+  }
+
+  PRINTF("IPHC: learning context %u for ", number);
+  PRINT6ADDR(prefix);
+  PRINTF("\n");
+
+#if SICSLOWPAN_CONTEXT_ACTIVATION_DELAY > 0
+  if(sicslowpan_context_set(number, prefix, 64, SICSLOWPAN_CONTEXT_FLAG_LOCAL,
+                            SICSLOWPAN_CONTEXT_ACTIVATION_DELAY)) {
+    return number;
+  }
+#else /* SICSLOWPAN_CONTEXT_ACTIVATION_DELAY > 0 */
+  if(sicslowpan_context_set(number, prefix, 64,
+                            SICSLOWPAN_CONTEXT_FLAG_LOCAL |
+                            SICSLOWPAN_CONTEXT_FLAG_COMPRESS,
+                            SICSLOWPAN_CONTEXT_LIFETIME_INFINITE)) {
+    return number;
+  }
+#endif /* SICSLOWPAN_CONTEXT_ACTIVATION_DELAY > 0 */
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
-  return NULL;
+  return -1;
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_write_6co(uint8_t *buf, uint8_t number)
+{
+  struct sicslowpan_addr_context *c;
+  uint16_t lifetime;
+
+  c = addr_context_lookup_by_number(number);
+  if(c == NULL) {
+    return 0;
+  }
+
+  if(c->flags & SICSLOWPAN_CONTEXT_FLAG_LOCAL) {
+    lifetime = SICSLOWPAN_CONTEXT_LIFETIME;
+  } else {
+    lifetime = c->lifetime;
+  }
+
+  buf[0] = c->length;
+  buf[1] = c->number & SICSLOWPAN_6CO_CID_MASK;
+  if(c->flags & SICSLOWPAN_CONTEXT_FLAG_COMPRESS) {
+    buf[1] |= SICSLOWPAN_6CO_FLAG_C;
+  }
+  buf[2] = 0;
+  buf[3] = 0;
+  SET16(buf, 4, lifetime);
+  memcpy(buf + 6, c->prefix, 8);
+  return SICSLOWPAN_6CO_BODY_LEN;
 }
 /*--------------------------------------------------------------------*/
+void
+sicslowpan_context_read_6co(const uint8_t *buf, int len)
+{
+  uip_ipaddr_t prefix;
+  uint8_t length;
+
+  if(len < 6) {
+    return;
+  }
+  length = buf[0];
+  if(length > 64 || len < 6 + (length + 7) / 8) {
+    /* Longer contexts would also cover the interface identifier. */
+    PRINTF("IPHC: ignoring 6CO with context length %u\n", length);
+    return;
+  }
+
+  memset(&prefix, 0, sizeof(prefix));
+  memcpy(&prefix, buf + 6, (length + 7) / 8);
+  sicslowpan_context_set(buf[1] & SICSLOWPAN_6CO_CID_MASK, &prefix, length,
+                         (buf[1] & SICSLOWPAN_6CO_FLAG_C) ?
+                         SICSLOWPAN_CONTEXT_FLAG_COMPRESS : 0,
+                         GET16(buf, 4));
+}
+/*--------------------------------------------------------------------*/
+uint8_t
+sicslowpan_context_version(void)
+{
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  return context_version;
+#else /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+  return 0;
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+}
+/*--------------------------------------------------------------------*/
+#if SICSLOWPAN_GHC
+static int
+ghc_neighbor_lookup(const linkaddr_t *lladdr)
+{
+#if SICSLOWPAN_GHC_ALL_NEIGHBORS
+  return 1;
+#else /* SICSLOWPAN_GHC_ALL_NEIGHBORS */
+  return !linkaddr_cmp(lladdr, &linkaddr_null) &&
+    nbr_table_get_from_lladdr(ghc_neighbors, lladdr) != NULL;
+#endif /* SICSLOWPAN_GHC_ALL_NEIGHBORS */
+}
+/*--------------------------------------------------------------------*/
+void
+sicslowpan_ghc_neighbor_capable(const linkaddr_t *lladdr)
+{
+#if !SICSLOWPAN_GHC_ALL_NEIGHBORS
+  if(nbr_table_get_from_lladdr(ghc_neighbors, lladdr) == NULL &&
+     nbr_table_add_lladdr(ghc_neighbors, lladdr,
+                          NBR_TABLE_REASON_UNDEFINED, NULL) != NULL) {
+    PRINTF("GHC: neighbor ");
+    PRINTLLADDR((const uip_lladdr_t *)lladdr);
+    PRINTF(" supports GHC\n");
+  }
+#endif /* !SICSLOWPAN_GHC_ALL_NEIGHBORS */
+}
+#endif /* SICSLOWPAN_GHC */
+/*--------------------------------------------------------------------*/
 static uint8_t
 compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
 {
@@ -660,6 +1013,11 @@ static void
 compress_hdr_iphc(linkaddr_t *link_destaddr)
 {
   uint8_t tmp, iphc0, iphc1;
+  struct sicslowpan_addr_context *src_context, *dest_context;
+#if SICSLOWPAN_GHC
+  uint8_t ghc;
+  uint8_t *nh_ptr, *nhc_ptr;
+#endif /* SICSLOWPAN_GHC */
 #if DEBUG
   { uint16_t ndx;
     PRINTF("before compression (%d): ", UIP_IP_BUF->len[1]);
@@ -690,11 +1048,27 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
    */
 
 
-  /* check if dest context exists (for allocating third byte) */
-  /* TODO: fix this so that it remembers the looked up values for
-     avoiding two lookups - or set the lookup values immediately */
-  if(addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr) != NULL ||
-     addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr) != NULL) {
+  /* Look up the contexts of both addresses once. */
+  src_context = NULL;
+  if(!uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
+    src_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr);
+  }
+  dest_context = NULL;
+  if(!uip_is_addr_mcast(&UIP_IP_BUF->destipaddr)) {
+    dest_context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr);
+  }
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 && SICSLOWPAN_CONTEXT_LEARNING
+  if(src_context == NULL) {
+    context_learn_observe(&UIP_IP_BUF->srcipaddr);
+  }
+  if(dest_context == NULL) {
+    context_learn_observe(&UIP_IP_BUF->destipaddr);
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 && SICSLOWPAN_CONTEXT_LEARNING */
+
+  /* The [ SCI | DCI ] byte is only needed for contexts other than 0 */
+  if((src_context != NULL && src_context->number != 0) ||
+     (dest_context != NULL && dest_context->number != 0)) {
     /* set context flag and increase hc06_ptr */
     PRINTF("IPHC: compressing dest or src ipaddr - setting CID\n");
     iphc1 |= SICSLOWPAN_IPHC_CID;
@@ -754,6 +1128,19 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   }
 #endif /*UIP_CONF_UDP*/
 
+#if SICSLOWPAN_GHC
+  /* An ICMPv6 message is GHC compressed as a whole, behind an NHC
+     byte. Remember where the next header would go, in case the
+     message turns out not to compress. */
+  ghc = ghc_out_max > 0 &&
+    (UIP_IP_BUF->proto == UIP_PROTO_UDP ||
+     UIP_IP_BUF->proto == UIP_PROTO_ICMP6);
+  if(ghc && UIP_IP_BUF->proto == UIP_PROTO_ICMP6) {
+    iphc0 |= SICSLOWPAN_IPHC_NH_C;
+  }
+  nh_ptr = hc06_ptr;
+#endif /* SICSLOWPAN_GHC */
+
   if ((iphc0 & SICSLOWPAN_IPHC_NH_C) == 0) {
     *hc06_ptr = UIP_IP_BUF->proto;
     hc06_ptr += 1;
@@ -787,13 +1174,12 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     PRINTF("IPHC: compressing unspecified - setting SAC\n");
     iphc1 |= SICSLOWPAN_IPHC_SAC;
     iphc1 |= SICSLOWPAN_IPHC_SAM_00;
-  } else if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->srcipaddr))
-     != NULL) {
+  } else if(src_context != NULL) {
     /* elide the prefix - indicate by CID and set context + SAC */
     PRINTF("IPHC: compressing src with context - setting CID & SAC ctx: %d\n",
-           context->number);
-    iphc1 |= SICSLOWPAN_IPHC_CID | SICSLOWPAN_IPHC_SAC;
-    PACKETBUF_IPHC_BUF[2] |= context->number << 4;
+           src_context->number);
+    iphc1 |= SICSLOWPAN_IPHC_SAC;
+    PACKETBUF_IPHC_BUF[2] |= src_context->number << 4;
     /* compession compare with this nodes address (source) */
 
     iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_SAM_BIT,
@@ -841,10 +1227,10 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
     }
   } else {
     /* Address is unicast, try to compress */
-    if((context = addr_context_lookup_by_prefix(&UIP_IP_BUF->destipaddr)) != NULL) {
+    if(dest_context != NULL) {
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
-      PACKETBUF_IPHC_BUF[2] |= context->number;
+      PACKETBUF_IPHC_BUF[2] |= dest_context->number;
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
@@ -867,6 +1253,10 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
 
   uncomp_hdr_len = UIP_IPH_LEN;
 
+#if SICSLOWPAN_GHC
+  nhc_ptr = hc06_ptr;
+#endif /* SICSLOWPAN_GHC */
+
 #if UIP_CONF_UDP || UIP_CONF_ROUTER
   /* UDP header compression */
   if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
@@ -918,11 +1308,56 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
   }
 #endif /*UIP_CONF_UDP*/
 
+#if SICSLOWPAN_GHC
+  if(ghc) {
+    uint8_t dict[SICSLOWPAN_GHC_DICT_LEN];
+    int len;
+
+    if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
+      *nhc_ptr = SICSLOWPAN_NHC_UDP_GHC_ID |
+        (*nhc_ptr & ~SICSLOWPAN_NHC_UDP_MASK);
+    } else {
+      *hc06_ptr++ = SICSLOWPAN_NHC_ICMP6_GHC;
+    }
+    sicslowpan_ghc_dict(dict, &UIP_IP_BUF->srcipaddr,
+                        &UIP_IP_BUF->destipaddr);
+    len = sicslowpan_ghc_compress(dict, (uint8_t *)UIP_IP_BUF + uncomp_hdr_len,
+                                  uip_len - uncomp_hdr_len, hc06_ptr,
+                                  ghc_out_max - (hc06_ptr - packetbuf_ptr));
+    if(len >= 0 && len < uip_len - uncomp_hdr_len) {
+      PRINTF("GHC: payload of %u bytes compressed to %d\n",
+             uip_len - uncomp_hdr_len, len);
+#if SICSLOWPAN_STATS
+      sicslowpan_stats.ghc_packets++;
+      sicslowpan_stats.ghc_bytes += len;
+      sicslowpan_stats.ghc_uncomp_bytes += uip_len - uncomp_hdr_len;
+#endif /* SICSLOWPAN_STATS */
+      hc06_ptr += len;
+      uncomp_hdr_len = uip_len;
+    } else if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
+      /* Send the payload as it is, with the plain UDP NHC. */
+      *nhc_ptr = SICSLOWPAN_NHC_UDP_ID | (*nhc_ptr & ~SICSLOWPAN_NHC_UDP_MASK);
+    } else {
+      /* Drop the NHC byte and carry the next header inline again. */
+      hc06_ptr--;
+      memmove(nh_ptr + 1, nh_ptr, hc06_ptr - nh_ptr);
+      *nh_ptr = UIP_PROTO_ICMP6;
+      hc06_ptr++;
+      iphc0 &= ~SICSLOWPAN_IPHC_NH_C;
+    }
+  }
+#endif /* SICSLOWPAN_GHC */
+
   /* before the packetbuf_hdr_len operation */
   PACKETBUF_IPHC_BUF[0] = iphc0;
   PACKETBUF_IPHC_BUF[1] = iphc1;
 
   packetbuf_hdr_len = hc06_ptr - packetbuf_ptr;
+#if SICSLOWPAN_STATS
+  sicslowpan_stats.iphc_packets++;
+  sicslowpan_stats.iphc_hdr_bytes += packetbuf_hdr_len;
+  sicslowpan_stats.iphc_uncomp_hdr_bytes += uncomp_hdr_len;
+#endif /* SICSLOWPAN_STATS */
   return;
 }
 
@@ -942,11 +1377,15 @@ compress_hdr_iphc(linkaddr_t *link_destaddr)
  * \param ip_len Equal to 0 if the packet is not a fragment (IP length
  * is then inferred from the L2 length), non 0 if the packet is a 1st
  * fragment.
+ * \return 1 on success, 0 if the packet could not be uncompressed
  */
-static void
+static int
 uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
 {
   uint8_t tmp, iphc0, iphc1;
+#if SICSLOWPAN_GHC
+  uint8_t ghc = 0;
+#endif /* SICSLOWPAN_GHC */
   /* at least two byte will be used for the encoding */
   hc06_ptr = packetbuf_ptr + packetbuf_hdr_len + 2;
 
@@ -1028,7 +1467,7 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
       context = addr_context_lookup_by_number(sci);
       if(context == NULL) {
         PRINTF("sicslowpan uncompress_hdr: error context not found\n");
-        return;
+        return 0;
       }
     }
     /* if tmp == 0 we do not have a context and therefore no prefix */
@@ -1075,7 +1514,7 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
       /* all valid cases below need the context! */
       if(context == NULL) {
         PRINTF("sicslowpan uncompress_hdr: error context not found\n");
-        return;
+        return 0;
       }
       uncompress_addr(&SICSLOWPAN_IP_BUF(buf)->destipaddr, context->prefix,
                       unc_ctxconf[tmp],
@@ -1092,12 +1531,24 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
   /* Next header processing - continued */
   if((iphc0 & SICSLOWPAN_IPHC_NH_C)) {
     /* The next header is compressed, NHC is following */
-    if((*hc06_ptr & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_ID) {
+    uint8_t nhc = *hc06_ptr;
+#if SICSLOWPAN_GHC
+    if(nhc == SICSLOWPAN_NHC_ICMP6_GHC) {
+      SICSLOWPAN_IP_BUF(buf)->proto = UIP_PROTO_ICMP6;
+      hc06_ptr++;
+      ghc = 1;
+    } else if((nhc & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_GHC_ID) {
+      /* Continue as with the plain UDP NHC */
+      nhc = SICSLOWPAN_NHC_UDP_ID | (nhc & ~SICSLOWPAN_NHC_UDP_MASK);
+      ghc = 1;
+    }
+#endif /* SICSLOWPAN_GHC */
+    if((nhc & SICSLOWPAN_NHC_UDP_MASK) == SICSLOWPAN_NHC_UDP_ID) {
       uint8_t checksum_compressed;
       SICSLOWPAN_IP_BUF(buf)->proto = UIP_PROTO_UDP;
-      checksum_compressed = *hc06_ptr & SICSLOWPAN_NHC_UDP_CHECKSUMC;
-      PRINTF("IPHC: Incoming header value: %i\n", *hc06_ptr);
-      switch(*hc06_ptr & SICSLOWPAN_NHC_UDP_CS_P_11) {
+      checksum_compressed = nhc & SICSLOWPAN_NHC_UDP_CHECKSUMC;
+      PRINTF("IPHC: Incoming header value: %i\n", nhc);
+      switch(nhc & SICSLOWPAN_NHC_UDP_CS_P_11) {
       case SICSLOWPAN_NHC_UDP_CS_P_00:
 	/* 1 byte for NHC, 4 byte for ports, 2 bytes chksum */
 	memcpy(&SICSLOWPAN_UDP_BUF(buf)->srcport, hc06_ptr + 1, 2);
@@ -1142,7 +1593,7 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
 
       default:
         PRINTF("sicslowpan uncompress_hdr: error unsupported UDP compression\n");
-        return;
+        return 0;
       }
       if(!checksum_compressed) { /* has_checksum, default  */
 	memcpy(&SICSLOWPAN_UDP_BUF(buf)->udpchksum, hc06_ptr, 2);
@@ -1155,6 +1606,32 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
     }
   }
 
+#if SICSLOWPAN_GHC
+  if(ghc) {
+    uint8_t dict[SICSLOWPAN_GHC_DICT_LEN];
+    int len;
+
+    /* GHC packets are never fragmented, see output() */
+    if(ip_len != 0) {
+      PRINTF("GHC: compressed fragment\n");
+      return 0;
+    }
+    sicslowpan_ghc_dict(dict, &SICSLOWPAN_IP_BUF(buf)->srcipaddr,
+                        &SICSLOWPAN_IP_BUF(buf)->destipaddr);
+    len = sicslowpan_ghc_decompress(dict, hc06_ptr,
+                                    packetbuf_datalen() - (hc06_ptr - packetbuf_ptr),
+                                    buf + uncomp_hdr_len,
+                                    UIP_BUFSIZE - UIP_LLH_LEN - uncomp_hdr_len);
+    if(len < 0) {
+      PRINTF("GHC: malformed payload\n");
+      return 0;
+    }
+    uncomp_hdr_len += len;
+    hc06_ptr = packetbuf_ptr + packetbuf_datalen();
+    sicslowpan_ghc_neighbor_capable(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  }
+#endif /* SICSLOWPAN_GHC */
+
   packetbuf_hdr_len = hc06_ptr - packetbuf_ptr;
 
   /* IP length field. */
@@ -1174,7 +1651,7 @@ uncompress_hdr_iphc(uint8_t *buf, uint16_t ip_len)
     memcpy(&SICSLOWPAN_UDP_BUF(buf)->udplen, &SICSLOWPAN_IP_BUF(buf)->len[0], 2);
   }
 
-  return;
+  return 1;
 }
 /** @} */
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
@@ -1217,6 +1694,9 @@ compress_hdr_ipv6(linkaddr_t *link_destaddr)
 static void
 packet_sent(void *ptr, int status, int transmissions)
 {
+  /* Update the link statistics first, the neighbor callback reads them */
+  link_stats_packet_sent(packetbuf_addr(PACKETBUF_ADDR_RECEIVER),
+                         status, transmissions);
   uip_ds6_link_neighbor_callback(status, transmissions);
 
   if(callback != NULL) {
@@ -1320,19 +1800,6 @@ output(const uip_lladdr_t *localdest)
 
   PRINTFO("sicslowpan output: sending packet len %d\n", uip_len);
 
-  if(uip_len >= COMPRESSION_THRESHOLD) {
-    /* Try to compress the headers */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
-    compress_hdr_ipv6(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
-    compress_hdr_iphc(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
-  } else {
-    compress_hdr_ipv6(&dest);
-  }
-  PRINTFO("sicslowpan output: header of len %d\n", packetbuf_hdr_len);
-
   /* Calculate NETSTACK_FRAMER's header length, that will be added in the NETSTACK_RDC.
    * We calculate it here only to make a better decision of whether the outgoing packet
    * needs to be fragmented or not. */
@@ -1349,6 +1816,26 @@ output(const uip_lladdr_t *localdest)
 #endif /* USE_FRAMER_HDRLEN */
 
   max_payload = MAC_MAX_PAYLOAD - framer_hdrlen;
+
+#if SICSLOWPAN_GHC
+  /* Fragments carry the payload at its uncompressed offset, so GHC is
+     only used when the compressed packet fits in a single frame. */
+  ghc_out_max = ghc_neighbor_lookup(&dest) ? max_payload : 0;
+#endif /* SICSLOWPAN_GHC */
+
+  if(uip_len >= COMPRESSION_THRESHOLD) {
+    /* Try to compress the headers */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
+    compress_hdr_ipv6(&dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+    compress_hdr_iphc(&dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
+  } else {
+    compress_hdr_ipv6(&dest);
+  }
+  PRINTFO("sicslowpan output: header of len %d\n", packetbuf_hdr_len);
+
   if((int)uip_len - (int)uncomp_hdr_len > max_payload - (int)packetbuf_hdr_len) {
 #if SICSLOWPAN_CONF_FRAG
     struct queuebuf *q;
@@ -1524,6 +2011,7 @@ input(void)
   /* Save the RSSI of the incoming packet in case the upper layer will
      want to query us for it later. */
   last_rssi = (signed short)packetbuf_attr(PACKETBUF_ATTR_RSSI);
+  link_stats_input_callback(packetbuf_addr(PACKETBUF_ADDR_SENDER));
 
 #if SICSLOWPAN_CONF_FRAG
 
@@ -1605,7 +2093,10 @@ input(void)
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
   if((PACKETBUF_HC1_PTR[PACKETBUF_HC1_DISPATCH] & 0xe0) == SICSLOWPAN_DISPATCH_IPHC) {
     PRINTFI("sicslowpan input: IPHC\n");
-    uncompress_hdr_iphc(buffer, frag_size);
+    if(!uncompress_hdr_iphc(buffer, frag_size)) {
+      PRINTFI("sicslowpan input: could not uncompress IPHC\n");
+      return;
+    }
   } else
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
     switch(PACKETBUF_HC1_PTR[PACKETBUF_HC1_DISPATCH]) {
@@ -1736,6 +2227,10 @@ sicslowpan_init(void)
 
   tcpip_set_outputfunc(output);
 
+#if SICSLOWPAN_GHC && !SICSLOWPAN_GHC_ALL_NEIGHBORS
+  nbr_table_register(ghc_neighbors, NULL);
+#endif /* SICSLOWPAN_GHC && !SICSLOWPAN_GHC_ALL_NEIGHBORS */
+
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
 /* Preinitialize any address contexts for better header compression
  * (Saves up to 13 bytes per 6lowpan packet)
@@ -1778,9 +2273,64 @@ sicslowpan_init(void)
   }
 #endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 1 */
 
+#if SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0
+  {
+    int i;
+    /* The preconfigured contexts are /64 contexts that never expire. */
+    for(i = 0; i < SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS; i++) {
+      if(addr_contexts[i].used) {
+        addr_contexts[i].length = 64;
+        addr_contexts[i].flags = SICSLOWPAN_CONTEXT_FLAG_LOCAL |
+          SICSLOWPAN_CONTEXT_FLAG_COMPRESS;
+        addr_contexts[i].lifetime = SICSLOWPAN_CONTEXT_LIFETIME_INFINITE;
+        context_index[addr_contexts[i].number] = i + 1;
+      }
+    }
+  }
+#endif /* SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS > 0 */
+
 #endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
 }
 /*--------------------------------------------------------------------*/
+#if SICSLOWPAN_COMPRESSION != SICSLOWPAN_COMPRESSION_HC06
+/* Address contexts are only used by IPHC. */
+const struct sicslowpan_addr_context *
+sicslowpan_context_get(uint8_t number)
+{
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_set(uint8_t number, const uip_ipaddr_t *prefix,
+                       uint8_t length, uint8_t flags, uint16_t lifetime)
+{
+  return 0;
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_learn(const uip_ipaddr_t *prefix)
+{
+  return -1;
+}
+/*--------------------------------------------------------------------*/
+int
+sicslowpan_context_write_6co(uint8_t *buf, uint8_t number)
+{
+  return 0;
+}
+/*--------------------------------------------------------------------*/
+void
+sicslowpan_context_read_6co(const uint8_t *buf, int len)
+{
+}
+/*--------------------------------------------------------------------*/
+uint8_t
+sicslowpan_context_version(void)
+{
+  return 0;
+}
+#endif /* SICSLOWPAN_COMPRESSION != SICSLOWPAN_COMPRESSION_HC06 */
+/*--------------------------------------------------------------------*/
 int
 sicslowpan_get_last_rssi(void)
 {
@@ -164,6 +164,16 @@
 #define SICSLOWPAN_NHC_UDP_CS_P_11  0xF3 /* source & dest = 0xF0B + 4bit inline */
 /** @} */
 
+/**
+ * \name LOWPAN_NHC with 6LoWPAN-GHC (RFC 7400)
+ * @{
+ */
+/* As LOWPAN_UDP, with the UDP payload GHC compressed */
+#define SICSLOWPAN_NHC_UDP_GHC_ID                   0xD0
+/* The whole ICMPv6 message is GHC compressed */
+#define SICSLOWPAN_NHC_ICMP6_GHC                    0xDF
+/** @} */
+
 
 /**
  * \name The 6lowpan "headers" length
@@ -220,11 +230,77 @@
  * each context can have upto 8 bytes
  */
 struct sicslowpan_addr_context {
-  uint8_t used; /* possibly use as prefix-length */
-  uint8_t number;
-  uint8_t prefix[8];
+  uint8_t used;
+  uint8_t number;     /* context identifier (CID), 0-15 */
+  uint8_t prefix[8];  /* bits beyond the prefix length are zero */
+  uint8_t length;     /* prefix length in bits, at most 64 */
+  uint8_t flags;
+  uint16_t lifetime;  /* remaining lifetime in minutes */
 };
 
+/**
+ * \name Address context flags and lifetimes
+ * @{
+ */
+/** The context may be used for compression (the C flag of the 6CO) */
+#define SICSLOWPAN_CONTEXT_FLAG_COMPRESS     0x01
+/** The context was configured or learned by this node */
+#define SICSLOWPAN_CONTEXT_FLAG_LOCAL        0x02
+
+#define SICSLOWPAN_CONTEXT_LIFETIME_INFINITE 0xffff
+/** @} */
+
+/**
+ * \name 6LoWPAN Context Option (RFC 6775)
+ * @{
+ */
+/** Length of a 6CO without its type and length bytes, for a context
+    prefix of up to 64 bits */
+#define SICSLOWPAN_6CO_BODY_LEN              14
+#define SICSLOWPAN_6CO_FLAG_C                0x10
+#define SICSLOWPAN_6CO_CID_MASK              0x0f
+/** @} */
+
+/**
+ * Lifetime in minutes that contexts configured or learned by this
+ * node are advertised with in 6LoWPAN Context Options.
+ */
+#ifdef SICSLOWPAN_CONF_CONTEXT_LIFETIME
+#define SICSLOWPAN_CONTEXT_LIFETIME SICSLOWPAN_CONF_CONTEXT_LIFETIME
+#else
+#define SICSLOWPAN_CONTEXT_LIFETIME 60
+#endif
+
+/**
+ * Minutes a learned context is advertised for decompression only
+ * before this node starts compressing with it, so that the other
+ * nodes have received it by then (RFC 6775, section 7.2).
+ */
+#ifdef SICSLOWPAN_CONF_CONTEXT_ACTIVATION_DELAY
+#define SICSLOWPAN_CONTEXT_ACTIVATION_DELAY SICSLOWPAN_CONF_CONTEXT_ACTIVATION_DELAY
+#else
+#define SICSLOWPAN_CONTEXT_ACTIVATION_DELAY 2
+#endif
+
+/**
+ * Learn contexts for the /64 prefixes that show up most often in the
+ * headers this node compresses. Only to be enabled on the border
+ * router, which then distributes the contexts to the other nodes.
+ */
+#ifdef SICSLOWPAN_CONF_CONTEXT_LEARNING
+#define SICSLOWPAN_CONTEXT_LEARNING SICSLOWPAN_CONF_CONTEXT_LEARNING
+#else
+#define SICSLOWPAN_CONTEXT_LEARNING 0
+#endif
+
+/** Number of headers using a prefix, within about a minute, after
+    which a context is learned for it */
+#ifdef SICSLOWPAN_CONF_CONTEXT_LEARN_THRESHOLD
+#define SICSLOWPAN_CONTEXT_LEARN_THRESHOLD SICSLOWPAN_CONF_CONTEXT_LEARN_THRESHOLD
+#else
+#define SICSLOWPAN_CONTEXT_LEARN_THRESHOLD 8
+#endif
+
 /**
  * \name Address compressibility test functions
  * @{
@@ -321,6 +397,120 @@ struct sicslowpan_nh_compressor {
 
 int sicslowpan_get_last_rssi(void);
 
+/**
+ * Generic Header Compression (RFC 7400) of UDP payloads and ICMPv6
+ * messages, such as RPL and ND control traffic. Received GHC packets
+ * are always decompressed; packets are only compressed for neighbors
+ * that are known to support GHC, and only when the result fits in a
+ * single frame.
+ */
+#ifdef SICSLOWPAN_CONF_GHC
+#define SICSLOWPAN_GHC SICSLOWPAN_CONF_GHC
+#else
+#define SICSLOWPAN_GHC 0
+#endif
+
+/**
+ * Assume that all neighbors support GHC, also for link-layer
+ * broadcasts. For networks where every node runs GHC, as RPL
+ * networks do not exchange the ND messages that advertise it.
+ */
+#ifdef SICSLOWPAN_CONF_GHC_ALL_NEIGHBORS
+#define SICSLOWPAN_GHC_ALL_NEIGHBORS SICSLOWPAN_CONF_GHC_ALL_NEIGHBORS
+#else
+#define SICSLOWPAN_GHC_ALL_NEIGHBORS 0
+#endif
+
+/**
+ * \brief Note that a neighbor supports GHC
+ * \param lladdr The link-layer address of the neighbor
+ *
+ * Called when a neighbor advertises GHC in a 6LoWPAN Capability
+ * Indication Option. Neighbors that send GHC packets are noted
+ * automatically.
+ */
+void sicslowpan_ghc_neighbor_capable(const linkaddr_t *lladdr);
+
+#ifdef SICSLOWPAN_CONF_STATS
+#define SICSLOWPAN_STATS SICSLOWPAN_CONF_STATS
+#else
+#define SICSLOWPAN_STATS 0
+#endif
+
+#if SICSLOWPAN_STATS
+/** Header compression statistics, for comparing context setups. */
+struct sicslowpan_stats {
+  unsigned long iphc_packets;         /* packets compressed with IPHC */
+  unsigned long iphc_hdr_bytes;       /* bytes of the compressed headers */
+  unsigned long iphc_uncomp_hdr_bytes; /* bytes of the headers before compression */
+  unsigned long ghc_packets;          /* packets with a GHC compressed payload */
+  unsigned long ghc_bytes;            /* bytes of the GHC compressed payloads */
+  unsigned long ghc_uncomp_bytes;     /* bytes of the payloads before compression */
+};
+extern struct sicslowpan_stats sicslowpan_stats;
+#endif /* SICSLOWPAN_STATS */
+
+/**
+ * \name Address context management
+ * @{
+ */
+
+/**
+ * \brief Get the address context with a given CID
+ * \param number The context identifier, 0-15
+ * \return The context, or NULL if it is not in use
+ */
+const struct sicslowpan_addr_context *sicslowpan_context_get(uint8_t number);
+
+/**
+ * \brief Add, update or remove an address context
+ * \param number The context identifier, 0-15
+ * \param prefix The context prefix
+ * \param length The prefix length in bits, at most 64
+ * \param flags SICSLOWPAN_CONTEXT_FLAG_* flags of the context
+ * \param lifetime Lifetime in minutes, 0 removes the context
+ * \return 1 if the context was set, 0 if it was removed or could not
+ *         be stored
+ *
+ * A context that was configured or learned by this node is not
+ * replaced by a context without SICSLOWPAN_CONTEXT_FLAG_LOCAL.
+ */
+int sicslowpan_context_set(uint8_t number, const uip_ipaddr_t *prefix,
+                           uint8_t length, uint8_t flags, uint16_t lifetime);
+
+/**
+ * \brief Learn a context for a /64 prefix on a free CID
+ * \return The CID of the context for the prefix, or -1 if the
+ *         context table is full
+ *
+ * The context is used for compression after
+ * SICSLOWPAN_CONTEXT_ACTIVATION_DELAY minutes.
+ */
+int sicslowpan_context_learn(const uip_ipaddr_t *prefix);
+
+/**
+ * \brief Write a 6LoWPAN Context Option body for a context
+ * \param buf Where to write the option, after its type and length
+ * \param number The context identifier
+ * \return SICSLOWPAN_6CO_BODY_LEN, or 0 if the context is not in use
+ */
+int sicslowpan_context_write_6co(uint8_t *buf, uint8_t number);
+
+/**
+ * \brief Apply a received 6LoWPAN Context Option
+ * \param buf The option, after its type and length
+ * \param len The length of buf
+ */
+void sicslowpan_context_read_6co(const uint8_t *buf, int len);
+
+/**
+ * \brief Get a counter that changes whenever a context is added,
+ * removed, or starts or stops being used for compression
+ */
+uint8_t sicslowpan_context_version(void);
+
+/** @} */
+
 extern const struct network_driver sicslowpan_driver;
 
 #endif /* SICSLOWPAN_H_ */
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup uip6
+ * @{
+ */
+
+/**
+ * \file
+ *    Deadline queue for IPv6 data structure maintenance
+ */
+
+#include "net/ip/tcpip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/uip-ds6-expiry.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+/* Longest wait that fits an etimer, in seconds. clock_time_t is only
+   16 bits on some platforms. */
+#define MAX_WAIT ((unsigned long)((clock_time_t)~0 >> 1) / CLOCK_SECOND)
+
+#define IS_DUE(e, now) ((long)((now) - (e)->deadline) >= 0)
+
+/* Sorted by deadline, earliest first. */
+static uip_ds6_expiry_t *head;
+static uip_ds6_expiry_t *tail;
+static uint8_t running;
+
+/*---------------------------------------------------------------------------*/
+static void
+arm(void)
+{
+  unsigned long now;
+  unsigned long wait;
+  clock_time_t interval;
+
+  if(running) {
+    return;
+  }
+
+  PROCESS_CONTEXT_BEGIN(&tcpip_process);
+  if(head == NULL) {
+    etimer_stop(&uip_ds6_timer_periodic);
+  } else {
+    now = clock_seconds();
+    interval = UIP_DS6_PERIOD;
+    if(!IS_DUE(head, now)) {
+      wait = head->deadline - now;
+      if(wait > MAX_WAIT) {
+        wait = MAX_WAIT;
+      }
+      /* Land just after the second boundary at which the deadline is
+         reached, rather than up to a second late. */
+      if(wait * CLOCK_SECOND - clock_time() % CLOCK_SECOND > interval) {
+        interval = wait * CLOCK_SECOND - clock_time() % CLOCK_SECOND;
+      }
+    }
+    PRINTF("uip-ds6-expiry: next run in %lu ticks\n",
+           (unsigned long)interval);
+    etimer_set(&uip_ds6_timer_periodic, interval);
+  }
+  PROCESS_CONTEXT_END(&tcpip_process);
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_entry(uip_ds6_expiry_t *e)
+{
+  uip_ds6_expiry_t *prev;
+
+  if(head == e) {
+    head = e->next;
+    prev = NULL;
+  } else {
+    for(prev = head; prev != NULL && prev->next != e; prev = prev->next);
+    if(prev == NULL) {
+      return;
+    }
+    prev->next = e->next;
+  }
+  if(tail == e) {
+    tail = prev;
+  }
+  e->next = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_expiry_init(void)
+{
+  head = tail = NULL;
+  running = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+uip_ds6_expiry_pending(const uip_ds6_expiry_t *e)
+{
+  return e->next != NULL || tail == e;
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_expiry_set(uip_ds6_expiry_t *e, unsigned long deadline,
+                   uip_ds6_expiry_callback_t callback)
+{
+  uip_ds6_expiry_t *prev;
+
+  e->callback = callback;
+  if(uip_ds6_expiry_pending(e)) {
+    if((long)(deadline - e->deadline) >= 0) {
+      /* The callback runs first and will re-enqueue the entry. */
+      return;
+    }
+    remove_entry(e);
+  }
+  e->deadline = deadline;
+
+  if(tail == NULL) {
+    head = tail = e;
+  } else if((long)(deadline - tail->deadline) >= 0) {
+    /* Most deadlines are "now + lifetime", which sorts last. */
+    tail->next = e;
+    tail = e;
+  } else if((long)(deadline - head->deadline) < 0) {
+    e->next = head;
+    head = e;
+  } else {
+    for(prev = head; (long)(prev->next->deadline - deadline) <= 0;
+        prev = prev->next);
+    e->next = prev->next;
+    prev->next = e;
+  }
+
+  if(head == e) {
+    arm();
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_expiry_stop(uip_ds6_expiry_t *e)
+{
+  /* The timer is not re-armed when the head goes away: it will find
+     nothing due, which costs one wakeup instead of an etimer update
+     on every removal. */
+  if(uip_ds6_expiry_pending(e)) {
+    remove_entry(e);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_expiry_run(void)
+{
+  uip_ds6_expiry_t *e;
+  unsigned long now;
+
+  now = clock_seconds();
+  running = 1;
+  while(head != NULL && IS_DUE(head, now) && uip_len == 0) {
+    e = head;
+    head = e->next;
+    if(tail == e) {
+      tail = NULL;
+    }
+    e->next = NULL;
+    e->callback(e);
+  }
+  running = 0;
+  arm();
+}
+/*---------------------------------------------------------------------------*/
+/** @} */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \addtogroup uip6
+ * @{
+ */
+
+/**
+ * \file
+ *    Deadline queue for IPv6 data structure maintenance
+ *
+ *    Neighbor cache entries, addresses, prefixes and default routers
+ *    each embed a uip_ds6_expiry_t and enqueue it with the deadline
+ *    of their next timer event. uip_ds6_periodic() only runs the
+ *    entries that are due, and uip_ds6_timer_periodic is armed for
+ *    the earliest deadline instead of firing every UIP_DS6_PERIOD.
+ *
+ *    Deadlines are kept in clock_seconds(), like the stimers they
+ *    mirror. Rescheduling to a later deadline is lazy: the entry
+ *    stays where it is, and its callback is expected to check its
+ *    own timers and enqueue itself again. Callbacks can therefore
+ *    run early, but never late.
+ */
+
+#ifndef UIP_DS6_EXPIRY_H_
+#define UIP_DS6_EXPIRY_H_
+
+#include <stddef.h>
+#include "sys/stimer.h"
+
+struct uip_ds6_expiry;
+
+typedef void (*uip_ds6_expiry_callback_t)(struct uip_ds6_expiry *e);
+
+/** \brief An entry in the expiry queue */
+typedef struct uip_ds6_expiry {
+  struct uip_ds6_expiry *next;
+  unsigned long deadline;
+  uip_ds6_expiry_callback_t callback;
+} uip_ds6_expiry_t;
+
+/** \brief The clock_seconds() value at which stimer \a t expires */
+#define UIP_DS6_EXPIRY_STIMER(t) ((t)->start + (t)->interval)
+
+/** \brief Get the structure that embeds expiry entry \a e as \a field */
+#define UIP_DS6_EXPIRY_CONTAINER(e, type, field) \
+  ((type *)((char *)(e) - offsetof(type, field)))
+
+/** \brief Empty the queue */
+void uip_ds6_expiry_init(void);
+
+/**
+ * \brief Schedule a callback no later than a deadline
+ * \param e The entry
+ * \param deadline The clock_seconds() value at which to run \a callback
+ * \param callback The function to call when the deadline is reached
+ *
+ * If \a e is already queued with an earlier or equal deadline it is
+ * left in place.
+ */
+void uip_ds6_expiry_set(uip_ds6_expiry_t *e, unsigned long deadline,
+                        uip_ds6_expiry_callback_t callback);
+
+/** \brief Remove an entry from the queue, if queued */
+void uip_ds6_expiry_stop(uip_ds6_expiry_t *e);
+
+/** \brief Check whether an entry is queued */
+int uip_ds6_expiry_pending(const uip_ds6_expiry_t *e);
+
+/**
+ * \brief Run the callbacks of all entries that are due
+ *
+ * Processing stops early when a callback leaves an outgoing packet in
+ * uip_buf, since the caller can only send one packet per run; the
+ * remaining entries are then retried after UIP_DS6_PERIOD.
+ */
+void uip_ds6_expiry_run(void);
+
+#endif /* UIP_DS6_EXPIRY_H_ */
+/** @} */
@@ -82,8 +82,18 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
                 uint8_t isrouter, uint8_t state, nbr_table_reason_t reason,
                 void *data)
 {
-  uip_ds6_nbr_t *nbr = nbr_table_add_lladdr(ds6_neighbors, (linkaddr_t*)lladdr
-                                            , reason, data);
+  uip_ds6_nbr_t *nbr;
+
+#if UIP_ND6_SEND_NA
+  /* An existing entry is cleared when re-added, take it off the expiry
+     queue first */
+  nbr = uip_ds6_nbr_ll_lookup(lladdr);
+  if(nbr != NULL) {
+    uip_ds6_expiry_stop(&nbr->expiry);
+  }
+#endif /* UIP_ND6_SEND_NA */
+  nbr = nbr_table_add_lladdr(ds6_neighbors, (linkaddr_t*)lladdr
+                             , reason, data);
   if(nbr) {
     uip_ipaddr_copy(&nbr->ipaddr, ipaddr);
 #if UIP_ND6_SEND_NA || UIP_ND6_SEND_RA || !UIP_CONF_ROUTER
@@ -98,6 +108,7 @@ uip_ds6_nbr_add(const uip_ipaddr_t *ipaddr, const uip_lladdr_t *lladdr,
     stimer_set(&nbr->reachable, 0);
     stimer_set(&nbr->sendns, 0);
     nbr->nscount = 0;
+    uip_ds6_nbr_schedule(nbr);
 #endif /* UIP_ND6_SEND_NA */
     PRINTF("Adding neighbor with ip addr ");
     PRINT6ADDR(ipaddr);
@@ -130,6 +141,9 @@ uip_ds6_nbr_rm(uip_ds6_nbr_t *nbr)
 #if UIP_CONF_IPV6_QUEUE_PKT
     uip_packetqueue_free(&nbr->packethandle);
 #endif /* UIP_CONF_IPV6_QUEUE_PKT */
+#if UIP_ND6_SEND_NA
+    uip_ds6_expiry_stop(&nbr->expiry);
+#endif /* UIP_ND6_SEND_NA */
     NEIGHBOR_STATE_CHANGED(nbr);
     return nbr_table_remove(ds6_neighbors, nbr);
   }
@@ -234,6 +248,9 @@ uip_ds6_link_neighbor_callback(int status, int numtx)
     if(nbr != NULL && nbr->state != NBR_INCOMPLETE) {
       nbr->state = NBR_REACHABLE;
       stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
+#if UIP_ND6_SEND_NA
+      uip_ds6_nbr_schedule(nbr);
+#endif /* UIP_ND6_SEND_NA */
       PRINTF("uip-ds6-neighbor : received a link layer ACK : ");
       PRINTLLADDR((uip_lladdr_t *)dest);
       PRINTF(" is reachable.\n");
@@ -244,82 +261,138 @@ uip_ds6_link_neighbor_callback(int status, int numtx)
 }
 #if UIP_ND6_SEND_NA
 /*---------------------------------------------------------------------------*/
-/** Periodic processing on neighbors */
-void
-uip_ds6_neighbor_periodic(void)
+/* Run the state machine of one neighbor. Returns 0 if it was removed. */
+static int
+nbr_process(uip_ds6_nbr_t *nbr)
 {
-  uip_ds6_nbr_t *nbr = nbr_table_head(ds6_neighbors);
-  while(nbr != NULL) {
-    switch(nbr->state) {
-    case NBR_REACHABLE:
-      if(stimer_expired(&nbr->reachable)) {
+  switch(nbr->state) {
+  case NBR_REACHABLE:
+    if(stimer_expired(&nbr->reachable)) {
 #if UIP_CONF_IPV6_RPL
-        /* when a neighbor leave its REACHABLE state and is a default router,
-           instead of going to STALE state it enters DELAY state in order to
-           force a NUD on it. Otherwise, if there is no upward traffic, the
-           node never knows if the default router is still reachable. This
-           mimics the 6LoWPAN-ND behavior.
-         */
-        if(uip_ds6_defrt_lookup(&nbr->ipaddr) != NULL) {
-          PRINTF("REACHABLE: defrt moving to DELAY (");
-          PRINT6ADDR(&nbr->ipaddr);
-          PRINTF(")\n");
-          nbr->state = NBR_DELAY;
-          stimer_set(&nbr->reachable, UIP_ND6_DELAY_FIRST_PROBE_TIME);
-          nbr->nscount = 0;
-        } else {
-          PRINTF("REACHABLE: moving to STALE (");
-          PRINT6ADDR(&nbr->ipaddr);
-          PRINTF(")\n");
-          nbr->state = NBR_STALE;
-        }
-#else /* UIP_CONF_IPV6_RPL */
+      /* when a neighbor leave its REACHABLE state and is a default router,
+         instead of going to STALE state it enters DELAY state in order to
+         force a NUD on it. Otherwise, if there is no upward traffic, the
+         node never knows if the default router is still reachable. This
+         mimics the 6LoWPAN-ND behavior.
+       */
+      if(uip_ds6_defrt_lookup(&nbr->ipaddr) != NULL) {
+        PRINTF("REACHABLE: defrt moving to DELAY (");
+        PRINT6ADDR(&nbr->ipaddr);
+        PRINTF(")\n");
+        nbr->state = NBR_DELAY;
+        stimer_set(&nbr->reachable, UIP_ND6_DELAY_FIRST_PROBE_TIME);
+        nbr->nscount = 0;
+      } else {
         PRINTF("REACHABLE: moving to STALE (");
         PRINT6ADDR(&nbr->ipaddr);
         PRINTF(")\n");
         nbr->state = NBR_STALE;
-#endif /* UIP_CONF_IPV6_RPL */
-      }
-      break;
-    case NBR_INCOMPLETE:
-      if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
-        uip_ds6_nbr_rm(nbr);
-      } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        PRINTF("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
       }
+#else /* UIP_CONF_IPV6_RPL */
+      PRINTF("REACHABLE: moving to STALE (");
+      PRINT6ADDR(&nbr->ipaddr);
+      PRINTF(")\n");
+      nbr->state = NBR_STALE;
+#endif /* UIP_CONF_IPV6_RPL */
+    }
+    break;
+  case NBR_INCOMPLETE:
+    /* Give up once the last NS has gone unanswered for a retransmission
+       interval (RFC 4861 section 7.3.3) */
+    if(!stimer_expired(&nbr->sendns)) {
       break;
-    case NBR_DELAY:
-      if(stimer_expired(&nbr->reachable)) {
-        nbr->state = NBR_PROBE;
-        nbr->nscount = 0;
-        PRINTF("DELAY: moving to PROBE\n");
-        stimer_set(&nbr->sendns, 0);
-      }
+    }
+    if(nbr->nscount >= UIP_ND6_MAX_MULTICAST_SOLICIT) {
+      uip_ds6_nbr_rm(nbr);
+      return 0;
+    } else if(uip_len == 0) {
+      nbr->nscount++;
+      PRINTF("NBR_INCOMPLETE: NS %u\n", nbr->nscount);
+      uip_nd6_ns_output(NULL, NULL, &nbr->ipaddr);
+      stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+    }
+    break;
+  case NBR_DELAY:
+    if(stimer_expired(&nbr->reachable)) {
+      nbr->state = NBR_PROBE;
+      nbr->nscount = 0;
+      PRINTF("DELAY: moving to PROBE\n");
+      stimer_set(&nbr->sendns, 0);
+    }
+    break;
+  case NBR_PROBE:
+    if(!stimer_expired(&nbr->sendns)) {
       break;
-    case NBR_PROBE:
-      if(nbr->nscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
-        uip_ds6_defrt_t *locdefrt;
-        PRINTF("PROBE END\n");
-        if((locdefrt = uip_ds6_defrt_lookup(&nbr->ipaddr)) != NULL) {
-          if (!locdefrt->isinfinite) {
-            uip_ds6_defrt_rm(locdefrt);
-          }
+    }
+    if(nbr->nscount >= UIP_ND6_MAX_UNICAST_SOLICIT) {
+      uip_ds6_defrt_t *locdefrt;
+      PRINTF("PROBE END\n");
+      if((locdefrt = uip_ds6_defrt_lookup(&nbr->ipaddr)) != NULL) {
+        if (!locdefrt->isinfinite) {
+          uip_ds6_defrt_rm(locdefrt);
         }
-        uip_ds6_nbr_rm(nbr);
-      } else if(stimer_expired(&nbr->sendns) && (uip_len == 0)) {
-        nbr->nscount++;
-        PRINTF("PROBE: NS %u\n", nbr->nscount);
-        uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr);
-        stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
       }
-      break;
-    default:
-      break;
+      uip_ds6_nbr_rm(nbr);
+      return 0;
+    } else if(uip_len == 0) {
+      nbr->nscount++;
+      PRINTF("PROBE: NS %u\n", nbr->nscount);
+      uip_nd6_ns_output(NULL, &nbr->ipaddr, &nbr->ipaddr);
+      stimer_set(&nbr->sendns, uip_ds6_if.retrans_timer / 1000);
+    }
+    break;
+  default:
+    break;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+nbr_expired(uip_ds6_expiry_t *e)
+{
+  uip_ds6_nbr_t *nbr;
+
+  nbr = UIP_DS6_EXPIRY_CONTAINER(e, uip_ds6_nbr_t, expiry);
+  if(nbr_process(nbr)) {
+    uip_ds6_nbr_schedule(nbr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** Queue a neighbor for the next timer of its current state. To be
+    called whenever the state, reachable or sendns timer is changed. */
+void
+uip_ds6_nbr_schedule(uip_ds6_nbr_t *nbr)
+{
+  switch(nbr->state) {
+  case NBR_REACHABLE:
+  case NBR_DELAY:
+    uip_ds6_expiry_set(&nbr->expiry, UIP_DS6_EXPIRY_STIMER(&nbr->reachable),
+                       nbr_expired);
+    break;
+  case NBR_INCOMPLETE:
+  case NBR_PROBE:
+    uip_ds6_expiry_set(&nbr->expiry, UIP_DS6_EXPIRY_STIMER(&nbr->sendns),
+                       nbr_expired);
+    break;
+  default:
+    /* STALE: nothing to do until a packet is sent */
+    uip_ds6_expiry_stop(&nbr->expiry);
+    break;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** Process all neighbors at once, regardless of the expiry queue */
+void
+uip_ds6_neighbor_periodic(void)
+{
+  uip_ds6_nbr_t *nbr;
+  uip_ds6_nbr_t *next;
+
+  for(nbr = nbr_table_head(ds6_neighbors); nbr != NULL; nbr = next) {
+    next = nbr_table_next(ds6_neighbors, nbr);
+    if(nbr_process(nbr)) {
+      uip_ds6_nbr_schedule(nbr);
     }
-    nbr = nbr_table_next(ds6_neighbors, nbr);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -49,6 +49,7 @@
 #include "net/ip/uip.h"
 #include "net/nbr-table.h"
 #include "sys/stimer.h"
+#include "net/ipv6/uip-ds6-expiry.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/nbr-table.h"
 
@@ -71,12 +72,14 @@ typedef struct uip_ds6_nbr {
   uip_ipaddr_t ipaddr;
   uint8_t isrouter;
   uint8_t state;
-  uint16_t link_metric;
 #if UIP_ND6_SEND_NA || UIP_ND6_SEND_RA
   struct stimer reachable;
   struct stimer sendns;
   uint8_t nscount;
 #endif /* UIP_ND6_SEND_NA || UIP_ND6_SEND_RA */
+#if UIP_ND6_SEND_NA
+  uip_ds6_expiry_t expiry;
+#endif /* UIP_ND6_SEND_NA */
 #if UIP_CONF_IPV6_QUEUE_PKT
   struct uip_packetqueue_handle packethandle;
 #define UIP_DS6_NBR_PACKET_LIFETIME CLOCK_SECOND * 4
@@ -99,6 +102,9 @@ uip_ipaddr_t *uip_ds6_nbr_ipaddr_from_lladdr(const uip_lladdr_t *lladdr);
 const uip_lladdr_t *uip_ds6_nbr_lladdr_from_ipaddr(const uip_ipaddr_t *ipaddr);
 void uip_ds6_link_neighbor_callback(int status, int numtx);
 void uip_ds6_neighbor_periodic(void);
+#if UIP_ND6_SEND_NA
+void uip_ds6_nbr_schedule(uip_ds6_nbr_t *nbr);
+#endif /* UIP_ND6_SEND_NA */
 int uip_ds6_nbr_num(void);
 
 /**
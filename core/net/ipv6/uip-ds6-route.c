@@ -565,6 +565,7 @@ uip_ds6_defrt_add(uip_ipaddr_t *ipaddr, unsigned long interval)
   } else {
     d->isinfinite = 1;
   }
+  uip_ds6_defrt_schedule(d);
 
   ANNOTATE("#L %u 1\n", ipaddr->u8[sizeof(uip_ipaddr_t) - 1]);
 
@@ -595,6 +596,7 @@ uip_ds6_defrt_rm(uip_ds6_defrt_t *defrt)
     if(d == defrt) {
       PRINTF("Removing default route\n");
       list_remove(defaultrouterlist, defrt);
+      uip_ds6_expiry_stop(&defrt->expiry);
       memb_free(&defaultroutermemb, defrt);
       ANNOTATE("#L %u 0\n", defrt->ipaddr.u8[sizeof(uip_ipaddr_t) - 1]);
 #if UIP_DS6_NOTIFICATIONS
@@ -671,4 +673,32 @@ uip_ds6_defrt_periodic(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+static void
+defrt_expired(uip_ds6_expiry_t *e)
+{
+  uip_ds6_defrt_t *d;
+
+  d = UIP_DS6_EXPIRY_CONTAINER(e, uip_ds6_defrt_t, expiry);
+  if(d->isinfinite) {
+    return;
+  }
+  if(stimer_expired(&d->lifetime)) {
+    PRINTF("defrt_expired: defrt lifetime expired\n");
+    uip_ds6_defrt_rm(d);
+  } else {
+    uip_ds6_defrt_schedule(d);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_defrt_schedule(uip_ds6_defrt_t *defrt)
+{
+  if(defrt->isinfinite) {
+    uip_ds6_expiry_stop(&defrt->expiry);
+  } else {
+    uip_ds6_expiry_set(&defrt->expiry, UIP_DS6_EXPIRY_STIMER(&defrt->lifetime),
+                       defrt_expired);
+  }
+}
+/*---------------------------------------------------------------------------*/
 /** @} */
@@ -44,6 +44,7 @@
 #include "net/nbr-table.h"
 #include "sys/stimer.h"
 #include "lib/list.h"
+#include "net/ipv6/uip-ds6-expiry.h"
 
 NBR_TABLE_DECLARE(nbr_routes);
 
@@ -100,6 +101,7 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define RPL_ROUTE_ENTRY_NOPATH_RECEIVED   0x01
 #define RPL_ROUTE_ENTRY_DAO_PENDING       0x02
 #define RPL_ROUTE_ENTRY_DAO_NACK          0x04
+#define RPL_ROUTE_ENTRY_DAO_FORWARD       0x08
 
 #define RPL_ROUTE_IS_NOPATH_RECEIVED(route)                             \
   (((route)->state.state_flags & RPL_ROUTE_ENTRY_NOPATH_RECEIVED) != 0)
@@ -128,6 +130,15 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
     (route)->state.state_flags &= ~RPL_ROUTE_ENTRY_DAO_NACK;            \
   } while(0)
 
+#define RPL_ROUTE_IS_DAO_FORWARD(route)                                 \
+  ((route->state.state_flags & RPL_ROUTE_ENTRY_DAO_FORWARD) != 0)
+#define RPL_ROUTE_SET_DAO_FORWARD(route) do {                           \
+    (route)->state.state_flags |= RPL_ROUTE_ENTRY_DAO_FORWARD;          \
+  } while(0)
+#define RPL_ROUTE_CLEAR_DAO_FORWARD(route) do {                         \
+    (route)->state.state_flags &= ~RPL_ROUTE_ENTRY_DAO_FORWARD;         \
+  } while(0)
+
 #define RPL_ROUTE_CLEAR_DAO(route) do {                                 \
     (route)->state.state_flags &= ~(RPL_ROUTE_ENTRY_DAO_NACK|RPL_ROUTE_ENTRY_DAO_PENDING); \
   } while(0)
@@ -138,6 +149,7 @@ typedef struct rpl_route_entry {
   struct rpl_dag *dag;
   uint8_t dao_seqno_out;
   uint8_t dao_seqno_in;
+  uint8_t path_sequence;
   uint8_t state_flags;
 } rpl_route_entry_t;
 #endif /* UIP_DS6_ROUTE_STATE_TYPE */
@@ -177,6 +189,7 @@ typedef struct uip_ds6_defrt {
   uip_ipaddr_t ipaddr;
   struct stimer lifetime;
   uint8_t isinfinite;
+  uip_ds6_expiry_t expiry;
 } uip_ds6_defrt_t;
 
 /** \name Default router list basic routines */
@@ -188,6 +201,7 @@ uip_ds6_defrt_t *uip_ds6_defrt_lookup(uip_ipaddr_t *ipaddr);
 uip_ipaddr_t *uip_ds6_defrt_choose(void);
 
 void uip_ds6_defrt_periodic(void);
+void uip_ds6_defrt_schedule(uip_ds6_defrt_t *defrt);
 /** @} */
 
 
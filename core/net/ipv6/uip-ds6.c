@@ -60,6 +60,8 @@ struct stimer uip_ds6_timer_ra;                                 /**< RA timer, t
 #if UIP_ND6_SEND_RA
 static uint8_t racount;                                         /**< number of RA already sent */
 static uint16_t rand_time;                                      /**< random time value for timers */
+static uip_ds6_expiry_t ra_expiry;                              /**< RA timer entry in the expiry queue */
+static void ra_schedule(void);
 #endif
 #else /* UIP_CONF_ROUTER */
 struct etimer uip_ds6_timer_rs;                                 /**< RS timer, to schedule RS sending */
@@ -88,11 +90,95 @@ static uip_ds6_aaddr_t *locaaddr;
 #endif /* UIP_DS6_AADDR_NB */
 static uip_ds6_prefix_t *locprefix;
 
+#if UIP_DS6_ADDR_FILTER_BITS
+#if UIP_DS6_ADDR_FILTER_BITS > 256
+#error UIP_DS6_CONF_ADDR_FILTER_BITS: the filter hashes index at most 256 bits
+#endif
+/*
+ * Bloom filters over the addresses in the unicast, multicast and
+ * anycast lists. uip_process() looks up the destination of every
+ * incoming packet, so packets that are only forwarded are rejected
+ * here without comparing them against each list entry. The filters
+ * are rebuilt from the lists when an address is removed.
+ */
+typedef uint8_t addr_filter_t[(UIP_DS6_ADDR_FILTER_BITS + 7) / 8];
+
+static addr_filter_t addr_filter;
+static addr_filter_t maddr_filter;
+#if UIP_DS6_AADDR_NB
+static addr_filter_t aaddr_filter;
+#endif /* UIP_DS6_AADDR_NB */
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+addr_filter_hash(const uip_ipaddr_t *ipaddr)
+{
+  uint16_t hash;
+  uint8_t i;
+
+  hash = 0;
+  for(i = 0; i < sizeof(ipaddr->u16) / sizeof(ipaddr->u16[0]); i++) {
+    hash = ((hash << 5) | (hash >> 11)) ^ ipaddr->u16[i];
+  }
+  return hash;
+}
+/*---------------------------------------------------------------------------*/
+static void
+addr_filter_add(uint8_t *filter, const uip_ipaddr_t *ipaddr)
+{
+  uint16_t hash;
+  uint8_t bit;
+
+  hash = addr_filter_hash(ipaddr);
+  bit = (hash & 0xff) % UIP_DS6_ADDR_FILTER_BITS;
+  filter[bit >> 3] |= 1 << (bit & 7);
+  bit = (hash >> 8) % UIP_DS6_ADDR_FILTER_BITS;
+  filter[bit >> 3] |= 1 << (bit & 7);
+}
+/*---------------------------------------------------------------------------*/
+static int
+addr_filter_match(const uint8_t *filter, const uip_ipaddr_t *ipaddr)
+{
+  uint16_t hash;
+  uint8_t bit;
+
+  hash = addr_filter_hash(ipaddr);
+  bit = (hash & 0xff) % UIP_DS6_ADDR_FILTER_BITS;
+  if(!(filter[bit >> 3] & (1 << (bit & 7)))) {
+    return 0;
+  }
+  bit = (hash >> 8) % UIP_DS6_ADDR_FILTER_BITS;
+  return (filter[bit >> 3] & (1 << (bit & 7))) != 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+addr_filter_rebuild(uint8_t *filter, uip_ds6_element_t *list, uint8_t size,
+                    uint16_t elementsize)
+{
+  uip_ds6_element_t *element;
+
+  memset(filter, 0, sizeof(addr_filter_t));
+  for(element = list;
+      element <
+      (uip_ds6_element_t *)((uint8_t *)list + (size * elementsize));
+      element = (uip_ds6_element_t *)((uint8_t *)element + elementsize)) {
+    if(element->isused) {
+      addr_filter_add(filter, &element->ipaddr);
+    }
+  }
+}
+#else /* UIP_DS6_ADDR_FILTER_BITS */
+#define addr_filter_add(filter, ipaddr)
+#define addr_filter_match(filter, ipaddr) 1
+#define addr_filter_rebuild(filter, list, size, elementsize)
+#endif /* UIP_DS6_ADDR_FILTER_BITS */
+
 /*---------------------------------------------------------------------------*/
 void
 uip_ds6_init(void)
 {
 
+  uip_ds6_expiry_init();
   uip_ds6_neighbors_init();
   uip_ds6_route_init();
 
@@ -102,6 +188,13 @@ uip_ds6_init(void)
      UIP_DS6_ADDR_NB, UIP_DS6_MADDR_NB, UIP_DS6_AADDR_NB);
   memset(uip_ds6_prefix_list, 0, sizeof(uip_ds6_prefix_list));
   memset(&uip_ds6_if, 0, sizeof(uip_ds6_if));
+#if UIP_DS6_ADDR_FILTER_BITS
+  memset(addr_filter, 0, sizeof(addr_filter));
+  memset(maddr_filter, 0, sizeof(maddr_filter));
+#if UIP_DS6_AADDR_NB
+  memset(aaddr_filter, 0, sizeof(aaddr_filter));
+#endif /* UIP_DS6_AADDR_NB */
+#endif /* UIP_DS6_ADDR_FILTER_BITS */
   uip_ds6_addr_size = sizeof(struct uip_ds6_addr);
   uip_ds6_netif_addr_list_offset = offsetof(struct uip_ds6_netif, addr_list);
 
@@ -130,13 +223,13 @@ uip_ds6_init(void)
   uip_ds6_maddr_add(&loc_fipaddr);
 #if UIP_ND6_SEND_RA
   stimer_set(&uip_ds6_timer_ra, 2);     /* wait to have a link local IP address */
+  ra_schedule();
 #endif /* UIP_ND6_SEND_RA */
 #else /* UIP_CONF_ROUTER */
   etimer_set(&uip_ds6_timer_rs,
              random_rand() % (UIP_ND6_MAX_RTR_SOLICITATION_DELAY *
                               CLOCK_SECOND));
 #endif /* UIP_CONF_ROUTER */
-  etimer_set(&uip_ds6_timer_periodic, UIP_DS6_PERIOD);
 
   return;
 }
@@ -146,58 +239,11 @@ uip_ds6_init(void)
 void
 uip_ds6_periodic(void)
 {
-
-  /* Periodic processing on unicast addresses */
-  for(locaddr = uip_ds6_if.addr_list;
-      locaddr < uip_ds6_if.addr_list + UIP_DS6_ADDR_NB; locaddr++) {
-    if(locaddr->isused) {
-      if((!locaddr->isinfinite) && (stimer_expired(&locaddr->vlifetime))) {
-        uip_ds6_addr_rm(locaddr);
-#if UIP_ND6_DEF_MAXDADNS > 0
-      } else if((locaddr->state == ADDR_TENTATIVE)
-                && (locaddr->dadnscount <= uip_ds6_if.maxdadns)
-                && (timer_expired(&locaddr->dadtimer))
-                && (uip_len == 0)) {
-        uip_ds6_dad(locaddr);
-#endif /* UIP_ND6_DEF_MAXDADNS > 0 */
-      }
-    }
-  }
-
-  /* Periodic processing on default routers */
-  uip_ds6_defrt_periodic();
-  /*  for(locdefrt = uip_ds6_defrt_list;
-      locdefrt < uip_ds6_defrt_list + UIP_DS6_DEFRT_NB; locdefrt++) {
-    if((locdefrt->isused) && (!locdefrt->isinfinite) &&
-       (stimer_expired(&(locdefrt->lifetime)))) {
-      uip_ds6_defrt_rm(locdefrt);
-    }
-    }*/
-
-#if !UIP_CONF_ROUTER
-  /* Periodic processing on prefixes */
-  for(locprefix = uip_ds6_prefix_list;
-      locprefix < uip_ds6_prefix_list + UIP_DS6_PREFIX_NB;
-      locprefix++) {
-    if(locprefix->isused && !locprefix->isinfinite
-       && stimer_expired(&(locprefix->vlifetime))) {
-      uip_ds6_prefix_rm(locprefix);
-    }
-  }
-#endif /* !UIP_CONF_ROUTER */
-
-#if UIP_ND6_SEND_NA
-  uip_ds6_neighbor_periodic();
-#endif /* UIP_ND6_SEND_RA */
-
-#if UIP_CONF_ROUTER && UIP_ND6_SEND_RA
-  /* Periodic RA sending */
-  if(stimer_expired(&uip_ds6_timer_ra) && (uip_len == 0)) {
-    uip_ds6_send_ra_periodic();
-  }
-#endif /* UIP_CONF_ROUTER && UIP_ND6_SEND_RA */
-  etimer_reset(&uip_ds6_timer_periodic);
-  return;
+  /* Addresses, prefixes, default routers, neighbors and the RA timer
+     all queue themselves for their next deadline, so only the entries
+     that are due are looked at here. */
+  UIP_STAT(++uip_stat.ds6.periodic);
+  uip_ds6_expiry_run();
 }
 
 /*---------------------------------------------------------------------------*/
@@ -276,6 +322,7 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
     } else {
       locprefix->isinfinite = 1;
     }
+    uip_ds6_prefix_schedule(locprefix);
     PRINTF("Adding prefix ");
     PRINT6ADDR(&locprefix->ipaddr);
     PRINTF("length %u, vlifetime %lu\n", ipaddrlen, interval);
@@ -283,6 +330,33 @@ uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t ipaddrlen,
   }
   return NULL;
 }
+/*---------------------------------------------------------------------------*/
+static void
+prefix_expired(uip_ds6_expiry_t *e)
+{
+  uip_ds6_prefix_t *prefix;
+
+  prefix = UIP_DS6_EXPIRY_CONTAINER(e, uip_ds6_prefix_t, expiry);
+  if(prefix->isused && !prefix->isinfinite) {
+    if(stimer_expired(&prefix->vlifetime)) {
+      uip_ds6_prefix_rm(prefix);
+    } else {
+      uip_ds6_prefix_schedule(prefix);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_prefix_schedule(uip_ds6_prefix_t *prefix)
+{
+  if(prefix->isinfinite) {
+    uip_ds6_expiry_stop(&prefix->expiry);
+  } else {
+    uip_ds6_expiry_set(&prefix->expiry,
+                       UIP_DS6_EXPIRY_STIMER(&prefix->vlifetime),
+                       prefix_expired);
+  }
+}
 #endif /* UIP_CONF_ROUTER */
 
 /*---------------------------------------------------------------------------*/
@@ -291,6 +365,9 @@ uip_ds6_prefix_rm(uip_ds6_prefix_t *prefix)
 {
   if(prefix != NULL) {
     prefix->isused = 0;
+#if !UIP_CONF_ROUTER
+    uip_ds6_expiry_stop(&prefix->expiry);
+#endif /* !UIP_CONF_ROUTER */
   }
   return;
 }
@@ -331,6 +408,7 @@ uip_ds6_addr_add(uip_ipaddr_t *ipaddr, unsigned long vlifetime, uint8_t type)
       (uip_ds6_element_t **)&locaddr) == FREESPACE) {
     locaddr->isused = 1;
     uip_ipaddr_copy(&locaddr->ipaddr, ipaddr);
+    addr_filter_add(addr_filter, ipaddr);
     locaddr->type = type;
     if(vlifetime == 0) {
       locaddr->isinfinite = 1;
@@ -347,6 +425,7 @@ uip_ds6_addr_add(uip_ipaddr_t *ipaddr, unsigned long vlifetime, uint8_t type)
 #else /* UIP_ND6_DEF_MAXDADNS > 0 */
     locaddr->state = ADDR_PREFERRED;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+    uip_ds6_addr_schedule(locaddr);
     uip_create_solicited_node(ipaddr, &loc_fipaddr);
     uip_ds6_maddr_add(&loc_fipaddr);
     return locaddr;
@@ -364,14 +443,80 @@ uip_ds6_addr_rm(uip_ds6_addr_t *addr)
       uip_ds6_maddr_rm(locmaddr);
     }
     addr->isused = 0;
+    uip_ds6_expiry_stop(&addr->expiry);
+    addr_filter_rebuild(addr_filter, (uip_ds6_element_t *)uip_ds6_if.addr_list,
+                        UIP_DS6_ADDR_NB, sizeof(uip_ds6_addr_t));
   }
   return;
 }
+/*---------------------------------------------------------------------------*/
+static void
+addr_expired(uip_ds6_expiry_t *e)
+{
+  uip_ds6_addr_t *addr;
+
+  addr = UIP_DS6_EXPIRY_CONTAINER(e, uip_ds6_addr_t, expiry);
+  if(!addr->isused) {
+    return;
+  }
+  if((!addr->isinfinite) && (stimer_expired(&addr->vlifetime))) {
+    uip_ds6_addr_rm(addr);
+    return;
+  }
+#if UIP_ND6_DEF_MAXDADNS > 0
+  if((addr->state == ADDR_TENTATIVE)
+     && (addr->dadnscount <= uip_ds6_if.maxdadns)
+     && (timer_expired(&addr->dadtimer))) {
+    uip_ds6_dad(addr);
+  }
+#endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+  uip_ds6_addr_schedule(addr);
+}
+/*---------------------------------------------------------------------------*/
+void
+uip_ds6_addr_schedule(uip_ds6_addr_t *addr)
+{
+  unsigned long deadline;
+  uint8_t pending;
+#if UIP_ND6_DEF_MAXDADNS > 0
+  unsigned long dad;
+#endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+
+  deadline = 0;
+  pending = 0;
+  if(!addr->isinfinite) {
+    deadline = UIP_DS6_EXPIRY_STIMER(&addr->vlifetime);
+    pending = 1;
+  }
+#if UIP_ND6_DEF_MAXDADNS > 0
+  if((addr->state == ADDR_TENTATIVE)
+     && (addr->dadnscount <= uip_ds6_if.maxdadns)) {
+    /* The DAD timer has sub-second resolution, round it up */
+    dad = clock_seconds();
+    if(!timer_expired(&addr->dadtimer)) {
+      dad += (timer_remaining(&addr->dadtimer) + CLOCK_SECOND - 1) /
+        CLOCK_SECOND;
+    }
+    if(!pending || (long)(dad - deadline) < 0) {
+      deadline = dad;
+      pending = 1;
+    }
+  }
+#endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+  if(pending) {
+    uip_ds6_expiry_set(&addr->expiry, deadline, addr_expired);
+  } else {
+    uip_ds6_expiry_stop(&addr->expiry);
+  }
+}
 
 /*---------------------------------------------------------------------------*/
 uip_ds6_addr_t *
 uip_ds6_addr_lookup(uip_ipaddr_t *ipaddr)
 {
+  if(!addr_filter_match(addr_filter, ipaddr)) {
+    return NULL;
+  }
   if(uip_ds6_list_loop
      ((uip_ds6_element_t *)uip_ds6_if.addr_list, UIP_DS6_ADDR_NB,
       sizeof(uip_ds6_addr_t), ipaddr, 128,
@@ -429,6 +574,7 @@ uip_ds6_maddr_add(const uip_ipaddr_t *ipaddr)
       (uip_ds6_element_t **)&locmaddr) == FREESPACE) {
     locmaddr->isused = 1;
     uip_ipaddr_copy(&locmaddr->ipaddr, ipaddr);
+    addr_filter_add(maddr_filter, ipaddr);
     return locmaddr;
   }
   return NULL;
@@ -440,6 +586,8 @@ uip_ds6_maddr_rm(uip_ds6_maddr_t *maddr)
 {
   if(maddr != NULL) {
     maddr->isused = 0;
+    addr_filter_rebuild(maddr_filter, (uip_ds6_element_t *)uip_ds6_if.maddr_list,
+                        UIP_DS6_MADDR_NB, sizeof(uip_ds6_maddr_t));
   }
   return;
 }
@@ -448,6 +596,9 @@ uip_ds6_maddr_rm(uip_ds6_maddr_t *maddr)
 uip_ds6_maddr_t *
 uip_ds6_maddr_lookup(const uip_ipaddr_t *ipaddr)
 {
+  if(!addr_filter_match(maddr_filter, ipaddr)) {
+    return NULL;
+  }
   if(uip_ds6_list_loop
      ((uip_ds6_element_t *)uip_ds6_if.maddr_list, UIP_DS6_MADDR_NB,
       sizeof(uip_ds6_maddr_t), (void*)ipaddr, 128,
@@ -469,6 +620,7 @@ uip_ds6_aaddr_add(uip_ipaddr_t *ipaddr)
       (uip_ds6_element_t **)&locaaddr) == FREESPACE) {
     locaaddr->isused = 1;
     uip_ipaddr_copy(&locaaddr->ipaddr, ipaddr);
+    addr_filter_add(aaddr_filter, ipaddr);
     return locaaddr;
   }
 #endif /* UIP_DS6_AADDR_NB */
@@ -481,6 +633,10 @@ uip_ds6_aaddr_rm(uip_ds6_aaddr_t *aaddr)
 {
   if(aaddr != NULL) {
     aaddr->isused = 0;
+#if UIP_DS6_AADDR_NB
+    addr_filter_rebuild(aaddr_filter, (uip_ds6_element_t *)uip_ds6_if.aaddr_list,
+                        UIP_DS6_AADDR_NB, sizeof(uip_ds6_aaddr_t));
+#endif /* UIP_DS6_AADDR_NB */
   }
   return;
 }
@@ -490,6 +646,9 @@ uip_ds6_aaddr_t *
 uip_ds6_aaddr_lookup(uip_ipaddr_t *ipaddr)
 {
 #if UIP_DS6_AADDR_NB
+  if(!addr_filter_match(aaddr_filter, ipaddr)) {
+    return NULL;
+  }
   if(uip_ds6_list_loop((uip_ds6_element_t *)uip_ds6_if.aaddr_list,
                        UIP_DS6_AADDR_NB, sizeof(uip_ds6_aaddr_t), ipaddr, 128,
                        (uip_ds6_element_t **)&locaaddr) == FOUND) {
@@ -648,6 +807,7 @@ uip_ds6_send_ra_sollicited(void)
                  stimer_elapsed(&uip_ds6_timer_ra));
   */ } else {
       stimer_set(&uip_ds6_timer_ra, rand_time);
+      ra_schedule();
     }
   }
 }
@@ -675,6 +835,24 @@ uip_ds6_send_ra_periodic(void)
   }
   PRINTF("Random time 3 = %u\n", rand_time);
   stimer_set(&uip_ds6_timer_ra, rand_time);
+  ra_schedule();
+}
+/*---------------------------------------------------------------------------*/
+static void
+ra_expired(uip_ds6_expiry_t *e)
+{
+  if(stimer_expired(&uip_ds6_timer_ra)) {
+    uip_ds6_send_ra_periodic();
+  } else {
+    ra_schedule();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+ra_schedule(void)
+{
+  uip_ds6_expiry_set(&ra_expiry, UIP_DS6_EXPIRY_STIMER(&uip_ds6_timer_ra),
+                     ra_expired);
 }
 
 #endif /* UIP_ND6_SEND_RA */
@@ -46,6 +46,7 @@
 #include "sys/stimer.h"
 /* The size of uip_ds6_addr_t depends on UIP_ND6_DEF_MAXDADNS. Include uip-nd6.h to define it. */
 #include "net/ipv6/uip-nd6.h"
+#include "net/ipv6/uip-ds6-expiry.h"
 #include "net/ipv6/uip-ds6-route.h"
 #include "net/ipv6/uip-ds6-nbr.h"
 
@@ -141,6 +142,18 @@
 #endif
 #define UIP_DS6_AADDR_NB UIP_DS6_AADDR_NBS + UIP_DS6_AADDR_NBU
 
+/*
+ * Size in bits of the filters that let the unicast, multicast and
+ * anycast lookups reject addresses that are not ours without scanning
+ * the address lists. Each list gets its own filter; 0 disables them.
+ * Each hash indexes the filter with 8 bits, so at most 256.
+ */
+#ifndef UIP_DS6_CONF_ADDR_FILTER_BITS
+#define UIP_DS6_ADDR_FILTER_BITS 64
+#else
+#define UIP_DS6_ADDR_FILTER_BITS UIP_DS6_CONF_ADDR_FILTER_BITS
+#endif
+
 /*--------------------------------------------------*/
 /* Should we use LinkLayer acks in NUD ?*/
 #ifndef UIP_CONF_DS6_LL_NUD
@@ -161,7 +174,8 @@
 #define  ADDR_MANUAL 3
 
 /** \brief General DS6 definitions */
-/** Period for uip-ds6 periodic task*/
+/** Minimum interval between two runs of the uip-ds6 periodic task. The
+ * task itself is scheduled by the expiry queue (uip-ds6-expiry.h). */
 #ifndef UIP_DS6_CONF_PERIOD
 #define UIP_DS6_PERIOD   (CLOCK_SECOND/10)
 #else
@@ -195,6 +209,7 @@ typedef struct uip_ds6_prefix {
   uint8_t length;
   struct stimer vlifetime;
   uint8_t isinfinite;
+  uip_ds6_expiry_t expiry;
 } uip_ds6_prefix_t;
 #endif /*UIP_CONF_ROUTER */
 
@@ -210,6 +225,7 @@ typedef struct uip_ds6_addr {
   struct timer dadtimer;
   uint8_t dadnscount;
 #endif /* UIP_ND6_DEF_MAXDADNS > 0 */
+  uip_ds6_expiry_t expiry;
 } uip_ds6_addr_t;
 
 /** \brief Anycast address  */
@@ -279,7 +295,8 @@ extern struct etimer uip_ds6_timer_rs;
 /** \brief Initialize data structures */
 void uip_ds6_init(void);
 
-/** \brief Periodic processing of data structures */
+/** \brief Periodic processing of data structures: runs the entries of
+ * the expiry queue that are due */
 void uip_ds6_periodic(void);
 
 /** \brief Generic loop routine on an abstract data structure, which generalizes
@@ -302,6 +319,8 @@ uip_ds6_prefix_t *uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t length,
 #else /* UIP_CONF_ROUTER */
 uip_ds6_prefix_t *uip_ds6_prefix_add(uip_ipaddr_t *ipaddr, uint8_t length,
                                      unsigned long interval);
+/** \brief Queue the prefix for its lifetime, to be called after changing it */
+void uip_ds6_prefix_schedule(uip_ds6_prefix_t *prefix);
 #endif /* UIP_CONF_ROUTER */
 void uip_ds6_prefix_rm(uip_ds6_prefix_t *prefix);
 uip_ds6_prefix_t *uip_ds6_prefix_lookup(uip_ipaddr_t *ipaddr,
@@ -316,6 +335,9 @@ uint8_t uip_ds6_is_addr_onlink(uip_ipaddr_t *ipaddr);
 uip_ds6_addr_t *uip_ds6_addr_add(uip_ipaddr_t *ipaddr,
                                  unsigned long vlifetime, uint8_t type);
 void uip_ds6_addr_rm(uip_ds6_addr_t *addr);
+/** \brief Queue the address for its next timer, to be called after
+ * changing its lifetime or DAD timer */
+void uip_ds6_addr_schedule(uip_ds6_addr_t *addr);
 uip_ds6_addr_t *uip_ds6_addr_lookup(uip_ipaddr_t *ipaddr);
 uip_ds6_addr_t *uip_ds6_get_link_local(int8_t state);
 uip_ds6_addr_t *uip_ds6_get_global(int8_t state);
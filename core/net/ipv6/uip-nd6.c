@@ -73,6 +73,7 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6.h"
 #include "net/ip/uip-nameserver.h"
+#include "net/ipv6/sicslowpan.h"
 #include "lib/random.h"
 
 /*------------------------------------------------------------------*/
@@ -153,6 +154,17 @@ create_llao(uint8_t *llao, uint8_t type) {
   memset(&llao[UIP_ND6_OPT_DATA_OFFSET + UIP_LLADDR_LEN], 0,
          UIP_ND6_OPT_LLAO_LEN - 2 - UIP_LLADDR_LEN);
 }
+#if SICSLOWPAN_GHC && (UIP_ND6_SEND_RA || !UIP_CONF_ROUTER)
+/*------------------------------------------------------------------*/
+/* create a 6CIO advertising GHC */
+static void
+create_6cio(uint8_t *cio) {
+  memset(cio, 0, UIP_ND6_OPT_6CIO_LEN);
+  cio[UIP_ND6_OPT_TYPE_OFFSET] = UIP_ND6_OPT_6CIO;
+  cio[UIP_ND6_OPT_LEN_OFFSET] = UIP_ND6_OPT_6CIO_LEN >> 3;
+  cio[3] = UIP_ND6_6CIO_FLAG_G;
+}
+#endif /* SICSLOWPAN_GHC && (UIP_ND6_SEND_RA || !UIP_CONF_ROUTER) */
 
 /*------------------------------------------------------------------*/
 
@@ -513,6 +525,7 @@ na_input(void)
 
         /* reachable time is stored in ms */
         stimer_set(&(nbr->reachable), uip_ds6_if.reachable_time / 1000);
+        uip_ds6_nbr_schedule(nbr);
 
       } else {
         nbr->state = NBR_STALE;
@@ -535,6 +548,7 @@ na_input(void)
             nbr->state = NBR_REACHABLE;
             /* reachable time is stored in ms */
             stimer_set(&(nbr->reachable), uip_ds6_if.reachable_time / 1000);
+            uip_ds6_nbr_schedule(nbr);
           } else {
             if(nd6_opt_llao != 0 && is_llchange) {
               nbr->state = NBR_STALE;
@@ -580,6 +594,9 @@ discard:
 static void
 rs_input(void)
 {
+#if SICSLOWPAN_GHC
+  uint8_t ghc = 0;
+#endif /* SICSLOWPAN_GHC */
 
   PRINTF("Received RS from ");
   PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
@@ -617,6 +634,11 @@ rs_input(void)
     case UIP_ND6_OPT_SLLAO:
       nd6_opt_llao = (uint8_t *)UIP_ND6_OPT_HDR_BUF;
       break;
+#if SICSLOWPAN_GHC
+    case UIP_ND6_OPT_6CIO:
+      ghc = ((uint8_t *)UIP_ND6_OPT_HDR_BUF)[3] & UIP_ND6_6CIO_FLAG_G;
+      break;
+#endif /* SICSLOWPAN_GHC */
     default:
       PRINTF("ND option not supported in RS\n");
       break;
@@ -648,12 +670,21 @@ rs_input(void)
           nbr->reachable = nbr_data.reachable;
           nbr->sendns = nbr_data.sendns;
           nbr->nscount = nbr_data.nscount;
+#if UIP_ND6_SEND_NA
+          uip_ds6_nbr_schedule(nbr);
+#endif /* UIP_ND6_SEND_NA */
         }
         nbr->isrouter = 0;
       }
 #if UIP_CONF_IPV6_CHECKS
     }
 #endif /*UIP_CONF_IPV6_CHECKS */
+#if SICSLOWPAN_GHC
+    if(ghc) {
+      sicslowpan_ghc_neighbor_capable(
+        (linkaddr_t *)&nd6_opt_llao[UIP_ND6_OPT_DATA_OFFSET]);
+    }
+#endif /* SICSLOWPAN_GHC */
   }
 
   /* Schedule a sollicited RA */
@@ -734,6 +765,12 @@ uip_nd6_ra_output(uip_ipaddr_t * dest)
   uip_len += UIP_ND6_OPT_MTU_LEN;
   nd6_opt_offset += UIP_ND6_OPT_MTU_LEN;
 
+#if SICSLOWPAN_GHC
+  create_6cio((uint8_t *)UIP_ND6_OPT_HDR_BUF);
+  uip_len += UIP_ND6_OPT_6CIO_LEN;
+  nd6_opt_offset += UIP_ND6_OPT_6CIO_LEN;
+#endif /* SICSLOWPAN_GHC */
+
 #if UIP_ND6_RA_RDNSS
   if(uip_nameserver_count() > 0) {
     uint8_t i = 0;
@@ -756,6 +793,30 @@ uip_nd6_ra_output(uip_ipaddr_t * dest)
   }
 #endif /* UIP_ND6_RA_RDNSS */
 
+#if UIP_ND6_RA_6CO
+  {
+    uint8_t cid;
+    int len;
+
+    for(cid = 0; cid < 16; cid++) {
+      if(UIP_LLH_LEN + uip_len + UIP_ND6_OPT_HDR_LEN +
+         SICSLOWPAN_6CO_BODY_LEN > UIP_BUFSIZE) {
+        PRINTF("No room for 6CO %u in RA\n", cid);
+        break;
+      }
+      len = sicslowpan_context_write_6co((uint8_t *)UIP_ND6_OPT_HDR_BUF +
+                                         UIP_ND6_OPT_HDR_LEN, cid);
+      if(len > 0) {
+        len += UIP_ND6_OPT_HDR_LEN;
+        UIP_ND6_OPT_HDR_BUF->type = UIP_ND6_OPT_6CO;
+        UIP_ND6_OPT_HDR_BUF->len = len >> 3;
+        uip_len += len;
+        nd6_opt_offset += len;
+      }
+    }
+  }
+#endif /* UIP_ND6_RA_6CO */
+
   UIP_IP_BUF->len[0] = ((uip_len - UIP_IPH_LEN) >> 8);
   UIP_IP_BUF->len[1] = ((uip_len - UIP_IPH_LEN) & 0xff);
 
@@ -800,6 +861,12 @@ uip_nd6_rs_output(void)
 
     create_llao(&uip_buf[uip_l2_l3_icmp_hdr_len + UIP_ND6_RS_LEN],
                 UIP_ND6_OPT_SLLAO);
+#if SICSLOWPAN_GHC
+    create_6cio(&uip_buf[uip_l2_l3_icmp_hdr_len + UIP_ND6_RS_LEN +
+                         UIP_ND6_OPT_LLAO_LEN]);
+    uip_len += UIP_ND6_OPT_6CIO_LEN;
+    UIP_IP_BUF->len[1] += UIP_ND6_OPT_6CIO_LEN;
+#endif /* SICSLOWPAN_GHC */
   }
 
   UIP_ICMP_BUF->icmpchksum = 0;
@@ -826,6 +893,9 @@ uip_nd6_rs_output(void)
 void
 ra_input(void)
 {
+#if SICSLOWPAN_GHC
+  uint8_t ghc = 0;
+#endif /* SICSLOWPAN_GHC */
   PRINTF("Received RA from ");
   PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
   PRINTF(" to ");
@@ -860,6 +930,7 @@ ra_input(void)
 
   /* Options processing */
   nd6_opt_offset = UIP_ND6_RA_LEN;
+  nd6_opt_llao = NULL;
   while(uip_l3_icmp_hdr_len + nd6_opt_offset < uip_len) {
     if(UIP_ND6_OPT_HDR_BUF->len == 0) {
       PRINTF("RA received is bad");
@@ -894,6 +965,20 @@ ra_input(void)
       uip_ds6_if.link_mtu =
         uip_ntohl(((uip_nd6_opt_mtu *) UIP_ND6_OPT_HDR_BUF)->mtu);
       break;
+#if SICSLOWPAN_GHC
+    case UIP_ND6_OPT_6CIO:
+      ghc = ((uint8_t *)UIP_ND6_OPT_HDR_BUF)[3] & UIP_ND6_6CIO_FLAG_G;
+      break;
+#endif /* SICSLOWPAN_GHC */
+#if UIP_ND6_RA_6CO
+    case UIP_ND6_OPT_6CO:
+      PRINTF("Processing 6CO option in RA\n");
+      sicslowpan_context_read_6co((uint8_t *)UIP_ND6_OPT_HDR_BUF +
+                                  UIP_ND6_OPT_HDR_LEN,
+                                  (UIP_ND6_OPT_HDR_BUF->len << 3) -
+                                  UIP_ND6_OPT_HDR_LEN);
+      break;
+#endif /* UIP_ND6_RA_6CO */
     case UIP_ND6_OPT_PREFIX_INFO:
       PRINTF("Processing PREFIX option in RA\n");
       nd6_opt_prefix_info = (uip_nd6_opt_prefix_info *) UIP_ND6_OPT_HDR_BUF;
@@ -932,6 +1017,7 @@ ra_input(void)
               stimer_set(&prefix->vlifetime,
                          uip_ntohl(nd6_opt_prefix_info->validlt));
               prefix->isinfinite = 0;
+              uip_ds6_prefix_schedule(prefix);
               break;
             }
           }
@@ -964,6 +1050,7 @@ ra_input(void)
                 PRINTF(" new value %lu\n", (unsigned long)(2 * 60 * 60));
               }
               addr->isinfinite = 0;
+              uip_ds6_addr_schedule(addr);
             } else {
               addr->isinfinite = 1;
             }
@@ -1004,6 +1091,13 @@ ra_input(void)
     nd6_opt_offset += (UIP_ND6_OPT_HDR_BUF->len << 3);
   }
 
+#if SICSLOWPAN_GHC
+  if(ghc && nd6_opt_llao != NULL) {
+    sicslowpan_ghc_neighbor_capable(
+      (linkaddr_t *)&nd6_opt_llao[UIP_ND6_OPT_DATA_OFFSET]);
+  }
+#endif /* SICSLOWPAN_GHC */
+
   defrt = uip_ds6_defrt_lookup(&UIP_IP_BUF->srcipaddr);
   if(UIP_ND6_RA_BUF->router_lifetime != 0) {
     if(nbr != NULL) {
@@ -1016,6 +1110,7 @@ ra_input(void)
     } else {
       stimer_set(&(defrt->lifetime),
                  (unsigned long)(uip_ntohs(UIP_ND6_RA_BUF->router_lifetime)));
+      uip_ds6_defrt_schedule(defrt);
     }
   } else {
     if(defrt != NULL) {
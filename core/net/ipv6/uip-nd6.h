@@ -158,6 +158,15 @@
 #endif
 /** @} */
 
+/** \name RFC 6775 6LoWPAN Context Option in RAs */
+/** @{ */
+#ifndef UIP_CONF_ND6_RA_6CO
+#define UIP_ND6_RA_6CO                  0
+#else
+#define UIP_ND6_RA_6CO                  UIP_CONF_ND6_RA_6CO
+#endif
+/** @} */
+
 
 /** \name ND6 option types */
 /** @{ */
@@ -168,6 +177,8 @@
 #define UIP_ND6_OPT_MTU                 5
 #define UIP_ND6_OPT_RDNSS               25
 #define UIP_ND6_OPT_DNSSL               31
+#define UIP_ND6_OPT_6CO                 34
+#define UIP_ND6_OPT_6CIO                36
 /** @} */
 
 /** \name ND6 option types */
@@ -192,6 +203,7 @@
 #define UIP_ND6_OPT_MTU_LEN            8
 #define UIP_ND6_OPT_RDNSS_LEN          1
 #define UIP_ND6_OPT_DNSSL_LEN          1
+#define UIP_ND6_OPT_6CIO_LEN           8
 
 
 /* Length of TLLAO and SLLAO options, it is L2 dependant */
@@ -223,6 +235,10 @@
 #define UIP_ND6_RA_FLAG_AUTONOMOUS      0x40
 /** @} */
 
+/** \brief 6CIO flag (RFC 7400), in the fourth byte of the option:
+    the sender supports 6LoWPAN-GHC */
+#define UIP_ND6_6CIO_FLAG_G             0x01
+
 /**
  * \name ND message structures
  * @{
@@ -152,7 +152,6 @@ uint8_t uip_ext_opt_offset = 0;
  * \name Buffer defines
  * @{
  */
-#define FBUF                             ((struct uip_tcpip_hdr *)&uip_reassbuf[0])
 #define UIP_IP_BUF                          ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 #define UIP_ICMP_BUF                      ((struct uip_icmp_hdr *)&uip_buf[uip_l2_l3_hdr_len])
 #define UIP_UDP_BUF                        ((struct uip_udp_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
@@ -629,20 +628,53 @@ uip_listen(uint16_t port)
 #if UIP_CONF_IPV6_REASSEMBLY
 #define UIP_REASS_BUFSIZE (UIP_BUFSIZE - UIP_LLH_LEN)
 
-static uint8_t uip_reassbuf[UIP_REASS_BUFSIZE];
+/* Number of datagrams that can be reassembled at the same time. */
+#ifdef UIP_CONF_IPV6_REASS_CONTEXTS
+#define UIP_REASS_CONTEXTS UIP_CONF_IPV6_REASS_CONTEXTS
+#else
+#define UIP_REASS_CONTEXTS 2
+#endif
+
+/* A block covers one byte of the bitmap. */
+#define UIP_REASS_BLOCK_SIZE 64
+#define UIP_REASS_BLOCKS ((UIP_REASS_BUFSIZE + UIP_REASS_BLOCK_SIZE - 1) / \
+                          UIP_REASS_BLOCK_SIZE)
+
+/* Memory shared by all reassemblies. It is handed out in blocks as
+   fragments arrive, so several small datagrams fit where one of
+   maximum size would. The default holds one datagram of maximum size,
+   which is what a single reassembly buffer used to take. */
+#ifdef UIP_CONF_IPV6_REASS_POOL_SIZE
+#define UIP_REASS_POOL_SIZE UIP_CONF_IPV6_REASS_POOL_SIZE
+#else
+#define UIP_REASS_POOL_SIZE (UIP_REASS_BLOCKS * UIP_REASS_BLOCK_SIZE)
+#endif
+
+/* Number of datagrams from the same source that can be reassembled at
+   the same time. Lower it so that one host cannot hold every context;
+   by default, a single peer may send back-to-back fragmented datagrams
+   over all of them. */
+#ifdef UIP_CONF_IPV6_REASS_PER_SOURCE
+#define UIP_REASS_PER_SOURCE UIP_CONF_IPV6_REASS_PER_SOURCE
+#else
+#define UIP_REASS_PER_SOURCE UIP_REASS_CONTEXTS
+#endif
+
+#define UIP_REASS_POOL_BLOCKS (UIP_REASS_POOL_SIZE / UIP_REASS_BLOCK_SIZE)
+#if UIP_REASS_POOL_BLOCKS > 255
+#error UIP_CONF_IPV6_REASS_POOL_SIZE too large
+#endif
 
-static uint8_t uip_reassbitmap[UIP_REASS_BUFSIZE / (8 * 8)];
 /*the first byte of an IP fragment is aligned on an 8-byte boundary */
 
 static const uint8_t bitmap_bits[8] = {0xff, 0x7f, 0x3f, 0x1f,
                                     0x0f, 0x07, 0x03, 0x01};
-static uint16_t uip_reasslen;
 static uint8_t uip_reassflags;
 
 #define UIP_REASS_FLAG_LASTFRAG 0x01
 #define UIP_REASS_FLAG_FIRSTFRAG 0x02
 #define UIP_REASS_FLAG_ERROR_MSG 0x04
-
+#define UIP_REASS_FLAG_USED 0x08
 
 /*
  * See RFC 2460 for a description of fragmentation in IPv6
@@ -651,190 +683,425 @@ static uint8_t uip_reassflags;
  *  |  Unfragmentable  |Fragment|    first     |
  *  |       Part       | Header |   fragment   |
  *  +------------------+--------+--------------+
+ *
+ * A datagram is laid out as in uip_buf: the unfragmentable part
+ * followed by the fragmentable part. This layout is mapped onto pool
+ * blocks, which are only allocated for the parts that have arrived.
  */
+struct uip_reass_context {
+  struct timer timer;
+  uip_ipaddr_t srcipaddr;
+  uip_ipaddr_t destipaddr;
+  uint32_t id;
+  /* Length of the fragmentable part, valid once the last fragment is in. */
+  uint16_t len;
+  uint8_t flags;
+  uint8_t nblocks;
+  /* Pool block + 1 for each block of the datagram, 0 if not allocated. */
+  uint8_t block[UIP_REASS_BLOCKS];
+  uint8_t bitmap[UIP_REASS_BUFSIZE / (8 * 8) + 1];
+};
 
+static struct uip_reass_context reass_contexts[UIP_REASS_CONTEXTS];
+static uint8_t reass_pool[UIP_REASS_POOL_BLOCKS][UIP_REASS_BLOCK_SIZE];
+static uint8_t reass_pool_used[UIP_REASS_POOL_BLOCKS];
 
 struct etimer uip_reass_timer; /**< Timer for reassembly */
-uint8_t uip_reass_on; /* equal to 1 if we are currently reassembling a packet */
+uint8_t uip_reass_on; /* number of packets currently being reassembled */
 
-static uint32_t uip_id; /* For every packet that is to be fragmented, the source
-                        node generates an Identification value that is present
-                        in all the fragments */
 #define IP_MF   0x0001
 
+/*---------------------------------------------------------------------------*/
+static clock_time_t
+reass_remaining(struct uip_reass_context *c)
+{
+  return timer_expired(&c->timer) ? 0 : timer_remaining(&c->timer);
+}
+/*---------------------------------------------------------------------------*/
+/* Run uip_reass_timer until the first reassembly deadline. */
+static void
+reass_timer_update(void)
+{
+  struct uip_reass_context *c;
+  clock_time_t remaining;
+  clock_time_t next;
+
+  next = 0;
+  uip_reass_on = 0;
+  for(c = reass_contexts; c < reass_contexts + UIP_REASS_CONTEXTS; c++) {
+    if(c->flags & UIP_REASS_FLAG_USED) {
+      remaining = reass_remaining(c);
+      if(uip_reass_on == 0 || remaining < next) {
+        next = remaining;
+      }
+      uip_reass_on++;
+    }
+  }
+  if(uip_reass_on == 0) {
+    etimer_stop(&uip_reass_timer);
+  } else {
+    etimer_set(&uip_reass_timer, next);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+reass_free(struct uip_reass_context *c)
+{
+  uint8_t i;
+
+  for(i = 0; i < UIP_REASS_BLOCKS; i++) {
+    if(c->block[i] != 0) {
+      reass_pool_used[c->block[i] - 1] = 0;
+    }
+  }
+  memset(c, 0, sizeof(*c));
+}
+/*---------------------------------------------------------------------------*/
+/* Pick the reassembly to give up when contexts or memory run out: an
+   expired one, else the one holding the most blocks, or the oldest
+   among those. */
+static struct uip_reass_context *
+reass_victim(const struct uip_reass_context *keep)
+{
+  struct uip_reass_context *c;
+  struct uip_reass_context *victim;
+
+  victim = NULL;
+  for(c = reass_contexts; c < reass_contexts + UIP_REASS_CONTEXTS; c++) {
+    if(c == keep || !(c->flags & UIP_REASS_FLAG_USED)) {
+      continue;
+    }
+    if(timer_expired(&c->timer)) {
+      return c;
+    }
+    if(victim == NULL || c->nblocks > victim->nblocks ||
+       (c->nblocks == victim->nblocks &&
+        reass_remaining(c) < reass_remaining(victim))) {
+      victim = c;
+    }
+  }
+  return victim;
+}
+/*---------------------------------------------------------------------------*/
+static int
+reass_alloc_block(struct uip_reass_context *c, uint8_t index)
+{
+  struct uip_reass_context *victim;
+  uint8_t i;
+
+  do {
+    for(i = 0; i < UIP_REASS_POOL_BLOCKS; i++) {
+      if(!reass_pool_used[i]) {
+        reass_pool_used[i] = 1;
+        c->block[index] = i + 1;
+        c->nblocks++;
+        return 1;
+      }
+    }
+    /* Out of memory: evict another reassembly instead of waiting for
+       it to time out. */
+    victim = reass_victim(c);
+    if(victim != NULL) {
+      PRINTF("Reassembly pool full, evicting a reassembly\n");
+      reass_free(victim);
+    }
+  } while(victim != NULL);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+reass_write(struct uip_reass_context *c, uint16_t pos,
+            const uint8_t *data, uint16_t len)
+{
+  uint16_t n;
+  uint8_t index;
+
+  while(len > 0) {
+    index = pos / UIP_REASS_BLOCK_SIZE;
+    if(c->block[index] == 0 && !reass_alloc_block(c, index)) {
+      return 0;
+    }
+    n = UIP_REASS_BLOCK_SIZE - pos % UIP_REASS_BLOCK_SIZE;
+    if(n > len) {
+      n = len;
+    }
+    memcpy(&reass_pool[c->block[index] - 1][pos % UIP_REASS_BLOCK_SIZE],
+           data, n);
+    pos += n;
+    data += n;
+    len -= n;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reass_read(const struct uip_reass_context *c, uint8_t *data, uint16_t len)
+{
+  uint16_t n;
+  uint8_t index;
+
+  for(index = 0; len > 0; index++) {
+    n = len < UIP_REASS_BLOCK_SIZE ? len : UIP_REASS_BLOCK_SIZE;
+    if(c->block[index] != 0) {
+      memcpy(data, reass_pool[c->block[index] - 1], n);
+    }
+    data += n;
+    len -= n;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct uip_reass_context *
+reass_lookup(void)
+{
+  struct uip_reass_context *c;
+
+  for(c = reass_contexts; c < reass_contexts + UIP_REASS_CONTEXTS; c++) {
+    if((c->flags & UIP_REASS_FLAG_USED) &&
+       c->id == UIP_FRAG_BUF->id &&
+       uip_ipaddr_cmp(&c->srcipaddr, &UIP_IP_BUF->srcipaddr) &&
+       uip_ipaddr_cmp(&c->destipaddr, &UIP_IP_BUF->destipaddr)) {
+      return c;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct uip_reass_context *
+reass_new(void)
+{
+  struct uip_reass_context *c;
+  struct uip_reass_context *free_context;
+  uint8_t from_source;
+
+  free_context = NULL;
+  from_source = 0;
+  for(c = reass_contexts; c < reass_contexts + UIP_REASS_CONTEXTS; c++) {
+    if(!(c->flags & UIP_REASS_FLAG_USED) || timer_expired(&c->timer)) {
+      /* Expired reassemblies are given up at the next uip_reass_over(),
+         they can be reused right away. */
+      if(free_context == NULL) {
+        free_context = c;
+      }
+    } else if(uip_ipaddr_cmp(&c->srcipaddr, &UIP_IP_BUF->srcipaddr)) {
+      from_source++;
+    }
+  }
+
+  if(from_source >= UIP_REASS_PER_SOURCE) {
+    /* The source has used up its share. Its reassemblies in progress
+       are more likely to complete than this one: drop the fragment. */
+    PRINTF("Too many reassemblies from the source, dropping fragment\n");
+    return NULL;
+  } else if(free_context != NULL) {
+    c = free_context;
+    reass_free(c);
+  } else {
+    c = reass_victim(NULL);
+    reass_free(c);
+  }
+
+  PRINTF("Starting reassembly\n");
+  c->flags = UIP_REASS_FLAG_USED;
+  c->id = UIP_FRAG_BUF->id;
+  uip_ipaddr_copy(&c->srcipaddr, &UIP_IP_BUF->srcipaddr);
+  uip_ipaddr_copy(&c->destipaddr, &UIP_IP_BUF->destipaddr);
+  timer_set(&c->timer, UIP_REASS_MAXAGE * CLOCK_SECOND);
+  return c;
+}
+/*---------------------------------------------------------------------------*/
 static uint16_t
 uip_reass(void)
 {
+  struct uip_reass_context *c;
   uint16_t offset=0;
   uint16_t len;
+  uint16_t reasslen;
   uint16_t i;
 
-  /* If ip_reasstmr is zero, no packet is present in the buffer */
-  /* We first write the unfragmentable part of IP header into the reassembly
-     buffer. The reset the other reassembly variables. */
-  if(uip_reass_on == 0) {
-    PRINTF("Starting reassembly\n");
-    memcpy(FBUF, UIP_IP_BUF, uip_ext_len + UIP_IPH_LEN);
-    /* temporary in case we do not receive the fragment with offset 0 first */
-    etimer_set(&uip_reass_timer, UIP_REASS_MAXAGE*CLOCK_SECOND);
-    uip_reass_on = 1;
-    uip_reassflags = 0;
-    uip_id = UIP_FRAG_BUF->id;
-    /* Clear the bitmap. */
-    memset(uip_reassbitmap, 0, sizeof(uip_reassbitmap));
-  }
+  uip_reassflags = 0;
+
   /*
-   * Check if the incoming fragment matches the one currently present
-   * in the reasembly buffer. If so, we proceed with copying the fragment
-   * into the buffer.
+   * Find the reassembly the incoming fragment belongs to, or start a
+   * new one. We first write the unfragmentable part of IP header into
+   * the reassembly, in case we do not receive the fragment with offset
+   * 0 first.
    */
-  if(uip_ipaddr_cmp(&FBUF->srcipaddr, &UIP_IP_BUF->srcipaddr) &&
-     uip_ipaddr_cmp(&FBUF->destipaddr, &UIP_IP_BUF->destipaddr) &&
-     UIP_FRAG_BUF->id == uip_id) {
-    len = uip_len - uip_ext_len - UIP_IPH_LEN - UIP_FRAGH_LEN;
-    offset = (uip_ntohs(UIP_FRAG_BUF->offsetresmore) & 0xfff8);
-    /* in byte, originaly in multiple of 8 bytes*/
-    PRINTF("len %d\n", len);
-    PRINTF("offset %d\n", offset);
-    if(offset == 0){
-      uip_reassflags |= UIP_REASS_FLAG_FIRSTFRAG;
-      /*
-       * The Next Header field of the last header of the Unfragmentable
-       * Part is obtained from the Next Header field of the first
-       * fragment's Fragment header.
-       */
-      *uip_next_hdr = UIP_FRAG_BUF->next;
-      memcpy(FBUF, UIP_IP_BUF, uip_ext_len + UIP_IPH_LEN);
-      PRINTF("src ");
-      PRINT6ADDR(&FBUF->srcipaddr);
-      PRINTF("dest ");
-      PRINT6ADDR(&FBUF->destipaddr);
-      PRINTF("next %d\n", UIP_IP_BUF->proto);
-
-    }
-
-    /* If the offset or the offset + fragment length overflows the
-       reassembly buffer, we discard the entire packet. */
-    if(offset > UIP_REASS_BUFSIZE ||
-       offset + len > UIP_REASS_BUFSIZE) {
-      uip_reass_on = 0;
-      etimer_stop(&uip_reass_timer);
+  c = reass_lookup();
+  if(c == NULL) {
+    c = reass_new();
+    if(c == NULL) {
+      return 0;
+    }
+    if(!reass_write(c, 0, (uint8_t *)UIP_IP_BUF, uip_ext_len + UIP_IPH_LEN)) {
+      reass_free(c);
+      reass_timer_update();
       return 0;
     }
+  }
 
-    /* If this fragment has the More Fragments flag set to zero, it is the
-       last fragment*/
-    if((uip_ntohs(UIP_FRAG_BUF->offsetresmore) & IP_MF) == 0) {
-      uip_reassflags |= UIP_REASS_FLAG_LASTFRAG;
-      /*calculate the size of the entire packet*/
-      uip_reasslen = offset + len;
-      PRINTF("LAST FRAGMENT reasslen %d\n", uip_reasslen);
-    } else {
-      /* If len is not a multiple of 8 octets and the M flag of that fragment
-         is 1, then that fragment must be discarded and an ICMP Parameter
-         Problem, Code 0, message should be sent to the source of the fragment,
-         pointing to the Payload Length field of the fragment packet. */
-      if(len % 8 != 0){
-        uip_icmp6_error_output(ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER, 4);
-        uip_reassflags |= UIP_REASS_FLAG_ERROR_MSG;
-        /* not clear if we should interrupt reassembly, but it seems so from
-           the conformance tests */
-        uip_reass_on = 0;
-        etimer_stop(&uip_reass_timer);
-        return uip_len;
-      }
+  len = uip_len - uip_ext_len - UIP_IPH_LEN - UIP_FRAGH_LEN;
+  offset = (uip_ntohs(UIP_FRAG_BUF->offsetresmore) & 0xfff8);
+  /* in byte, originaly in multiple of 8 bytes*/
+  PRINTF("len %d\n", len);
+  PRINTF("offset %d\n", offset);
+  if(offset == 0){
+    c->flags |= UIP_REASS_FLAG_FIRSTFRAG;
+    /*
+     * The Next Header field of the last header of the Unfragmentable
+     * Part is obtained from the Next Header field of the first
+     * fragment's Fragment header.
+     */
+    *uip_next_hdr = UIP_FRAG_BUF->next;
+    if(!reass_write(c, 0, (uint8_t *)UIP_IP_BUF, uip_ext_len + UIP_IPH_LEN)) {
+      reass_free(c);
+      reass_timer_update();
+      return 0;
+    }
+    PRINTF("src ");
+    PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
+    PRINTF("dest ");
+    PRINT6ADDR(&UIP_IP_BUF->destipaddr);
+    PRINTF("next %d\n", UIP_IP_BUF->proto);
+  }
+
+  /* If the offset or the offset + fragment length overflows the
+     reassembly buffer, we discard the entire packet. */
+  if(offset > UIP_REASS_BUFSIZE ||
+     UIP_IPH_LEN + uip_ext_len + offset + len > UIP_REASS_BUFSIZE) {
+    reass_free(c);
+    reass_timer_update();
+    return 0;
+  }
+
+  /* If this fragment has the More Fragments flag set to zero, it is the
+     last fragment*/
+  if((uip_ntohs(UIP_FRAG_BUF->offsetresmore) & IP_MF) == 0) {
+    c->flags |= UIP_REASS_FLAG_LASTFRAG;
+    /*calculate the size of the entire packet*/
+    c->len = offset + len;
+    PRINTF("LAST FRAGMENT reasslen %d\n", c->len);
+  } else {
+    /* If len is not a multiple of 8 octets and the M flag of that fragment
+       is 1, then that fragment must be discarded and an ICMP Parameter
+       Problem, Code 0, message should be sent to the source of the fragment,
+       pointing to the Payload Length field of the fragment packet. */
+    if(len % 8 != 0){
+      uip_icmp6_error_output(ICMP6_PARAM_PROB, ICMP6_PARAMPROB_HEADER, 4);
+      uip_reassflags |= UIP_REASS_FLAG_ERROR_MSG;
+      /* not clear if we should interrupt reassembly, but it seems so from
+         the conformance tests */
+      reass_free(c);
+      reass_timer_update();
+      return uip_len;
     }
+  }
 
-    /* Copy the fragment into the reassembly buffer, at the right
-       offset. */
-    memcpy((uint8_t *)FBUF + UIP_IPH_LEN + uip_ext_len + offset,
-           (uint8_t *)UIP_FRAG_BUF + UIP_FRAGH_LEN, len);
+  /* Copy the fragment into the reassembly, at the right offset. If
+     no memory can be found for it, the datagram cannot complete. */
+  if(!reass_write(c, UIP_IPH_LEN + uip_ext_len + offset,
+                  (uint8_t *)UIP_FRAG_BUF + UIP_FRAGH_LEN, len)) {
+    PRINTF("Reassembly pool exhausted\n");
+    reass_free(c);
+    reass_timer_update();
+    return 0;
+  }
 
-    /* Update the bitmap. */
-    if(offset >> 6 == (offset + len) >> 6) {
-      uip_reassbitmap[offset >> 6] |=
-        bitmap_bits[(offset >> 3) & 7] &
-        ~bitmap_bits[((offset + len) >> 3)  & 7];
-    } else {
-      /* If the two endpoints are in different bytes, we update the
-         bytes in the endpoints and fill the stuff inbetween with
-         0xff. */
-      uip_reassbitmap[offset >> 6] |= bitmap_bits[(offset >> 3) & 7];
+  /* Update the bitmap. */
+  if(offset >> 6 == (offset + len) >> 6) {
+    c->bitmap[offset >> 6] |=
+      bitmap_bits[(offset >> 3) & 7] &
+      ~bitmap_bits[((offset + len) >> 3)  & 7];
+  } else {
+    /* If the two endpoints are in different bytes, we update the
+       bytes in the endpoints and fill the stuff inbetween with
+       0xff. */
+    c->bitmap[offset >> 6] |= bitmap_bits[(offset >> 3) & 7];
 
-      for(i = (1 + (offset >> 6)); i < ((offset + len) >> 6); ++i) {
-        uip_reassbitmap[i] = 0xff;
-      }
-      uip_reassbitmap[(offset + len) >> 6] |=
-        ~bitmap_bits[((offset + len) >> 3) & 7];
+    for(i = (1 + (offset >> 6)); i < ((offset + len) >> 6); ++i) {
+      c->bitmap[i] = 0xff;
     }
+    c->bitmap[(offset + len) >> 6] |=
+      ~bitmap_bits[((offset + len) >> 3) & 7];
+  }
 
-    /* Finally, we check if we have a full packet in the buffer. We do
-       this by checking if we have the last fragment and if all bits
-       in the bitmap are set. */
+  /* Finally, we check if we have a full packet in the buffer. We do
+     this by checking if we have the last fragment and if all bits
+     in the bitmap are set. */
 
-    if(uip_reassflags & UIP_REASS_FLAG_LASTFRAG) {
-      /* Check all bytes up to and including all but the last byte in
-         the bitmap. */
-      for(i = 0; i < (uip_reasslen >> 6); ++i) {
-        if(uip_reassbitmap[i] != 0xff) {
-          return 0;
-        }
-      }
-      /* Check the last byte in the bitmap. It should contain just the
-         right amount of bits. */
-      if(uip_reassbitmap[uip_reasslen >> 6] !=
-         (uint8_t)~bitmap_bits[(uip_reasslen >> 3) & 7]) {
-        return 0;
+  if(c->flags & UIP_REASS_FLAG_LASTFRAG) {
+    /* Check all bytes up to and including all but the last byte in
+       the bitmap. */
+    for(i = 0; i < (c->len >> 6); ++i) {
+      if(c->bitmap[i] != 0xff) {
+        break;
       }
+    }
+    /* Check the last byte in the bitmap. It should contain just the
+       right amount of bits. */
+    if(i < (c->len >> 6) ||
+       c->bitmap[c->len >> 6] != (uint8_t)~bitmap_bits[(c->len >> 3) & 7]) {
+      reass_timer_update();
+      return 0;
+    }
 
-      /* If we have come this far, we have a full packet in the
-         buffer, so we copy it to uip_buf. We also reset the timer. */
-      uip_reass_on = 0;
-      etimer_stop(&uip_reass_timer);
-
-      uip_reasslen += UIP_IPH_LEN + uip_ext_len;
-      memcpy(UIP_IP_BUF, FBUF, uip_reasslen);
-      UIP_IP_BUF->len[0] = ((uip_reasslen - UIP_IPH_LEN) >> 8);
-      UIP_IP_BUF->len[1] = ((uip_reasslen - UIP_IPH_LEN) & 0xff);
-      PRINTF("REASSEMBLED PAQUET %d (%d)\n", uip_reasslen,
-             (UIP_IP_BUF->len[0] << 8) | UIP_IP_BUF->len[1]);
+    /* If we have come this far, we have a full packet, so we copy it
+       to uip_buf and release the reassembly. */
+    reasslen = c->len + UIP_IPH_LEN + uip_ext_len;
+    reass_read(c, (uint8_t *)UIP_IP_BUF, reasslen);
+    reass_free(c);
+    reass_timer_update();
 
-      return uip_reasslen;
+    UIP_IP_BUF->len[0] = ((reasslen - UIP_IPH_LEN) >> 8);
+    UIP_IP_BUF->len[1] = ((reasslen - UIP_IPH_LEN) & 0xff);
+    PRINTF("REASSEMBLED PAQUET %d (%d)\n", reasslen,
+           (UIP_IP_BUF->len[0] << 8) | UIP_IP_BUF->len[1]);
 
-    }
-  } else {
-    PRINTF("Already reassembling another paquet\n");
+    return reasslen;
   }
+
+  /* Starting this reassembly may have evicted others. */
+  reass_timer_update();
   return 0;
 }
 
 void
 uip_reass_over(void)
 {
-  /* to late, we abandon the reassembly of the packet */
-
-  uip_reass_on = 0;
-  etimer_stop(&uip_reass_timer);
-
-  if(uip_reassflags & UIP_REASS_FLAG_FIRSTFRAG){
-    PRINTF("FRAG INTERRUPTED TOO LATE\n");
-    /* If the first fragment has been received, an ICMP Time Exceeded
-       -- Fragment Reassembly Time Exceeded message should be sent to the
-       source of that fragment. */
-    /** \note
-     * We don't have a complete packet to put in the error message.
-     * We could include the first fragment but since its not mandated by
-     * any RFC, we decided not to include it as it reduces the size of
-     * the packet.
-     */
-    uip_clear_buf();
-    memcpy(UIP_IP_BUF, FBUF, UIP_IPH_LEN); /* copy the header for src
-                                              and dest address*/
-    uip_icmp6_error_output(ICMP6_TIME_EXCEEDED, ICMP6_TIME_EXCEED_REASSEMBLY, 0);
+  struct uip_reass_context *c;
+
+  /* to late, we abandon the reassembly of the packets that have
+     expired. Only one error message fits in uip_buf, so the timer is
+     rearmed to handle any further ones. */
+  for(c = reass_contexts; c < reass_contexts + UIP_REASS_CONTEXTS; c++) {
+    if(!(c->flags & UIP_REASS_FLAG_USED) || !timer_expired(&c->timer)) {
+      continue;
+    }
 
-    UIP_STAT(++uip_stat.ip.sent);
-    uip_flags = 0;
+    if(c->flags & UIP_REASS_FLAG_FIRSTFRAG){
+      PRINTF("FRAG INTERRUPTED TOO LATE\n");
+      /* If the first fragment has been received, an ICMP Time Exceeded
+         -- Fragment Reassembly Time Exceeded message should be sent to the
+         source of that fragment. */
+      /** \note
+       * We don't have a complete packet to put in the error message.
+       * We could include the first fragment but since its not mandated by
+       * any RFC, we decided not to include it as it reduces the size of
+       * the packet.
+       */
+      uip_clear_buf();
+      reass_read(c, (uint8_t *)UIP_IP_BUF, UIP_IPH_LEN); /* copy the header
+                                                            for src and
+                                                            dest address*/
+      reass_free(c);
+      uip_icmp6_error_output(ICMP6_TIME_EXCEEDED, ICMP6_TIME_EXCEED_REASSEMBLY, 0);
+
+      UIP_STAT(++uip_stat.ip.sent);
+      uip_flags = 0;
+      break;
+    }
+    reass_free(c);
   }
+  reass_timer_update();
 }
 
 #endif /* UIP_CONF_IPV6_REASSEMBLY */
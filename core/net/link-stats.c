@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *    Link statistics shared by the MAC, routing and collect layers
+ */
+
+#include "contiki.h"
+#include "sys/ctimer.h"
+#include "net/mac/mac.h"
+#include "net/packetbuf.h"
+#include "net/nbr-table.h"
+#include "net/link-stats.h"
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+/* Freshness is halved every half life, and an entry is fresh when it
+   has seen FRESHNESS_TARGET transmissions recently */
+#define FRESHNESS_HALF_LIFE     (20 * 60 * (clock_time_t)CLOCK_SECOND)
+#define FRESHNESS_TARGET        4
+#define FRESHNESS_MAX           16
+#define FRESHNESS_EXPIRATION    (10 * 60 * (clock_time_t)CLOCK_SECOND)
+
+NBR_TABLE(struct link_stats, link_stats);
+
+static struct ctimer periodic_timer;
+/*---------------------------------------------------------------------------*/
+static void
+ewma_packet_sent(struct link_stats *stats, int status, int numtx)
+{
+  uint16_t packet_etx;
+
+  if(status == MAC_TX_NOACK) {
+    packet_etx = LINK_STATS_ETX_NOACK_PENALTY * LINK_STATS_ETX_DIVISOR;
+  } else {
+    packet_etx = numtx * LINK_STATS_ETX_DIVISOR;
+  }
+
+  if(stats->etx == 0) {
+    /* No estimate yet, start from the first packet */
+    stats->etx = packet_etx;
+  } else {
+    stats->etx = ((uint32_t)stats->etx * LINK_STATS_ETX_ALPHA +
+                  (uint32_t)packet_etx * (100 - LINK_STATS_ETX_ALPHA)) / 100;
+  }
+}
+const struct link_stats_estimator link_stats_ewma = {
+  "ewma",
+  ewma_packet_sent
+};
+/*---------------------------------------------------------------------------*/
+static void
+window_packet_sent(struct link_stats *stats, int status, int numtx)
+{
+  uint32_t etx;
+
+  stats->window_tx += numtx;
+  if(status == MAC_TX_OK) {
+    stats->window_acked++;
+  }
+
+  if(stats->window_acked == 0) {
+    etx = (uint32_t)LINK_STATS_ETX_NOACK_PENALTY * LINK_STATS_ETX_DIVISOR;
+  } else {
+    etx = (uint32_t)stats->window_tx * LINK_STATS_ETX_DIVISOR /
+      stats->window_acked;
+  }
+  if(etx > (uint32_t)LINK_STATS_ETX_NOACK_PENALTY * LINK_STATS_ETX_DIVISOR) {
+    etx = (uint32_t)LINK_STATS_ETX_NOACK_PENALTY * LINK_STATS_ETX_DIVISOR;
+  }
+  stats->etx = etx;
+
+  if(stats->window_tx >= LINK_STATS_ETX_WINDOW) {
+    /* Start a new window, so that the estimate follows changes */
+    stats->window_tx = 0;
+    stats->window_acked = 0;
+  }
+}
+const struct link_stats_estimator link_stats_window = {
+  "window",
+  window_packet_sent
+};
+/*---------------------------------------------------------------------------*/
+const struct link_stats *
+link_stats_from_lladdr(const linkaddr_t *lladdr)
+{
+  return nbr_table_get_from_lladdr(link_stats, lladdr);
+}
+/*---------------------------------------------------------------------------*/
+const linkaddr_t *
+link_stats_get_lladdr(const struct link_stats *stats)
+{
+  return nbr_table_get_lladdr(link_stats, stats);
+}
+/*---------------------------------------------------------------------------*/
+int
+link_stats_is_fresh(const struct link_stats *stats)
+{
+  return stats != NULL &&
+    clock_time() - stats->last_tx_time < FRESHNESS_EXPIRATION &&
+    stats->freshness >= FRESHNESS_TARGET;
+}
+/*---------------------------------------------------------------------------*/
+const struct link_stats *
+link_stats_head(void)
+{
+  return nbr_table_head(link_stats);
+}
+/*---------------------------------------------------------------------------*/
+const struct link_stats *
+link_stats_next(const struct link_stats *stats)
+{
+  return nbr_table_next(link_stats, (struct link_stats *)stats);
+}
+/*---------------------------------------------------------------------------*/
+void
+link_stats_packet_sent(const linkaddr_t *lladdr, int status, int numtx)
+{
+  struct link_stats *stats;
+
+  if(lladdr == NULL || linkaddr_cmp(lladdr, &linkaddr_null)) {
+    return;
+  }
+  /* Collisions and other errors say nothing about the link itself */
+  if(status != MAC_TX_OK && status != MAC_TX_NOACK) {
+    return;
+  }
+
+  stats = nbr_table_get_from_lladdr(link_stats, lladdr);
+  if(stats == NULL) {
+    stats = nbr_table_add_lladdr(link_stats, lladdr,
+                                 NBR_TABLE_REASON_LINK_STATS, NULL);
+    if(stats == NULL) {
+      return;
+    }
+  }
+
+  stats->last_tx_time = clock_time();
+  stats->tx_count += numtx;
+  if(status == MAC_TX_OK) {
+    stats->ack_count++;
+  }
+  stats->freshness = MIN(stats->freshness + numtx, FRESHNESS_MAX);
+
+  LINK_STATS_ESTIMATOR.packet_sent(stats, status, numtx);
+
+  PRINTF("link-stats: %u.%u status %d numtx %d etx %u\n",
+         lladdr->u8[LINKADDR_SIZE - 2], lladdr->u8[LINKADDR_SIZE - 1],
+         status, numtx, stats->etx);
+}
+/*---------------------------------------------------------------------------*/
+void
+link_stats_input_callback(const linkaddr_t *lladdr)
+{
+  struct link_stats *stats;
+  int16_t rssi;
+  uint8_t lqi;
+
+  if(lladdr == NULL || linkaddr_cmp(lladdr, &linkaddr_null)) {
+    return;
+  }
+
+  rssi = (int16_t)packetbuf_attr(PACKETBUF_ATTR_RSSI);
+  lqi = packetbuf_attr(PACKETBUF_ATTR_LINK_QUALITY);
+
+  /* Only neighbors we transmit to get an entry: overhearing must not
+     fill the neighbor table */
+  stats = nbr_table_get_from_lladdr(link_stats, lladdr);
+  if(stats == NULL) {
+    return;
+  }
+
+  if(stats->rx_count == 0) {
+    stats->rssi = rssi;
+    stats->lqi = lqi;
+  } else {
+    stats->rssi = ((int32_t)stats->rssi * LINK_STATS_RSSI_ALPHA +
+                   (int32_t)rssi * (100 - LINK_STATS_RSSI_ALPHA)) / 100;
+    stats->lqi = ((uint16_t)stats->lqi * LINK_STATS_RSSI_ALPHA +
+                  (uint16_t)lqi * (100 - LINK_STATS_RSSI_ALPHA)) / 100;
+  }
+  stats->last_rx_time = clock_time();
+  stats->rx_count++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+periodic(void *ptr)
+{
+  struct link_stats *stats;
+  struct link_stats *next;
+  clock_time_t now;
+
+  now = clock_time();
+  for(stats = nbr_table_head(link_stats); stats != NULL; stats = next) {
+    next = nbr_table_next(link_stats, stats);
+    /* Receptions do not keep an entry alive, as anything in range
+       may be overheard */
+    if(now - stats->last_tx_time > LINK_STATS_EXPIRATION_TIME) {
+      /* Frees the neighbor for others unless another table uses it */
+      nbr_table_remove(link_stats, stats);
+    } else {
+      stats->freshness >>= 1;
+    }
+  }
+  ctimer_reset(&periodic_timer);
+}
+/*---------------------------------------------------------------------------*/
+void
+link_stats_init(void)
+{
+  nbr_table_register(link_stats, NULL);
+  ctimer_set(&periodic_timer, FRESHNESS_HALF_LIFE, periodic, NULL);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *    Link statistics shared by the MAC, routing and collect layers
+ *
+ *    One entry per neighbor, kept in a nbr-table and fed from the
+ *    MAC transmission callbacks and the packetbuf attributes of
+ *    received frames. The ETX is computed by a pluggable estimator,
+ *    selected with LINK_STATS_CONF_ESTIMATOR.
+ */
+
+#ifndef LINK_STATS_H_
+#define LINK_STATS_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+/** \brief Fixed point divisor of the ETX */
+#define LINK_STATS_ETX_DIVISOR 128
+
+/* ETX recorded for a transmission that got no ACK */
+#ifdef LINK_STATS_CONF_ETX_NOACK_PENALTY
+#define LINK_STATS_ETX_NOACK_PENALTY LINK_STATS_CONF_ETX_NOACK_PENALTY
+#else /* LINK_STATS_CONF_ETX_NOACK_PENALTY */
+#define LINK_STATS_ETX_NOACK_PENALTY 10
+#endif /* LINK_STATS_CONF_ETX_NOACK_PENALTY */
+
+/* Weight of the old ETX in the moving average of the EWMA estimator,
+   in 1/100 */
+#ifdef LINK_STATS_CONF_ETX_ALPHA
+#define LINK_STATS_ETX_ALPHA LINK_STATS_CONF_ETX_ALPHA
+#else /* LINK_STATS_CONF_ETX_ALPHA */
+#define LINK_STATS_ETX_ALPHA 90
+#endif /* LINK_STATS_CONF_ETX_ALPHA */
+
+/* Transmissions over which the window estimator computes the ETX */
+#ifdef LINK_STATS_CONF_ETX_WINDOW
+#define LINK_STATS_ETX_WINDOW LINK_STATS_CONF_ETX_WINDOW
+#else /* LINK_STATS_CONF_ETX_WINDOW */
+#define LINK_STATS_ETX_WINDOW 16
+#endif /* LINK_STATS_CONF_ETX_WINDOW */
+
+/* Weight of the old RSSI and LQI in their moving averages, in 1/100 */
+#ifdef LINK_STATS_CONF_RSSI_ALPHA
+#define LINK_STATS_RSSI_ALPHA LINK_STATS_CONF_RSSI_ALPHA
+#else /* LINK_STATS_CONF_RSSI_ALPHA */
+#define LINK_STATS_RSSI_ALPHA 85
+#endif /* LINK_STATS_CONF_RSSI_ALPHA */
+
+/* The estimator used for the ETX */
+#ifdef LINK_STATS_CONF_ESTIMATOR
+#define LINK_STATS_ESTIMATOR LINK_STATS_CONF_ESTIMATOR
+#else /* LINK_STATS_CONF_ESTIMATOR */
+#define LINK_STATS_ESTIMATOR link_stats_ewma
+#endif /* LINK_STATS_CONF_ESTIMATOR */
+
+/* Entries we have not transmitted to for this long are removed */
+#ifdef LINK_STATS_CONF_EXPIRATION_TIME
+#define LINK_STATS_EXPIRATION_TIME LINK_STATS_CONF_EXPIRATION_TIME
+#else /* LINK_STATS_CONF_EXPIRATION_TIME */
+#define LINK_STATS_EXPIRATION_TIME (20 * 60 * (clock_time_t)CLOCK_SECOND)
+#endif /* LINK_STATS_CONF_EXPIRATION_TIME */
+
+/** \brief Statistics of the link to one neighbor */
+struct link_stats {
+  uint16_t etx;               /**< ETX times LINK_STATS_ETX_DIVISOR,
+                                   0 until the first transmission */
+  int16_t rssi;               /**< Moving average of the RSSI */
+  uint8_t lqi;                /**< Moving average of the LQI */
+  uint8_t freshness;          /**< Recent transmissions, halved
+                                   periodically */
+  uint8_t window_tx;          /**< Estimator state, transmissions */
+  uint8_t window_acked;       /**< Estimator state, ACKed packets */
+  uint16_t tx_count;          /**< Transmissions, including retries */
+  uint16_t ack_count;         /**< Packets that were ACKed */
+  uint16_t rx_count;          /**< Frames received */
+  clock_time_t last_tx_time;  /**< Time of the last transmission */
+  clock_time_t last_rx_time;  /**< Time of the last reception */
+};
+
+/** \brief An ETX estimator */
+struct link_stats_estimator {
+  char *name;
+  /** Update the ETX of \a stats after a packet was sent \a numtx
+      times with MAC status \a status. Only called for MAC_TX_OK and
+      MAC_TX_NOACK. */
+  void (*packet_sent)(struct link_stats *stats, int status, int numtx);
+};
+
+/** \brief Exponentially weighted moving average of the per-packet ETX */
+extern const struct link_stats_estimator link_stats_ewma;
+/** \brief Ratio of transmissions to ACKed packets over a window */
+extern const struct link_stats_estimator link_stats_window;
+
+/** \brief The statistics of the link to \a lladdr, or NULL */
+const struct link_stats *link_stats_from_lladdr(const linkaddr_t *lladdr);
+
+/** \brief The link-layer address of the neighbor of \a stats */
+const linkaddr_t *link_stats_get_lladdr(const struct link_stats *stats);
+
+/** \brief Nonzero if \a stats reflect recent transmissions */
+int link_stats_is_fresh(const struct link_stats *stats);
+
+/** \brief The first entry of the table, for iteration */
+const struct link_stats *link_stats_head(void);
+
+/** \brief The entry after \a stats, or NULL */
+const struct link_stats *link_stats_next(const struct link_stats *stats);
+
+/**
+ * \brief Account for a unicast packet sent to \a lladdr
+ * \param lladdr The receiver; broadcasts are ignored
+ * \param status The MAC status, MAC_TX_*
+ * \param numtx The number of transmissions
+ */
+void link_stats_packet_sent(const linkaddr_t *lladdr, int status, int numtx);
+
+/**
+ * \brief Account for a frame received from \a lladdr, with the RSSI
+ * and LQI in the packetbuf attributes
+ */
+void link_stats_input_callback(const linkaddr_t *lladdr);
+
+/** \brief Initialize the module, called from netstack_init() */
+void link_stats_init(void);
+
+#endif /* LINK_STATS_H_ */
@@ -45,6 +45,7 @@
 
 /* c.f. IEEE 802.15.4e Table 4b */
 enum ieee802154e_header_ie_id {
+  HEADER_IE_VENDOR_SPECIFIC = 0x00,
   HEADER_IE_LE_CSL = 0x1a,
   HEADER_IE_LE_RIT,
   HEADER_IE_DSME_PAN_DESCRIPTOR,
@@ -60,9 +61,13 @@ enum ieee802154e_header_ie_id {
 enum ieee802154e_payload_ie_id {
   PAYLOAD_IE_ESDU = 0,
   PAYLOAD_IE_MLME,
+  PAYLOAD_IE_IETF = 0x5,
   PAYLOAD_IE_LIST_TERMINATION = 0xf,
 };
 
+/* c.f. RFC 8137 and RFC 8480: sub-IE ID of 6P within the IETF IE */
+#define IETF_IE_SUB_ID_6TOP 0xc9
+
 /* c.f. IEEE 802.15.4e Table 4d */
 enum ieee802154e_mlme_short_subie_id {
   MLME_SHORT_IE_TSCH_SYNCHRONIZATION = 0x1a,
@@ -148,6 +153,26 @@ frame80215e_create_ie_header_ack_nack_time_correction(uint8_t *buf, int len,
   }
 }
 
+/* Header IE. Vendor specific. Used by upper layers to piggyback their own
+ * information, e.g. in EBs */
+int
+frame80215e_create_ie_header_vendor_specific(uint8_t *buf, int len,
+    struct ieee802154_ies *ies)
+{
+  if(ies != NULL && ies->ie_vendor_len <= FRAME802154E_IE_MAX_VENDOR_LEN) {
+    int ie_len = 3 + ies->ie_vendor_len;
+    if(len >= 2 + ie_len) {
+      buf[2] = (FRAME802154E_IE_VENDOR_OUI >> 16) & 0xff;
+      buf[3] = (FRAME802154E_IE_VENDOR_OUI >> 8) & 0xff;
+      buf[4] = FRAME802154E_IE_VENDOR_OUI & 0xff;
+      memcpy(buf + 5, ies->ie_vendor_data, ies->ie_vendor_len);
+      create_header_ie_descriptor(buf, HEADER_IE_VENDOR_SPECIFIC, ie_len);
+      return 2 + ie_len;
+    }
+  }
+  return -1;
+}
+
 /* Header IE. List termination 1 (Signals the end of the Header IEs when
  * followed by payload IEs) */
 int
@@ -192,6 +217,23 @@ frame80215e_create_ie_payload_list_termination(uint8_t *buf, int len,
   }
 }
 
+/* Payload IE. IETF, containing a 6top sub-IE. Only the IE descriptor and
+ * sub-IE ID are written; the ie_sixtop_content_len bytes of 6P message
+ * are expected right after */
+int
+frame80215e_create_ie_ietf_6top(uint8_t *buf, int len,
+    struct ieee802154_ies *ies)
+{
+  int ie_len = 1;
+  if(len >= 2 + ie_len && ies != NULL) {
+    create_payload_ie_descriptor(buf, PAYLOAD_IE_IETF, 1 + ies->ie_sixtop_content_len);
+    buf[2] = IETF_IE_SUB_ID_6TOP;
+    return 2 + ie_len;
+  } else {
+    return -1;
+  }
+}
+
 /* Payload IE. MLME. Used to nest sub-IEs */
 int
 frame80215e_create_ie_mlme(uint8_t *buf, int len,
@@ -348,6 +390,20 @@ frame802154e_parse_header_ie(const uint8_t *buf, int len,
         return len;
       }
       break;
+    case HEADER_IE_VENDOR_SPECIFIC:
+      if(len >= 3) {
+        uint32_t oui = (uint32_t)buf[0] << 16 | (uint32_t)buf[1] << 8 | buf[2];
+        if(oui == FRAME802154E_IE_VENDOR_OUI
+           && len - 3 <= FRAME802154E_IE_MAX_VENDOR_LEN) {
+          if(ies != NULL) {
+            ies->ie_vendor_len = len - 3;
+            memcpy(ies->ie_vendor_data, buf + 3, len - 3);
+          }
+        }
+        /* Skip IEs of other vendors */
+        return len;
+      }
+      break;
   }
   return -1;
 }
@@ -529,6 +585,17 @@ frame802154e_parse_information_elements(const uint8_t *buf, uint8_t buf_size,
             len = 0; /* Reset len as we want to read subIEs and not jump over them */
             PRINTF("frame802154e: entering MLME ie with len %u\n", nested_mlme_len);
             break;
+          case PAYLOAD_IE_IETF:
+            if(len > buf_size) {
+              return -1;
+            }
+            if(len >= 1 && buf[0] == IETF_IE_SUB_ID_6TOP) {
+              /* Point to the 6P message, the upper layer will parse it */
+              ies->ie_sixtop_content = buf + 1;
+              ies->ie_sixtop_content_len = len - 1;
+            }
+            /* Skip other IETF sub-IEs */
+            break;
           case PAYLOAD_IE_LIST_TERMINATION:
             PRINTF("frame802154e: payload ie list termination %u\n", len);
             return (len == 0) ? buf + len - start : -1;
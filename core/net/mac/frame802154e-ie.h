@@ -46,6 +46,22 @@
 
 #define FRAME802154E_IE_MAX_LINKS       4
 
+/* Maximum length of the data carried in a vendor-specific header IE */
+#ifdef FRAME802154E_CONF_IE_MAX_VENDOR_LEN
+#define FRAME802154E_IE_MAX_VENDOR_LEN  FRAME802154E_CONF_IE_MAX_VENDOR_LEN
+#else
+#define FRAME802154E_IE_MAX_VENDOR_LEN  4
+#endif
+
+/* The OUI used in, and expected in, vendor-specific header IEs. Vendor IEs
+ * with another OUI are skipped when parsing. The default is in the locally
+ * assigned (CID) range. */
+#ifdef FRAME802154E_CONF_IE_VENDOR_OUI
+#define FRAME802154E_IE_VENDOR_OUI      FRAME802154E_CONF_IE_VENDOR_OUI
+#else
+#define FRAME802154E_IE_VENDOR_OUI      0x0a0000
+#endif
+
 /* Structures used for the Slotframe and Links information element */
 struct tsch_slotframe_and_links_link {
   uint16_t timeslot;
@@ -65,6 +81,8 @@ struct ieee802154_ies {
   /* Header IEs */
   int16_t ie_time_correction;
   uint8_t ie_is_nack;
+  uint8_t ie_vendor_len; /* 0 if there is no vendor-specific IE */
+  uint8_t ie_vendor_data[FRAME802154E_IE_MAX_VENDOR_LEN];
   /* Payload MLME */
   uint8_t ie_payload_ie_offset;
   uint16_t ie_mlme_len;
@@ -80,12 +98,18 @@ struct ieee802154_ies {
   /* We include and parse only the sequence len and list and omit unused fields */
   uint16_t ie_hopping_sequence_len;
   uint8_t ie_hopping_sequence_list[TSCH_HOPPING_SEQUENCE_MAX_LEN];
+  /* Payload IETF IE: 6top sub-IE, pointing into the parsed frame */
+  const uint8_t *ie_sixtop_content;
+  uint16_t ie_sixtop_content_len;
 };
 
 /** Insert various Information Elements **/
 /* Header IE. ACK/NACK time correction. Used in enhanced ACKs */
 int frame80215e_create_ie_header_ack_nack_time_correction(uint8_t *buf, int len,
     struct ieee802154_ies *ies);
+/* Header IE. Vendor specific, with our OUI. Carries ie_vendor_data */
+int frame80215e_create_ie_header_vendor_specific(uint8_t *buf, int len,
+    struct ieee802154_ies *ies);
 /* Header IE. List termination 1 (Signals the end of the Header IEs when
  * followed by payload IEs) */
 int frame80215e_create_ie_header_list_termination_1(uint8_t *buf, int len,
@@ -97,6 +121,10 @@ int frame80215e_create_ie_header_list_termination_2(uint8_t *buf, int len,
 /* Payload IE. List termination */
 int frame80215e_create_ie_payload_list_termination(uint8_t *buf, int len,
     struct ieee802154_ies *ies);
+/* Payload IE. IETF, with a 6top sub-IE of ie_sixtop_content_len bytes.
+ * Writes only the IE and sub-IE headers. */
+int frame80215e_create_ie_ietf_6top(uint8_t *buf, int len,
+    struct ieee802154_ies *ies);
 /* Payload IE. MLME. Used to nest sub-IEs */
 int frame80215e_create_ie_mlme(uint8_t *buf, int len,
     struct ieee802154_ies *ies);
@@ -40,6 +40,7 @@
 #include "net/mac/frame802154.h"
 #include "net/llsec/llsec802154.h"
 #include "net/packetbuf.h"
+#include "net/mac/tsch/tsch-conf.h"
 #include "lib/random.h"
 #include <string.h>
 
@@ -97,6 +98,11 @@ create_frame(int type, int do_create)
 
   /* Insert IEEE 802.15.4 version bits. */
   params.fcf.frame_version = FRAME802154_VERSION;
+
+#if TSCH_WITH_SIXTOP
+  /* The payload starts with IEs, e.g. 6top messages */
+  params.fcf.ie_list_present = packetbuf_attr(PACKETBUF_ATTR_MAC_METADATA);
+#endif /* TSCH_WITH_SIXTOP */
   
 #if LLSEC802154_USES_AUX_HEADER
   if(packetbuf_attr(PACKETBUF_ATTR_SECURITY_LEVEL)) {
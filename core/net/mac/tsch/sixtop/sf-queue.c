@@ -0,0 +1,652 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         SF-queue: a minimal 6top scheduling function.
+ *           All negotiated cells are in a dedicated slotframe. A node samples
+ *           the number of packets queued for its time source, and adds
+ *           (resp. deletes) one Tx cell to it through 6P when the backlog
+ *           reached SF_QUEUE_HIGH_WATERMARK (resp. stayed at 0) during an
+ *           adaptation interval. The time source installs the matching Rx
+ *           cell. Upon inconsistency (6P timeout, sequence number mismatch)
+ *           or time source switch, the cells with the peer are cleared. The
+ *           CLEAR request is repeated until the peer answers it, so that
+ *           it does not keep Rx cells for us.
+ *         As a responder, SF-queue handles ADD, DELETE, RELOCATE, COUNT,
+ *         LIST and CLEAR for cells where the initiator transmits.
+ */
+
+#include <string.h>
+#include "contiki.h"
+#include "lib/random.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "net/mac/tsch/tsch.h"
+#include "net/mac/tsch/tsch-queue.h"
+#include "net/mac/tsch/tsch-schedule.h"
+#include "net/mac/tsch/sixtop/sixp.h"
+#include "net/mac/tsch/sixtop/sf-queue.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+/* Link options of the cells we negotiate, as initiator and responder */
+#define CELL_OPTIONS_INITIATOR  SIXP_PKT_CELL_OPTION_TX
+#define LINK_OPTIONS_INITIATOR  LINK_OPTION_TX
+#define LINK_OPTIONS_RESPONDER  LINK_OPTION_RX
+
+static struct ctimer sample_timer;
+/* Our time source, i.e. the peer we negotiate Tx cells with */
+static linkaddr_t parent;
+static uint8_t has_parent;
+/* Largest backlog sampled during the current adaptation interval */
+static uint8_t max_backlog;
+static uint16_t sample_count;
+
+/* Peers that have not answered our CLEAR yet */
+struct pending_clear {
+  struct pending_clear *next;
+  linkaddr_t addr;
+  uint8_t attempts;
+};
+MEMB(pending_clear_memb, struct pending_clear, SF_QUEUE_MAX_PENDING_CLEARS);
+LIST(pending_clear_list);
+static struct ctimer clear_timer;
+
+/*---------------------------------------------------------------------------*/
+/* The schedule is emptied upon association: look our slotframe up
+ * every time, and create it if needed */
+static struct tsch_slotframe *
+get_slotframe(void)
+{
+  struct tsch_slotframe *sf = tsch_schedule_get_slotframe_by_handle(SF_QUEUE_SLOTFRAME_HANDLE);
+  if(sf == NULL) {
+    sf = tsch_schedule_add_slotframe(SF_QUEUE_SLOTFRAME_HANDLE, SF_QUEUE_SLOTFRAME_LENGTH);
+  }
+  return sf;
+}
+/*---------------------------------------------------------------------------*/
+static struct tsch_link *
+find_cell(const linkaddr_t *peer, const struct sixp_pkt_cell *cell, uint8_t link_options)
+{
+  struct tsch_link *l = tsch_schedule_get_link_by_timeslot(get_slotframe(), cell->timeslot);
+  if(l != NULL && linkaddr_cmp(&l->addr, peer)
+     && l->channel_offset == cell->channel_offset && l->link_options == link_options) {
+    return l;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Is timeslot unused in our slotframe, and in the others? */
+static int
+is_free(uint16_t timeslot)
+{
+  struct tsch_slotframe *sf = tsch_schedule_slotframes_next(NULL);
+  while(sf != NULL) {
+    if(tsch_schedule_get_link_by_timeslot(sf, timeslot % sf->size.val) != NULL) {
+      return 0;
+    }
+    sf = tsch_schedule_slotframes_next(sf);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Fills list with up to max_len free cells, starting from a random
+ * timeslot. Returns the number of cells. */
+static uint8_t
+get_free_cells(struct sixp_pkt_cell *list, uint8_t max_len)
+{
+  uint16_t offset = random_rand() % SF_QUEUE_SLOTFRAME_LENGTH;
+  uint8_t len = 0;
+  uint16_t i;
+
+  for(i = 0; i < SF_QUEUE_SLOTFRAME_LENGTH && len < max_len; i++) {
+    uint16_t timeslot = (offset + i) % SF_QUEUE_SLOTFRAME_LENGTH;
+    if(is_free(timeslot)) {
+      list[len].timeslot = timeslot;
+      list[len].channel_offset = random_rand() % TSCH_HOPPING_SEQUENCE_MAX_LEN;
+      len++;
+    }
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* Fills list with up to max_len cells with peer, skipping the first
+ * offset ones. Returns the number of cells, and the total in *total. */
+static uint8_t
+get_cells(const linkaddr_t *peer, uint8_t link_options, uint16_t offset,
+          struct sixp_pkt_cell *list, uint8_t max_len, uint16_t *total)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  struct tsch_link *l;
+  uint8_t len = 0;
+  uint16_t count = 0;
+
+  for(l = sf != NULL ? list_head(sf->links_list) : NULL; l != NULL; l = list_item_next(l)) {
+    if(linkaddr_cmp(&l->addr, peer) && l->link_options == link_options) {
+      if(count >= offset && len < max_len) {
+        list[len].timeslot = l->timeslot;
+        list[len].channel_offset = l->channel_offset;
+        len++;
+      }
+      count++;
+    }
+  }
+  if(total != NULL) {
+    *total = count;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
+sf_queue_num_tx_cells(const linkaddr_t *peer)
+{
+  uint16_t total;
+  get_cells(peer, LINK_OPTIONS_INITIATOR, 0, NULL, 0, &total);
+  return total;
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_cells(const linkaddr_t *peer, uint8_t link_options,
+          const struct sixp_pkt_cell *list, uint8_t len)
+{
+  uint8_t i;
+  for(i = 0; i < len; i++) {
+    PRINTF("SF-queue: add cell %u %u with %u\n",
+           list[i].timeslot, list[i].channel_offset, peer->u8[LINKADDR_SIZE - 1]);
+    tsch_schedule_add_link(get_slotframe(), link_options, LINK_TYPE_NORMAL, peer,
+                           list[i].timeslot, list[i].channel_offset);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_cells(const linkaddr_t *peer, uint8_t link_options,
+             const struct sixp_pkt_cell *list, uint8_t len)
+{
+  uint8_t i;
+  for(i = 0; i < len; i++) {
+    struct tsch_link *l = find_cell(peer, &list[i], link_options);
+    if(l != NULL) {
+      PRINTF("SF-queue: remove cell %u %u with %u\n",
+             list[i].timeslot, list[i].channel_offset, peer->u8[LINKADDR_SIZE - 1]);
+      tsch_schedule_remove_link(get_slotframe(), l);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Removes all cells with peer */
+static void
+remove_all_cells(const linkaddr_t *peer)
+{
+  struct tsch_slotframe *sf = get_slotframe();
+  struct tsch_link *l = sf != NULL ? list_head(sf->links_list) : NULL;
+  while(l != NULL) {
+    struct tsch_link *next = list_item_next(l);
+    if(linkaddr_cmp(&l->addr, peer)) {
+      tsch_schedule_remove_link(sf, l);
+    }
+    l = next;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct pending_clear *
+pending_clear_lookup(const linkaddr_t *peer)
+{
+  struct pending_clear *c;
+  for(c = list_head(pending_clear_list); c != NULL; c = list_item_next(c)) {
+    if(linkaddr_cmp(&c->addr, peer)) {
+      return c;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+pending_clear_remove(struct pending_clear *c)
+{
+  list_remove(pending_clear_list, c);
+  memb_free(&pending_clear_memb, c);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends a CLEAR request, unless a transaction with the peer is ongoing.
+ * A failed transmission, an error code or a timeout leave the peer in the
+ * pending list, and the CLEAR is retried by retry_clears() */
+static void
+send_clear(struct pending_clear *c)
+{
+  static const uint8_t body[SIXP_PKT_CLEAR_REQ_LEN];
+  if(!sixp_is_busy(&c->addr)
+     && sixp_output(SIXP_PKT_TYPE_REQUEST, SIXP_PKT_CMD_CLEAR, SF_QUEUE_SFID,
+                    body, sizeof(body), &c->addr, NULL, NULL, 0) == 0) {
+    c->attempts++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+retry_clears(void *ptr)
+{
+  struct pending_clear *c;
+  struct pending_clear *next;
+
+  for(c = list_head(pending_clear_list); c != NULL; c = next) {
+    next = list_item_next(c);
+    if(c->attempts >= SF_QUEUE_CLEAR_MAX_ATTEMPTS) {
+      PRINTF("SF-queue:! %u never answered our CLEAR, giving up\n",
+             c->addr.u8[LINKADDR_SIZE - 1]);
+      pending_clear_remove(c);
+    } else {
+      send_clear(c);
+    }
+  }
+  if(list_head(pending_clear_list) != NULL) {
+    ctimer_reset(&clear_timer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Our schedule with peer is inconsistent: remove our cells first, as the
+ * CLEAR request would otherwise be sent on cells the peer may not listen to */
+static void
+reset_peer(const linkaddr_t *peer)
+{
+  struct pending_clear *c;
+
+  PRINTF("SF-queue: reset schedule with %u\n", peer->u8[LINKADDR_SIZE - 1]);
+  remove_all_cells(peer);
+
+  c = pending_clear_lookup(peer);
+  if(c == NULL) {
+    c = memb_alloc(&pending_clear_memb);
+    if(c == NULL) {
+      PRINTF("SF-queue:! no room to clear %u\n", peer->u8[LINKADDR_SIZE - 1]);
+      return;
+    }
+    linkaddr_copy(&c->addr, peer);
+    list_add(pending_clear_list, c);
+    if(ctimer_expired(&clear_timer)) {
+      ctimer_set(&clear_timer, SF_QUEUE_ADAPT_INTERVAL, retry_clears, NULL);
+    }
+  }
+  c->attempts = 0;
+  send_clear(c);
+}
+/*---------------------------------------------------------------------------*/
+static void
+request_sent(const linkaddr_t *peer, int status, const void *arg, uint16_t arg_len)
+{
+  if(status != SIXP_OUTPUT_STATUS_SUCCESS) {
+    /* The request may have been sent on cells the peer no longer has */
+    reset_peer(peer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+request_add(void)
+{
+  static uint8_t body[SIXP_PKT_CELL_LIST_OFFSET + SIXTOP_MAX_CELLS * SIXP_PKT_CELL_LEN];
+  struct sixp_pkt_cell list[SIXTOP_MAX_CELLS];
+  uint8_t len;
+  int body_len;
+
+  /* Propose several candidates, the parent picks one it has free */
+  len = get_free_cells(list, SIXTOP_MAX_CELLS);
+  if(len == 0) {
+    PRINTF("SF-queue:! no free cell to add\n");
+    return;
+  }
+  body_len = sixp_pkt_create_cell_list_req(body, sizeof(body), CELL_OPTIONS_INITIATOR, 1, list, len);
+  if(body_len >= 0) {
+    sixp_output(SIXP_PKT_TYPE_REQUEST, SIXP_PKT_CMD_ADD, SF_QUEUE_SFID,
+                body, body_len, &parent, request_sent, NULL, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+request_delete(void)
+{
+  static uint8_t body[SIXP_PKT_CELL_LIST_OFFSET + SIXP_PKT_CELL_LEN];
+  struct sixp_pkt_cell cell;
+  int body_len;
+
+  if(get_cells(&parent, LINK_OPTIONS_INITIATOR, 0, &cell, 1, NULL) == 0) {
+    return;
+  }
+  body_len = sixp_pkt_create_cell_list_req(body, sizeof(body), CELL_OPTIONS_INITIATOR, 1, &cell, 1);
+  if(body_len >= 0) {
+    sixp_output(SIXP_PKT_TYPE_REQUEST, SIXP_PKT_CMD_DELETE, SF_QUEUE_SFID,
+                body, body_len, &parent, request_sent, NULL, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Reads the CellList of pkt, starting at offset, into list */
+static uint8_t
+read_cells(const struct sixp_pkt *pkt, uint16_t offset, uint8_t max_len,
+           struct sixp_pkt_cell *list)
+{
+  uint8_t len = 0;
+  if(pkt->body_len < offset) {
+    return 0;
+  }
+  while(len < max_len
+        && sixp_pkt_get_cell(pkt->body + offset, pkt->body_len - offset, len, &list[len]) == 0) {
+    len++;
+  }
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_response(const struct sixp_pkt *pkt, uint8_t cmd, const linkaddr_t *peer)
+{
+  struct sixp_pkt_cell list[SIXTOP_MAX_CELLS];
+  uint8_t len;
+  uint8_t i;
+
+  if(cmd == SIXP_PKT_CMD_CLEAR) {
+    /* Any answer but success, e.g. busy, and the CLEAR is retried */
+    struct pending_clear *c = pending_clear_lookup(peer);
+    if(c != NULL && pkt->code == SIXP_PKT_RC_SUCCESS) {
+      pending_clear_remove(c);
+    }
+    return;
+  }
+  if(pkt->code == SIXP_PKT_RC_ERR_SEQNUM) {
+    /* The peer lost track of our transactions, e.g. it rebooted */
+    reset_peer(peer);
+    return;
+  }
+  if(pkt->code != SIXP_PKT_RC_SUCCESS) {
+    /* E.g. busy or no free cell: try again at the next adaptation */
+    PRINTF("SF-queue: request %u to %u failed, rc %u\n", cmd, peer->u8[LINKADDR_SIZE - 1], pkt->code);
+    return;
+  }
+
+  len = read_cells(pkt, 0, SIXTOP_MAX_CELLS, list);
+  if(cmd == SIXP_PKT_CMD_ADD) {
+    for(i = 0; i < len; i++) {
+      if(is_free(list[i].timeslot)) {
+        add_cells(peer, LINK_OPTIONS_INITIATOR, &list[i], 1);
+      }
+    }
+  } else if(cmd == SIXP_PKT_CMD_DELETE) {
+    remove_cells(peer, LINK_OPTIONS_INITIATOR, list, len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_response_sent(const linkaddr_t *peer, int status, const void *arg, uint16_t arg_len)
+{
+  /* Without the acknowledgment, the initiator may have missed the response.
+   * It will time out and clear. */
+  if(status == SIXP_OUTPUT_STATUS_SUCCESS) {
+    add_cells(peer, LINK_OPTIONS_RESPONDER, arg, arg_len / sizeof(struct sixp_pkt_cell));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+delete_response_sent(const linkaddr_t *peer, int status, const void *arg, uint16_t arg_len)
+{
+  remove_cells(peer, LINK_OPTIONS_RESPONDER, arg, arg_len / sizeof(struct sixp_pkt_cell));
+}
+/*---------------------------------------------------------------------------*/
+/* arg holds the relocated cells, then as many new cells */
+static void
+relocate_response_sent(const linkaddr_t *peer, int status, const void *arg, uint16_t arg_len)
+{
+  const struct sixp_pkt_cell *list = arg;
+  uint8_t len = arg_len / (2 * sizeof(struct sixp_pkt_cell));
+  if(status == SIXP_OUTPUT_STATUS_SUCCESS) {
+    remove_cells(peer, LINK_OPTIONS_RESPONDER, list, len);
+    add_cells(peer, LINK_OPTIONS_RESPONDER, list + len, len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+clear_response_sent(const linkaddr_t *peer, int status, const void *arg, uint16_t arg_len)
+{
+  remove_all_cells(peer);
+}
+/*---------------------------------------------------------------------------*/
+static void
+respond(uint8_t rc, const uint8_t *body, uint16_t body_len, const linkaddr_t *peer,
+        sixp_sent_callback_t func, const void *arg, uint16_t arg_len)
+{
+  sixp_output(SIXP_PKT_TYPE_RESPONSE, rc, SF_QUEUE_SFID, body, body_len, peer,
+              func, arg, arg_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_request(const struct sixp_pkt *pkt, const linkaddr_t *peer)
+{
+  static uint8_t body[SIXP_PKT_MAX_BODY_LEN];
+  /* Cells of the request, then cells of the response */
+  struct sixp_pkt_cell list[2 * SIXTOP_MAX_CELLS];
+  uint8_t num_cells;
+  uint8_t len;
+  uint8_t i;
+  int body_len;
+
+  if(pkt->code == SIXP_PKT_CMD_CLEAR) {
+    respond(SIXP_PKT_RC_SUCCESS, NULL, 0, peer, clear_response_sent, NULL, 0);
+    return;
+  }
+
+  /* All other commands start with Metadata and CellOptions. We only
+   * handle cells where the initiator transmits. */
+  if(pkt->body_len < SIXP_PKT_COUNT_REQ_LEN || pkt->body[2] != CELL_OPTIONS_INITIATOR) {
+    respond(SIXP_PKT_RC_ERR, NULL, 0, peer, NULL, NULL, 0);
+    return;
+  }
+
+  switch(pkt->code) {
+    case SIXP_PKT_CMD_ADD:
+    case SIXP_PKT_CMD_DELETE:
+    case SIXP_PKT_CMD_RELOCATE:
+      if(pkt->body_len < SIXP_PKT_CELL_LIST_OFFSET) {
+        break;
+      }
+      num_cells = MIN(pkt->body[3], SIXTOP_MAX_CELLS);
+      len = read_cells(pkt, SIXP_PKT_CELL_LIST_OFFSET, 2 * SIXTOP_MAX_CELLS, list);
+
+      if(pkt->code == SIXP_PKT_CMD_ADD) {
+        /* Select num_cells candidates that are free on our side */
+        uint8_t selected = 0;
+        for(i = 0; i < len && selected < num_cells; i++) {
+          if(is_free(list[i].timeslot)) {
+            list[selected++] = list[i];
+          }
+        }
+        if(selected == 0 && num_cells > 0) {
+          respond(SIXP_PKT_RC_ERR_CELLLIST, NULL, 0, peer, NULL, NULL, 0);
+          return;
+        }
+        body_len = sixp_pkt_create_cell_list(body, sizeof(body), list, selected);
+        respond(SIXP_PKT_RC_SUCCESS, body, body_len, peer,
+                add_response_sent, list, selected * sizeof(struct sixp_pkt_cell));
+        return;
+      }
+
+      /* DELETE and RELOCATE: all cells of the list must exist */
+      if(len < num_cells) {
+        break;
+      }
+      for(i = 0; i < num_cells; i++) {
+        if(find_cell(peer, &list[i], LINK_OPTIONS_RESPONDER) == NULL) {
+          respond(SIXP_PKT_RC_ERR_CELLLIST, NULL, 0, peer, NULL, NULL, 0);
+          return;
+        }
+      }
+
+      if(pkt->code == SIXP_PKT_CMD_DELETE) {
+        body_len = sixp_pkt_create_cell_list(body, sizeof(body), list, num_cells);
+        respond(SIXP_PKT_RC_SUCCESS, body, body_len, peer,
+                delete_response_sent, list, num_cells * sizeof(struct sixp_pkt_cell));
+      } else {
+        /* RELOCATE: pick new cells among the candidates following the
+         * relocation list. The first cells of the relocation list are
+         * relocated, as many as new cells were found. */
+        struct sixp_pkt_cell relocated[2 * SIXTOP_MAX_CELLS];
+        uint8_t selected = 0;
+        for(i = num_cells; i < len && selected < num_cells; i++) {
+          if(is_free(list[i].timeslot)) {
+            relocated[SIXTOP_MAX_CELLS + selected++] = list[i];
+          }
+        }
+        if(selected == 0 && num_cells > 0) {
+          respond(SIXP_PKT_RC_ERR_CELLLIST, NULL, 0, peer, NULL, NULL, 0);
+          return;
+        }
+        memcpy(relocated, list, selected * sizeof(struct sixp_pkt_cell));
+        memmove(relocated + selected, relocated + SIXTOP_MAX_CELLS,
+                selected * sizeof(struct sixp_pkt_cell));
+        body_len = sixp_pkt_create_cell_list(body, sizeof(body), relocated + selected, selected);
+        respond(SIXP_PKT_RC_SUCCESS, body, body_len, peer,
+                relocate_response_sent, relocated, 2 * selected * sizeof(struct sixp_pkt_cell));
+      }
+      return;
+
+    case SIXP_PKT_CMD_COUNT: {
+      uint16_t total;
+      get_cells(peer, LINK_OPTIONS_RESPONDER, 0, NULL, 0, &total);
+      body[0] = total & 0xff;
+      body[1] = total >> 8;
+      respond(SIXP_PKT_RC_SUCCESS, body, 2, peer, NULL, NULL, 0);
+      return;
+    }
+
+    case SIXP_PKT_CMD_LIST: {
+      uint16_t offset;
+      uint16_t max_num_cells;
+      uint16_t total;
+      if(pkt->body_len < SIXP_PKT_LIST_REQ_LEN) {
+        break;
+      }
+      offset = pkt->body[4] | (pkt->body[5] << 8);
+      max_num_cells = pkt->body[6] | (pkt->body[7] << 8);
+      len = get_cells(peer, LINK_OPTIONS_RESPONDER, offset, list,
+                      MIN(max_num_cells, SIXTOP_MAX_CELLS), &total);
+      body_len = sixp_pkt_create_cell_list(body, sizeof(body), list, len);
+      /* EOL: no cell left after this response */
+      respond(offset + len >= total ? SIXP_PKT_RC_EOL : SIXP_PKT_RC_SUCCESS,
+              body, body_len, peer, NULL, NULL, 0);
+      return;
+    }
+
+    default:
+      /* SIGNAL is not supported */
+      break;
+  }
+
+  respond(SIXP_PKT_RC_ERR, NULL, 0, peer, NULL, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(const struct sixp_pkt *pkt, uint8_t cmd, const linkaddr_t *peer)
+{
+  if(pkt->type == SIXP_PKT_TYPE_REQUEST) {
+    handle_request(pkt, peer);
+  } else if(pkt->type == SIXP_PKT_TYPE_RESPONSE) {
+    handle_response(pkt, cmd, peer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+timeout(uint8_t cmd, const linkaddr_t *peer)
+{
+  /* A CLEAR that timed out is still pending, and will be retried */
+  if(cmd != SIXP_PKT_CMD_CLEAR) {
+    reset_peer(peer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Follows the time source, and adapts the number of Tx cells to it */
+static void
+sample(void *ptr)
+{
+  struct tsch_neighbor *n = tsch_queue_get_time_source();
+  int backlog;
+
+  ctimer_reset(&sample_timer);
+
+  if(n == NULL || !linkaddr_cmp(&n->addr, &parent)) {
+    if(has_parent) {
+      /* Give our cells back to the former time source */
+      reset_peer(&parent);
+      has_parent = 0;
+    }
+    if(n != NULL) {
+      linkaddr_copy(&parent, &n->addr);
+      has_parent = 1;
+    }
+    max_backlog = 0;
+    sample_count = 0;
+    return;
+  }
+
+  backlog = tsch_queue_packet_count(&parent);
+  if(backlog > max_backlog) {
+    max_backlog = backlog;
+  }
+
+  if(++sample_count >= SF_QUEUE_ADAPT_INTERVAL / SF_QUEUE_SAMPLE_PERIOD) {
+    /* Wait for a pending CLEAR, which would remove the cells we add */
+    if(!sixp_is_busy(&parent) && pending_clear_lookup(&parent) == NULL) {
+      int num_cells = sf_queue_num_tx_cells(&parent);
+      if(max_backlog >= SF_QUEUE_HIGH_WATERMARK && num_cells < SF_QUEUE_MAX_CELLS) {
+        request_add();
+      } else if(max_backlog == 0 && num_cells > 0) {
+        request_delete();
+      }
+    }
+    max_backlog = 0;
+    sample_count = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  get_slotframe();
+  memb_init(&pending_clear_memb);
+  list_init(pending_clear_list);
+  has_parent = 0;
+  max_backlog = 0;
+  sample_count = 0;
+  ctimer_set(&sample_timer, SF_QUEUE_SAMPLE_PERIOD, sample, NULL);
+}
+/*---------------------------------------------------------------------------*/
+const struct sixtop_sf sf_queue = {
+  SF_QUEUE_SFID,
+  SF_QUEUE_TIMEOUT,
+  init,
+  input,
+  timeout,
+};
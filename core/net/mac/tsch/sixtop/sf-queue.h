@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         SF-queue: a minimal 6top scheduling function. Nodes negotiate
+ *         dedicated Tx cells to their time source depending on the backlog
+ *         of their queue, and answer the requests of their children.
+ */
+
+#ifndef __SF_QUEUE_H__
+#define __SF_QUEUE_H__
+
+#include "net/mac/tsch/sixtop/sixtop.h"
+
+/******** Configuration *******/
+
+/* Scheduling function identifier, from the experimental range */
+#ifdef SF_QUEUE_CONF_SFID
+#define SF_QUEUE_SFID SF_QUEUE_CONF_SFID
+#else
+#define SF_QUEUE_SFID 0xf0
+#endif
+
+/* Handle and length of the slotframe holding the negotiated cells */
+#ifdef SF_QUEUE_CONF_SLOTFRAME_HANDLE
+#define SF_QUEUE_SLOTFRAME_HANDLE SF_QUEUE_CONF_SLOTFRAME_HANDLE
+#else
+#define SF_QUEUE_SLOTFRAME_HANDLE 1
+#endif
+
+#ifdef SF_QUEUE_CONF_SLOTFRAME_LENGTH
+#define SF_QUEUE_SLOTFRAME_LENGTH SF_QUEUE_CONF_SLOTFRAME_LENGTH
+#else
+#define SF_QUEUE_SLOTFRAME_LENGTH TSCH_SCHEDULE_DEFAULT_LENGTH
+#endif
+
+/* Maximum number of Tx cells to our time source */
+#ifdef SF_QUEUE_CONF_MAX_CELLS
+#define SF_QUEUE_MAX_CELLS SF_QUEUE_CONF_MAX_CELLS
+#else
+#define SF_QUEUE_MAX_CELLS SIXTOP_MAX_CELLS
+#endif
+
+/* A cell is added when this many packets were queued for the time source
+ * during an adaptation interval, and removed when none was */
+#ifdef SF_QUEUE_CONF_HIGH_WATERMARK
+#define SF_QUEUE_HIGH_WATERMARK SF_QUEUE_CONF_HIGH_WATERMARK
+#else
+#define SF_QUEUE_HIGH_WATERMARK 2
+#endif
+
+/* Period at which the queue is sampled, and adaptation interval */
+#ifdef SF_QUEUE_CONF_SAMPLE_PERIOD
+#define SF_QUEUE_SAMPLE_PERIOD SF_QUEUE_CONF_SAMPLE_PERIOD
+#else
+#define SF_QUEUE_SAMPLE_PERIOD (CLOCK_SECOND / 2)
+#endif
+
+#ifdef SF_QUEUE_CONF_ADAPT_INTERVAL
+#define SF_QUEUE_ADAPT_INTERVAL SF_QUEUE_CONF_ADAPT_INTERVAL
+#else
+#define SF_QUEUE_ADAPT_INTERVAL (8 * CLOCK_SECOND)
+#endif
+
+/* 6P transaction timeout */
+#ifdef SF_QUEUE_CONF_TIMEOUT
+#define SF_QUEUE_TIMEOUT SF_QUEUE_CONF_TIMEOUT
+#else
+#define SF_QUEUE_TIMEOUT (10 * CLOCK_SECOND)
+#endif
+
+/* Number of peers a CLEAR can be pending with */
+#ifdef SF_QUEUE_CONF_MAX_PENDING_CLEARS
+#define SF_QUEUE_MAX_PENDING_CLEARS SF_QUEUE_CONF_MAX_PENDING_CLEARS
+#else
+#define SF_QUEUE_MAX_PENDING_CLEARS 2
+#endif
+
+/* A CLEAR is sent again every adaptation interval until the peer answers,
+ * at most this many times. The peer is then considered gone. */
+#ifdef SF_QUEUE_CONF_CLEAR_MAX_ATTEMPTS
+#define SF_QUEUE_CLEAR_MAX_ATTEMPTS SF_QUEUE_CONF_CLEAR_MAX_ATTEMPTS
+#else
+#define SF_QUEUE_CLEAR_MAX_ATTEMPTS 8
+#endif
+
+/********** Functions *********/
+
+/* Number of negotiated Tx cells to peer */
+int sf_queue_num_tx_cells(const linkaddr_t *peer);
+
+extern const struct sixtop_sf sf_queue;
+
+#endif /* __SF_QUEUE_H__ */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         6top Protocol (6P, RFC 8480) message creation and parsing.
+ *         Multi-byte fields are little endian, as in IEEE 802.15.4.
+ */
+
+#include <string.h>
+#include "contiki.h"
+#include "net/mac/tsch/sixtop/sixp-pkt.h"
+
+#define WRITE16(buf, val) \
+  do { ((uint8_t *)(buf))[0] = (val) & 0xff; \
+       ((uint8_t *)(buf))[1] = ((val) >> 8) & 0xff; } while(0)
+
+#define READ16(buf, var) \
+  (var) = ((uint8_t *)(buf))[0] | ((uint8_t *)(buf))[1] << 8
+
+/*---------------------------------------------------------------------------*/
+int
+sixp_pkt_create(uint8_t *buf, uint16_t buf_len, const struct sixp_pkt *pkt)
+{
+  if(pkt == NULL || buf_len < SIXP_PKT_HEADER_LEN + pkt->body_len) {
+    return -1;
+  }
+  /* b0-3: version, b4-5: type, b6-7: reserved */
+  buf[0] = (SIXP_PKT_VERSION & 0x0f) | ((pkt->type & 0x03) << 4);
+  buf[1] = pkt->code;
+  buf[2] = pkt->sfid;
+  buf[3] = pkt->seqnum;
+  if(pkt->body_len > 0) {
+    memcpy(buf + SIXP_PKT_HEADER_LEN, pkt->body, pkt->body_len);
+  }
+  return SIXP_PKT_HEADER_LEN + pkt->body_len;
+}
+/*---------------------------------------------------------------------------*/
+int
+sixp_pkt_parse(const uint8_t *buf, uint16_t len, struct sixp_pkt *pkt, uint8_t *version)
+{
+  if(buf == NULL || pkt == NULL || len < SIXP_PKT_HEADER_LEN) {
+    return -1;
+  }
+  if(version != NULL) {
+    *version = buf[0] & 0x0f;
+  }
+  pkt->type = (buf[0] >> 4) & 0x03;
+  if(pkt->type > SIXP_PKT_TYPE_CONFIRMATION) {
+    return -1;
+  }
+  pkt->code = buf[1];
+  pkt->sfid = buf[2];
+  pkt->seqnum = buf[3];
+  pkt->body = buf + SIXP_PKT_HEADER_LEN;
+  pkt->body_len = len - SIXP_PKT_HEADER_LEN;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+sixp_pkt_create_cell_list_req(uint8_t *buf, uint16_t buf_len,
+    uint8_t cell_options, uint8_t num_cells,
+    const struct sixp_pkt_cell *list, uint8_t list_len)
+{
+  int ret;
+  if(buf_len < SIXP_PKT_CELL_LIST_OFFSET) {
+    return -1;
+  }
+  /* Metadata: unused by our scheduling functions */
+  WRITE16(buf, 0);
+  buf[2] = cell_options;
+  buf[3] = num_cells;
+  ret = sixp_pkt_create_cell_list(buf + SIXP_PKT_CELL_LIST_OFFSET,
+                                   buf_len - SIXP_PKT_CELL_LIST_OFFSET, list, list_len);
+  return ret < 0 ? -1 : SIXP_PKT_CELL_LIST_OFFSET + ret;
+}
+/*---------------------------------------------------------------------------*/
+int
+sixp_pkt_create_cell_list(uint8_t *buf, uint16_t buf_len,
+    const struct sixp_pkt_cell *list, uint8_t list_len)
+{
+  uint8_t i;
+  if(buf_len < list_len * SIXP_PKT_CELL_LEN) {
+    return -1;
+  }
+  for(i = 0; i < list_len; i++) {
+    WRITE16(buf + i * SIXP_PKT_CELL_LEN, list[i].timeslot);
+    WRITE16(buf + i * SIXP_PKT_CELL_LEN + 2, list[i].channel_offset);
+  }
+  return list_len * SIXP_PKT_CELL_LEN;
+}
+/*---------------------------------------------------------------------------*/
+int
+sixp_pkt_get_cell(const uint8_t *buf, uint16_t list_len,
+    uint8_t index, struct sixp_pkt_cell *cell)
+{
+  if((index + 1) * SIXP_PKT_CELL_LEN > list_len) {
+    return -1;
+  }
+  READ16(buf + index * SIXP_PKT_CELL_LEN, cell->timeslot);
+  READ16(buf + index * SIXP_PKT_CELL_LEN + 2, cell->channel_offset);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
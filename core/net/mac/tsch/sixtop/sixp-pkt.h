@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         6top Protocol (6P, RFC 8480) message format
+ */
+
+#ifndef __SIXP_PKT_H__
+#define __SIXP_PKT_H__
+
+#include "contiki.h"
+#include "net/mac/tsch/sixtop/sixtop-conf.h"
+
+/********** Constants *********/
+
+/* 6P version implemented */
+#define SIXP_PKT_VERSION            0
+
+/* Message types, c.f. RFC 8480 section 3.2.2 */
+enum sixp_pkt_type {
+  SIXP_PKT_TYPE_REQUEST = 0,
+  SIXP_PKT_TYPE_RESPONSE = 1,
+  SIXP_PKT_TYPE_CONFIRMATION = 2,
+};
+
+/* Command identifiers, c.f. RFC 8480 section 6.2.2 */
+enum sixp_pkt_cmd {
+  SIXP_PKT_CMD_ADD = 1,
+  SIXP_PKT_CMD_DELETE = 2,
+  SIXP_PKT_CMD_RELOCATE = 3,
+  SIXP_PKT_CMD_COUNT = 4,
+  SIXP_PKT_CMD_LIST = 5,
+  SIXP_PKT_CMD_SIGNAL = 6,
+  SIXP_PKT_CMD_CLEAR = 7,
+};
+
+/* Return codes, c.f. RFC 8480 section 6.2.4 */
+enum sixp_pkt_rc {
+  SIXP_PKT_RC_SUCCESS = 0,
+  SIXP_PKT_RC_EOL = 1,
+  SIXP_PKT_RC_ERR = 2,
+  SIXP_PKT_RC_RESET = 3,
+  SIXP_PKT_RC_ERR_VERSION = 4,
+  SIXP_PKT_RC_ERR_SFID = 5,
+  SIXP_PKT_RC_ERR_SEQNUM = 6,
+  SIXP_PKT_RC_ERR_CELLLIST = 7,
+  SIXP_PKT_RC_ERR_BUSY = 8,
+  SIXP_PKT_RC_ERR_LOCKED = 9,
+};
+
+/* CellOptions bitmap, c.f. RFC 8480 section 6.2.3. Always expressed from
+ * the point of view of the sender of the request. */
+#define SIXP_PKT_CELL_OPTION_TX     0x01
+#define SIXP_PKT_CELL_OPTION_RX     0x02
+#define SIXP_PKT_CELL_OPTION_SHARED 0x04
+
+/* Length of the 6P header: version/type, code, SFID, SeqNum */
+#define SIXP_PKT_HEADER_LEN         4
+/* Length of a cell in a CellList: slotOffset, channelOffset */
+#define SIXP_PKT_CELL_LEN           4
+/* Offset of the CellList in ADD, DELETE and RELOCATE request bodies,
+ * after Metadata (2), CellOptions (1) and NumCells (1) */
+#define SIXP_PKT_CELL_LIST_OFFSET   4
+/* Length of a COUNT request body: Metadata, CellOptions */
+#define SIXP_PKT_COUNT_REQ_LEN      3
+/* Length of a LIST request body: Metadata, CellOptions, Reserved, Offset, MaxNumCells */
+#define SIXP_PKT_LIST_REQ_LEN       8
+/* Length of a CLEAR request body: Metadata */
+#define SIXP_PKT_CLEAR_REQ_LEN      2
+
+/* Largest body we send: a RELOCATE request with full relocation and
+ * candidate lists */
+#define SIXP_PKT_MAX_BODY_LEN       (SIXP_PKT_CELL_LIST_OFFSET + 2 * SIXTOP_MAX_CELLS * SIXP_PKT_CELL_LEN)
+
+/************ Types ***********/
+
+/* A 6P message. body points to the message body, which is not copied */
+struct sixp_pkt {
+  enum sixp_pkt_type type;
+  uint8_t code; /* Command for requests, return code otherwise */
+  uint8_t sfid;
+  uint8_t seqnum;
+  const uint8_t *body;
+  uint16_t body_len;
+};
+
+struct sixp_pkt_cell {
+  uint16_t timeslot;
+  uint16_t channel_offset;
+};
+
+/********** Functions *********/
+
+/* Writes a 6P message to buf. Returns its length, -1 if buf is too short */
+int sixp_pkt_create(uint8_t *buf, uint16_t buf_len, const struct sixp_pkt *pkt);
+/* Parses a 6P message. Returns 0 if success, -1 if the message is malformed.
+ * Messages with another 6P version are parsed, the version is not checked. */
+int sixp_pkt_parse(const uint8_t *buf, uint16_t len, struct sixp_pkt *pkt, uint8_t *version);
+
+/* Writes the body of an ADD, DELETE or RELOCATE request: Metadata,
+ * CellOptions, NumCells and the cells of list (list_len cells, i.e.
+ * relocation and candidate lists, concatenated, for RELOCATE).
+ * Returns the body length, -1 if buf is too short */
+int sixp_pkt_create_cell_list_req(uint8_t *buf, uint16_t buf_len,
+    uint8_t cell_options, uint8_t num_cells,
+    const struct sixp_pkt_cell *list, uint8_t list_len);
+/* Writes a CellList, as used in responses. Returns its length, -1 if
+ * buf is too short */
+int sixp_pkt_create_cell_list(uint8_t *buf, uint16_t buf_len,
+    const struct sixp_pkt_cell *list, uint8_t list_len);
+/* Reads the cell at position index of the CellList starting at buf.
+ * Returns 0 if success, -1 if beyond list_len bytes */
+int sixp_pkt_get_cell(const uint8_t *buf, uint16_t list_len,
+    uint8_t index, struct sixp_pkt_cell *cell);
+
+#endif /* __SIXP_PKT_H__ */
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         6top Protocol (6P, RFC 8480): 2-step transactions and per-peer
+ *         sequence numbers.
+ */
+
+#include <string.h>
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "net/mac/mac.h"
+#include "net/packetbuf.h"
+#include "net/mac/tsch/sixtop/sixtop.h"
+#include "net/mac/tsch/sixtop/sixp.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+enum sixp_trans_state {
+  SIXP_TRANS_REQUEST_SENDING,  /* Our request is in the MAC queue */
+  SIXP_TRANS_REQUEST_SENT,     /* Our request was acknowledged, waiting for the response */
+  SIXP_TRANS_REQUEST_RECEIVED, /* Waiting for the SF to respond */
+  SIXP_TRANS_RESPONSE_SENDING, /* Our response is in the MAC queue */
+};
+
+/* An ongoing transaction. There is at most one per peer. */
+struct sixp_trans {
+  struct sixp_trans *next;
+  linkaddr_t peer;
+  const struct sixtop_sf *sf;
+  enum sixp_trans_state state;
+  /* Identifies the transaction in MAC callbacks, which may come late */
+  uint8_t id;
+  uint8_t cmd;
+  uint8_t seqnum;
+  struct ctimer timer;
+  sixp_sent_callback_t func;
+  uint16_t arg_len;
+  uint8_t arg[SIXP_MAX_ARG_LEN];
+};
+
+/* The sequence number of the next transaction with a peer */
+struct sixp_nbr {
+  struct sixp_nbr *next;
+  linkaddr_t addr;
+  uint8_t seqnum;
+};
+
+MEMB(trans_memb, struct sixp_trans, SIXTOP_MAX_TRANSACTIONS);
+LIST(trans_list);
+MEMB(nbr_memb, struct sixp_nbr, SIXTOP_MAX_NEIGHBORS);
+LIST(nbr_list);
+
+static uint8_t next_trans_id;
+
+/*---------------------------------------------------------------------------*/
+static struct sixp_trans *
+trans_lookup(const linkaddr_t *peer)
+{
+  struct sixp_trans *trans;
+  for(trans = list_head(trans_list); trans != NULL; trans = list_item_next(trans)) {
+    if(linkaddr_cmp(&trans->peer, peer)) {
+      return trans;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+trans_free(struct sixp_trans *trans)
+{
+  ctimer_stop(&trans->timer);
+  list_remove(trans_list, trans);
+  memb_free(&trans_memb, trans);
+}
+/*---------------------------------------------------------------------------*/
+static struct sixp_nbr *
+nbr_lookup(const linkaddr_t *addr)
+{
+  struct sixp_nbr *nbr;
+  for(nbr = list_head(nbr_list); nbr != NULL; nbr = list_item_next(nbr)) {
+    if(linkaddr_cmp(&nbr->addr, addr)) {
+      return nbr;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct sixp_nbr *
+nbr_get(const linkaddr_t *addr)
+{
+  struct sixp_nbr *nbr = nbr_lookup(addr);
+  if(nbr == NULL) {
+    nbr = memb_alloc(&nbr_memb);
+    if(nbr == NULL) {
+      /* Forget the oldest peer. If it comes back, the sequence number
+       * mismatch will lead it to clear our common schedule. */
+      nbr = list_chop(nbr_list);
+    }
+    linkaddr_copy(&nbr->addr, addr);
+    /* No record of this peer: as after a reset */
+    nbr->seqnum = 0;
+    list_push(nbr_list, nbr);
+  }
+  return nbr;
+}
+/*---------------------------------------------------------------------------*/
+/* Advance the sequence number after a transaction. 0 only follows a reset
+ * or a CLEAR, 0xff wraps to 1. */
+static void
+nbr_seqnum_update(const linkaddr_t *addr, uint8_t cmd)
+{
+  struct sixp_nbr *nbr = nbr_get(addr);
+  if(cmd == SIXP_PKT_CMD_CLEAR) {
+    nbr->seqnum = 0;
+  } else {
+    nbr->seqnum = nbr->seqnum == 0xff ? 1 : nbr->seqnum + 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_mac_sent(void *ptr, int status, int transmissions)
+{
+  static uint8_t arg[SIXP_MAX_ARG_LEN];
+  struct sixp_trans *trans;
+  sixp_sent_callback_t func;
+  uint16_t arg_len;
+  linkaddr_t peer;
+  int sixp_status = status == MAC_TX_OK ? SIXP_OUTPUT_STATUS_SUCCESS : SIXP_OUTPUT_STATUS_FAILURE;
+
+  for(trans = list_head(trans_list); trans != NULL; trans = list_item_next(trans)) {
+    if(trans->id == (uint8_t)(uintptr_t)ptr) {
+      break;
+    }
+  }
+  if(trans == NULL
+     || (trans->state != SIXP_TRANS_REQUEST_SENDING && trans->state != SIXP_TRANS_RESPONSE_SENDING)) {
+    /* The transaction is over already */
+    return;
+  }
+
+  PRINTF("6P: sent %s to %u, status %d\n",
+         trans->state == SIXP_TRANS_REQUEST_SENDING ? "request" : "response",
+         trans->peer.u8[LINKADDR_SIZE - 1], status);
+
+  func = trans->func;
+  arg_len = trans->arg_len;
+  memcpy(arg, trans->arg, arg_len);
+  linkaddr_copy(&peer, &trans->peer);
+
+  if(trans->state == SIXP_TRANS_REQUEST_SENDING) {
+    if(sixp_status == SIXP_OUTPUT_STATUS_SUCCESS) {
+      /* Now wait for the response */
+      trans->state = SIXP_TRANS_REQUEST_SENT;
+    } else {
+      /* The peer never got the request: the transaction did not happen */
+      trans_free(trans);
+    }
+  } else {
+    /* Our response ends the transaction */
+    nbr_seqnum_update(&peer, trans->cmd);
+    trans_free(trans);
+  }
+
+  if(func != NULL) {
+    func(&peer, sixp_status, arg, arg_len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_timeout(void *ptr)
+{
+  struct sixp_trans *trans = ptr;
+  const struct sixtop_sf *sf = trans->sf;
+  uint8_t cmd = trans->cmd;
+  int is_initiator = trans->state == SIXP_TRANS_REQUEST_SENDING
+    || trans->state == SIXP_TRANS_REQUEST_SENT;
+  linkaddr_t peer;
+
+  PRINTF("6P: transaction with %u timed out\n", trans->peer.u8[LINKADDR_SIZE - 1]);
+
+  linkaddr_copy(&peer, &trans->peer);
+  trans_free(trans);
+  if(is_initiator && sf->timeout_handler != NULL) {
+    sf->timeout_handler(cmd, &peer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+send_pkt(struct sixp_trans *trans, enum sixp_pkt_type type, uint8_t code,
+         uint8_t sfid, uint8_t seqnum, const uint8_t *body, uint16_t body_len,
+         const linkaddr_t *peer)
+{
+  static uint8_t buf[SIXP_PKT_HEADER_LEN + SIXP_PKT_MAX_BODY_LEN];
+  struct sixp_pkt pkt;
+  int len;
+
+  pkt.type = type;
+  pkt.code = code;
+  pkt.sfid = sfid;
+  pkt.seqnum = seqnum;
+  pkt.body = body;
+  pkt.body_len = body_len;
+  if((len = sixp_pkt_create(buf, sizeof(buf), &pkt)) < 0) {
+    return -1;
+  }
+  return sixtop_output(peer, buf, len, trans != NULL ? handle_mac_sent : NULL,
+                       trans != NULL ? (void *)(uintptr_t)trans->id : NULL);
+}
+/*---------------------------------------------------------------------------*/
+int
+sixp_output(enum sixp_pkt_type type, uint8_t code, uint8_t sfid,
+            const uint8_t *body, uint16_t body_len, const linkaddr_t *peer,
+            sixp_sent_callback_t func, const void *arg, uint16_t arg_len)
+{
+  struct sixp_trans *trans;
+  const struct sixtop_sf *sf;
+
+  if(peer == NULL || arg_len > SIXP_MAX_ARG_LEN || body_len > SIXP_PKT_MAX_BODY_LEN) {
+    return -1;
+  }
+
+  trans = trans_lookup(peer);
+  if(type == SIXP_PKT_TYPE_REQUEST) {
+    if(trans != NULL) {
+      PRINTF("6P:! transaction with %u ongoing\n", peer->u8[LINKADDR_SIZE - 1]);
+      return -1;
+    }
+    if((sf = sixtop_find_sf(sfid)) == NULL
+       || (trans = memb_alloc(&trans_memb)) == NULL) {
+      return -1;
+    }
+    linkaddr_copy(&trans->peer, peer);
+    trans->sf = sf;
+    trans->state = SIXP_TRANS_REQUEST_SENDING;
+    trans->id = next_trans_id++;
+    trans->cmd = code;
+    trans->seqnum = nbr_get(peer)->seqnum;
+    list_add(trans_list, trans);
+    ctimer_set(&trans->timer, sf->timeout, handle_timeout, trans);
+  } else if(type == SIXP_PKT_TYPE_RESPONSE) {
+    if(trans == NULL || trans->state != SIXP_TRANS_REQUEST_RECEIVED
+       || trans->sf->sfid != sfid) {
+      PRINTF("6P:! no request from %u to respond to\n", peer->u8[LINKADDR_SIZE - 1]);
+      return -1;
+    }
+    trans->state = SIXP_TRANS_RESPONSE_SENDING;
+  } else {
+    return -1;
+  }
+
+  trans->func = func;
+  trans->arg_len = arg_len;
+  if(arg_len > 0) {
+    memcpy(trans->arg, arg, arg_len);
+  }
+
+  PRINTF("6P: send %s %u to %u, seqnum %u\n",
+         type == SIXP_PKT_TYPE_REQUEST ? "request" : "response",
+         code, peer->u8[LINKADDR_SIZE - 1], trans->seqnum);
+
+  if(send_pkt(trans, type, code, sfid, trans->seqnum, body, body_len, peer) < 0) {
+    trans_free(trans);
+    return -1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_request(const struct sixp_pkt *pkt, uint8_t version, const linkaddr_t *src)
+{
+  const struct sixtop_sf *sf;
+  struct sixp_trans *trans;
+  uint8_t rc;
+
+  trans = trans_lookup(src);
+  if(trans != NULL && trans->seqnum == pkt->seqnum
+     && (trans->state == SIXP_TRANS_REQUEST_RECEIVED || trans->state == SIXP_TRANS_RESPONSE_SENDING)) {
+    /* Retransmission of a request we are processing */
+    return;
+  }
+
+  if(version != SIXP_PKT_VERSION) {
+    rc = SIXP_PKT_RC_ERR_VERSION;
+  } else if((sf = sixtop_find_sf(pkt->sfid)) == NULL) {
+    rc = SIXP_PKT_RC_ERR_SFID;
+  } else if(trans != NULL) {
+    /* One transaction at a time with a given peer */
+    rc = SIXP_PKT_RC_ERR_BUSY;
+  } else if(pkt->code != SIXP_PKT_CMD_CLEAR && pkt->seqnum != nbr_get(src)->seqnum) {
+    /* Inconsistent state, e.g. one of us rebooted. CLEAR works regardless. */
+    rc = SIXP_PKT_RC_ERR_SEQNUM;
+  } else if((trans = memb_alloc(&trans_memb)) == NULL) {
+    rc = SIXP_PKT_RC_ERR_BUSY;
+  } else {
+    linkaddr_copy(&trans->peer, src);
+    trans->sf = sf;
+    trans->state = SIXP_TRANS_REQUEST_RECEIVED;
+    trans->id = next_trans_id++;
+    trans->cmd = pkt->code;
+    trans->seqnum = pkt->seqnum;
+    trans->func = NULL;
+    trans->arg_len = 0;
+    list_add(trans_list, trans);
+    ctimer_set(&trans->timer, sf->timeout, handle_timeout, trans);
+    /* The SF responds with sixp_output */
+    sf->input(pkt, pkt->code, src);
+    return;
+  }
+
+  PRINTF("6P: reject request %u from %u, rc %u\n", pkt->code, src->u8[LINKADDR_SIZE - 1], rc);
+  send_pkt(NULL, SIXP_PKT_TYPE_RESPONSE, rc, pkt->sfid, pkt->seqnum, NULL, 0, src);
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_response(const struct sixp_pkt *pkt, const linkaddr_t *src)
+{
+  const struct sixtop_sf *sf;
+  struct sixp_trans *trans;
+  uint8_t cmd;
+
+  trans = trans_lookup(src);
+  /* The response may be processed before the MAC callback of our request */
+  if(trans == NULL || trans->seqnum != pkt->seqnum
+     || (trans->state != SIXP_TRANS_REQUEST_SENT && trans->state != SIXP_TRANS_REQUEST_SENDING)) {
+    PRINTF("6P:! unexpected response from %u\n", src->u8[LINKADDR_SIZE - 1]);
+    return;
+  }
+
+  sf = trans->sf;
+  cmd = trans->cmd;
+  trans_free(trans);
+  if(pkt->code != SIXP_PKT_RC_ERR_SEQNUM) {
+    nbr_seqnum_update(src, cmd);
+  }
+  sf->input(pkt, cmd, src);
+}
+/*---------------------------------------------------------------------------*/
+void
+sixp_input(const uint8_t *buf, uint16_t len, const linkaddr_t *src)
+{
+  struct sixp_pkt pkt;
+  uint8_t version;
+
+  if(sixp_pkt_parse(buf, len, &pkt, &version) < 0) {
+    PRINTF("6P:! malformed message from %u\n", src->u8[LINKADDR_SIZE - 1]);
+    return;
+  }
+
+  PRINTF("6P: received type %u code %u from %u, seqnum %u\n",
+         pkt.type, pkt.code, src->u8[LINKADDR_SIZE - 1], pkt.seqnum);
+
+  if(pkt.type == SIXP_PKT_TYPE_REQUEST) {
+    handle_request(&pkt, version, src);
+  } else if(pkt.type == SIXP_PKT_TYPE_RESPONSE && version == SIXP_PKT_VERSION) {
+    handle_response(&pkt, src);
+  }
+  /* Confirmations are not supported, as we never respond with candidates */
+}
+/*---------------------------------------------------------------------------*/
+int
+sixp_is_busy(const linkaddr_t *peer)
+{
+  return trans_lookup(peer) != NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+sixp_init(void)
+{
+  memb_init(&trans_memb);
+  list_init(trans_list);
+  memb_init(&nbr_memb);
+  list_init(nbr_list);
+}
+/*---------------------------------------------------------------------------*/
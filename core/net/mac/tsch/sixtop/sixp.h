@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         6top Protocol (6P, RFC 8480): 2-step transactions and per-peer
+ *         sequence numbers. The cells to negotiate are up to the
+ *         scheduling functions, see sixtop.h.
+ */
+
+#ifndef __SIXP_H__
+#define __SIXP_H__
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include "net/mac/tsch/sixtop/sixp-pkt.h"
+
+/********** Constants *********/
+
+/* Status passed to sixp_sent_callback_t */
+#define SIXP_OUTPUT_STATUS_SUCCESS  0
+#define SIXP_OUTPUT_STATUS_FAILURE  1
+
+/* Maximum length of the argument of sixp_sent_callback_t */
+#define SIXP_MAX_ARG_LEN  (2 * SIXTOP_MAX_CELLS * sizeof(struct sixp_pkt_cell))
+
+/************ Types ***********/
+
+/* Called once a request or response was sent (status SUCCESS: acknowledged
+ * by the peer). arg is a copy of the argument given to sixp_output */
+typedef void (* sixp_sent_callback_t)(const linkaddr_t *peer, int status,
+                                      const void *arg, uint16_t arg_len);
+
+/********** Functions *********/
+
+/* Sends a 6P request, opening a transaction with peer, or the response to
+ * the request received from peer. Confirmations (3-step transactions) are
+ * not supported. For requests, func is called unless the response comes
+ * first. Returns 0 if success, -1 if failure, e.g. if a transaction with
+ * peer is already ongoing. */
+int sixp_output(enum sixp_pkt_type type, uint8_t code, uint8_t sfid,
+                const uint8_t *body, uint16_t body_len, const linkaddr_t *peer,
+                sixp_sent_callback_t func, const void *arg, uint16_t arg_len);
+/* Processes a received 6P message, called by the 6top sublayer */
+void sixp_input(const uint8_t *buf, uint16_t len, const linkaddr_t *src);
+/* Is a transaction ongoing with peer? */
+int sixp_is_busy(const linkaddr_t *peer);
+/* Initializes 6P, called by the 6top sublayer */
+void sixp_init(void);
+
+#endif /* __SIXP_H__ */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         6top sublayer configuration
+ */
+
+#ifndef __SIXTOP_CONF_H__
+#define __SIXTOP_CONF_H__
+
+#include "net/nbr-table.h"
+
+/* Maximum number of scheduling functions that can be registered */
+#ifdef SIXTOP_CONF_MAX_SCHEDULING_FUNCTIONS
+#define SIXTOP_MAX_SCHEDULING_FUNCTIONS SIXTOP_CONF_MAX_SCHEDULING_FUNCTIONS
+#else
+#define SIXTOP_MAX_SCHEDULING_FUNCTIONS 1
+#endif
+
+/* Maximum number of concurrent 6P transactions (at most one per peer) */
+#ifdef SIXTOP_CONF_MAX_TRANSACTIONS
+#define SIXTOP_MAX_TRANSACTIONS SIXTOP_CONF_MAX_TRANSACTIONS
+#else
+#define SIXTOP_MAX_TRANSACTIONS 2
+#endif
+
+/* Maximum number of peers we keep a 6P sequence number for */
+#ifdef SIXTOP_CONF_MAX_NEIGHBORS
+#define SIXTOP_MAX_NEIGHBORS SIXTOP_CONF_MAX_NEIGHBORS
+#else
+#define SIXTOP_MAX_NEIGHBORS NBR_TABLE_MAX_NEIGHBORS
+#endif
+
+/* Maximum number of cells in a CellList, for both requests and responses.
+ * Bounds the size of 6P messages and of the state kept per transaction. */
+#ifdef SIXTOP_CONF_MAX_CELLS
+#define SIXTOP_MAX_CELLS SIXTOP_CONF_MAX_CELLS
+#else
+#define SIXTOP_MAX_CELLS 4
+#endif
+
+#endif /* __SIXTOP_CONF_H__ */
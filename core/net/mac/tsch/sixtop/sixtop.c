@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         6top sublayer: carries 6P messages in IEEE 802.15.4 IETF IEs and
+ *         dispatches them to the registered scheduling functions (SF).
+ */
+
+#include <string.h>
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/mac/frame802154.h"
+#include "net/mac/frame802154e-ie.h"
+#include "net/mac/tsch/sixtop/sixtop.h"
+#include "net/mac/tsch/sixtop/sixp.h"
+
+#define DEBUG DEBUG_NONE
+#include "net/ip/uip-debug.h"
+
+/* Header IE list termination (2), IETF payload IE descriptor (2), sub-IE ID (1) */
+#define SIXTOP_IE_OVERHEAD 5
+
+static const struct sixtop_sf *sf_list[SIXTOP_MAX_SCHEDULING_FUNCTIONS];
+
+/*---------------------------------------------------------------------------*/
+int
+sixtop_add_sf(const struct sixtop_sf *sf)
+{
+  int i;
+  if(sf == NULL || sixtop_find_sf(sf->sfid) != NULL) {
+    return -1;
+  }
+  for(i = 0; i < SIXTOP_MAX_SCHEDULING_FUNCTIONS; i++) {
+    if(sf_list[i] == NULL) {
+      sf_list[i] = sf;
+      if(sf->init != NULL) {
+        sf->init();
+      }
+      PRINTF("6top: added SF %u\n", sf->sfid);
+      return 0;
+    }
+  }
+  PRINTF("6top:! no room for SF %u\n", sf->sfid);
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+const struct sixtop_sf *
+sixtop_find_sf(uint8_t sfid)
+{
+  int i;
+  for(i = 0; i < SIXTOP_MAX_SCHEDULING_FUNCTIONS; i++) {
+    if(sf_list[i] != NULL && sf_list[i]->sfid == sfid) {
+      return sf_list[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+sixtop_output(const linkaddr_t *dest_addr, const uint8_t *msg, uint16_t msg_len,
+              mac_callback_t callback, void *ptr)
+{
+  struct ieee802154_ies ies;
+  uint8_t *buf;
+
+  if(dest_addr == NULL || msg_len + SIXTOP_IE_OVERHEAD > PACKETBUF_SIZE) {
+    return -1;
+  }
+
+  packetbuf_clear();
+  buf = packetbuf_dataptr();
+  memset(&ies, 0, sizeof(ies));
+  ies.ie_sixtop_content_len = msg_len;
+  /* No header IE: terminate the header IE list right away */
+  frame80215e_create_ie_header_list_termination_1(buf, 2, &ies);
+  frame80215e_create_ie_ietf_6top(buf + 2, 3, &ies);
+  memcpy(buf + SIXTOP_IE_OVERHEAD, msg, msg_len);
+  packetbuf_set_datalen(SIXTOP_IE_OVERHEAD + msg_len);
+
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest_addr);
+  /* Tell the framer to announce IEs in the frame control field */
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_METADATA, 1);
+
+  NETSTACK_LLSEC.send(callback, ptr);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+sixtop_input(void)
+{
+  frame802154_t frame;
+  struct ieee802154_ies ies;
+  linkaddr_t src;
+
+  /* The MAC header was already parsed, but we need its IE list flag */
+  if(frame802154_parse(packetbuf_hdrptr(), packetbuf_totlen(), &frame) == 0
+     || !frame.fcf.ie_list_present) {
+    return 0;
+  }
+
+  memset(&ies, 0, sizeof(ies));
+  if(frame802154e_parse_information_elements(packetbuf_dataptr(), packetbuf_datalen(), &ies) < 0
+     || ies.ie_sixtop_content == NULL) {
+    return 0;
+  }
+
+  /* The packetbuf is reused if the SF responds right away */
+  linkaddr_copy(&src, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  sixp_input(ies.ie_sixtop_content, ies.ie_sixtop_content_len, &src);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+sixtop_init(void)
+{
+  memset(sf_list, 0, sizeof(sf_list));
+  sixp_init();
+}
+/*---------------------------------------------------------------------------*/
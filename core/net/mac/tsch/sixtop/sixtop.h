@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         6top sublayer: carries 6P messages in IEEE 802.15.4 IETF IEs and
+ *         dispatches them to the registered scheduling functions (SF).
+ */
+
+#ifndef __SIXTOP_H__
+#define __SIXTOP_H__
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include "net/mac/mac.h"
+#include "net/mac/tsch/sixtop/sixtop-conf.h"
+#include "net/mac/tsch/sixtop/sixp-pkt.h"
+
+/************ Types ***********/
+
+/* A scheduling function. It decides on the cells to negotiate and
+ * answers the requests of its peers, through sixp_output() */
+struct sixtop_sf {
+  /* Scheduling function identifier, carried in every 6P message */
+  uint8_t sfid;
+  /* 6P transaction timeout */
+  clock_time_t timeout;
+  /* Called when the SF is registered */
+  void (* init)(void);
+  /* Called upon reception of a request, or of the response to one of our
+   * requests. cmd is the command of the request in both cases. */
+  void (* input)(const struct sixp_pkt *pkt, uint8_t cmd, const linkaddr_t *peer);
+  /* Called when one of our requests got no response within timeout */
+  void (* timeout_handler)(uint8_t cmd, const linkaddr_t *peer);
+};
+
+/********** Functions *********/
+
+/* Registers a scheduling function. Returns 0 if success, -1 if failure */
+int sixtop_add_sf(const struct sixtop_sf *sf);
+/* Looks up a scheduling function from its SFID */
+const struct sixtop_sf *sixtop_find_sf(uint8_t sfid);
+/* Sends a 6P message to dest_addr, in an IETF IE. Returns 0 if the
+ * frame was passed to the MAC layer, -1 otherwise */
+int sixtop_output(const linkaddr_t *dest_addr, const uint8_t *msg, uint16_t msg_len,
+                  mac_callback_t callback, void *ptr);
+/* Called by TSCH on data frame reception, after the MAC header was parsed.
+ * Returns 1 if the frame carried a 6P message and was consumed. */
+int sixtop_input(void);
+/* Initializes the 6top sublayer, called by TSCH at startup */
+void sixtop_init(void);
+
+#endif /* __SIXTOP_H__ */
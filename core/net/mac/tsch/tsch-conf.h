@@ -168,6 +168,14 @@
 #define TSCH_WITH_LINK_SELECTOR 0
 #endif /* TSCH_CONF_WITH_LINK_SELECTOR */
 
+/* Run the 6top sublayer, for scheduling functions to negotiate cells
+ * with their neighbors through 6P. Requires MODULES += core/net/mac/tsch/sixtop */
+#ifdef TSCH_CONF_WITH_SIXTOP
+#define TSCH_WITH_SIXTOP TSCH_CONF_WITH_SIXTOP
+#else /* TSCH_CONF_WITH_SIXTOP */
+#define TSCH_WITH_SIXTOP 0
+#endif /* TSCH_CONF_WITH_SIXTOP */
+
 /* Estimate the drift of the time-source neighbor and compensate for it? */
 #ifdef TSCH_CONF_ADAPTIVE_TIMESYNC
 #define TSCH_ADAPTIVE_TIMESYNC TSCH_CONF_ADAPTIVE_TIMESYNC
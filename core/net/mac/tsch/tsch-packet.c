@@ -278,6 +278,17 @@ tsch_packet_create_eb(uint8_t *buf, int buf_size, uint8_t seqno,
   }
 #endif /* TSCH_PACKET_EB_WITH_SLOTFRAME_AND_LINK */
 
+#ifdef TSCH_CALLBACK_EB_CREATE
+  /* Let upper layers piggyback information in a vendor-specific IE */
+  TSCH_CALLBACK_EB_CREATE(&ies);
+  if(ies.ie_vendor_len > 0) {
+    if((ret = frame80215e_create_ie_header_vendor_specific(buf + curr_len, buf_size - curr_len, &ies)) == -1) {
+      return -1;
+    }
+    curr_len += ret;
+  }
+#endif /* TSCH_CALLBACK_EB_CREATE */
+
   /* First add header-IE termination IE to stipulate that next come payload IEs */
   if((ret = frame80215e_create_ie_header_list_termination_1(buf + curr_len, buf_size - curr_len, &ies)) == -1) {
     return -1;
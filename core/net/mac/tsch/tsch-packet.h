@@ -84,6 +84,20 @@ by default, useful in case of duplicate seqno */
 /* Max TSCH packet lenght */
 #define TSCH_PACKET_MAX_LEN MIN(127,PACKETBUF_SIZE)
 
+/*********** Callbacks *********/
+
+/* Called by TSCH when creating an EB. Can fill in the vendor-specific
+ * IE fields of ies (ie_vendor_len and ie_vendor_data) */
+#ifdef TSCH_CALLBACK_EB_CREATE
+void TSCH_CALLBACK_EB_CREATE(struct ieee802154_ies *ies);
+#endif
+
+/* Called by TSCH upon reception of an EB from any neighbor, once
+ * associated */
+#ifdef TSCH_CALLBACK_EB_RECEIVED
+void TSCH_CALLBACK_EB_RECEIVED(const linkaddr_t *src, const struct ieee802154_ies *ies);
+#endif
+
 /********** Functions *********/
 
 /* Construct enhanced ACK packet and return ACK length */
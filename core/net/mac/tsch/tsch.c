@@ -46,6 +46,7 @@
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
 #include "net/mac/framer-802154.h"
+#include "net/link-stats.h"
 #include "net/mac/tsch/tsch.h"
 #include "net/mac/tsch/tsch-slot-operation.h"
 #include "net/mac/tsch/tsch-queue.h"
@@ -54,6 +55,9 @@
 #include "net/mac/tsch/tsch-packet.h"
 #include "net/mac/tsch/tsch-security.h"
 #include "lib/random.h"
+#if TSCH_WITH_SIXTOP
+#include "net/mac/tsch/sixtop/sixtop.h"
+#endif /* TSCH_WITH_SIXTOP */
 
 #if FRAME802154_VERSION < FRAME802154_IEEE802154E_2012
 #error TSCH: FRAME802154_VERSION must be at least FRAME802154_IEEE802154E_2012
@@ -229,6 +233,8 @@ tsch_reset(void)
 static void
 keepalive_packet_sent(void *ptr, int status, int transmissions)
 {
+  /* Keep-alives bypass the upper layers, account for them here */
+  link_stats_packet_sent(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), status, transmissions);
 #ifdef TSCH_LINK_NEIGHBOR_CALLBACK
   TSCH_LINK_NEIGHBOR_CALLBACK(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), status, transmissions);
 #endif
@@ -277,6 +283,10 @@ eb_input(struct input_packet *current_input)
                           &frame, &eb_ies, NULL, 1)) {
     /* PAN ID check and authentication done at rx time */
 
+#ifdef TSCH_CALLBACK_EB_RECEIVED
+    TSCH_CALLBACK_EB_RECEIVED((const linkaddr_t *)&frame.src_addr, &eb_ies);
+#endif
+
 #if TSCH_AUTOSELECT_TIME_SOURCE
     if(!tsch_is_coordinator) {
       /* Maintain EB received counter for every neighbor */
@@ -856,6 +866,9 @@ tsch_init(void)
   tsch_queue_init();
   tsch_schedule_init();
   tsch_log_init();
+#if TSCH_WITH_SIXTOP
+  sixtop_init();
+#endif /* TSCH_WITH_SIXTOP */
   ringbufindex_init(&input_ringbuf, TSCH_MAX_INCOMING_PACKETS);
   ringbufindex_init(&dequeued_ringbuf, TSCH_DEQUEUED_ARRAY_SIZE);
 
@@ -987,6 +1000,12 @@ packet_input(void)
       PRINTF("TSCH: received from %u with seqno %u\n",
              TSCH_LOG_ID_FROM_LINKADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER)),
              packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO));
+#if TSCH_WITH_SIXTOP
+      if(sixtop_input()) {
+        /* 6P message, consumed by the 6top sublayer */
+        return;
+      }
+#endif /* TSCH_WITH_SIXTOP */
       NETSTACK_LLSEC.input();
     }
   }
@@ -189,6 +189,14 @@ nbr_table_allocate(nbr_table_reason_t reason, void *data)
   if(key != NULL) {
     return key;
   } else {
+    /* A key that no table uses any more can be reused right away */
+    for(key = list_head(nbr_table_keys); key != NULL; key = list_item_next(key)) {
+      if(used_map[index_from_key(key)] == 0) {
+        list_remove(nbr_table_keys, key);
+        return key;
+      }
+    }
+
 #ifdef NBR_TABLE_FIND_REMOVABLE
     const linkaddr_t *lladdr;
     lladdr = NBR_TABLE_FIND_REMOVABLE(reason, data);
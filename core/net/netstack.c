@@ -38,6 +38,7 @@
  */
 
 #include "net/netstack.h"
+#include "net/link-stats.h"
 /*---------------------------------------------------------------------------*/
 void
 netstack_init(void)
@@ -47,5 +48,6 @@ netstack_init(void)
   NETSTACK_LLSEC.init();
   NETSTACK_MAC.init();
   NETSTACK_NETWORK.init();
+  link_stats_init();
 }
 /*---------------------------------------------------------------------------*/
@@ -241,6 +241,9 @@ enum {
   PACKETBUF_ATTR_TSCH_SLOTFRAME,
   PACKETBUF_ATTR_TSCH_TIMESLOT,
 #endif /* TSCH_WITH_LINK_SELECTOR */
+#if TSCH_WITH_SIXTOP
+  PACKETBUF_ATTR_MAC_METADATA,
+#endif /* TSCH_WITH_SIXTOP */
   
   /* Scope 1 attributes: used between two neighbors only. */
 #if PACKETBUF_WITH_PACKET_TYPE
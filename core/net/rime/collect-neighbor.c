@@ -51,6 +51,7 @@
 
 #include "net/rime/collect-neighbor.h"
 #include "net/rime/collect.h"
+#include "net/link-stats.h"
 
 #ifdef COLLECT_NEIGHBOR_CONF_MAX_COLLECT_NEIGHBORS
 #define MAX_COLLECT_NEIGHBORS COLLECT_NEIGHBOR_CONF_MAX_COLLECT_NEIGHBORS
@@ -58,6 +59,18 @@
 #define MAX_COLLECT_NEIGHBORS 8
 #endif /* COLLECT_NEIGHBOR_CONF_MAX_COLLECT_NEIGHBORS */
 
+/* Use the ETX of the shared link statistics when they are fresh. Off
+   by default: the MAC-level ETX counts link-layer retransmissions,
+   collect's own estimate counts its end-to-end ones, and a node that
+   enables this advertises rtmetrics its older neighbors would not
+   compute. Enable it network-wide, per project, until the collect
+   regression tests have been run with it on. */
+#ifdef COLLECT_NEIGHBOR_CONF_LINK_STATS
+#define COLLECT_NEIGHBOR_LINK_STATS COLLECT_NEIGHBOR_CONF_LINK_STATS
+#else /* COLLECT_NEIGHBOR_CONF_LINK_STATS */
+#define COLLECT_NEIGHBOR_LINK_STATS 0
+#endif /* COLLECT_NEIGHBOR_CONF_LINK_STATS */
+
 #define RTMETRIC_MAX COLLECT_MAX_DEPTH
 
 MEMB(collect_neighbors_mem, struct collect_neighbor, MAX_COLLECT_NEIGHBORS);
@@ -374,6 +387,23 @@ collect_neighbor_rx(struct collect_neighbor *n)
   n->age = 0;
 }
 /*---------------------------------------------------------------------------*/
+static uint16_t
+link_estimate(struct collect_neighbor *n)
+{
+#if COLLECT_NEIGHBOR_LINK_STATS
+  const struct link_stats *stats;
+
+  /* The MAC layer sees every transmission to the neighbor, not only
+     those of collect, so prefer its estimate when it is recent. */
+  stats = link_stats_from_lladdr(&n->addr);
+  if(link_stats_is_fresh(stats)) {
+    return (uint32_t)stats->etx * COLLECT_LINK_ESTIMATE_UNIT /
+      LINK_STATS_ETX_DIVISOR;
+  }
+#endif /* COLLECT_NEIGHBOR_LINK_STATS */
+  return collect_link_estimate(&n->le);
+}
+/*---------------------------------------------------------------------------*/
 uint16_t
 collect_neighbor_link_estimate(struct collect_neighbor *n)
 {
@@ -385,9 +415,9 @@ collect_neighbor_link_estimate(struct collect_neighbor *n)
            n->addr.u8[0], n->addr.u8[1],
            collect_link_estimate(&n->le),
            collect_link_estimate(&n->le) + CONGESTION_PENALTY);*/
-    return collect_link_estimate(&n->le) + CONGESTION_PENALTY;
+    return link_estimate(n) + CONGESTION_PENALTY;
   } else {
-    return collect_link_estimate(&n->le);
+    return link_estimate(n);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -397,7 +427,7 @@ collect_neighbor_rtmetric_link_estimate(struct collect_neighbor *n)
   if(n == NULL) {
     return 0;
   }
-  return n->rtmetric + collect_link_estimate(&n->le);
+  return n->rtmetric + link_estimate(n);
 }
 /*---------------------------------------------------------------------------*/
 uint16_t
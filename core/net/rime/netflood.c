@@ -43,6 +43,7 @@
  */
 
 #include "net/rime/netflood.h"
+#include "lib/dup-cache.h"
 
 #include <string.h>
 
@@ -62,6 +63,20 @@ struct netflood_hdr {
 #define PRINTF(...)
 #endif
 
+DUP_CACHE(seen, NETFLOOD_DUP_CACHE_BITS, 2, NETFLOOD_DUP_CACHE_LIFETIME);
+
+/*---------------------------------------------------------------------------*/
+static uint32_t
+packet_hash(struct netflood_conn *c, const linkaddr_t *originator,
+            uint16_t seqno)
+{
+  uint32_t hash;
+
+  hash = dup_cache_hash(DUP_CACHE_HASH_INIT, &c->c.c.c.channel.channelno,
+                        sizeof(c->c.c.c.channel.channelno));
+  hash = dup_cache_hash(hash, originator, sizeof(linkaddr_t));
+  return dup_cache_hash(hash, &seqno, sizeof(seqno));
+}
 /*---------------------------------------------------------------------------*/
 static int
 send(struct netflood_conn *c)
@@ -87,8 +102,8 @@ recv_from_ipolite(struct ipolite_conn *ipolite, const linkaddr_t *from)
 
   packetbuf_hdrreduce(sizeof(struct netflood_hdr));
   if(c->u->recv != NULL) {
-    if(!(linkaddr_cmp(&hdr.originator, &c->last_originator) &&
-	 hdr.originator_seqno <= c->last_originator_seqno)) {
+    if(!dup_cache_lookup(&seen, packet_hash(c, &hdr.originator,
+                                            hdr.originator_seqno))) {
 
       if(c->u->recv(c, from, &hdr.originator, hdr.originator_seqno,
 		    hops)) {
@@ -111,6 +126,8 @@ recv_from_ipolite(struct ipolite_conn *ipolite, const linkaddr_t *from)
 	    hdr.hops++;
 	    memcpy(packetbuf_dataptr(), &hdr, sizeof(struct netflood_hdr));
 	    send(c);
+	    dup_cache_add(&seen, packet_hash(c, &hdr.originator,
+	                                     hdr.originator_seqno));
 	    linkaddr_copy(&c->last_originator, &hdr.originator);
 	    c->last_originator_seqno = hdr.originator_seqno;
 	  }
@@ -167,6 +184,8 @@ netflood_send(struct netflood_conn *c, uint8_t seqno)
     linkaddr_copy(&c->last_originator, &hdr->originator);
     c->last_originator_seqno = hdr->originator_seqno = seqno;
     hdr->hops = 0;
+    dup_cache_add(&seen, packet_hash(c, &hdr->originator,
+                                     hdr->originator_seqno));
     PRINTF("%d.%d: netflood sending '%s'\n",
 	   linkaddr_node_addr.u8[0], linkaddr_node_addr.u8[1],
 	   (char *)packetbuf_dataptr());
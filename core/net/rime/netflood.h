@@ -54,16 +54,15 @@
  * primitive does not perform retransmissions of flooded packets and
  * packets are not tagged with version numbers.  Instead, the netflood
  * primitive sets the end-to-end sender and end-to-end packet ID
- * attributes on the packets it sends.  A forwarding node saves the
- * end-to-end sender and packet ID of the last packet it forwards and
- * does not forward a packet if it has the same end-to-end sender and
- * packet ID as the last packet.  This reduces the risk of routing
- * loops, but does not eliminate them entirely as the netflood
- * primitive saves the attributes of the latest packet seen only.
- * Therefore, the netflood primitive also uses the time to live
- * attribute, which is decreased by one before forwarding a packet.
- * If the time to live reaches zero, the primitive does not forward
- * the packet.
+ * attributes on the packets it sends.  A forwarding node remembers the
+ * end-to-end sender and packet ID of the packets it forwards in a
+ * duplicate cache (see lib/dup-cache.h) and does not forward a packet
+ * it finds there.  This works with many concurrent originators, but
+ * the cache forgets packets after a while and can report false
+ * positives.  Therefore, the netflood primitive also uses the time to
+ * live attribute, which is decreased by one before forwarding a
+ * packet.  If the time to live reaches zero, the primitive does not
+ * forward the packet.
  *
  * \section netflood-channels Channels
  *
@@ -77,6 +76,20 @@
 #include "net/queuebuf.h"
 #include "net/rime/ipolite.h"
 
+/* Bits per generation of the duplicate cache, shared by all connections */
+#ifdef NETFLOOD_CONF_DUP_CACHE_BITS
+#define NETFLOOD_DUP_CACHE_BITS NETFLOOD_CONF_DUP_CACHE_BITS
+#else
+#define NETFLOOD_DUP_CACHE_BITS 128
+#endif
+
+/* Forwarded packets are remembered for one to two of these */
+#ifdef NETFLOOD_CONF_DUP_CACHE_LIFETIME
+#define NETFLOOD_DUP_CACHE_LIFETIME NETFLOOD_CONF_DUP_CACHE_LIFETIME
+#else
+#define NETFLOOD_DUP_CACHE_LIFETIME (8 * CLOCK_SECOND)
+#endif
+
 struct netflood_conn;
 
 #define NETFLOOD_ATTRIBUTES   { PACKETBUF_ADDR_ESENDER, PACKETBUF_ADDRSIZE }, \
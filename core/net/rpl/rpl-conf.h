@@ -186,6 +186,19 @@
 #define RPL_DIO_REDUNDANCY          10
 #endif
 
+/*
+ * Adaptive DIO redundancy. When enabled, the redundancy constant used
+ * locally by the DIO Trickle timer is lowered as the number of RPL
+ * neighbors grows (see trickle_timer_set_density()), so that dense
+ * neighborhoods send fewer DIOs per interval. The DIO redundancy
+ * advertised in DIOs is not affected.
+ */
+#ifdef RPL_CONF_DIO_ADAPTIVE_REDUNDANCY
+#define RPL_DIO_ADAPTIVE_REDUNDANCY RPL_CONF_DIO_ADAPTIVE_REDUNDANCY
+#else
+#define RPL_DIO_ADAPTIVE_REDUNDANCY 0
+#endif
+
 /*
  * Initial metric attributed to a link when the ETX is unknown
  */
@@ -347,4 +360,16 @@
 #define RPL_DIS_START_DELAY             5
 #endif
 
+/*
+ * Carry the 6LoWPAN header compression contexts (RFC 6775 Context
+ * Options) in DIOs, so that contexts configured or learned at the root
+ * reach every node of the DODAG. Nodes only accept contexts from their
+ * preferred parent.
+ */
+#ifdef RPL_CONF_WITH_6CO
+#define RPL_WITH_6CO                    RPL_CONF_WITH_6CO
+#else
+#define RPL_WITH_6CO                    0
+#endif
+
 #endif /* RPL_CONF_H */
@@ -49,7 +49,9 @@
 #include "net/ipv6/uip-nd6.h"
 #include "net/ipv6/uip-ds6-nbr.h"
 #include "net/nbr-table.h"
+#include "net/link-stats.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/sicslowpan.h"
 #include "lib/list.h"
 #include "lib/memb.h"
 #include "sys/ctimer.h"
@@ -86,6 +88,9 @@ NBR_TABLE_GLOBAL(rpl_parent_t, rpl_parents);
 rpl_instance_t instance_table[RPL_MAX_INSTANCES];
 rpl_instance_t *default_instance;
 
+/* Set when a parent was flagged for rank recalculation. */
+static uint8_t parents_updated;
+
 /*---------------------------------------------------------------------------*/
 void
 rpl_print_neighbor_list(void)
@@ -99,16 +104,26 @@ rpl_print_neighbor_list(void)
 
     printf("RPL: rank %u dioint %u, %u nbr(s)\n", curr_rank, curr_dio_interval, uip_ds6_nbr_num());
     while(p != NULL) {
-      uip_ds6_nbr_t *nbr = rpl_get_nbr(p);
       printf("RPL: nbr %3u %5u, %5u => %5u %c%c (last tx %u min ago)\n",
           nbr_table_get_lladdr(rpl_parents, p)->u8[7],
-          p->rank, nbr ? nbr->link_metric : 0,
+          p->rank, rpl_get_parent_link_metric(p),
           default_instance->of->calculate_rank(p, 0),
           default_instance->current_dag == p->dag ? 'd' : ' ',
           p == default_instance->current_dag->preferred_parent ? '*' : ' ',
           (unsigned)((now - p->last_tx_time) / (60 * CLOCK_SECOND)));
       p = nbr_table_next(rpl_parents, p);
     }
+#if RPL_CONF_STATS
+    printf("RPL: %u parent evaluations, %u parent scans, %u path metric updates\n",
+        rpl_stats.parent_evaluations, rpl_stats.parent_scans,
+        rpl_stats.path_metric_updates);
+#endif /* RPL_CONF_STATS */
+#if TRICKLE_TIMER_STATS
+    printf("RPL: DIO k %u, %u sent, %u suppressed, %u resets\n",
+        default_instance->dio_timer.k, default_instance->dio_timer.tx,
+        default_instance->dio_timer.suppressed,
+        default_instance->dio_timer.resets);
+#endif /* TRICKLE_TIMER_STATS */
     printf("RPL: end of list\n");
   }
 }
@@ -156,16 +171,17 @@ rpl_get_parent_rank(uip_lladdr_t *addr)
 }
 /*---------------------------------------------------------------------------*/
 uint16_t
-rpl_get_parent_link_metric(const uip_lladdr_t *addr)
+rpl_get_parent_link_metric(rpl_parent_t *p)
 {
-  uip_ds6_nbr_t *nbr;
-  nbr = nbr_table_get_from_lladdr(ds6_neighbors, (const linkaddr_t *)addr);
+  const struct link_stats *stats;
 
-  if(nbr != NULL) {
-    return nbr->link_metric;
-  } else {
-    return 0;
+  stats = link_stats_from_lladdr(nbr_table_get_lladdr(rpl_parents, p));
+  if(stats != NULL && stats->etx != 0) {
+    return (uint32_t)stats->etx * RPL_DAG_MC_ETX_DIVISOR /
+      LINK_STATS_ETX_DIVISOR;
   }
+  /* No transmissions to this parent yet */
+  return RPL_INIT_LINK_METRIC * RPL_DAG_MC_ETX_DIVISOR;
 }
 /*---------------------------------------------------------------------------*/
 uip_ipaddr_t *
@@ -202,6 +218,13 @@ rpl_set_preferred_parent(rpl_dag_t *dag, rpl_parent_t *p)
     nbr_table_unlock(rpl_parents, dag->preferred_parent);
     nbr_table_lock(rpl_parents, p);
     dag->preferred_parent = p;
+
+    /* The objective function favors the preferred parent when comparing
+       parents, so the candidate order is only known to hold if the
+       best candidate is the new preferred parent. */
+    if(p != dag->best_candidate) {
+      dag->candidates_valid = 0;
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -347,8 +370,6 @@ rpl_set_root(uint8_t instance_id, uip_ipaddr_t *dag_id)
 
   instance->dio_intdoubl = RPL_DIO_INTERVAL_DOUBLINGS;
   instance->dio_intmin = RPL_DIO_INTERVAL_MIN;
-  /* The current interval must differ from the minimum interval in order to
-     trigger a DIO timer reset. */
   instance->dio_intcurrent = RPL_DIO_INTERVAL_MIN +
     RPL_DIO_INTERVAL_DOUBLINGS;
   instance->dio_redundancy = RPL_DIO_REDUNDANCY;
@@ -472,6 +493,13 @@ rpl_set_prefix(rpl_dag_t *dag, uip_ipaddr_t *prefix, unsigned len)
     PRINTF("rpl_set_prefix - prefix NON-NULL\n");
     check_prefix(&last_prefix, &dag->prefix_info);
   }
+#if RPL_WITH_6CO && SICSLOWPAN_CONTEXT_LEARNING
+  /* The root hands out a compression context for the DAG prefix. */
+  if(dag->instance != NULL && dag->rank == ROOT_RANK(dag->instance) &&
+     len <= 64) {
+    sicslowpan_context_learn(prefix);
+  }
+#endif /* RPL_WITH_6CO && SICSLOWPAN_CONTEXT_LEARNING */
   return 1;
 }
 /*---------------------------------------------------------------------------*/
@@ -589,9 +617,10 @@ rpl_free_instance(rpl_instance_t *instance)
 #if RPL_WITH_PROBING
   ctimer_stop(&instance->probing_timer);
 #endif /* RPL_WITH_PROBING */
-  ctimer_stop(&instance->dio_timer);
+  trickle_timer_stop(&instance->dio_timer);
   ctimer_stop(&instance->dao_timer);
   ctimer_stop(&instance->dao_lifetime_timer);
+  ctimer_stop(&instance->dao_forward_timer);
 
   if(default_instance == instance) {
     default_instance = NULL;
@@ -640,17 +669,13 @@ rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
     if(p == NULL) {
       PRINTF("RPL: rpl_add_parent p NULL\n");
     } else {
-      uip_ds6_nbr_t *nbr;
-      nbr = rpl_get_nbr(p);
-
       p->dag = dag;
       p->rank = dio->rank;
       p->dtsn = dio->dtsn;
-
-      /* Check whether we have a neighbor that has not gotten a link metric yet */
-      if(nbr != NULL && nbr->link_metric == 0) {
-	nbr->link_metric = RPL_INIT_LINK_METRIC * RPL_DAG_MC_ETX_DIVISOR;
-      }
+      RPL_PARENT_INVALIDATE_PATH_METRIC(p);
+#if RPL_WITH_DAO_ACK
+      p->link_metric_penalty = 0;
+#endif /* RPL_WITH_DAO_ACK */
 #if RPL_DAG_MC != RPL_DAG_MC_NONE
       memcpy(&p->mc, &dio->mc, sizeof(p->mc));
 #endif /* RPL_DAG_MC != RPL_DAG_MC_NONE */
@@ -713,7 +738,7 @@ rpl_select_dag(rpl_instance_t *instance, rpl_parent_t *p)
 
   best_dag = instance->current_dag;
   if(best_dag->rank != ROOT_RANK(instance)) {
-    if(rpl_select_parent(p->dag) != NULL) {
+    if(rpl_select_parent(p->dag, p) != NULL) {
       if(p->dag != best_dag) {
         best_dag = instance->of->best_dag(best_dag, p->dag);
       }
@@ -795,32 +820,121 @@ rpl_select_dag(rpl_instance_t *instance, rpl_parent_t *p)
   return best_dag;
 }
 /*---------------------------------------------------------------------------*/
+static int
+is_candidate(rpl_dag_t *dag, rpl_parent_t *p)
+{
+  return p->dag == dag && p->rank != INFINITE_RANK;
+}
+/*---------------------------------------------------------------------------*/
+/* Drop a parent that will not be compared against the candidates. */
+static void
+forget_candidate(rpl_dag_t *dag, rpl_parent_t *p)
+{
+  if(p == dag->best_candidate) {
+    dag->candidates_valid = 0;
+  } else if(p == dag->second_candidate) {
+    dag->candidates_valid &= ~RPL_DAG_CANDIDATE_SECOND_VALID;
+  }
+}
+/*---------------------------------------------------------------------------*/
 static rpl_parent_t *
-best_parent(rpl_dag_t *dag)
+compare_parents(rpl_dag_t *dag, rpl_parent_t *p1, rpl_parent_t *p2)
+{
+  RPL_STAT(rpl_stats.parent_evaluations++);
+  return dag->instance->of->best_parent(p1, p2);
+}
+/*---------------------------------------------------------------------------*/
+static void
+scan_candidates(rpl_dag_t *dag)
 {
-  rpl_parent_t *p, *best;
+  rpl_parent_t *p, *best, *second;
 
-  best = NULL;
+  RPL_STAT(rpl_stats.parent_scans++);
+
+  best = second = NULL;
 
   p = nbr_table_head(rpl_parents);
   while(p != NULL) {
-    if(p->dag != dag || p->rank == INFINITE_RANK) {
+    if(!is_candidate(dag, p)) {
       /* ignore this neighbor */
     } else if(best == NULL) {
       best = p;
-    } else {
-      best = dag->instance->of->best_parent(best, p);
+    } else if(compare_parents(dag, best, p) == p) {
+      second = best;
+      best = p;
+    } else if(second == NULL || compare_parents(dag, second, p) == p) {
+      second = p;
     }
     p = nbr_table_next(rpl_parents, p);
   }
 
+  dag->best_candidate = best;
+  dag->second_candidate = second;
+  dag->candidates_valid = RPL_DAG_CANDIDATE_BEST_VALID | RPL_DAG_CANDIDATE_SECOND_VALID;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the best parent of a DAG after the rank or the metrics of
+ * the parent "changed" were updated. Only the changed parent is compared
+ * against the cached best and second best candidates; the parent set is
+ * scanned when the cache is invalid, or when the best candidate got
+ * worse and the runner-up is unknown.
+ */
+static rpl_parent_t *
+best_parent(rpl_dag_t *dag, rpl_parent_t *changed)
+{
+  rpl_parent_t *best, *second;
+
+  if(changed == NULL || !(dag->candidates_valid & RPL_DAG_CANDIDATE_BEST_VALID)) {
+    scan_candidates(dag);
+    return dag->best_candidate;
+  }
+
+  best = dag->best_candidate;
+  second = dag->second_candidate;
+
+  if(changed == best) {
+    if(!(dag->candidates_valid & RPL_DAG_CANDIDATE_SECOND_VALID)) {
+      scan_candidates(dag);
+    } else if(!is_candidate(dag, changed) ||
+              (second != NULL && compare_parents(dag, changed, second) == second)) {
+      /* The runner-up takes over; who comes next is unknown. */
+      dag->best_candidate = second;
+      dag->candidates_valid &= ~RPL_DAG_CANDIDATE_SECOND_VALID;
+    }
+    return dag->best_candidate;
+  }
+
+  if(!is_candidate(dag, changed)) {
+    if(changed == second) {
+      dag->candidates_valid &= ~RPL_DAG_CANDIDATE_SECOND_VALID;
+    }
+    return best;
+  }
+
+  if(best == NULL || compare_parents(dag, best, changed) == changed) {
+    dag->second_candidate = best;
+    dag->best_candidate = changed;
+    dag->candidates_valid |= RPL_DAG_CANDIDATE_SECOND_VALID;
+    return changed;
+  }
+
+  if(dag->candidates_valid & RPL_DAG_CANDIDATE_SECOND_VALID) {
+    if(changed == second) {
+      /* It may have fallen behind another parent. */
+      dag->candidates_valid &= ~RPL_DAG_CANDIDATE_SECOND_VALID;
+    } else if(second == NULL || compare_parents(dag, second, changed) == changed) {
+      dag->second_candidate = changed;
+    }
+  }
+
   return best;
 }
 /*---------------------------------------------------------------------------*/
 rpl_parent_t *
-rpl_select_parent(rpl_dag_t *dag)
+rpl_select_parent(rpl_dag_t *dag, rpl_parent_t *changed)
 {
-  rpl_parent_t *best = best_parent(dag);
+  rpl_parent_t *best = best_parent(dag, changed);
 
   if(best != NULL) {
     rpl_set_preferred_parent(dag, best);
@@ -841,6 +955,12 @@ rpl_remove_parent(rpl_parent_t *parent)
 
   rpl_nullify_parent(parent);
 
+  if(parent->dag != NULL &&
+     (parent == parent->dag->best_candidate ||
+      parent == parent->dag->second_candidate)) {
+    parent->dag->candidates_valid = 0;
+  }
+
   nbr_table_remove(rpl_parents, parent);
 }
 /*---------------------------------------------------------------------------*/
@@ -896,6 +1016,8 @@ rpl_move_parent(rpl_dag_t *dag_src, rpl_dag_t *dag_dst, rpl_parent_t *parent)
   PRINT6ADDR(rpl_get_parent_ipaddr(parent));
   PRINTF("\n");
 
+  dag_src->candidates_valid = 0;
+  dag_dst->candidates_valid = 0;
   parent->dag = dag_dst;
 }
 /*---------------------------------------------------------------------------*/
@@ -1084,6 +1206,7 @@ rpl_add_dag(uip_ipaddr_t *from, rpl_dio_t *dio)
     }
   }
   p->rank = dio->rank;
+  RPL_PARENT_INVALIDATE_PATH_METRIC(p);
 
   /* Determine the objective function by using the
      objective code point of the DIO. */
@@ -1198,10 +1321,23 @@ rpl_local_repair(rpl_instance_t *instance)
 }
 /*---------------------------------------------------------------------------*/
 void
+rpl_schedule_parent_update(rpl_parent_t *parent)
+{
+  parent->flags |= RPL_PARENT_FLAG_UPDATED;
+  RPL_PARENT_INVALIDATE_PATH_METRIC(parent);
+  parents_updated = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
 rpl_recalculate_ranks(void)
 {
   rpl_parent_t *p;
 
+  if(!parents_updated) {
+    return;
+  }
+  parents_updated = 0;
+
   /*
    * We recalculate ranks when we receive feedback from the system rather
    * than RPL protocol messages. This periodical recalculation is called
@@ -1210,7 +1346,6 @@ rpl_recalculate_ranks(void)
   p = nbr_table_head(rpl_parents);
   while(p != NULL) {
     if(p->dag != NULL && p->dag->instance && (p->flags & RPL_PARENT_FLAG_UPDATED)) {
-      p->flags &= ~RPL_PARENT_FLAG_UPDATED;
       PRINTF("RPL: rpl_process_parent_event recalculate_ranks\n");
       if(!rpl_process_parent_event(p->dag->instance, p)) {
         PRINTF("RPL: A parent was dropped\n");
@@ -1232,12 +1367,17 @@ rpl_process_parent_event(rpl_instance_t *instance, rpl_parent_t *p)
 
   return_value = 1;
 
+  /* The parent is evaluated now; skip it in rpl_recalculate_ranks(). */
+  p->flags &= ~RPL_PARENT_FLAG_UPDATED;
+
   if(!acceptable_rank(p->dag, p->rank)) {
     /* The candidate parent is no longer valid: the rank increase resulting
        from the choice of it as a parent would be too high. */
     PRINTF("RPL: Unacceptable rank %u\n", (unsigned)p->rank);
     rpl_nullify_parent(p);
     if(p != instance->current_dag->preferred_parent) {
+      /* It is not reselected below, so it must not stay cached. */
+      forget_candidate(p->dag, p);
       return 0;
     } else {
       return_value = 0;
@@ -1385,7 +1525,7 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
 
   if(dag->rank == ROOT_RANK(instance)) {
     if(dio->rank != INFINITE_RANK) {
-      instance->dio_counter++;
+      trickle_timer_consistency(&instance->dio_timer);
     }
     return;
   }
@@ -1433,21 +1573,19 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
     if(p->rank == dio->rank) {
       PRINTF("RPL: Received consistent DIO\n");
       if(dag->joined) {
-        instance->dio_counter++;
+        trickle_timer_consistency(&instance->dio_timer);
       }
     }
   }
   p->rank = dio->rank;
-
-  /* Parent info has been updated, trigger rank recalculation */
-  p->flags |= RPL_PARENT_FLAG_UPDATED;
+  RPL_PARENT_INVALIDATE_PATH_METRIC(p);
 
   PRINTF("RPL: preferred DAG ");
   PRINT6ADDR(&instance->current_dag->dag_id);
   PRINTF(", rank %u, min_rank %u, ",
 	 instance->current_dag->rank, instance->current_dag->min_rank);
   PRINTF("parent rank %u, parent etx %u, link metric %u, instance etx %u\n",
-	 p->rank, -1/*p->mc.obj.etx*/, rpl_get_nbr(p)->link_metric, instance->mc.obj.etx);
+	 p->rank, -1/*p->mc.obj.etx*/, rpl_get_parent_link_metric(p), instance->mc.obj.etx);
 
   /* We have allocated a candidate parent; process the DIO further. */
 
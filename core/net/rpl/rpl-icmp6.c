@@ -53,6 +53,7 @@
 #include "net/rpl/rpl-private.h"
 #include "net/packetbuf.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/sicslowpan.h"
 #include "random.h"
 
 #include <limits.h>
@@ -72,13 +73,34 @@
 #define UIP_ICMP_BUF     ((struct uip_icmp_hdr *)&uip_buf[uip_l2_l3_hdr_len])
 #define UIP_ICMP_PAYLOAD ((unsigned char *)&uip_buf[uip_l2_l3_icmp_hdr_len])
 /*---------------------------------------------------------------------------*/
+/* Size of a target option plus its transit information option */
+#define RPL_DAO_TARGET_LEN(prefixlen) (4 + ((prefixlen) + 7) / CHAR_BIT + 6)
+
+/* State shared by the targets of the DAO being processed */
+struct dao_input_state {
+  rpl_instance_t *instance;
+  rpl_dag_t *dag;
+  uip_ipaddr_t *sender;
+  uint8_t sequence;
+  uint8_t learned_from;
+  uint8_t is_root;
+  uint8_t status;
+  uint8_t acked;
+  uint8_t forward;
+  uint8_t nbr_added;
+#if RPL_CONF_MULTICAST
+  uint8_t mcast;
+#endif
+};
+/*---------------------------------------------------------------------------*/
 static void dis_input(void);
 static void dio_input(void);
 static void dao_input(void);
 static void dao_ack_input(void);
 
-static void dao_output_target_seq(rpl_parent_t *parent, uip_ipaddr_t *prefix,
-				  uint8_t lifetime, uint8_t seq_no);
+static void dao_output_targets(rpl_parent_t *parent, uip_ipaddr_t *prefix,
+                               uint8_t lifetime, uint8_t seq_no,
+                               int with_forward);
 
 /* some debug callbacks useful when debugging RPL networks */
 #ifdef RPL_DEBUG_DIO_INPUT
@@ -90,6 +112,8 @@ void RPL_DEBUG_DAO_OUTPUT(rpl_parent_t *);
 #endif
 
 static uint8_t dao_sequence = RPL_LOLLIPOP_INIT;
+/* Path sequence of our own targets, incremented for each new DAO */
+static uint8_t path_sequence = RPL_LOLLIPOP_INIT;
 
 extern rpl_of_t RPL_OF;
 
@@ -103,36 +127,45 @@ UIP_ICMP6_HANDLER(dio_handler, ICMP6_RPL, RPL_CODE_DIO, dio_input);
 UIP_ICMP6_HANDLER(dao_handler, ICMP6_RPL, RPL_CODE_DAO, dao_input);
 UIP_ICMP6_HANDLER(dao_ack_handler, ICMP6_RPL, RPL_CODE_DAO_ACK, dao_ack_input);
 /*---------------------------------------------------------------------------*/
-
-#if RPL_WITH_DAO_ACK
-static uip_ds6_route_t *
-find_route_entry_by_dao_ack(uint8_t seq)
+/* Lollipop comparison of RFC 6550, section 7.2: is a newer than b? */
+static int
+lollipop_greater_than(uint8_t a, uint8_t b)
 {
-  uip_ds6_route_t *re;
-  re = uip_ds6_route_head();
-  while(re != NULL) {
-    if(re->state.dao_seqno_out == seq && RPL_ROUTE_IS_DAO_PENDING(re)) {
-      /* found it! */
-      return re;
-    }
-    re = uip_ds6_route_next(re);
+  if(a > RPL_LOLLIPOP_CIRCULAR_REGION && b <= RPL_LOLLIPOP_CIRCULAR_REGION) {
+    return (RPL_LOLLIPOP_MAX_VALUE + 1 + b - a) > RPL_LOLLIPOP_SEQUENCE_WINDOWS;
+  }
+  if(a <= RPL_LOLLIPOP_CIRCULAR_REGION && b > RPL_LOLLIPOP_CIRCULAR_REGION) {
+    return (RPL_LOLLIPOP_MAX_VALUE + 1 + a - b) <= RPL_LOLLIPOP_SEQUENCE_WINDOWS;
   }
-  return NULL;
+  if(a > RPL_LOLLIPOP_CIRCULAR_REGION) {
+    /* Both in the linear region. */
+    return a > b;
+  }
+  return (a > b && a - b <= RPL_LOLLIPOP_CIRCULAR_REGION / 2) ||
+         (a < b && b - a > RPL_LOLLIPOP_CIRCULAR_REGION / 2);
 }
-#endif /* RPL_WITH_DAO_ACK */
-
-/* prepare for forwarding of DAO */
+/*---------------------------------------------------------------------------*/
+/* Lifetime, in lifetime units, to advertise upwards for a DAO route */
 static uint8_t
-prepare_for_dao_fwd(uint8_t sequence, uip_ds6_route_t *rep)
+route_dao_lifetime(rpl_instance_t *instance, uip_ds6_route_t *rep)
 {
-  /* not pending - or pending but not a retransmission */
-  RPL_LOLLIPOP_INCREMENT(dao_sequence);
+  unsigned long units;
 
-  /* set DAO pending and sequence numbers */
-  rep->state.dao_seqno_in = sequence;
-  rep->state.dao_seqno_out = dao_sequence;
-  RPL_ROUTE_SET_DAO_PENDING(rep);
-  return dao_sequence;
+  if(RPL_ROUTE_IS_NOPATH_RECEIVED(rep)) {
+    return RPL_ZERO_LIFETIME;
+  }
+  if(instance->lifetime_unit == 0 ||
+     (instance->lifetime_unit == 0xffff && instance->default_lifetime == 0xff)) {
+    return instance->default_lifetime;
+  }
+
+  units = (rep->state.lifetime + instance->lifetime_unit - 1) /
+    instance->lifetime_unit;
+  if(units == 0) {
+    /* About to expire, but still valid. */
+    return 1;
+  }
+  return units < 0xff ? units : 0xfe;
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -206,6 +239,7 @@ rpl_icmp6_update_nbr_table(uip_ipaddr_t *from, nbr_table_reason_t reason, void *
        neighbor entry to reachable to avoid sending NS/NA, etc.  */
     stimer_set(&nbr->reachable, UIP_ND6_REACHABLE_TIME / 1000);
     nbr->state = NBR_REACHABLE;
+    uip_ds6_nbr_schedule(nbr);
 #endif /* UIP_ND6_SEND_NA */
   }
   return nbr;
@@ -293,6 +327,11 @@ dio_input(void)
   int i;
   int len;
   uip_ipaddr_t from;
+#if RPL_WITH_6CO
+  rpl_instance_t *instance;
+  rpl_dag_t *dag;
+  uint8_t from_parent;
+#endif /* RPL_WITH_6CO */
 
   memset(&dio, 0, sizeof(dio));
 
@@ -344,6 +383,19 @@ dio_input(void)
   PRINT6ADDR(&dio.dag_id);
   PRINTF(", %u)\n", dio.preference);
 
+#if RPL_WITH_6CO
+  /* Compression contexts are only taken from the preferred parent, so
+     that all nodes along a path agree on them. */
+  from_parent = 0;
+  instance = rpl_get_instance(dio.instance_id);
+  if(instance != NULL && instance->current_dag != NULL) {
+    dag = instance->current_dag;
+    from_parent = dag->preferred_parent != NULL &&
+      uip_ipaddr_cmp(&dag->dag_id, &dio.dag_id) &&
+      uip_ipaddr_cmp(rpl_get_parent_ipaddr(dag->preferred_parent), &from);
+  }
+#endif /* RPL_WITH_6CO */
+
   /* Check if there are any DIO suboptions. */
   for(; i < buffer_length; i += len) {
     subopt_type = buffer[i];
@@ -457,6 +509,18 @@ dio_input(void)
       PRINTF("RPL: Copying prefix information\n");
       memcpy(&dio.prefix_info.prefix, &buffer[i + 16], 16);
       break;
+#if RPL_WITH_6CO
+    case RPL_OPTION_6CO:
+      if(len < 8) {
+        PRINTF("RPL: Invalid 6LoWPAN context option, len = %d\n", len);
+        RPL_STAT(rpl_stats.malformed_msgs++);
+        goto discard;
+      }
+      if(from_parent) {
+        sicslowpan_context_read_6co(&buffer[i + 2], len - 2);
+      }
+      break;
+#endif /* RPL_WITH_6CO */
     default:
       PRINTF("RPL: Unsupported suboption type in DIO: %u\n",
 	(unsigned)subopt_type);
@@ -478,6 +542,9 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
 {
   unsigned char *buffer;
   int pos;
+#if RPL_WITH_6CO
+  int len;
+#endif /* RPL_WITH_6CO */
   rpl_dag_t *dag = instance->current_dag;
 #if !RPL_LEAF_ONLY
   uip_ipaddr_t addr;
@@ -599,6 +666,27 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
            dag->prefix_info.length);
   }
 
+#if RPL_WITH_6CO
+  {
+    uint8_t cid;
+
+    /* Announce our compression contexts for as long as they fit. */
+    for(cid = 0; cid <= SICSLOWPAN_6CO_CID_MASK; cid++) {
+      if(uip_l2_l3_icmp_hdr_len + pos + 2 + SICSLOWPAN_6CO_BODY_LEN >
+         UIP_BUFSIZE) {
+        PRINTF("RPL: No room for more contexts in DIO\n");
+        break;
+      }
+      len = sicslowpan_context_write_6co(&buffer[pos + 2], cid);
+      if(len > 0) {
+        buffer[pos++] = RPL_OPTION_6CO;
+        buffer[pos++] = len;
+        pos += len;
+      }
+    }
+  }
+#endif /* RPL_WITH_6CO */
+
 #if RPL_LEAF_ONLY
 #if (DEBUG) & DEBUG_PRINT
   if(uc_addr == NULL) {
@@ -628,34 +716,180 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
 }
 /*---------------------------------------------------------------------------*/
 static void
+dao_input_forward(struct dao_input_state *in, uip_ds6_route_t *rep)
+{
+  /* Targets are forwarded to our parent in the next aggregated DAO. */
+  if(in->dag->preferred_parent != NULL &&
+     rpl_get_parent_ipaddr(in->dag->preferred_parent) != NULL) {
+    rep->state.dao_seqno_in = in->sequence;
+    RPL_ROUTE_SET_DAO_FORWARD(rep);
+    in->forward = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_input_target(struct dao_input_state *in, uip_ipaddr_t *prefix,
+                 uint8_t prefixlen, uint8_t lifetime, uint8_t pathsequence)
+{
+  uip_ds6_route_t *rep;
+  uip_ipaddr_t *nexthop;
+  int installed;
+
+  PRINTF("RPL: DAO lifetime: %u, path sequence: %u, prefix length: %u prefix: ",
+         (unsigned)lifetime, (unsigned)pathsequence, (unsigned)prefixlen);
+  PRINT6ADDR(prefix);
+  PRINTF("\n");
+
+#if RPL_CONF_MULTICAST
+  if(uip_is_addr_mcast_global(prefix)) {
+    mcast_group = uip_mcast6_route_add(prefix);
+    if(mcast_group) {
+      mcast_group->dag = in->dag;
+      mcast_group->lifetime = RPL_LIFETIME(in->instance, lifetime);
+    }
+    /* Multicast groups are advertised upwards along with our own DAO. */
+    in->mcast = 1;
+    in->acked = 0;
+    return;
+  }
+#endif
+
+  nexthop = NULL;
+  rep = uip_ds6_route_lookup(prefix);
+  if(rep != NULL && rep->length != prefixlen) {
+    rep = NULL;
+  }
+  if(rep != NULL) {
+    nexthop = uip_ds6_route_nexthop(rep);
+    /* A target with an older path sequence via another next hop is
+       stale information from a path that is no longer used. */
+    if(nexthop != NULL && !uip_ipaddr_cmp(nexthop, in->sender) &&
+       lollipop_greater_than(rep->state.path_sequence, pathsequence)) {
+      PRINTF("RPL: Ignoring DAO target with old path sequence %u (%u)\n",
+             pathsequence, rep->state.path_sequence);
+      return;
+    }
+  }
+  installed = nexthop != NULL && uip_ipaddr_cmp(nexthop, in->sender) &&
+    !RPL_ROUTE_IS_NOPATH_RECEIVED(rep);
+
+  if(lifetime == RPL_ZERO_LIFETIME) {
+    PRINTF("RPL: No-Path DAO received\n");
+    /* No-Path DAO received; invoke the route purging routine. */
+    if(installed) {
+      PRINTF("RPL: Setting expiration timer for prefix ");
+      PRINT6ADDR(prefix);
+      PRINTF("\n");
+      RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
+      rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
+      rep->state.path_sequence = pathsequence;
+
+      /* We forward the No-Path target to our parent, if we have one. */
+      dao_input_forward(in, rep);
+    }
+    return;
+  }
+
+  PRINTF("RPL: Adding DAO route\n");
+
+  /* Update and add neighbor - if no room - fail. */
+  if(!in->nbr_added) {
+    if(rpl_icmp6_update_nbr_table(in->sender, NBR_TABLE_REASON_RPL_DAO,
+                                  in->instance) == NULL) {
+      PRINTF("RPL: Out of Memory, dropping DAO from ");
+      PRINT6ADDR(in->sender);
+      PRINTF(", ");
+      PRINTLLADDR((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER));
+      PRINTF("\n");
+      in->status = in->is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+        RPL_DAO_ACK_UNABLE_TO_ACCEPT;
+      return;
+    }
+    in->nbr_added = 1;
+  }
+
+  rep = rpl_add_route(in->dag, prefix, prefixlen, in->sender);
+  if(rep == NULL) {
+    RPL_STAT(rpl_stats.mem_overflows++);
+    PRINTF("RPL: Could not add a route after receiving a DAO\n");
+    in->status = in->is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
+      RPL_DAO_ACK_UNABLE_TO_ACCEPT;
+    return;
+  }
+
+  /* set lifetime and clear NOPATH bit */
+  rep->state.lifetime = RPL_LIFETIME(in->instance, lifetime);
+  RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
+  rep->state.path_sequence = pathsequence;
+
+  if(in->learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
+    /*
+     * An installed route that is not pending and has the same seq-no
+     * has already been acknowledged upstream, so this is a
+     * retransmission that we can ack right away without forwarding.
+     */
+    if(installed && !RPL_ROUTE_IS_DAO_PENDING(rep) &&
+       !RPL_ROUTE_IS_DAO_FORWARD(rep) &&
+       rep->state.dao_seqno_in == in->sequence) {
+      return;
+    }
+    in->acked = 0;
+    dao_input_forward(in, rep);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Process the target options in buffer[start..end), which all share
+   the same transit information. */
+static void
+dao_input_targets(struct dao_input_state *in, unsigned char *buffer,
+                  int start, int end, uint8_t lifetime, uint8_t pathsequence)
+{
+  uip_ipaddr_t prefix;
+  uint8_t prefixlen;
+  int i;
+  int len;
+
+  for(i = start; i < end; i += len) {
+    if(buffer[i] == RPL_OPTION_PAD1) {
+      len = 1;
+      continue;
+    }
+    len = 2 + buffer[i + 1];
+    if(buffer[i] != RPL_OPTION_TARGET) {
+      continue;
+    }
+    prefixlen = buffer[i + 3];
+    if(prefixlen > sizeof(prefix) * CHAR_BIT ||
+       4 + (prefixlen + 7) / CHAR_BIT > len) {
+      RPL_STAT(rpl_stats.malformed_msgs++);
+      continue;
+    }
+    memset(&prefix, 0, sizeof(prefix));
+    memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
+    dao_input_target(in, &prefix, prefixlen, lifetime, pathsequence);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
 dao_input(void)
 {
+  struct dao_input_state in;
   uip_ipaddr_t dao_sender_addr;
   rpl_dag_t *dag;
   rpl_instance_t *instance;
   unsigned char *buffer;
   uint16_t sequence;
   uint8_t instance_id;
-  uint8_t lifetime;
-  uint8_t prefixlen;
   uint8_t flags;
   uint8_t subopt_type;
-  /*
-  uint8_t pathcontrol;
-  uint8_t pathsequence;
-  */
-  uip_ipaddr_t prefix;
-  uip_ds6_route_t *rep;
   uint8_t buffer_length;
   int pos;
   int len;
   int i;
+  int target_pos;
   int learned_from;
   rpl_parent_t *parent;
-  uip_ds6_nbr_t *nbr;
-  int is_root;
 
-  prefixlen = 0;
   parent = NULL;
 
   uip_ipaddr_copy(&dao_sender_addr, &UIP_IP_BUF->srcipaddr);
@@ -673,15 +907,12 @@ dao_input(void)
     goto discard;
   }
 
-  lifetime = instance->default_lifetime;
-
   flags = buffer[pos++];
   /* reserved */
   pos++;
   sequence = buffer[pos++];
 
   dag = instance->current_dag;
-  is_root = (dag->rank == ROOT_RANK(instance));
 
   /* Is the DAG ID present? */
   if(flags & RPL_DAO_D_FLAG) {
@@ -711,7 +942,7 @@ dao_input(void)
       PRINTF("RPL: Loop detected when receiving a unicast DAO from a node with a lower rank! (%u < %u)\n",
           DAG_RANK(parent->rank, instance), DAG_RANK(dag->rank, instance));
       parent->rank = INFINITE_RANK;
-      parent->flags |= RPL_PARENT_FLAG_UPDATED;
+      rpl_schedule_parent_update(parent);
       goto discard;
     }
 
@@ -719,12 +950,27 @@ dao_input(void)
     if(parent != NULL && parent == dag->preferred_parent) {
       PRINTF("RPL: Loop detected when receiving a unicast DAO from our parent\n");
       parent->rank = INFINITE_RANK;
-      parent->flags |= RPL_PARENT_FLAG_UPDATED;
+      rpl_schedule_parent_update(parent);
       goto discard;
     }
   }
 
-  /* Check if there are any RPL options present. */
+  memset(&in, 0, sizeof(in));
+  in.instance = instance;
+  in.dag = dag;
+  in.sender = &dao_sender_addr;
+  in.sequence = sequence;
+  in.learned_from = learned_from;
+  in.is_root = dag->rank == ROOT_RANK(instance);
+  in.status = RPL_DAO_ACK_UNCONDITIONAL_ACCEPT;
+  in.acked = 1;
+
+  /*
+   * A DAO may carry several targets. A transit information option
+   * applies to the targets that precede it, back to the previous
+   * transit information option.
+   */
+  target_pos = -1;
   for(i = pos; i < buffer_length; i += len) {
     subopt_type = buffer[i];
     if(subopt_type == RPL_OPTION_PAD1) {
@@ -736,159 +982,43 @@ dao_input(void)
 
     switch(subopt_type) {
     case RPL_OPTION_TARGET:
-      /* Handle the target option. */
-      prefixlen = buffer[i + 3];
-      memset(&prefix, 0, sizeof(prefix));
-      memcpy(&prefix, buffer + i + 4, (prefixlen + 7) / CHAR_BIT);
+      if(target_pos < 0) {
+        target_pos = i;
+      }
       break;
     case RPL_OPTION_TRANSIT:
-      /* The path sequence and control are ignored. */
-      /*      pathcontrol = buffer[i + 3];
-              pathsequence = buffer[i + 4];*/
-      lifetime = buffer[i + 5];
-      /* The parent address is also ignored. */
+      /* The path control and the parent address are ignored. */
+      if(target_pos >= 0) {
+        dao_input_targets(&in, buffer, target_pos, i,
+                          buffer[i + 5], buffer[i + 4]);
+        target_pos = -1;
+      }
       break;
     }
   }
-
-  PRINTF("RPL: DAO lifetime: %u, prefix length: %u prefix: ",
-          (unsigned)lifetime, (unsigned)prefixlen);
-  PRINT6ADDR(&prefix);
-  PRINTF("\n");
+  if(target_pos >= 0) {
+    /* Targets without transit information get the default lifetime. */
+    dao_input_targets(&in, buffer, target_pos, buffer_length,
+                      instance->default_lifetime, 0);
+  }
 
 #if RPL_CONF_MULTICAST
-  if(uip_is_addr_mcast_global(&prefix)) {
-    mcast_group = uip_mcast6_route_add(&prefix);
-    if(mcast_group) {
-      mcast_group->dag = dag;
-      mcast_group->lifetime = RPL_LIFETIME(instance, lifetime);
-    }
-    goto fwd_dao;
+  if(in.mcast && dag->preferred_parent != NULL) {
+    rpl_schedule_dao(instance);
   }
 #endif
 
-  rep = uip_ds6_route_lookup(&prefix);
-
-  if(lifetime == RPL_ZERO_LIFETIME) {
-    PRINTF("RPL: No-Path DAO received\n");
-    /* No-Path DAO received; invoke the route purging routine. */
-    if(rep != NULL &&
-       !RPL_ROUTE_IS_NOPATH_RECEIVED(rep) &&
-       rep->length == prefixlen &&
-       uip_ds6_route_nexthop(rep) != NULL &&
-       uip_ipaddr_cmp(uip_ds6_route_nexthop(rep), &dao_sender_addr)) {
-      PRINTF("RPL: Setting expiration timer for prefix ");
-      PRINT6ADDR(&prefix);
-      PRINTF("\n");
-      RPL_ROUTE_SET_NOPATH_RECEIVED(rep);
-      rep->state.lifetime = RPL_NOPATH_REMOVAL_DELAY;
-
-      /* We forward the incoming No-Path DAO to our parent, if we have
-         one. */
-      if(dag->preferred_parent != NULL &&
-         rpl_get_parent_ipaddr(dag->preferred_parent) != NULL) {
-        uint8_t out_seq;
-        out_seq = prepare_for_dao_fwd(sequence, rep);
-
-        PRINTF("RPL: Forwarding No-path DAO to parent - out_seq:%d",
-	       out_seq);
-        PRINT6ADDR(rpl_get_parent_ipaddr(dag->preferred_parent));
-        PRINTF("\n");
-
-        buffer = UIP_ICMP_PAYLOAD;
-        buffer[3] = out_seq; /* add an outgoing seq no before fwd */
-        uip_icmp6_send(rpl_get_parent_ipaddr(dag->preferred_parent),
-                       ICMP6_RPL, RPL_CODE_DAO, buffer_length);
-      }
-    } 
-    /* independent if we remove or not - ACK the request */
-    if(flags & RPL_DAO_K_FLAG) {
-      /* indicate that we accepted the no-path DAO */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-                     RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
-    }
-    goto discard;
-  }
-
-  PRINTF("RPL: Adding DAO route\n");
-
-  /* Update and add neighbor - if no room - fail. */
-  if((nbr = rpl_icmp6_update_nbr_table(&dao_sender_addr, NBR_TABLE_REASON_RPL_DAO, instance)) == NULL) {
-    PRINTF("RPL: Out of Memory, dropping DAO from ");
-    PRINT6ADDR(&dao_sender_addr);
-    PRINTF(", ");
-    PRINTLLADDR((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER));
-    PRINTF("\n");
-    if(flags & RPL_DAO_K_FLAG) {
-      /* signal the failure to add the node */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-		     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-		     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
-    }
-    goto discard;
+  /* This may send the forwarded targets right away, which overwrites
+     the DAO in the buffer. */
+  if(in.forward) {
+    rpl_schedule_dao_forward(instance);
   }
 
-  rep = rpl_add_route(dag, &prefix, prefixlen, &dao_sender_addr);
-  if(rep == NULL) {
-    RPL_STAT(rpl_stats.mem_overflows++);
-    PRINTF("RPL: Could not add a route after receiving a DAO\n");
-    if(flags & RPL_DAO_K_FLAG) {
+  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO && (flags & RPL_DAO_K_FLAG)) {
+    if(in.status != RPL_DAO_ACK_UNCONDITIONAL_ACCEPT) {
       /* signal the failure to add the node */
-      dao_ack_output(instance, &dao_sender_addr, sequence,
-		     is_root ? RPL_DAO_ACK_UNABLE_TO_ADD_ROUTE_AT_ROOT :
-		     RPL_DAO_ACK_UNABLE_TO_ACCEPT);
-    }
-    goto discard;
-  }
-
-  /* set lifetime and clear NOPATH bit */
-  rep->state.lifetime = RPL_LIFETIME(instance, lifetime);
-  RPL_ROUTE_CLEAR_NOPATH_RECEIVED(rep);
-
-#if RPL_CONF_MULTICAST
-fwd_dao:
-#endif
-
-  if(learned_from == RPL_ROUTE_FROM_UNICAST_DAO) {
-    int should_ack = 0;
-
-    if(flags & RPL_DAO_K_FLAG) {
-      /*
-       * check if this route is already installed and we can ack now!
-       * not pending - and same seq-no means that we can ack.
-       * (e.g. the route is installed already so it will not take any
-       * more room that it already takes - so should be ok!)
-       */
-      if((!RPL_ROUTE_IS_DAO_PENDING(rep) &&
-          rep->state.dao_seqno_in == sequence) ||
-          dag->rank == ROOT_RANK(instance)) {
-        should_ack = 1;
-      }
-    }
-
-    if(dag->preferred_parent != NULL &&
-       rpl_get_parent_ipaddr(dag->preferred_parent) != NULL) {
-      uint8_t out_seq = 0;
-      /* if this is pending and we get the same seq no it is a retrans */
-      if(RPL_ROUTE_IS_DAO_PENDING(rep) &&
-         rep->state.dao_seqno_in == sequence) {
-        /* keep the same seq-no as before for parent also */
-        out_seq = rep->state.dao_seqno_out;
-      } else {
-        out_seq = prepare_for_dao_fwd(sequence, rep);
-      }
-
-      PRINTF("RPL: Forwarding DAO to parent ");
-      PRINT6ADDR(rpl_get_parent_ipaddr(dag->preferred_parent));
-      PRINTF(" in seq: %d out seq: %d\n", sequence, out_seq);
-
-      buffer = UIP_ICMP_PAYLOAD;
-      buffer[3] = out_seq; /* add an outgoing seq no before fwd */
-      uip_icmp6_send(rpl_get_parent_ipaddr(dag->preferred_parent),
-                     ICMP6_RPL, RPL_CODE_DAO, buffer_length);
-    }
-
-    if(should_ack) {
+      dao_ack_output(instance, &dao_sender_addr, sequence, in.status);
+    } else if(in.acked || in.is_root) {
       PRINTF("RPL: Sending DAO ACK\n");
       dao_ack_output(instance, &dao_sender_addr, sequence,
                      RPL_DAO_ACK_UNCONDITIONAL_ACCEPT);
@@ -949,8 +1079,8 @@ handle_dao_retransmission(void *ptr)
 	     handle_dao_retransmission, parent);
 
   instance->my_dao_transmissions++;
-  dao_output_target_seq(parent, &prefix,
-			instance->default_lifetime, instance->my_dao_seqno);
+  dao_output_targets(parent, &prefix, instance->default_lifetime,
+                     instance->my_dao_seqno, 0);
 }
 #endif /* RPL_WITH_DAO_ACK */
 /*---------------------------------------------------------------------------*/
@@ -970,9 +1100,10 @@ dao_output(rpl_parent_t *parent, uint8_t lifetime)
   }
 
   RPL_LOLLIPOP_INCREMENT(dao_sequence);
+  RPL_LOLLIPOP_INCREMENT(path_sequence);
 #if RPL_WITH_DAO_ACK
   /* set up the state since this will be the first transmission of DAO */
-  /* retransmissions will call directly to dao_output_target_seq */
+  /* retransmissions will call directly to dao_output_targets */
   /* keep track of my own sending of DAO for handling ack and loss of ack */
   if(lifetime != RPL_ZERO_LIFETIME) {
     rpl_instance_t *instance;
@@ -989,24 +1120,108 @@ dao_output(rpl_parent_t *parent, uint8_t lifetime)
   parent->dag->instance->has_downward_route = lifetime != RPL_ZERO_LIFETIME;
 #endif /* RPL_WITH_DAO_ACK */
 
-  /* Sending a DAO with own prefix as target */
-  dao_output_target(parent, &prefix, lifetime);
+  /* Sending a DAO with own prefix as target. Targets waiting to be
+     forwarded go along, unless this is a No-Path DAO to an old parent. */
+  dao_output_targets(parent, &prefix, lifetime, dao_sequence,
+                     lifetime != RPL_ZERO_LIFETIME);
 }
 /*---------------------------------------------------------------------------*/
 void
 dao_output_target(rpl_parent_t *parent, uip_ipaddr_t *prefix, uint8_t lifetime)
 {
-  dao_output_target_seq(parent, prefix, lifetime, dao_sequence);
+  if(prefix == NULL) {
+    PRINTF("RPL dao_output_target error prefix NULL\n");
+    return;
+  }
+  dao_output_targets(parent, prefix, lifetime, dao_sequence, 0);
+}
+/*---------------------------------------------------------------------------*/
+void
+dao_output_forward(rpl_parent_t *parent)
+{
+  RPL_LOLLIPOP_INCREMENT(dao_sequence);
+  dao_output_targets(parent, NULL, RPL_ZERO_LIFETIME, dao_sequence, 1);
 }
 /*---------------------------------------------------------------------------*/
+static int
+dao_output_header(rpl_dag_t *dag, unsigned char *buffer, uint8_t seq_no)
+{
+  int pos;
+
+  pos = 0;
+  buffer[pos++] = dag->instance->instance_id;
+  buffer[pos] = 0;
+#if RPL_DAO_SPECIFY_DAG
+  buffer[pos] |= RPL_DAO_D_FLAG;
+#endif /* RPL_DAO_SPECIFY_DAG */
+  ++pos;
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = seq_no;
+#if RPL_DAO_SPECIFY_DAG
+  memcpy(buffer + pos, &dag->dag_id, sizeof(dag->dag_id));
+  pos+=sizeof(dag->dag_id);
+#endif /* RPL_DAO_SPECIFY_DAG */
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dao_output_option(unsigned char *buffer, int pos, uip_ipaddr_t *prefix,
+                  uint8_t prefixlen, uint8_t pathsequence, uint8_t lifetime)
+{
+  /* create target subopt */
+  buffer[pos++] = RPL_OPTION_TARGET;
+  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
+  buffer[pos++] = 0; /* reserved */
+  buffer[pos++] = prefixlen;
+  memcpy(buffer + pos, prefix, (prefixlen + 7) / CHAR_BIT);
+  pos += ((prefixlen + 7) / CHAR_BIT);
+
+  /* Create a transit information sub-option. */
+  buffer[pos++] = RPL_OPTION_TRANSIT;
+  buffer[pos++] = 4;
+  buffer[pos++] = 0; /* flags - ignored */
+  buffer[pos++] = 0; /* path control - ignored */
+  buffer[pos++] = pathsequence;
+  buffer[pos++] = lifetime;
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dao_output_send(rpl_parent_t *parent, unsigned char *buffer, int pos,
+                int request_ack)
+{
+#if RPL_WITH_DAO_ACK
+  if(request_ack) {
+    buffer[1] |= RPL_DAO_K_FLAG;
+  }
+#endif /* RPL_WITH_DAO_ACK */
+
+  PRINTF("RPL: Sending a DAO with sequence number %u (%d bytes) to ",
+         buffer[3], pos);
+  PRINT6ADDR(rpl_get_parent_ipaddr(parent));
+  PRINTF("\n");
+
+  RPL_STAT(rpl_stats.dao_sent++);
+  uip_icmp6_send(rpl_get_parent_ipaddr(parent), ICMP6_RPL, RPL_CODE_DAO, pos);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Send a DAO with our own prefix as target, if prefix is not NULL,
+ * and with all targets waiting to be forwarded if with_forward is
+ * set. Targets that do not fit go into additional DAOs, each with a
+ * sequence number of its own.
+ */
 static void
-dao_output_target_seq(rpl_parent_t *parent, uip_ipaddr_t *prefix,
-		      uint8_t lifetime, uint8_t seq_no)
+dao_output_targets(rpl_parent_t *parent, uip_ipaddr_t *prefix,
+                   uint8_t lifetime, uint8_t seq_no, int with_forward)
 {
   rpl_dag_t *dag;
   rpl_instance_t *instance;
   unsigned char *buffer;
-  uint8_t prefixlen;
+  uip_ds6_route_t *rep;
+  uint8_t target_lifetime;
+  int request_ack;
+  int header_len;
   int pos;
 
   /* Destination Advertisement Object */
@@ -1033,8 +1248,7 @@ dao_output_target_seq(rpl_parent_t *parent, uip_ipaddr_t *prefix,
     PRINTF("RPL dao_output_target error instance NULL\n");
     return;
   }
-  if(prefix == NULL) {
-    PRINTF("RPL dao_output_target error prefix NULL\n");
+  if(rpl_get_parent_ipaddr(parent) == NULL) {
     return;
   }
 #ifdef RPL_DEBUG_DAO_OUTPUT
@@ -1042,55 +1256,141 @@ dao_output_target_seq(rpl_parent_t *parent, uip_ipaddr_t *prefix,
 #endif
 
   buffer = UIP_ICMP_PAYLOAD;
-  pos = 0;
+  pos = dao_output_header(dag, buffer, seq_no);
+  header_len = pos;
+  request_ack = 0;
+
+  if(prefix != NULL) {
+    PRINTF("RPL: Adding %starget with lifetime %u, prefix ",
+           lifetime == RPL_ZERO_LIFETIME ? "No-Path " : "", lifetime);
+    PRINT6ADDR(prefix);
+    PRINTF("\n");
 
-  buffer[pos++] = instance->instance_id;
-  buffer[pos] = 0;
-#if RPL_DAO_SPECIFY_DAG
-  buffer[pos] |= RPL_DAO_D_FLAG;
-#endif /* RPL_DAO_SPECIFY_DAG */
-#if RPL_WITH_DAO_ACK
-  if(lifetime != RPL_ZERO_LIFETIME) {
-    buffer[pos] |= RPL_DAO_K_FLAG;
+    pos = dao_output_option(buffer, pos, prefix, sizeof(*prefix) * CHAR_BIT,
+                            path_sequence, lifetime);
+    request_ack = lifetime != RPL_ZERO_LIFETIME;
+    RPL_STAT(rpl_stats.dao_targets_sent++);
   }
-#endif /* RPL_WITH_DAO_ACK */
-  ++pos;
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = seq_no;
-#if RPL_DAO_SPECIFY_DAG
-  memcpy(buffer + pos, &dag->dag_id, sizeof(dag->dag_id));
-  pos+=sizeof(dag->dag_id);
-#endif /* RPL_DAO_SPECIFY_DAG */
 
-  /* create target subopt */
-  prefixlen = sizeof(*prefix) * CHAR_BIT;
-  buffer[pos++] = RPL_OPTION_TARGET;
-  buffer[pos++] = 2 + ((prefixlen + 7) / CHAR_BIT);
-  buffer[pos++] = 0; /* reserved */
-  buffer[pos++] = prefixlen;
-  memcpy(buffer + pos, prefix, (prefixlen + 7) / CHAR_BIT);
-  pos += ((prefixlen + 7) / CHAR_BIT);
+  if(with_forward) {
+    for(rep = uip_ds6_route_head(); rep != NULL; rep = uip_ds6_route_next(rep)) {
+      if(!RPL_ROUTE_IS_DAO_FORWARD(rep) || rep->state.dag == NULL ||
+         rep->state.dag->instance != instance) {
+        continue;
+      }
 
-  /* Create a transit information sub-option. */
-  buffer[pos++] = RPL_OPTION_TRANSIT;
-  buffer[pos++] = 4;
-  buffer[pos++] = 0; /* flags - ignored */
-  buffer[pos++] = 0; /* path control - ignored */
-  buffer[pos++] = 0; /* path seq - ignored */
-  buffer[pos++] = lifetime;
+      if(pos > header_len &&
+         pos + RPL_DAO_TARGET_LEN(rep->length) > RPL_DAO_MAX_SIZE) {
+        /* This DAO is full - send it and start another one. */
+        dao_output_send(parent, buffer, pos, request_ack);
+        RPL_LOLLIPOP_INCREMENT(dao_sequence);
+        seq_no = dao_sequence;
+        buffer = UIP_ICMP_PAYLOAD;
+        pos = dao_output_header(dag, buffer, seq_no);
+        request_ack = 0;
+      }
 
-  PRINTF("RPL: Sending a %sDAO with sequence number %u, lifetime %u, prefix ",
-      lifetime == RPL_ZERO_LIFETIME ? "No-Path " : "", seq_no, lifetime);
-  PRINT6ADDR(prefix);
-  PRINTF(" to ");
-  PRINT6ADDR(rpl_get_parent_ipaddr(parent));
-  PRINTF("\n");
+      target_lifetime = route_dao_lifetime(instance, rep);
+      PRINTF("RPL: Forwarding %starget ",
+             target_lifetime == RPL_ZERO_LIFETIME ? "No-Path " : "");
+      PRINT6ADDR(&rep->ipaddr);
+      PRINTF(" in seq: %u out seq: %u\n", rep->state.dao_seqno_in, seq_no);
+
+      pos = dao_output_option(buffer, pos, &rep->ipaddr, rep->length,
+                              rep->state.path_sequence, target_lifetime);
+      if(target_lifetime != RPL_ZERO_LIFETIME) {
+        request_ack = 1;
+      }
+
+      /* set DAO pending and the outgoing sequence number */
+      RPL_ROUTE_CLEAR_DAO_FORWARD(rep);
+      rep->state.dao_seqno_out = seq_no;
+      RPL_ROUTE_SET_DAO_PENDING(rep);
+      RPL_STAT(rpl_stats.dao_targets_sent++);
+      RPL_STAT(rpl_stats.dao_targets_forwarded++);
+    }
+  }
 
-  if(rpl_get_parent_ipaddr(parent) != NULL) {
-    uip_icmp6_send(rpl_get_parent_ipaddr(parent), ICMP6_RPL, RPL_CODE_DAO, pos);
+  if(pos > header_len) {
+    dao_output_send(parent, buffer, pos, request_ack);
   }
 }
 /*---------------------------------------------------------------------------*/
+#if RPL_WITH_DAO_ACK
+static int
+dao_ack_pending(uip_ds6_route_t *re, uint8_t sequence)
+{
+  return RPL_ROUTE_IS_DAO_PENDING(re) && re->state.dao_seqno_out == sequence;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Forward a DAO ACK to the children whose targets were in the
+ * acknowledged DAO, once for every DAO that we received from them.
+ */
+static void
+dao_ack_forward(rpl_instance_t *instance, uint8_t sequence, uint8_t status)
+{
+  uip_ds6_route_t *re;
+  uip_ds6_route_t *other;
+  uip_ipaddr_t *nexthop;
+  uip_ipaddr_t *other_nexthop;
+  uint8_t seqno_in;
+  int found;
+
+  found = 0;
+  for(re = uip_ds6_route_head(); re != NULL; re = uip_ds6_route_next(re)) {
+    if(!dao_ack_pending(re, sequence)) {
+      continue;
+    }
+    found = 1;
+    nexthop = uip_ds6_route_nexthop(re);
+    seqno_in = re->state.dao_seqno_in;
+
+    /* pick the recorded seq no from that node and clear the pending
+       flag of all targets it sent in that DAO */
+    for(other = re; other != NULL; other = uip_ds6_route_next(other)) {
+      other_nexthop = uip_ds6_route_nexthop(other);
+      if(dao_ack_pending(other, sequence) &&
+         other->state.dao_seqno_in == seqno_in &&
+         (other_nexthop == nexthop ||
+          (other_nexthop != NULL && nexthop != NULL &&
+           uip_ipaddr_cmp(other_nexthop, nexthop)))) {
+        RPL_ROUTE_CLEAR_DAO_PENDING(other);
+        if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
+          RPL_ROUTE_SET_DAO_NACKED(other);
+        }
+      }
+    }
+
+    if(nexthop == NULL) {
+      PRINTF("RPL: No next hop to fwd DAO ACK to\n");
+    } else {
+      PRINTF("RPL: Fwd DAO ACK to:");
+      PRINT6ADDR(nexthop);
+      PRINTF("\n");
+      dao_ack_output(instance, nexthop, seqno_in, status);
+    }
+  }
+
+  if(!found) {
+    PRINTF("RPL: No route entry found to forward DAO ACK (seqno %u)\n", sequence);
+    return;
+  }
+
+  if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
+    /* these nodes did not get in to the routing tables above... - remove */
+    re = uip_ds6_route_head();
+    while(re != NULL) {
+      other = uip_ds6_route_next(re);
+      if(RPL_ROUTE_IS_DAO_NACKED(re) && re->state.dao_seqno_out == sequence) {
+        uip_ds6_route_rm(re);
+      }
+      re = other;
+    }
+  }
+}
+#endif /* RPL_WITH_DAO_ACK */
+/*---------------------------------------------------------------------------*/
 static void
 dao_ack_input(void)
 {
@@ -1148,35 +1448,11 @@ dao_ack_input(void)
       rpl_local_repair(instance);
     }
 #endif
-
-  } else {
-    /* this DAO ACK should be forwarded to another recently registered route */
-    uip_ds6_route_t *re;
-    uip_ipaddr_t *nexthop;
-    if((re = find_route_entry_by_dao_ack(sequence)) != NULL) {
-      /* pick the recorded seq no from that node and forward DAO ACK - and
-         clear the pending flag*/
-      RPL_ROUTE_CLEAR_DAO_PENDING(re);
-
-      nexthop = uip_ds6_route_nexthop(re);
-      if(nexthop == NULL) {
-        PRINTF("RPL: No next hop to fwd DAO ACK to\n");
-      } else {
-        PRINTF("RPL: Fwd DAO ACK to:");
-        PRINT6ADDR(nexthop);
-        PRINTF("\n");
-        buffer[2] = re->state.dao_seqno_in;
-        uip_icmp6_send(nexthop, ICMP6_RPL, RPL_CODE_DAO_ACK, 4);
-      }
-
-      if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
-        /* this node did not get in to the routing tables above... - remove */
-        uip_ds6_route_rm(re);
-      }
-    } else {
-      PRINTF("RPL: No route entry found to forward DAO ACK (seqno %u)\n", sequence);
-    }
   }
+
+  /* The DAO may also have carried targets of recently registered
+     routes; forward the ACK to them. */
+  dao_ack_forward(instance, sequence, status);
 #endif /* RPL_WITH_DAO_ACK */
   uip_clear_buf();
 }
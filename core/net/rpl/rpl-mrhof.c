@@ -48,6 +48,7 @@
 
 #include "net/rpl/rpl-private.h"
 #include "net/nbr-table.h"
+#include "net/link-stats.h"
 
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
@@ -75,13 +76,6 @@ rpl_of_t rpl_mrhof = {
   1
 };
 
-/* Constants for the ETX moving average */
-#define ETX_SCALE   100
-#define ETX_ALPHA   90
-
-/* Reject parents that have a higher link metric than the following. */
-#define MAX_LINK_METRIC			10
-
 /* Reject parents that have a higher path cost than the following. */
 #define MAX_PATH_COST			100
 
@@ -93,6 +87,17 @@ rpl_of_t rpl_mrhof = {
 
 typedef uint16_t rpl_path_metric_t;
 
+/* The ETX of the link statistics, plus what failed DAOs added to it */
+static uint16_t
+link_metric(rpl_parent_t *p)
+{
+#if RPL_WITH_DAO_ACK
+  return rpl_get_parent_link_metric(p) + p->link_metric_penalty;
+#else /* RPL_WITH_DAO_ACK */
+  return rpl_get_parent_link_metric(p);
+#endif /* RPL_WITH_DAO_ACK */
+}
+
 static rpl_path_metric_t
 calculate_path_metric(rpl_parent_t *p)
 {
@@ -100,21 +105,27 @@ calculate_path_metric(rpl_parent_t *p)
   if(p == NULL) {
     return MAX_PATH_COST * RPL_DAG_MC_ETX_DIVISOR;
   }
+  if(p->flags & RPL_PARENT_FLAG_PATH_METRIC_VALID) {
+    return p->path_metric;
+  }
   nbr = rpl_get_nbr(p);
   if(nbr == NULL) {
     return MAX_PATH_COST * RPL_DAG_MC_ETX_DIVISOR;
   }
+  RPL_STAT(rpl_stats.path_metric_updates++);
 #if RPL_DAG_MC == RPL_DAG_MC_NONE
-  {
-    return p->rank + (uint16_t)nbr->link_metric;
-  }
+  p->path_metric = p->rank + link_metric(p);
 #elif RPL_DAG_MC == RPL_DAG_MC_ETX
-  return p->mc.obj.etx + (uint16_t)nbr->link_metric;
+  p->path_metric = p->mc.obj.etx + link_metric(p);
 #elif RPL_DAG_MC == RPL_DAG_MC_ENERGY
-  return p->mc.obj.energy.energy_est + (uint16_t)nbr->link_metric;
+  p->path_metric = p->mc.obj.energy.energy_est + link_metric(p);
 #else
 #error "Unsupported RPL_DAG_MC configured. See rpl.h."
 #endif /* RPL_DAG_MC */
+  /* Valid until the link metric or the advertised rank or metric
+     container of the parent changes. */
+  p->flags |= RPL_PARENT_FLAG_PATH_METRIC_VALID;
+  return p->path_metric;
 }
 
 static void
@@ -132,12 +143,19 @@ dao_ack_callback(rpl_parent_t *p, int status)
   }
   /* here we need to handle failed DAO's and other stuff */
   PRINTF("RPL: MRHOF - DAO ACK received with status: %d\n", status);
-  if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT) {
-    /* punish the ETX as if this was 10 packets lost */
-    neighbor_link_callback(p, MAC_TX_OK, 10);
-  } else if(status == RPL_DAO_ACK_TIMEOUT) { /* timeout = no ack */
-    /* punish the total lack of ACK with a similar punishment */
-    neighbor_link_callback(p, MAC_TX_OK, 10);
+  if(status >= RPL_DAO_ACK_UNABLE_TO_ACCEPT ||
+     status == RPL_DAO_ACK_TIMEOUT) { /* timeout = no ack */
+    /* punish the ETX as if this was 10 packets lost, without touching
+       the link statistics, as no transmission failed */
+    uint16_t base, metric;
+
+    base = rpl_get_parent_link_metric(p);
+    metric = ((uint32_t)(base + p->link_metric_penalty) * LINK_STATS_ETX_ALPHA +
+              (uint32_t)LINK_STATS_ETX_NOACK_PENALTY * RPL_DAG_MC_ETX_DIVISOR *
+              (100 - LINK_STATS_ETX_ALPHA)) / 100;
+    p->link_metric_penalty = metric > base ? metric - base : 0;
+    RPL_PARENT_INVALIDATE_PATH_METRIC(p);
+    rpl_schedule_parent_update(p);
   }
 }
 #endif /* RPL_WITH_DAO_ACK */
@@ -145,42 +163,18 @@ dao_ack_callback(rpl_parent_t *p, int status)
 static void
 neighbor_link_callback(rpl_parent_t *p, int status, int numtx)
 {
-  uint16_t recorded_etx = 0;
-  uint16_t packet_etx = numtx * RPL_DAG_MC_ETX_DIVISOR;
-  uint16_t new_etx;
-  uip_ds6_nbr_t *nbr = NULL;
-
-  nbr = rpl_get_nbr(p);
-  if(nbr == NULL) {
-    /* No neighbor for this parent - something bad has occurred */
-    return;
-  }
-
-  recorded_etx = nbr->link_metric;
-
-  /* Do not penalize the ETX when collisions or transmission errors occur. */
+  /* The ETX itself is kept by the link statistics module, which the
+     MAC callback has updated already. Collisions and transmission
+     errors do not change it. */
   if(status == MAC_TX_OK || status == MAC_TX_NOACK) {
-    if(status == MAC_TX_NOACK) {
-      packet_etx = MAX_LINK_METRIC * RPL_DAG_MC_ETX_DIVISOR;
-    }
-
-    if(p->flags & RPL_PARENT_FLAG_LINK_METRIC_VALID) {
-      /* We already have a valid link metric, use weighted moving average to update it */
-      new_etx = ((uint32_t)recorded_etx * ETX_ALPHA +
-                 (uint32_t)packet_etx * (ETX_SCALE - ETX_ALPHA)) / ETX_SCALE;
-    } else {
-      /* We don't have a valid link metric, set it to the current packet's ETX */
-      new_etx = packet_etx;
-      /* Set link metric as valid */
-      p->flags |= RPL_PARENT_FLAG_LINK_METRIC_VALID;
-    }
-
-    PRINTF("RPL: ETX changed from %u to %u (packet ETX = %u)\n",
-        (unsigned)(recorded_etx / RPL_DAG_MC_ETX_DIVISOR),
-        (unsigned)(new_etx  / RPL_DAG_MC_ETX_DIVISOR),
-        (unsigned)(packet_etx / RPL_DAG_MC_ETX_DIVISOR));
-    /* update the link metric for this nbr */
-    nbr->link_metric = new_etx;
+#if RPL_WITH_DAO_ACK
+    /* The penalty fades as the link statistics get new samples */
+    p->link_metric_penalty = (uint32_t)p->link_metric_penalty *
+      LINK_STATS_ETX_ALPHA / 100;
+#endif /* RPL_WITH_DAO_ACK */
+    PRINTF("RPL: link metric now %u\n", link_metric(p));
+    p->flags |= RPL_PARENT_FLAG_LINK_METRIC_VALID;
+    RPL_PARENT_INVALIDATE_PATH_METRIC(p);
   }
 }
 
@@ -189,15 +183,14 @@ calculate_rank(rpl_parent_t *p, rpl_rank_t base_rank)
 {
   rpl_rank_t new_rank;
   rpl_rank_t rank_increase;
-  uip_ds6_nbr_t *nbr;
 
-  if(p == NULL || (nbr = rpl_get_nbr(p)) == NULL) {
+  if(p == NULL || rpl_get_nbr(p) == NULL) {
     if(base_rank == 0) {
       return INFINITE_RANK;
     }
     rank_increase = RPL_INIT_LINK_METRIC * RPL_DAG_MC_ETX_DIVISOR;
   } else {
-    rank_increase = nbr->link_metric;
+    rank_increase = link_metric(p);
     if(base_rank == 0) {
       base_rank = p->rank;
     }
@@ -88,6 +88,15 @@
 #define RPL_OPTION_PREFIX_INFO           8
 #define RPL_OPTION_TARGET_DESC           9
 
+/* DIO option carrying a 6LoWPAN Context Option body, see RPL_WITH_6CO.
+   RFC 6550 assigns no such option; the type is taken from the
+   unassigned range and can be changed to match other implementations. */
+#ifdef RPL_CONF_OPTION_6CO
+#define RPL_OPTION_6CO                   RPL_CONF_OPTION_6CO
+#else
+#define RPL_OPTION_6CO                   0x22
+#endif
+
 #define RPL_DAO_K_FLAG                   0x80 /* DAO ACK requested */
 #define RPL_DAO_D_FLAG                   0x40 /* DODAG ID present */
 
@@ -118,6 +127,27 @@
 #define RPL_DAO_DELAY                 (CLOCK_SECOND * 4)
 #endif /* RPL_CONF_DAO_DELAY */
 
+/*
+ * Targets received in DAOs from children are not forwarded one DAO at
+ * a time. They are collected for RPL_DAO_AGGREGATION_DELAY and sent
+ * to the preferred parent in as few DAOs as possible, piggybacked on
+ * our own DAO if that is due first. Zero forwards the targets of each
+ * received DAO right away.
+ */
+#ifdef RPL_CONF_DAO_AGGREGATION_DELAY
+#define RPL_DAO_AGGREGATION_DELAY     RPL_CONF_DAO_AGGREGATION_DELAY
+#else /* RPL_CONF_DAO_AGGREGATION_DELAY */
+#define RPL_DAO_AGGREGATION_DELAY     (CLOCK_SECOND / 2)
+#endif /* RPL_CONF_DAO_AGGREGATION_DELAY */
+
+/* Maximum size of the payload of an aggregated DAO. Targets that do
+   not fit are sent in additional DAOs. */
+#ifdef RPL_CONF_DAO_MAX_SIZE
+#define RPL_DAO_MAX_SIZE              RPL_CONF_DAO_MAX_SIZE
+#else /* RPL_CONF_DAO_MAX_SIZE */
+#define RPL_DAO_MAX_SIZE              (UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPICMPH_LEN)
+#endif /* RPL_CONF_DAO_MAX_SIZE */
+
 /* Delay between reception of a no-path DAO and actual route removal */
 #ifdef RPL_CONF_NOPATH_REMOVAL_DELAY
 #define RPL_NOPATH_REMOVAL_DELAY          RPL_CONF_NOPATH_REMOVAL_DELAY
@@ -265,6 +295,12 @@ struct rpl_stats {
   uint16_t loop_errors;
   uint16_t loop_warnings;
   uint16_t root_repairs;
+  uint16_t dao_sent;
+  uint16_t dao_targets_sent;
+  uint16_t dao_targets_forwarded;
+  uint16_t parent_evaluations;
+  uint16_t parent_scans;
+  uint16_t path_metric_updates;
 };
 typedef struct rpl_stats rpl_stats_t;
 
@@ -290,6 +326,7 @@ void dis_output(uip_ipaddr_t *addr);
 void dio_output(rpl_instance_t *, uip_ipaddr_t *uc_addr);
 void dao_output(rpl_parent_t *, uint8_t lifetime);
 void dao_output_target(rpl_parent_t *, uip_ipaddr_t *, uint8_t lifetime);
+void dao_output_forward(rpl_parent_t *);
 void dao_ack_output(rpl_instance_t *, uip_ipaddr_t *, uint8_t, uint8_t);
 void rpl_icmp6_register_handlers(void);
 uip_ds6_nbr_t *rpl_icmp6_update_nbr_table(uip_ipaddr_t *from,
@@ -316,10 +353,16 @@ rpl_parent_t *rpl_find_parent_any_dag(rpl_instance_t *instance, uip_ipaddr_t *ad
 void rpl_nullify_parent(rpl_parent_t *);
 void rpl_remove_parent(rpl_parent_t *);
 void rpl_move_parent(rpl_dag_t *dag_src, rpl_dag_t *dag_dst, rpl_parent_t *parent);
-rpl_parent_t *rpl_select_parent(rpl_dag_t *dag);
+rpl_parent_t *rpl_select_parent(rpl_dag_t *dag, rpl_parent_t *changed);
 rpl_dag_t *rpl_select_dag(rpl_instance_t *instance,rpl_parent_t *parent);
+void rpl_schedule_parent_update(rpl_parent_t *parent);
 void rpl_recalculate_ranks(void);
 
+/* Drop the path metric cached for a parent after its rank, metric
+   container or link metric changed. */
+#define RPL_PARENT_INVALIDATE_PATH_METRIC(p) \
+  ((p)->flags &= ~RPL_PARENT_FLAG_PATH_METRIC_VALID)
+
 /* RPL routing table functions. */
 void rpl_remove_routes(rpl_dag_t *dag);
 void rpl_remove_routes_by_nexthop(uip_ipaddr_t *nexthop, rpl_dag_t *dag);
@@ -333,6 +376,7 @@ rpl_of_t *rpl_find_of(rpl_ocp_t);
 /* Timer functions. */
 void rpl_schedule_dao(rpl_instance_t *);
 void rpl_schedule_dao_immediately(rpl_instance_t *);
+void rpl_schedule_dao_forward(rpl_instance_t *);
 void rpl_schedule_unicast_dio_immediately(rpl_instance_t *instance);
 void rpl_cancel_dao(rpl_instance_t *instance);
 void rpl_schedule_probing(rpl_instance_t *instance);
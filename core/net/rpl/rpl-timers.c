@@ -44,6 +44,7 @@
 #include "contiki-conf.h"
 #include "net/rpl/rpl-private.h"
 #include "net/ipv6/multicast/uip-mcast6.h"
+#include "net/ipv6/sicslowpan.h"
 #include "lib/random.h"
 #include "sys/ctimer.h"
 
@@ -59,14 +60,18 @@ void RPL_CALLBACK_NEW_DIO_INTERVAL(uint8_t dio_interval);
 static struct ctimer periodic_timer;
 
 static void handle_periodic_timer(void *ptr);
-static void new_dio_interval(rpl_instance_t *instance);
-static void handle_dio_timer(void *ptr);
+static void handle_dio_timer(void *ptr, uint8_t suppress);
 
 static uint16_t next_dis;
 
 /* dio_send_ok is true if the node is ready to send DIOs */
 static uint8_t dio_send_ok;
 
+#if RPL_WITH_6CO
+/* Version of the compression contexts last announced in DIOs */
+static uint8_t context_version;
+#endif /* RPL_WITH_6CO */
+
 /*---------------------------------------------------------------------------*/
 static void
 handle_periodic_timer(void *ptr)
@@ -83,37 +88,67 @@ handle_periodic_timer(void *ptr)
     dis_output(NULL);
   }
 #endif
+
+#if RPL_WITH_6CO
+  /* Spread new or changed compression contexts quickly. */
+  if(context_version != sicslowpan_context_version()) {
+    context_version = sicslowpan_context_version();
+    if(default_instance != NULL && default_instance->current_dag != NULL) {
+      rpl_reset_dio_timer(default_instance);
+    }
+  }
+#endif /* RPL_WITH_6CO */
   ctimer_reset(&periodic_timer);
 }
 /*---------------------------------------------------------------------------*/
+/* Derives the current DIO interval, in the 2^n ms form used by RPL,
+   from the Trickle timer. */
 static void
-new_dio_interval(rpl_instance_t *instance)
+update_dio_intcurrent(rpl_instance_t *instance)
 {
-  uint32_t time;
-  clock_time_t ticks;
-
-  /* TODO: too small timer intervals for many cases */
-  time = 1UL << instance->dio_intcurrent;
+  clock_time_t i;
+
+  instance->dio_intcurrent = instance->dio_intmin;
+  for(i = instance->dio_timer.i_min;
+      i < instance->dio_timer.i_cur &&
+        instance->dio_intcurrent < instance->dio_intmin + instance->dio_intdoubl;
+      i <<= 1) {
+    instance->dio_intcurrent++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_DIO_ADAPTIVE_REDUNDANCY
+static uint16_t
+dio_neighbor_density(rpl_instance_t *instance)
+{
+  rpl_parent_t *p;
+  uint16_t density;
 
-  /* Convert from milliseconds to CLOCK_TICKS. */
-  ticks = (time * CLOCK_SECOND) / 1000;
-  instance->dio_next_delay = ticks;
+  density = 0;
+  for(p = nbr_table_head(rpl_parents); p != NULL;
+      p = nbr_table_next(rpl_parents, p)) {
+    if(p->dag != NULL && p->dag->instance == instance) {
+      density++;
+    }
+  }
+  return density;
+}
+#endif /* RPL_DIO_ADAPTIVE_REDUNDANCY */
+/*---------------------------------------------------------------------------*/
+static void
+handle_dio_timer(void *ptr, uint8_t suppress)
+{
+  rpl_instance_t *instance;
 
-  /* random number between I/2 and I */
-  ticks = ticks / 2 + (ticks / 2 * (uint32_t)random_rand()) / RANDOM_RAND_MAX;
+  instance = (rpl_instance_t *)ptr;
 
-  /*
-   * The intervals must be equally long among the nodes for Trickle to
-   * operate efficiently. Therefore we need to calculate the delay between
-   * the randomized time and the start time of the next interval.
-   */
-  instance->dio_next_delay -= ticks;
-  instance->dio_send = 1;
+  PRINTF("RPL: DIO Timer triggered\n");
+  update_dio_intcurrent(instance);
 
 #if RPL_CONF_STATS
   /* keep some stats */
   instance->dio_totint++;
-  instance->dio_totrecv += instance->dio_counter;
+  instance->dio_totrecv += instance->dio_timer.c;
   ANNOTATE("#A rank=%u.%u(%u),stats=%d %d %d %d,color=%s\n",
 	   DAG_RANK(instance->current_dag->rank, instance),
            (10 * (instance->current_dag->rank % instance->min_hoprankinc)) / instance->min_hoprankinc,
@@ -123,60 +158,36 @@ new_dio_interval(rpl_instance_t *instance)
 	   instance->current_dag->rank == ROOT_RANK(instance) ? "BLUE" : "ORANGE");
 #endif /* RPL_CONF_STATS */
 
-  /* reset the redundancy counter */
-  instance->dio_counter = 0;
-
-  /* schedule the timer */
-  PRINTF("RPL: Scheduling DIO timer %lu ticks in future (Interval)\n", ticks);
-  ctimer_set(&instance->dio_timer, ticks, &handle_dio_timer, instance);
-
-#ifdef RPL_CALLBACK_NEW_DIO_INTERVAL
-  RPL_CALLBACK_NEW_DIO_INTERVAL(instance->dio_intcurrent);
-#endif /* RPL_CALLBACK_NEW_DIO_INTERVAL */
-}
-/*---------------------------------------------------------------------------*/
-static void
-handle_dio_timer(void *ptr)
-{
-  rpl_instance_t *instance;
-
-  instance = (rpl_instance_t *)ptr;
-
-  PRINTF("RPL: DIO Timer triggered\n");
   if(!dio_send_ok) {
     if(uip_ds6_get_link_local(ADDR_PREFERRED) != NULL) {
       dio_send_ok = 1;
     } else {
-      PRINTF("RPL: Postponing DIO transmission since link local address is not ok\n");
-      ctimer_set(&instance->dio_timer, CLOCK_SECOND, &handle_dio_timer, instance);
-      return;
+      PRINTF("RPL: Skipping DIO transmission since link local address is not ok\n");
     }
   }
 
-  if(instance->dio_send) {
-    /* send DIO if counter is less than desired redundancy */
-    if(instance->dio_redundancy != 0 && instance->dio_counter < instance->dio_redundancy) {
+  if(dio_send_ok) {
+    if(suppress == TRICKLE_TIMER_TX_OK) {
 #if RPL_CONF_STATS
       instance->dio_totsend++;
 #endif /* RPL_CONF_STATS */
       dio_output(instance, NULL);
     } else {
       PRINTF("RPL: Suppressing DIO transmission (%d >= %d)\n",
-             instance->dio_counter, instance->dio_redundancy);
-    }
-    instance->dio_send = 0;
-    PRINTF("RPL: Scheduling DIO timer %lu ticks in future (sent)\n",
-           instance->dio_next_delay);
-    ctimer_set(&instance->dio_timer, instance->dio_next_delay, handle_dio_timer, instance);
-  } else {
-    /* check if we need to double interval */
-    if(instance->dio_intcurrent < instance->dio_intmin + instance->dio_intdoubl) {
-      instance->dio_intcurrent++;
-      PRINTF("RPL: DIO Timer interval doubled %d\n", instance->dio_intcurrent);
+             instance->dio_timer.c, instance->dio_timer.k);
     }
-    new_dio_interval(instance);
   }
 
+#if RPL_DIO_ADAPTIVE_REDUNDANCY
+  /* Adapt k for the next interval. */
+  trickle_timer_set_density(&instance->dio_timer,
+                            dio_neighbor_density(instance));
+#endif /* RPL_DIO_ADAPTIVE_REDUNDANCY */
+
+#ifdef RPL_CALLBACK_NEW_DIO_INTERVAL
+  RPL_CALLBACK_NEW_DIO_INTERVAL(instance->dio_intcurrent);
+#endif /* RPL_CALLBACK_NEW_DIO_INTERVAL */
+
 #if DEBUG
   rpl_print_neighbor_list();
 #endif
@@ -191,18 +202,40 @@ rpl_reset_periodic_timer(void)
   ctimer_set(&periodic_timer, CLOCK_SECOND, handle_periodic_timer, NULL);
 }
 /*---------------------------------------------------------------------------*/
-/* Resets the DIO timer in the instance to its minimal interval. */
+/* Resets the DIO timer in the instance to its minimal interval, starting
+   it first if needed. The Trickle parameters are taken from the
+   instance, so this also applies new DAG configurations. */
 void
 rpl_reset_dio_timer(rpl_instance_t *instance)
 {
 #if !RPL_LEAF_ONLY
-  /* Do not reset if we are already on the minimum interval,
-     unless forced to do so. */
-  if(instance->dio_intcurrent > instance->dio_intmin) {
-    instance->dio_counter = 0;
-    instance->dio_intcurrent = instance->dio_intmin;
-    new_dio_interval(instance);
+  clock_time_t i_min;
+
+  /* Convert from milliseconds to CLOCK_TICKS. */
+  i_min = ((1UL << instance->dio_intmin) * CLOCK_SECOND) / 1000;
+
+  if(trickle_timer_config(&instance->dio_timer, i_min,
+                          instance->dio_intdoubl,
+                          instance->dio_redundancy) == TRICKLE_TIMER_ERROR) {
+    PRINTF("RPL: Invalid DIO timer configuration (Imin %u, doublings %u)\n",
+           instance->dio_intmin, instance->dio_intdoubl);
+    return;
+  }
+#if RPL_DIO_ADAPTIVE_REDUNDANCY
+  trickle_timer_set_density(&instance->dio_timer,
+                            dio_neighbor_density(instance));
+#endif /* RPL_DIO_ADAPTIVE_REDUNDANCY */
+
+  if(!trickle_timer_is_running(&instance->dio_timer)) {
+    trickle_timer_set(&instance->dio_timer, handle_dio_timer, instance);
   }
+  /* Does nothing if we are already on the minimum interval. */
+  trickle_timer_reset_event(&instance->dio_timer);
+  update_dio_intcurrent(instance);
+
+#ifdef RPL_CALLBACK_NEW_DIO_INTERVAL
+  RPL_CALLBACK_NEW_DIO_INTERVAL(instance->dio_intcurrent);
+#endif /* RPL_CALLBACK_NEW_DIO_INTERVAL */
 #if RPL_CONF_STATS
   rpl_stats.resets++;
 #endif /* RPL_CONF_STATS */
@@ -332,11 +365,57 @@ rpl_schedule_dao_immediately(rpl_instance_t *instance)
   schedule_dao(instance, 0);
 }
 /*---------------------------------------------------------------------------*/
+static void
+handle_dao_forward_timer(void *ptr)
+{
+  rpl_instance_t *instance;
+
+  instance = (rpl_instance_t *)ptr;
+
+  if(instance->current_dag != NULL &&
+     instance->current_dag->preferred_parent != NULL) {
+    PRINTF("RPL: handle_dao_forward_timer - forwarding DAO targets\n");
+    dao_output_forward(instance->current_dag->preferred_parent);
+  } else {
+    PRINTF("RPL: No suitable DAO parent to forward targets to\n");
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rpl_schedule_dao_forward(rpl_instance_t *instance)
+{
+  clock_time_t now;
+
+  if(RPL_DAO_AGGREGATION_DELAY == 0) {
+    handle_dao_forward_timer(instance);
+    return;
+  }
+
+  if(!etimer_expired(&instance->dao_forward_timer.etimer)) {
+    PRINTF("RPL: DAO forward timer already scheduled\n");
+    return;
+  }
+
+  /* If our own DAO is due within the aggregation delay, the targets
+     are sent along with it. */
+  now = clock_time();
+  if(!etimer_expired(&instance->dao_timer.etimer) &&
+     etimer_expiration_time(&instance->dao_timer.etimer) - now <=
+     RPL_DAO_AGGREGATION_DELAY) {
+    PRINTF("RPL: DAO targets will be sent with our own DAO\n");
+    return;
+  }
+
+  ctimer_set(&instance->dao_forward_timer, RPL_DAO_AGGREGATION_DELAY,
+             handle_dao_forward_timer, instance);
+}
+/*---------------------------------------------------------------------------*/
 void
 rpl_cancel_dao(rpl_instance_t *instance)
 {
   ctimer_stop(&instance->dao_timer);
   ctimer_stop(&instance->dao_lifetime_timer);
+  ctimer_stop(&instance->dao_forward_timer);
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -44,6 +44,7 @@
 #include "net/ip/uip.h"
 #include "net/ipv6/uip-ds6.h"
 #include "sys/ctimer.h"
+#include "lib/trickle-timer.h"
 
 /*---------------------------------------------------------------------------*/
 typedef uint16_t rpl_rank_t;
@@ -106,6 +107,11 @@ struct rpl_dag;
 /*---------------------------------------------------------------------------*/
 #define RPL_PARENT_FLAG_UPDATED           0x1
 #define RPL_PARENT_FLAG_LINK_METRIC_VALID 0x2
+#define RPL_PARENT_FLAG_PATH_METRIC_VALID 0x4
+
+/* Bits of rpl_dag_t.candidates_valid */
+#define RPL_DAG_CANDIDATE_BEST_VALID      0x1
+#define RPL_DAG_CANDIDATE_SECOND_VALID    0x2
 
 struct rpl_parent {
   struct rpl_dag *dag;
@@ -113,6 +119,14 @@ struct rpl_parent {
   rpl_metric_container_t mc;
 #endif /* RPL_DAG_MC != RPL_DAG_MC_NONE */
   rpl_rank_t rank;
+  /* Path metric through this parent, cached by the objective function
+     while RPL_PARENT_FLAG_PATH_METRIC_VALID is set. */
+  uint16_t path_metric;
+#if RPL_WITH_DAO_ACK
+  /* Added to the link metric by the objective function after failed
+     DAOs, which the link statistics know nothing about. */
+  uint16_t link_metric_penalty;
+#endif /* RPL_WITH_DAO_ACK */
   clock_time_t last_tx_time;
   uint8_t dtsn;
   uint8_t flags;
@@ -139,6 +153,12 @@ struct rpl_dag {
   /* live data for the DAG */
   uint8_t joined;
   rpl_parent_t *preferred_parent;
+  /* The two best candidate parents, maintained incrementally as
+     parents are updated so that the whole parent set only has to be
+     scanned when these are unknown. */
+  rpl_parent_t *best_candidate;
+  rpl_parent_t *second_candidate;
+  uint8_t candidates_valid;
   rpl_rank_t rank;
   struct rpl_instance *instance;
   rpl_prefix_t prefix_info;
@@ -222,9 +242,7 @@ struct rpl_instance {
   uint8_t dio_intmin;
   uint8_t dio_redundancy;
   uint8_t default_lifetime;
-  uint8_t dio_intcurrent;
-  uint8_t dio_send; /* for keeping track of which mode the timer is in */
-  uint8_t dio_counter;
+  uint8_t dio_intcurrent; /* current DIO interval, 2^n ms */
   /* my last registered DAO that I might be waiting for ACK on */
   uint8_t my_dao_seqno;
   uint8_t my_dao_transmissions;
@@ -238,13 +256,15 @@ struct rpl_instance {
   uint16_t dio_totsend;
   uint16_t dio_totrecv;
 #endif /* RPL_CONF_STATS */
-  clock_time_t dio_next_delay; /* delay for completion of dio interval */
 #if RPL_WITH_PROBING
   struct ctimer probing_timer;
 #endif /* RPL_WITH_PROBING */
-  struct ctimer dio_timer;
+  /* DIO Trickle timer. With TRICKLE_TIMER_CONF_STATS, it also counts the
+     DIOs sent and suppressed and the resets of this instance. */
+  struct trickle_timer dio_timer;
   struct ctimer dao_timer;
   struct ctimer dao_lifetime_timer;
+  struct ctimer dao_forward_timer;
   struct ctimer unicast_dio_timer;
   rpl_parent_t *unicast_dio_target;
 #if RPL_WITH_DAO_ACK
@@ -271,7 +291,7 @@ uint8_t rpl_invert_header(void);
 uip_ipaddr_t *rpl_get_parent_ipaddr(rpl_parent_t *nbr);
 rpl_parent_t *rpl_get_parent(uip_lladdr_t *addr);
 rpl_rank_t rpl_get_parent_rank(uip_lladdr_t *addr);
-uint16_t rpl_get_parent_link_metric(const uip_lladdr_t *addr);
+uint16_t rpl_get_parent_link_metric(rpl_parent_t *p);
 void rpl_dag_init(void);
 uip_ds6_nbr_t *rpl_get_nbr(rpl_parent_t *parent);
 void rpl_print_neighbor_list(void);
@@ -104,5 +104,18 @@ rtimer_run_next(void)
   return;
 }
 /*---------------------------------------------------------------------------*/
+int
+rtimer_next_expiration(rtimer_clock_t *time)
+{
+  struct rtimer *t;
+
+  t = next_rtimer;
+  if(t == NULL) {
+    return 0;
+  }
+  *time = t->time;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
 
 /** @}*/
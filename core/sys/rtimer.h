@@ -120,6 +120,18 @@ int rtimer_set(struct rtimer *task, rtimer_clock_t time,
  */
 void rtimer_run_next(void);
 
+/**
+ * \brief      Get the time of the next real-time task
+ * \param time Set to the time of the next task, if there is one
+ * \return     Non-zero (true) if a task is scheduled, zero (false)
+ *             otherwise
+ *
+ *             This function is used by the tickless idle module to
+ *             find out when the system next has to be awake.
+ *
+ */
+int rtimer_next_expiration(rtimer_clock_t *time);
+
 /**
  * \brief      Get the current clock time
  * \return     The current time
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Tickless idle: the time until the system next has to run
+ */
+
+/**
+ * \addtogroup tickless
+ * @{
+ */
+
+#include "sys/tickless.h"
+#include "sys/rtimer.h"
+
+struct tickless_stats tickless_stats;
+/*---------------------------------------------------------------------------*/
+#if TICKLESS_WITH_RTIMER
+/* Rounded down, so that the system wakes up early rather than late. */
+static clock_time_t
+rtimer_to_ticks(rtimer_clock_t t)
+{
+  if(RTIMER_SECOND >= CLOCK_SECOND) {
+    return t / ((RTIMER_SECOND + CLOCK_SECOND - 1) / CLOCK_SECOND);
+  }
+  return t * (CLOCK_SECOND / RTIMER_SECOND);
+}
+#endif /* TICKLESS_WITH_RTIMER */
+/*---------------------------------------------------------------------------*/
+clock_time_t
+tickless_next_wakeup(void)
+{
+  clock_time_t ticks;
+  clock_time_t until;
+#if TICKLESS_WITH_RTIMER
+  rtimer_clock_t next;
+  rtimer_clock_t now;
+#endif /* TICKLESS_WITH_RTIMER */
+
+  /* Polled processes and posted events */
+  if(process_nevents() > 0) {
+    return 0;
+  }
+
+  ticks = TICKLESS_FOREVER;
+
+  /* Event timers, and through them callback timers */
+  if(etimer_pending()) {
+    until = etimer_next_expiration_time() - clock_time();
+    if(until > TICKLESS_FOREVER) {
+      /* Already expired */
+      return 0;
+    }
+    ticks = until;
+  }
+
+#if TICKLESS_WITH_RTIMER
+  if(rtimer_next_expiration(&next)) {
+    now = RTIMER_NOW();
+    if(!RTIMER_CLOCK_LT(now, next)) {
+      return 0;
+    }
+    until = rtimer_to_ticks(next - now);
+    if(until < ticks) {
+      ticks = until;
+    }
+  }
+#endif /* TICKLESS_WITH_RTIMER */
+
+  return ticks;
+}
+/*---------------------------------------------------------------------------*/
+void
+tickless_poll_expired(void)
+{
+  clock_time_t until;
+
+  if(etimer_pending()) {
+    until = etimer_next_expiration_time() - clock_time();
+    if(until == 0 || until > TICKLESS_FOREVER) {
+      etimer_request_poll();
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+tickless_idle_enter(void)
+{
+#if TICKLESS_ENABLED
+  clock_time_t ticks;
+
+  ticks = tickless_next_wakeup();
+  /* The next tick comes anyway if the deadline is that close. */
+  if(ticks > 1) {
+    tickless_arch_set_wakeup(ticks);
+    tickless_stats.sleeps++;
+  }
+#endif /* TICKLESS_ENABLED */
+}
+/*---------------------------------------------------------------------------*/
+void
+tickless_idle_exit(void)
+{
+#if TICKLESS_ENABLED
+  tickless_arch_resume();
+#endif /* TICKLESS_ENABLED */
+}
+/*---------------------------------------------------------------------------*/
+
+/** @} */
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *         Header file for tickless idle
+ */
+
+/**
+ * \addtogroup sys
+ * @{
+ */
+
+/**
+ * \defgroup tickless Tickless idle
+ * @{
+ *
+ * Most of the time, a Contiki system has nothing to do until one of
+ * its timers expires. The tickless idle module computes how long the
+ * system can sleep. It cannot sleep at all if a process has been
+ * polled or has events waiting. Otherwise it can sleep until the
+ * next etimer or rtimer deadline. Callback timers run on event timers,
+ * so the ctimer deadlines are covered by the etimer deadline.
+ *
+ * A platform with a periodic clock interrupt can use this to wake up
+ * only at the next deadline instead of at every clock tick. To do so
+ * it implements tickless_arch_set_wakeup() and tickless_arch_resume()
+ * and sets TICKLESS_ARCH_CONF_AVAILABLE. Its idle loop calls
+ * tickless_idle_enter() and tickless_idle_exit() around the low power
+ * mode. The tickless idle mode is then turned on with
+ * TICKLESS_CONF_ENABLED.
+ */
+
+#ifndef TICKLESS_H_
+#define TICKLESS_H_
+
+#include "contiki.h"
+
+#ifdef TICKLESS_CONF_ENABLED
+#define TICKLESS_ENABLED TICKLESS_CONF_ENABLED
+#else /* TICKLESS_CONF_ENABLED */
+#define TICKLESS_ENABLED 0
+#endif /* TICKLESS_CONF_ENABLED */
+
+/* Whether the CPU port implements tickless_arch_set_wakeup() and
+   tickless_arch_resume() */
+#ifdef TICKLESS_ARCH_CONF_AVAILABLE
+#define TICKLESS_ARCH_AVAILABLE TICKLESS_ARCH_CONF_AVAILABLE
+#else /* TICKLESS_ARCH_CONF_AVAILABLE */
+#define TICKLESS_ARCH_AVAILABLE 0
+#endif /* TICKLESS_ARCH_CONF_AVAILABLE */
+
+#if TICKLESS_ENABLED && !TICKLESS_ARCH_AVAILABLE
+#error "TICKLESS_CONF_ENABLED is set but this platform has no tickless support"
+#endif /* TICKLESS_ENABLED && !TICKLESS_ARCH_AVAILABLE */
+
+/* Whether rtimer deadlines wake the system. Platforms whose rtimer
+   interrupt wakes the CPU on its own can turn this off. */
+#ifdef TICKLESS_CONF_WITH_RTIMER
+#define TICKLESS_WITH_RTIMER TICKLESS_CONF_WITH_RTIMER
+#else /* TICKLESS_CONF_WITH_RTIMER */
+#define TICKLESS_WITH_RTIMER 1
+#endif /* TICKLESS_CONF_WITH_RTIMER */
+
+/** The number of ticks returned when nothing is scheduled */
+#define TICKLESS_FOREVER (~((clock_time_t)0) / 2)
+
+struct tickless_stats {
+  /** The number of times that the system slept past a clock tick */
+  unsigned long sleeps;
+  /** The number of clock interrupts, counted by the platform */
+  unsigned long clock_interrupts;
+};
+
+extern struct tickless_stats tickless_stats;
+
+/**
+ * \brief      Get the time until the system next has to run
+ * \return     The number of clock ticks from now, 0 if the system
+ *             has work to do right away, or TICKLESS_FOREVER if
+ *             nothing is scheduled
+ *
+ *             The time is rounded down, so the system may wake up
+ *             slightly early for an rtimer but never late.
+ */
+clock_time_t tickless_next_wakeup(void);
+
+/**
+ * \brief      Poll the etimer module if a timer has expired
+ *
+ *             A platform whose clock advances without an interrupt
+ *             for every tick calls this after the clock has moved,
+ *             in place of the check in the clock interrupt.
+ */
+void tickless_poll_expired(void);
+
+/**
+ * \brief      Prepare the clock for a sleep
+ *
+ *             Called by the idle loop of the platform, with
+ *             interrupts disabled, right before it enters a low power
+ *             mode. The clock is set to interrupt at the next
+ *             deadline instead of at the next tick. Does nothing
+ *             unless TICKLESS_CONF_ENABLED is set.
+ */
+void tickless_idle_enter(void);
+
+/**
+ * \brief      Bring the clock up to date after a sleep
+ *
+ *             Called by the idle loop of the platform, with
+ *             interrupts disabled, when the CPU has woken up.
+ */
+void tickless_idle_exit(void);
+
+/**
+ * \brief      Have the clock interrupt after a number of ticks
+ * \param ticks The number of ticks, at least 2
+ *
+ *             Implemented by the platform. The platform may interrupt
+ *             earlier than asked, for instance when its timer cannot
+ *             count that far. A clock interrupt that ends a sleep
+ *             must wake the CPU so that the idle loop runs again.
+ */
+void tickless_arch_set_wakeup(clock_time_t ticks);
+
+/**
+ * \brief      Resume periodic clock ticks
+ *
+ *             Implemented by the platform. Accounts for the ticks that
+ *             passed during the sleep, so that clock_time() is
+ *             correct again, and polls the etimer module if a timer
+ *             has expired.
+ */
+void tickless_arch_resume(void);
+
+#endif /* TICKLESS_H_ */
+
+/** @} */
+/** @} */
@@ -33,6 +33,7 @@
 #include "sys/energest.h"
 #include "sys/clock.h"
 #include "sys/etimer.h"
+#include "sys/tickless.h"
 #include "rtimer-arch.h"
 #include "dev/watchdog.h"
 #include "isr_compat.h"
@@ -48,6 +49,18 @@ static volatile unsigned long seconds;
 static volatile clock_time_t count = 0;
 /* last_tar is used for calculating clock_fine */
 static volatile uint16_t last_tar = 0;
+/* The TAR value of the next clock tick. TACCR1 is set to this, except
+   during a tickless sleep. */
+static volatile uint16_t next_tick;
+
+#if TICKLESS_ENABLED
+/* Set while TACCR1 is past the next tick */
+static volatile uint8_t sleeping;
+/* TACCR1 has to stay within half a timer period for CLOCK_LT. Timer A
+   runs at RTIMER_ARCH_SECOND (32768 Hz), so with CLOCK_SECOND 128 a
+   sleep lasts at most 126 ticks, just under a second. */
+#define MAX_SLEEP_TICKS (0x7fff / INTERVAL - 1)
+#endif /* TICKLESS_ENABLED */
 /*---------------------------------------------------------------------------*/
 static inline uint16_t
 read_tar(void)
@@ -61,6 +74,32 @@ read_tar(void)
   return t1;
 }
 /*---------------------------------------------------------------------------*/
+/* Count the ticks up to now. Called with interrupts disabled. */
+static void
+update_count(void)
+{
+  last_tar = read_tar();
+  /* Make sure the next tick is in the future */
+  while(!CLOCK_LT(last_tar, next_tick)) {
+    next_tick += INTERVAL;
+    ++count;
+
+    /* Make sure the CLOCK_CONF_SECOND is a power of two, to ensure
+       that the modulo operation below becomes a logical and and not
+       an expensive divide. Algorithm from Wikipedia:
+       http://en.wikipedia.org/wiki/Power_of_two */
+#if (CLOCK_CONF_SECOND & (CLOCK_CONF_SECOND - 1)) != 0
+#error CLOCK_CONF_SECOND must be a power of two (i.e., 1, 2, 4, 8, 16, 32, 64, ...).
+#error Change CLOCK_CONF_SECOND in contiki-conf.h.
+#endif
+    if(count % CLOCK_CONF_SECOND == 0) {
+      ++seconds;
+      energest_flush();
+    }
+    last_tar = read_tar();
+  }
+}
+/*---------------------------------------------------------------------------*/
 ISR(TIMERA1, timera1)
 {
   ENERGEST_ON(ENERGEST_TYPE_IRQ);
@@ -68,31 +107,22 @@ ISR(TIMERA1, timera1)
   watchdog_start();
 
   if(TAIV == 2) {
+    tickless_stats.clock_interrupts++;
 
     /* HW timer bug fix: Interrupt handler called before TR==CCR.
      * Occurs when timer state is toggled between STOP and CONT. */
     while(TACTL & MC1 && TACCR1 - read_tar() == 1);
 
-    last_tar = read_tar();
-    /* Make sure interrupt time is future */
-    while(!CLOCK_LT(last_tar, TACCR1)) {
-      TACCR1 += INTERVAL;
-      ++count;
-
-      /* Make sure the CLOCK_CONF_SECOND is a power of two, to ensure
-         that the modulo operation below becomes a logical and and not
-         an expensive divide. Algorithm from Wikipedia:
-         http://en.wikipedia.org/wiki/Power_of_two */
-#if (CLOCK_CONF_SECOND & (CLOCK_CONF_SECOND - 1)) != 0
-#error CLOCK_CONF_SECOND must be a power of two (i.e., 1, 2, 4, 8, 16, 32, 64, ...).
-#error Change CLOCK_CONF_SECOND in contiki-conf.h.
-#endif
-      if(count % CLOCK_CONF_SECOND == 0) {
-        ++seconds;
-        energest_flush();
-      }
-      last_tar = read_tar();
+    update_count();
+    TACCR1 = next_tick;
+
+#if TICKLESS_ENABLED
+    if(sleeping) {
+      /* Have the idle loop set up the next sleep */
+      sleeping = 0;
+      LPM4_EXIT;
     }
+#endif /* TICKLESS_ENABLED */
 
     if(etimer_pending() &&
        (etimer_next_expiration_time() - count - 1) > MAX_TICKS) {
@@ -125,7 +155,8 @@ void
 clock_set(clock_time_t clock, clock_time_t fclock)
 {
   TAR = fclock;
-  TACCR1 = fclock + INTERVAL;
+  next_tick = fclock + INTERVAL;
+  TACCR1 = next_tick;
   count = clock;
 }
 /*---------------------------------------------------------------------------*/
@@ -172,7 +203,8 @@ clock_init(void)
   TACCTL1 = CCIE;
 
   /* Interrupt after X ms. */
-  TACCR1 = INTERVAL;
+  next_tick = INTERVAL;
+  TACCR1 = next_tick;
 
   /* Start Timer_A in continuous mode. */
   TACTL |= MC1;
@@ -228,6 +260,30 @@ clock_seconds(void)
   return t1;
 }
 /*---------------------------------------------------------------------------*/
+#if TICKLESS_ENABLED
+void
+tickless_arch_set_wakeup(clock_time_t ticks)
+{
+  if(ticks > MAX_SLEEP_TICKS) {
+    ticks = MAX_SLEEP_TICKS;
+  }
+  /* The deadline is ticks - 1 intervals after the next tick. If that
+     tick has already passed, its interrupt is pending and ends the
+     sleep right away. */
+  TACCR1 = next_tick + (ticks - 1) * INTERVAL;
+  sleeping = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+tickless_arch_resume(void)
+{
+  sleeping = 0;
+  update_count();
+  TACCR1 = next_tick;
+  tickless_poll_expired();
+}
+#endif /* TICKLESS_ENABLED */
+/*---------------------------------------------------------------------------*/
 rtimer_clock_t
 clock_counter(void)
 {
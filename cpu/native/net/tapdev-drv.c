@@ -45,6 +45,22 @@
 #define BUF ((struct uip_eth_hdr *)&uip_buf[0])
 #define IPBUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
 
+/* The number of frames handed to the stack per poll. */
+#ifdef TAPDEV_CONF_RX_BATCH
+#define TAPDEV_RX_BATCH TAPDEV_CONF_RX_BATCH
+#else
+#define TAPDEV_RX_BATCH 16
+#endif
+
+/* Set by platforms whose main loop dispatches select_set_callback()
+   callbacks, so that the driver is polled when the device is readable
+   rather than relying on the main loop to poll it every turn. */
+#ifdef TAPDEV_CONF_SELECT_CALLBACK
+#define TAPDEV_SELECT_CALLBACK TAPDEV_CONF_SELECT_CALLBACK
+#else
+#define TAPDEV_SELECT_CALLBACK 0
+#endif
+
 PROCESS(tapdev_process, "TAP driver");
 
 /*---------------------------------------------------------------------------*/
@@ -58,8 +74,8 @@ tapdev_output(void)
 }
 #endif
 /*---------------------------------------------------------------------------*/
-static void
-pollhandler(void)
+static int
+input(void)
 {
   uip_len = tapdev_poll();
 
@@ -85,9 +101,51 @@ pollhandler(void)
     } else {
       uip_clear_buf();
     }
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+pollhandler(void)
+{
+  int i;
+
+  /* Feed a burst of frames to the stack back-to-back instead of one
+     per main loop turn. If the batch is used up there may be more
+     frames waiting, so poll again after the other processes have
+     had a chance to run. */
+  for(i = 0; i < TAPDEV_RX_BATCH; i++) {
+    if(!input()) {
+      return;
+    }
+  }
+  process_poll(&tapdev_process);
+}
+/*---------------------------------------------------------------------------*/
+#if TAPDEV_SELECT_CALLBACK
+static int
+set_fd(fd_set *rset, fd_set *wset)
+{
+  if(tapdev_fd() < 0) {
+    return 0;
   }
+  FD_SET(tapdev_fd(), rset);
+  return 1;
 }
 /*---------------------------------------------------------------------------*/
+static void
+handle_fd(fd_set *rset, fd_set *wset)
+{
+  if(FD_ISSET(tapdev_fd(), rset)) {
+    process_poll(&tapdev_process);
+  }
+}
+static const struct select_callback tapdev_select_callback = {
+  set_fd, handle_fd
+};
+#endif /* TAPDEV_SELECT_CALLBACK */
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(tapdev_process, ev, data)
 {
   PROCESS_POLLHANDLER(pollhandler());
@@ -100,10 +158,20 @@ PROCESS_THREAD(tapdev_process, ev, data)
 #else
   tcpip_set_outputfunc(tapdev_send);
 #endif
+#if TAPDEV_SELECT_CALLBACK
+  if(tapdev_fd() >= 0) {
+    select_set_callback(tapdev_fd(), &tapdev_select_callback);
+  }
+#endif /* TAPDEV_SELECT_CALLBACK */
   process_poll(&tapdev_process);
 
   PROCESS_WAIT_UNTIL(ev == PROCESS_EVENT_EXIT);
 
+#if TAPDEV_SELECT_CALLBACK
+  if(tapdev_fd() >= 0) {
+    select_set_callback(tapdev_fd(), NULL);
+  }
+#endif /* TAPDEV_SELECT_CALLBACK */
   tapdev_exit();
 
   PROCESS_END();
@@ -43,6 +43,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -111,29 +112,23 @@ tapdev_fd(void)
 uint16_t
 tapdev_poll(void)
 {
-  fd_set fdset;
-  struct timeval tv;
   int ret;
-  
-  tv.tv_sec = 0;
-  tv.tv_usec = 0;
-  
-  FD_ZERO(&fdset);
-  if(fd > 0) {
-    FD_SET(fd, &fdset);
-  }
 
-  ret = select(fd + 1, &fdset, NULL, NULL, &tv);
-
-  if(ret == 0) {
+  if(fd <= 0) {
     return 0;
   }
+
+  /* The descriptor is non-blocking, so there is no need to select()
+     before every read. */
   ret = read(fd, uip_buf, UIP_BUFSIZE);
 
   PRINTF("tapdev6: read %d bytes (max %d)\n", ret, UIP_BUFSIZE);
-  
+
   if(ret == -1) {
-    perror("tapdev_poll: read");
+    if(errno != EAGAIN && errno != EWOULDBLOCK) {
+      perror("tapdev_poll: read");
+    }
+    return 0;
   }
   return ret;
 }
@@ -314,6 +309,9 @@ tapdev_init(void)
   }
 #endif /* Linux */
 
+  /* tapdev_poll() reads until the device has no more frames. */
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
 #ifdef __APPLE__
   tapdev_init_darwin_routes();
 #endif
@@ -369,6 +367,11 @@ do_send(void)
   ret = write(fd, uip_buf, uip_len);
 
   if(ret == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      /* The device queue is full: drop the frame as a NIC would. */
+      PRINTF("tapdev_send: queue full, frame dropped\n");
+      return;
+    }
     perror("tap_dev: tapdev_send: writev");
     exit(1);
   }
@@ -46,6 +46,19 @@
 #include "sys/rtimer.h"
 #include "sys/clock.h"
 
+#ifdef RTIMER_ARCH_CONF_TIMERFD
+#define RTIMER_ARCH_TIMERFD RTIMER_ARCH_CONF_TIMERFD
+#else
+#define RTIMER_ARCH_TIMERFD 0
+#endif
+
+#if RTIMER_ARCH_TIMERFD
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#endif /* RTIMER_ARCH_TIMERFD */
+
 #define DEBUG 0
 #if DEBUG
 #include <stdio.h>
@@ -54,6 +67,68 @@
 #define PRINTF(...)
 #endif
 
+#if RTIMER_ARCH_TIMERFD
+/* The rtimer is a timerfd that the main loop waits on together with
+   the other file descriptors, so that rtimer callbacks run in the
+   main loop rather than in signal context. */
+static int timerfd = -1;
+/*---------------------------------------------------------------------------*/
+static int
+timerfd_set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(timerfd, rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+timerfd_handle_fd(fd_set *rset, fd_set *wset)
+{
+  uint64_t expirations;
+
+  if(FD_ISSET(timerfd, rset)) {
+    if(read(timerfd, &expirations, sizeof(expirations)) > 0) {
+      rtimer_run_next();
+    }
+  }
+}
+static const struct select_callback timerfd_callback = {
+  timerfd_set_fd, timerfd_handle_fd
+};
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_init(void)
+{
+  timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(timerfd < 0) {
+    perror("rtimer_arch_init: timerfd_create");
+    return;
+  }
+  if(!select_set_callback(timerfd, &timerfd_callback)) {
+    fprintf(stderr, "rtimer_arch_init: timerfd %d out of range\n", timerfd);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_schedule(rtimer_clock_t t)
+{
+  struct itimerspec val;
+  rtimer_clock_t c;
+
+  c = t - (unsigned short)clock_time();
+
+  PRINTF("rtimer_arch_schedule time %u %u\n", t, c);
+
+  val.it_value.tv_sec = c / 1000;
+  val.it_value.tv_nsec = (c % 1000) * 1000000L;
+  if(c == 0) {
+    /* A zero value would disarm the timer. */
+    val.it_value.tv_nsec = 1;
+  }
+  val.it_interval.tv_sec = val.it_interval.tv_nsec = 0;
+  timerfd_settime(timerfd, 0, &val, NULL);
+}
+/*---------------------------------------------------------------------------*/
+#else /* RTIMER_ARCH_TIMERFD */
 /*---------------------------------------------------------------------------*/
 static void
 interrupt(int sig)
@@ -90,3 +165,4 @@ rtimer_arch_schedule(rtimer_clock_t t)
 #endif /* !_WIN32 */
 }
 /*---------------------------------------------------------------------------*/
+#endif /* RTIMER_ARCH_TIMERFD */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	A microbenchmark for the evaluation of query predicates in
+ *	the LVM, comparing the interpreted and compiled execution of
+ *	a set of predicates over synthetic tuples.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "contiki.h"
+#include "lib/random.h"
+
+#include "antelope.h"
+#include "lvm.h"
+
+#ifndef BENCHMARK_TUPLES
+#define BENCHMARK_TUPLES	1000000UL
+#endif
+
+#ifndef BENCHMARK_RELATION_TUPLES
+#define BENCHMARK_RELATION_TUPLES	1000
+#endif
+
+#define ROW_SIZE		6
+
+static const char *predicates[] = {
+  "a = 17",
+  "a > 100 AND b < 50",
+  "a > 10 * 10 AND b < 200 / 4 AND c = 3 + 4",
+  "a = 1 OR b = 2 OR c = 3 OR a + b > c",
+  "c > 1000 - 900 AND a < 20 OR b = 9 AND 1 = 1",
+};
+
+static unsigned char rows[256][ROW_SIZE];
+static unsigned char current_row[ROW_SIZE];
+static aql_adt_t adt;
+
+PROCESS(predicate_benchmark, "Predicate benchmark");
+AUTOSTART_PROCESSES(&predicate_benchmark);
+/*---------------------------------------------------------------------------*/
+static void
+generate_rows(void)
+{
+  int i;
+  int j;
+
+  for(i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+    for(j = 0; j < ROW_SIZE; j += 2) {
+      rows[i][j] = 0;
+      rows[i][j + 1] = random_rand() % 256;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+run_interpreted(lvm_instance_t *p, clock_time_t *elapsed)
+{
+  unsigned long i;
+  unsigned long matches;
+  unsigned char *row;
+  operand_value_t value;
+  clock_time_t start;
+
+  matches = 0;
+  start = clock_time();
+  for(i = 0; i < BENCHMARK_TUPLES; i++) {
+    memcpy(current_row, rows[i % (sizeof(rows) / sizeof(rows[0]))], ROW_SIZE);
+    row = current_row;
+    value.l = row[0] << 8 | row[1];
+    lvm_set_variable_value("a", value);
+    value.l = row[2] << 8 | row[3];
+    lvm_set_variable_value("b", value);
+    value.l = row[4] << 8 | row[5];
+    lvm_set_variable_value("c", value);
+    if(lvm_execute(p) == TRUE) {
+      matches++;
+    }
+  }
+  *elapsed = clock_time() - start;
+
+  return matches;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+run_compiled(lvm_instance_t *p, clock_time_t *elapsed)
+{
+  unsigned long i;
+  unsigned long matches;
+  clock_time_t start;
+
+  /* Bind the variables once, as is done when processing a relation. */
+  lvm_bind_variable("a", current_row, 2);
+  lvm_bind_variable("b", current_row + 2, 2);
+  lvm_bind_variable("c", current_row + 4, 2);
+
+  matches = 0;
+  start = clock_time();
+  for(i = 0; i < BENCHMARK_TUPLES; i++) {
+    memcpy(current_row, rows[i % (sizeof(rows) / sizeof(rows[0]))], ROW_SIZE);
+    if(lvm_execute(p) == TRUE) {
+      matches++;
+    }
+  }
+  *elapsed = clock_time() - start;
+
+  return matches;
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark_lvm(const char *predicate)
+{
+  char query[AQL_MAX_QUERY_LENGTH];
+  lvm_instance_t *p;
+  unsigned long interpreted_matches;
+  unsigned long compiled_matches;
+  clock_time_t interpreted_time;
+  clock_time_t compiled_time;
+
+  snprintf(query, sizeof(query), "SELECT a FROM r WHERE %s;", predicate);
+  if(AQL_ERROR(aql_parse(&adt, query)) || adt.lvm_instance == NULL) {
+    printf("Failed to parse \"%s\"\n", predicate);
+    return;
+  }
+  p = adt.lvm_instance;
+
+  interpreted_matches = run_interpreted(p, &interpreted_time);
+
+  if(LVM_ERROR(lvm_compile(p))) {
+    printf("Failed to compile \"%s\"\n", predicate);
+    return;
+  }
+  compiled_matches = run_compiled(p, &compiled_time);
+
+  printf("%-48s interpreted %5lu ms, compiled %5lu ms, matches %lu/%lu%s\n",
+         predicate,
+         (unsigned long)(interpreted_time * 1000 / CLOCK_SECOND),
+         (unsigned long)(compiled_time * 1000 / CLOCK_SECOND),
+         interpreted_matches, compiled_matches,
+         interpreted_matches == compiled_matches ? "" : " MISMATCH");
+}
+/*---------------------------------------------------------------------------*/
+static void
+query(const char *query_string)
+{
+  db_result_t result;
+
+  result = db_query(NULL, query_string);
+  if(DB_ERROR(result)) {
+    printf("Query \"%s\" failed: %s\n", query_string,
+           db_get_result_message(result));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+benchmark_select(const char *predicate)
+{
+  static db_handle_t handle;
+  db_result_t result;
+  unsigned long matches;
+  clock_time_t start;
+
+  start = clock_time();
+  result = db_query(&handle, "SELECT a, b, c FROM r WHERE %s;", predicate);
+  if(DB_ERROR(result)) {
+    printf("Query failed: %s\n", db_get_result_message(result));
+    return;
+  }
+
+  matches = 0;
+  while(db_processing(&handle)) {
+    result = db_process(&handle);
+    if(result == DB_GOT_ROW) {
+      matches++;
+    } else if(result == DB_FINISHED || DB_ERROR(result)) {
+      break;
+    }
+  }
+  db_free(&handle);
+
+  printf("%-48s %5lu ms, %lu of %u tuples\n", predicate,
+         (unsigned long)((clock_time() - start) * 1000 / CLOCK_SECOND),
+         matches, BENCHMARK_RELATION_TUPLES);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(predicate_benchmark, ev, data)
+{
+  static int i;
+  char insert[AQL_MAX_QUERY_LENGTH];
+  unsigned char *row;
+
+  PROCESS_BEGIN();
+
+  db_init();
+  generate_rows();
+
+  printf("LVM predicate evaluation over %lu synthetic tuples\n",
+         BENCHMARK_TUPLES);
+  for(i = 0; i < sizeof(predicates) / sizeof(predicates[0]); i++) {
+    benchmark_lvm(predicates[i]);
+  }
+
+  query("REMOVE RELATION r;");
+  query("CREATE RELATION r;");
+  query("CREATE ATTRIBUTE a DOMAIN INT IN r;");
+  query("CREATE ATTRIBUTE b DOMAIN INT IN r;");
+  query("CREATE ATTRIBUTE c DOMAIN INT IN r;");
+  for(i = 0; i < BENCHMARK_RELATION_TUPLES; i++) {
+    row = rows[i % (sizeof(rows) / sizeof(rows[0]))];
+    snprintf(insert, sizeof(insert), "INSERT (%u, %u, %u) INTO r;",
+             row[1], row[3], row[5]);
+    query(insert);
+  }
+
+  printf("SELECT over a relation with %u tuples\n", BENCHMARK_RELATION_TUPLES);
+  for(i = 0; i < sizeof(predicates) / sizeof(predicates[0]); i++) {
+    benchmark_select(predicates[i]);
+  }
+
+  query("REMOVE RELATION r;");
+  printf("Benchmark finished\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
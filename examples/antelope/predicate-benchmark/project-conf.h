@@ -0,0 +1,8 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* The benchmark is intended for the native platform, which
+   uses the POSIX file system instead of Coffee. */
+#define DB_FEATURE_COFFEE	0
+
+#endif /* PROJECT_CONF_H_ */
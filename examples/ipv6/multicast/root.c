@@ -52,8 +52,27 @@
 
 #define MAX_PAYLOAD_LEN 120
 #define MCAST_SINK_UDP_PORT 3001 /* Host byte order */
+
+/* Rate and number of messages. Raise the rate for throughput experiments */
+#ifdef MCAST_CONF_SEND_INTERVAL
+#define SEND_INTERVAL MCAST_CONF_SEND_INTERVAL
+#else
 #define SEND_INTERVAL CLOCK_SECOND /* clock ticks */
+#endif
+
+#ifdef MCAST_CONF_ITERATIONS
+#define ITERATIONS MCAST_CONF_ITERATIONS
+#else
 #define ITERATIONS 100 /* messages */
+#endif
+
+/* Copies of each message. More than one replays it, to exercise the
+ * duplicate detection of the engine */
+#ifdef MCAST_CONF_COPIES
+#define COPIES MCAST_CONF_COPIES
+#else
+#define COPIES 1
+#endif
 
 /* Start sending messages START_DELAY secs after we start so that routing can
  * converge */
@@ -75,6 +94,7 @@ static void
 multicast_send(void)
 {
   uint32_t id;
+  uint8_t i;
 
   id = uip_htonl(seq_id);
   memset(buf, 0, MAX_PAYLOAD_LEN);
@@ -87,7 +107,9 @@ multicast_send(void)
   PRINTF(" %lu bytes\n", (unsigned long)sizeof(id));
 
   seq_id++;
-  uip_udp_packet_send(mcast_conn, buf, sizeof(id));
+  for(i = 0; i < COPIES; i++) {
+    uip_udp_packet_send(mcast_conn, buf, sizeof(id));
+  }
 }
 /*---------------------------------------------------------------------------*/
 static void
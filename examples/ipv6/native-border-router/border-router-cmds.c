@@ -50,7 +50,7 @@
 
 uint8_t command_context;
 
-void packet_sent(uint8_t sessionid, uint8_t status, uint8_t tx);
+void packet_sent(int radio, uint8_t sessionid, uint8_t status, uint8_t tx);
 void nbr_print_stat(void);
 
 /*---------------------------------------------------------------------------*/
@@ -72,18 +72,32 @@ border_router_cmd_handler(const uint8_t *data, int len)
       return 1;
     } else if(data[1] == 'M' && command_context == CMD_CONTEXT_RADIO) {
       /* We need to know that this is from the slip-radio here. */
-      PRINTF("Setting MAC address\n");
-      border_router_set_mac(&data[2]);
+      if(slip_radio_current() == 0) {
+        /* The other radios are given the address of the first one */
+        PRINTF("Setting MAC address\n");
+        border_router_set_mac(&data[2]);
+      }
       return 1;
     } else if(data[1] == 'C' && command_context == CMD_CONTEXT_RADIO) {
       /* We need to know that this is from the slip-radio here. */
-      printf("Channel is:%d\n", data[2]);
+      if(slip_radio_count() > 1) {
+        printf("Radio %d channel is:%d\n", slip_radio_current(), data[2]);
+      } else {
+        printf("Channel is:%d\n", data[2]);
+      }
       return 1;
     } else if(data[1] == 'R' && command_context == CMD_CONTEXT_RADIO) {
       /* We need to know that this is from the slip-radio here. */
       PRINTF("Packet data report for sid:%d st:%d tx:%d\n",
 	     data[2], data[3], data[4]);
-      packet_sent(data[2], data[3], data[4]);
+      packet_sent(slip_radio_current(), data[2], data[3], data[4]);
+      return 1;
+    } else if(data[1] == 'W' && command_context == CMD_CONTEXT_RADIO) {
+      /* The radio supports the windowed protocol */
+      if(len >= 5) {
+        border_router_rdc_set_window(slip_radio_current(), data[2],
+                                     (data[3] << 8) | data[4]);
+      }
       return 1;
     } else if(data[1] == 'D' && command_context == CMD_CONTEXT_RADIO) {
       /* We need to know that this is from the slip-radio here... */
@@ -107,8 +121,17 @@ border_router_cmd_handler(const uint8_t *data, int len)
       cmd_send(buf, 18);
       return 1;
     } else if(data[1] == 'C' && command_context == CMD_CONTEXT_STDIO) {
-      /* send on! */
-      write_to_slip(data, len);
+      /* send on! "?C" goes to the first radio, "?C<n>" to radio n */
+      int radio = 0;
+      int j;
+      for(j = 2; j < len && data[j] >= '0' && data[j] <= '9'; j++) {
+        radio = radio * 10 + data[j] - '0';
+      }
+      if(radio >= slip_radio_count()) {
+        printf("No radio %d\n", radio);
+      } else {
+        write_to_radio(radio, data, 2);
+      }
       return 1;
     } else if(data[1] == 'S') {
       border_router_print_stat();
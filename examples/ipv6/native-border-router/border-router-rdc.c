@@ -30,7 +30,8 @@
 /**
  * \file
  *         A null RDC implementation that uses framer for headers and sends
- *         the packets over slip instead of radio.
+ *         the packets over slip instead of radio. Several slip-radios
+ *         can be used, each on its own channel or PAN.
  * \author
  *         Adam Dunkels <adam@sics.se>
  *         Joakim Eriksson <joakime@sics.se>
@@ -40,21 +41,49 @@
 #include "net/packetbuf.h"
 #include "net/queuebuf.h"
 #include "net/netstack.h"
+#include "net/nbr-table.h"
+#include "net/ipv6/uip-ds6-nbr.h"
+#include "net/mac/frame802154.h"
+#include "net/mac/mac-sequence.h"
 #include "packetutils.h"
 #include "border-router.h"
+#include <stdio.h>
 #include <string.h>
 
 #define DEBUG 0
 #if DEBUG
-#include <stdio.h>
 #define PRINTF(...) printf(__VA_ARGS__)
 #else
 #define PRINTF(...)
 #endif
 
+extern struct slip_config_radio slip_config_radios[];
+extern int slip_config_radio_count;
+
+/* Must divide 256: session ids step by MAX_CALLBACKS per slot */
 #define MAX_CALLBACKS 16
 static int callback_pos;
 
+/* How long to wait for a radio with the windowed protocol to report
+   on a frame before giving up on it. Radios with the original protocol
+   report on every frame once their MAC is done with it, which can take
+   much longer, so their frames do not time out. */
+#ifdef BORDER_ROUTER_CONF_RADIO_TIMEOUT
+#define RADIO_TIMEOUT BORDER_ROUTER_CONF_RADIO_TIMEOUT
+#else
+#define RADIO_TIMEOUT (2 * CLOCK_SECOND)
+#endif
+
+#define FRAME_MAX_LEN (PACKETBUF_NUM_ATTRS * 3 + 1 + PACKETBUF_SIZE)
+#define BATCH_MAX_LEN (PACKETUTILS_BATCH_HDR_LEN + \
+                       MAX_CALLBACKS * (PACKETUTILS_BATCH_FRAME_HDR_LEN + \
+                                        FRAME_MAX_LEN) + \
+                       PACKETUTILS_BATCH_CRC_LEN)
+
+#define TX_FREE    0
+#define TX_PENDING 1 /* Waiting for room in the radio window */
+#define TX_SENT    2 /* Sent to the radio, waiting for its report */
+
 /* a structure for calling back when packet data is coming back
    from radio... */
 struct tx_callback {
@@ -62,31 +91,289 @@ struct tx_callback {
   void *ptr;
   struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
   struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+  uint8_t state;
+  uint8_t radio;
+  /* Session id sent to the radio; sid % MAX_CALLBACKS is the slot */
+  uint8_t sid;
+  clock_time_t sent;
+  /* Only used with the windowed protocol */
+  uint16_t len;
+  uint8_t data[FRAME_MAX_LEN];
 };
 
 static struct tx_callback callbacks[MAX_CALLBACKS];
+
+struct radio_state {
+  /* The number of frames the radio accepts before reporting on them,
+     or zero if the radio only supports the original protocol. */
+  uint8_t window;
+  uint16_t mtu;
+  uint8_t outstanding;
+};
+static struct radio_state radios[BORDER_ROUTER_MAX_RADIOS];
+
+/* The radio that a neighbor was last heard on */
+struct radio_affinity {
+  uint8_t radio;
+};
+NBR_TABLE(struct radio_affinity, radio_affinity);
+
+static struct ctimer timeout_timer;
+
+static void send_pending(int radio);
+/*---------------------------------------------------------------------------*/
+static const struct slip_config_radio *
+radio_config(int radio)
+{
+  /* A radio connected over TCP or found by probing */
+  static const struct slip_config_radio default_config = { NULL, -1, -1 };
+
+  if(radio < slip_config_radio_count) {
+    return &slip_config_radios[radio];
+  }
+  return &default_config;
+}
 /*---------------------------------------------------------------------------*/
-void packet_sent(uint8_t sessionid, uint8_t status, uint8_t tx)
+/* Radios on the same channel and PAN reach the same nodes. */
+static int
+same_network(int a, int b)
 {
-  if(sessionid < MAX_CALLBACKS) {
-    struct tx_callback *callback;
-    callback = &callbacks[sessionid];
-    packetbuf_clear();
-    packetbuf_attr_copyfrom(callback->attrs, callback->addrs);
-    mac_call_sent_callback(callback->cback, callback->ptr, status, tx);
+  return radio_config(a)->channel == radio_config(b)->channel &&
+    radio_config(a)->pan_id == radio_config(b)->pan_id;
+}
+/*---------------------------------------------------------------------------*/
+/* The number of frames queued for a radio that it has not reported on */
+static int
+radio_load(int radio)
+{
+  int load;
+  int i;
+
+  load = 0;
+  for(i = 0; i < MAX_CALLBACKS; i++) {
+    if(callbacks[i].state != TX_FREE && callbacks[i].radio == radio) {
+      load++;
+    }
+  }
+  return load;
+}
+/*---------------------------------------------------------------------------*/
+/* The least loaded radio, among those in the same network as the given
+   radio or, if radio is negative, among all of them. */
+static int
+least_loaded(int radio)
+{
+  int best;
+  int load;
+  int best_load;
+  int i;
+
+  best = radio < 0 ? 0 : radio;
+  best_load = radio_load(best);
+  for(i = 0; i < slip_radio_count() && best_load > 0; i++) {
+    if(radio < 0 || same_network(i, radio)) {
+      load = radio_load(i);
+      if(load < best_load) {
+        best = i;
+        best_load = load;
+      }
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report_sent(struct tx_callback *callback, uint8_t status, uint8_t tx)
+{
+  if(status == MAC_TX_OK) {
+    slip_radio_stats[callback->radio].tx++;
   } else {
-    PRINTF("*** ERROR: too high session id %d\n", sessionid);
+    slip_radio_stats[callback->radio].tx_errors++;
   }
+  packetbuf_clear();
+  packetbuf_attr_copyfrom(callback->attrs, callback->addrs);
+  mac_call_sent_callback(callback->cback, callback->ptr, status, tx);
+}
+/*---------------------------------------------------------------------------*/
+void
+packet_sent(int radio, uint8_t sessionid, uint8_t status, uint8_t tx)
+{
+  struct tx_callback *callback;
+
+  callback = &callbacks[sessionid % MAX_CALLBACKS];
+  if(callback->state != TX_SENT || callback->radio != radio ||
+     callback->sid != sessionid) {
+    /* Already timed out, or the session has been reused since */
+    PRINTF("br-rdc: stale report from radio %d for sid %d\n",
+           radio, sessionid);
+    return;
+  }
+  callback->state = TX_FREE;
+  radios[radio].outstanding--;
+  report_sent(callback, status, tx);
+  if(radios[radio].window > 0) {
+    send_pending(radio);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+check_timeouts(void *ptr)
+{
+  struct tx_callback *callback;
+  int i;
+
+  for(i = 0; i < MAX_CALLBACKS; i++) {
+    callback = &callbacks[i];
+    if(callback->state == TX_SENT &&
+       radios[callback->radio].window > 0 &&
+       clock_time() - callback->sent >= RADIO_TIMEOUT) {
+      PRINTF("br-rdc: no report from radio %d for sid %d\n",
+             callback->radio, callback->sid);
+      callback->state = TX_FREE;
+      radios[callback->radio].outstanding--;
+      report_sent(callback, MAC_TX_ERR, 1);
+    }
+  }
+  for(i = 0; i < slip_radio_count(); i++) {
+    if(radios[i].window > 0) {
+      send_pending(i);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+mark_sent(int sid)
+{
+  callbacks[sid].state = TX_SENT;
+  callbacks[sid].sent = clock_time();
+  radios[callbacks[sid].radio].outstanding++;
+  if(radios[callbacks[sid].radio].window > 0 &&
+     ctimer_expired(&timeout_timer)) {
+    ctimer_set(&timeout_timer, RADIO_TIMEOUT / 2, check_timeouts, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Send as many pending frames as the radio window allows, in the order
+   they were queued, batching those that fit in one radio command. */
+static void
+send_pending(int radio)
+{
+  static uint8_t buf[BATCH_MAX_LEN];
+  struct radio_state *r;
+  struct tx_callback *callback;
+  int pos;
+  int count;
+  int sid;
+  int i;
+
+  r = &radios[radio];
+  pos = PACKETUTILS_BATCH_HDR_LEN;
+  count = 0;
+  for(i = 0; i < MAX_CALLBACKS && r->outstanding < r->window; i++) {
+    /* callback_pos is the oldest slot */
+    sid = (callback_pos + i) % MAX_CALLBACKS;
+    callback = &callbacks[sid];
+    if(callback->state != TX_PENDING || callback->radio != radio) {
+      continue;
+    }
+
+    if(PACKETUTILS_BATCH_HDR_LEN + PACKETUTILS_BATCH_FRAME_HDR_LEN +
+       callback->len + PACKETUTILS_BATCH_CRC_LEN > r->mtu) {
+      /* Too large to be batched: send it on its own after what has
+         been batched so far. */
+      if(count > 0) {
+        break;
+      }
+      buf[0] = '!';
+      buf[1] = 'S';
+      buf[2] = callback->sid;
+      memcpy(&buf[3], callback->data, callback->len);
+      write_to_radio(radio, buf, callback->len + 3);
+    } else {
+      if(pos + PACKETUTILS_BATCH_FRAME_HDR_LEN + callback->len +
+         PACKETUTILS_BATCH_CRC_LEN > r->mtu) {
+        break;
+      }
+      buf[pos++] = callback->sid;
+      buf[pos++] = callback->len >> 8;
+      buf[pos++] = callback->len & 0xff;
+      memcpy(&buf[pos], callback->data, callback->len);
+      pos += callback->len;
+      count++;
+    }
+    mark_sent(sid);
+  }
+
+  if(count > 0) {
+    buf[0] = '!';
+    buf[1] = 'B';
+    buf[2] = count;
+    packetutils_batch_add_crc(buf, pos);
+    write_to_radio(radio, buf, pos + PACKETUTILS_BATCH_CRC_LEN);
+    if(i < MAX_CALLBACKS && r->outstanding < r->window) {
+      /* Stopped at a frame that did not fit: continue with it. */
+      send_pending(radio);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+border_router_rdc_set_window(int radio, uint8_t window, uint16_t mtu)
+{
+  if(radio < 0 || radio >= slip_radio_count()) {
+    return;
+  }
+  if(window > MAX_CALLBACKS) {
+    window = MAX_CALLBACKS;
+  }
+  if(mtu > BATCH_MAX_LEN) {
+    mtu = BATCH_MAX_LEN;
+  }
+  printf("Radio %d window %u frames, %u bytes per command\n",
+         radio, window, mtu);
+  radios[radio].window = window;
+  radios[radio].mtu = mtu;
+  if(window > 0) {
+    /* The window keeps the radio from being overrun. */
+    slip_set_send_delay(radio, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+border_router_rdc_get_window(int radio, uint8_t *outstanding)
+{
+  if(outstanding != NULL) {
+    *outstanding = radios[radio].outstanding;
+  }
+  return radios[radio].window;
 }
 /*---------------------------------------------------------------------------*/
 static int
-setup_callback(mac_callback_t sent, void *ptr)
+setup_callback(int radio, mac_callback_t sent, void *ptr)
 {
   struct tx_callback *callback;
   int tmp = callback_pos;
   callback = &callbacks[callback_pos];
+  if(callback->state == TX_SENT && radios[callback->radio].window == 0) {
+    /* The radio has not reported on the frame that used the session
+       MAX_CALLBACKS frames ago; as with the original protocol, the
+       session is reused and the report is taken as lost. */
+    PRINTF("br-rdc: no report from radio %d for sid %d\n",
+           callback->radio, callback->sid);
+    slip_radio_stats[callback->radio].tx_errors++;
+    radios[callback->radio].outstanding--;
+    callback->state = TX_FREE;
+  }
+  if(callback->state != TX_FREE) {
+    /* All sessions are in use */
+    return -1;
+  }
   callback->cback = sent;
   callback->ptr = ptr;
+  callback->radio = radio;
+  /* A new session id for the slot, so that a late report for its
+     previous frame is not taken for this one. */
+  callback->sid += MAX_CALLBACKS;
   packetbuf_attr_copyto(callback->attrs, callback->addrs);
 
   callback_pos++;
@@ -98,19 +385,24 @@ setup_callback(mac_callback_t sent, void *ptr)
 }
 /*---------------------------------------------------------------------------*/
 static void
-send_packet(mac_callback_t sent, void *ptr)
+send_to_radio(int radio, mac_callback_t sent, void *ptr)
 {
   int size;
   /* 3 bytes per packet attribute is required for serialization */
   uint8_t buf[PACKETBUF_NUM_ATTRS * 3 + PACKETBUF_SIZE + 3];
-  uint8_t sid;
+  uint16_t pan_id;
+  int ret;
+  int sid;
 
-  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
-
-  /* ack or not ? */
-  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+  /* The frame carries the PAN ID of the radio */
+  pan_id = frame802154_get_pan_id();
+  if(radio_config(radio)->pan_id >= 0) {
+    frame802154_set_pan_id(radio_config(radio)->pan_id);
+  }
+  ret = NETSTACK_FRAMER.create();
+  frame802154_set_pan_id(pan_id);
 
-  if(NETSTACK_FRAMER.create() < 0) {
+  if(ret < 0) {
     /* Failed to allocate space for headers */
     PRINTF("br-rdc: send failed, too large header\n");
     mac_call_sent_callback(sent, ptr, MAC_TX_ERR_FATAL, 1);
@@ -124,17 +416,83 @@ send_packet(mac_callback_t sent, void *ptr)
     if(size < 0 || size + packetbuf_totlen() + 3 > sizeof(buf)) {
       PRINTF("br-rdc: send failed, too large header\n");
       mac_call_sent_callback(sent, ptr, MAC_TX_ERR_FATAL, 1);
+    } else if((sid = setup_callback(radio, sent, ptr)) < 0) {
+      PRINTF("br-rdc: send failed, radio window full\n");
+      mac_call_sent_callback(sent, ptr, MAC_TX_ERR, 1);
+    } else if(radios[radio].window > 0) {
+      /* Queue the frame until there is room in the radio window */
+      callbacks[sid].len = size + packetbuf_totlen();
+      memcpy(callbacks[sid].data, &buf[3], size);
+      memcpy(&callbacks[sid].data[size], packetbuf_hdrptr(),
+             packetbuf_totlen());
+      callbacks[sid].state = TX_PENDING;
+      send_pending(radio);
     } else {
-      sid = setup_callback(sent, ptr);
-
       buf[0] = '!';
       buf[1] = 'S';
-      buf[2] = sid; /* sequence or session number for this packet */
+      buf[2] = callbacks[sid].sid; /* session number for this packet */
 
       /* Copy packet data */
       memcpy(&buf[3 + size], packetbuf_hdrptr(), packetbuf_totlen());
 
-      write_to_slip(buf, packetbuf_totlen() + size + 3);
+      write_to_radio(radio, buf, packetbuf_totlen() + size + 3);
+      mark_sent(sid);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_packet(mac_callback_t sent, void *ptr)
+{
+  static uint8_t data[PACKETBUF_SIZE];
+  static struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  static struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+  struct radio_affinity *affinity;
+  int first;
+  int len;
+  int i;
+  int j;
+
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &linkaddr_node_addr);
+
+  /* ack or not ? */
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+
+  if(slip_radio_count() <= 1) {
+    send_to_radio(0, sent, ptr);
+
+  } else if(!packetbuf_holds_broadcast()) {
+    /* Unicast on the network the neighbor was heard on, or on any
+       radio if it has not been heard yet */
+    affinity = nbr_table_get_from_lladdr(radio_affinity,
+                                         packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+    send_to_radio(least_loaded(affinity != NULL ? affinity->radio : -1),
+                  sent, ptr);
+
+  } else {
+    /* Broadcast once on every network, on its least loaded radio. Only
+       the first copy is reported back to the MAC layer. */
+    len = packetbuf_copyto(data);
+    packetbuf_attr_copyto(attrs, addrs);
+    first = 1;
+    for(i = 0; i < slip_radio_count(); i++) {
+      for(j = 0; j < i; j++) {
+        if(same_network(i, j)) {
+          break;
+        }
+      }
+      if(j < i) {
+        /* Already sent on this network */
+        continue;
+      }
+      if(first) {
+        send_to_radio(least_loaded(i), sent, ptr);
+        first = 0;
+      } else {
+        packetbuf_copyfrom(data, len);
+        packetbuf_attr_copyfrom(attrs, addrs);
+        send_to_radio(least_loaded(i), NULL, NULL);
+      }
     }
   }
 }
@@ -148,11 +506,63 @@ send_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Remember the radio that a neighbor was heard on. Only neighbors that
+   the IPv6 layer knows are tracked so that overheard nodes do not take
+   up room in the neighbor table. */
+static void
+update_affinity(const linkaddr_t *addr, int radio)
+{
+  struct radio_affinity *affinity;
+
+  if(nbr_table_get_from_lladdr(ds6_neighbors, addr) == NULL) {
+    return;
+  }
+  affinity = nbr_table_get_from_lladdr(radio_affinity, addr);
+  if(affinity == NULL) {
+    affinity = nbr_table_add_lladdr(radio_affinity, addr,
+                                    NBR_TABLE_REASON_MAC, NULL);
+  }
+  if(affinity != NULL) {
+    affinity->radio = radio;
+  }
+}
+/*---------------------------------------------------------------------------*/
 static void
 packet_input(void)
 {
-  if(NETSTACK_FRAMER.parse() < 0) {
+  linkaddr_t sender;
+  uint16_t pan_id;
+  int radio;
+  int ret;
+
+  radio = slip_radio_current();
+  slip_radio_stats[radio].rx++;
+
+  pan_id = frame802154_get_pan_id();
+  if(radio_config(radio)->pan_id >= 0) {
+    frame802154_set_pan_id(radio_config(radio)->pan_id);
+  }
+  ret = NETSTACK_FRAMER.parse();
+  frame802154_set_pan_id(pan_id);
+
+  if(ret < 0) {
     PRINTF("br-rdc: failed to parse %u\n", packetbuf_datalen());
+    return;
+  }
+
+  if(slip_radio_count() > 1) {
+    /* Radios on the same network hear the same frames */
+    if(mac_sequence_is_duplicate()) {
+      slip_radio_stats[radio].rx_duplicates++;
+      return;
+    }
+    mac_sequence_register_seqno();
+
+    linkaddr_copy(&sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    update_affinity(&sender, radio);
+    NETSTACK_MAC.input();
+    /* The frame may have made the sender a neighbor */
+    update_affinity(&sender, radio);
   } else {
     NETSTACK_MAC.input();
   }
@@ -179,7 +589,14 @@ channel_check_interval(void)
 static void
 init(void)
 {
+  int i;
+
   callback_pos = 0;
+  for(i = 0; i < MAX_CALLBACKS; i++) {
+    callbacks[i].sid = i;
+  }
+  memset(radios, 0, sizeof(radios));
+  nbr_table_register(radio_affinity, NULL);
 }
 /*---------------------------------------------------------------------------*/
 const struct rdc_driver border_router_rdc_driver = {
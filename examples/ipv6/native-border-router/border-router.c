@@ -76,6 +76,8 @@ static char sensors[MAX_SENSORS][32];
 extern int contiki_argc;
 extern char **contiki_argv;
 extern const char *slip_config_ipaddr;
+extern struct slip_config_radio slip_config_radios[];
+extern int slip_config_radio_count;
 
 CMD_HANDLERS(border_router_cmd_handler);
 
@@ -200,6 +202,63 @@ PT_THREAD(generate_routes(struct httpd_state *s))
     SEND_STRING(&s->sout, buf);
   }
 
+  if(slip_radio_count() > 1) {
+    blen = 0;
+    ADD("<a href=\"radios\">Radios</a>\n");
+    SEND_STRING(&s->sout, buf);
+  }
+
+  SEND_STRING(&s->sout, BOTTOM);
+
+  PSOCK_END(&s->sout);
+}
+/*---------------------------------------------------------------------------*/
+static void
+radio_add(int radio)
+{
+  const struct slip_radio_stats *stats = &slip_radio_stats[radio];
+  uint8_t outstanding;
+  int window;
+
+  ADD("%d", radio);
+  if(radio < slip_config_radio_count) {
+    ADD(" %s", slip_config_radios[radio].siodev);
+    if(slip_config_radios[radio].channel >= 0) {
+      ADD(" channel %d", slip_config_radios[radio].channel);
+    }
+    if(slip_config_radios[radio].pan_id >= 0) {
+      ADD(" pan %04x", slip_config_radios[radio].pan_id);
+    }
+  }
+  ADD(": rx %lu (%lu dup) tx %lu (%lu err)", stats->rx, stats->rx_duplicates,
+      stats->tx, stats->tx_errors);
+  window = border_router_rdc_get_window(radio, &outstanding);
+  if(window > 0) {
+    ADD(" window %u/%d", outstanding, window);
+  }
+  ADD("\n");
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_radios(struct httpd_state *s))
+{
+  static int i;
+
+  PSOCK_BEGIN(&s->sout);
+
+  SEND_STRING(&s->sout, TOP);
+
+  blen = 0;
+  ADD("Radios<pre>");
+  SEND_STRING(&s->sout, buf);
+  for(i = 0; i < slip_radio_count(); i++) {
+    blen = 0;
+    radio_add(i);
+    SEND_STRING(&s->sout, buf);
+  }
+  blen = 0;
+  ADD("</pre>");
+  SEND_STRING(&s->sout, buf);
 
   SEND_STRING(&s->sout, BOTTOM);
 
@@ -209,6 +268,9 @@ PT_THREAD(generate_routes(struct httpd_state *s))
 httpd_simple_script_t
 httpd_simple_get_script(const char *name)
 {
+  if(strcmp(name, "radios") == 0) {
+    return generate_radios;
+  }
   return generate_routes;
 }
 
@@ -239,6 +301,51 @@ request_mac(void)
   write_to_slip((uint8_t *)"?M", 2);
 }
 /*---------------------------------------------------------------------------*/
+static void
+request_window(void)
+{
+  int i;
+
+  /* Radios that do not answer keep using the original protocol */
+  for(i = 0; i < slip_radio_count(); i++) {
+    write_to_radio(i, (uint8_t *)"?W", 2);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+configure_radios(void)
+{
+  uint8_t buf[10];
+  int i;
+
+  for(i = 0; i < slip_radio_count(); i++) {
+    if(i > 0) {
+      /* All radios use the address of the first one so that nodes see
+         a single border router */
+      buf[0] = '!';
+      buf[1] = 'M';
+      memcpy(&buf[2], uip_lladdr.addr, 8);
+      write_to_radio(i, buf, 10);
+    }
+    if(i >= slip_config_radio_count) {
+      continue;
+    }
+    if(slip_config_radios[i].channel >= 0) {
+      buf[0] = '!';
+      buf[1] = 'C';
+      buf[2] = slip_config_radios[i].channel;
+      write_to_radio(i, buf, 3);
+    }
+    if(slip_config_radios[i].pan_id >= 0) {
+      buf[0] = '!';
+      buf[1] = 'P';
+      buf[2] = slip_config_radios[i].pan_id >> 8;
+      buf[3] = slip_config_radios[i].pan_id & 0xff;
+      write_to_radio(i, buf, 4);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
 void
 border_router_set_mac(const uint8_t *data)
 {
@@ -256,8 +363,20 @@ border_router_set_mac(const uint8_t *data)
 void
 border_router_print_stat()
 {
+  const struct slip_radio_stats *stats;
+  int i;
+
   printf("bytes received over SLIP: %ld\n", slip_received);
   printf("bytes sent over SLIP: %ld\n", slip_sent);
+  if(slip_radio_count() > 1) {
+    for(i = 0; i < slip_radio_count(); i++) {
+      stats = &slip_radio_stats[i];
+      printf("radio %d: %ld bytes received, %ld bytes sent, "
+             "rx %lu (%lu dup) tx %lu (%lu err)\n", i,
+             stats->bytes_received, stats->bytes_sent,
+             stats->rx, stats->rx_duplicates, stats->tx, stats->tx_errors);
+    }
+  }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -325,6 +444,8 @@ PROCESS_THREAD(border_router_process, ev, data)
     request_mac();
     PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
   }
+  configure_radios();
+  request_window();
 
   if(slip_config_ipaddr != NULL) {
     uip_ipaddr_t prefix;
@@ -41,9 +41,39 @@
 #include "net/ip/uip.h"
 #include <stdio.h>
 
+/* The number of slip-radios that one border router can drive */
+#ifdef BORDER_ROUTER_CONF_MAX_RADIOS
+#define BORDER_ROUTER_MAX_RADIOS BORDER_ROUTER_CONF_MAX_RADIOS
+#else
+#define BORDER_ROUTER_MAX_RADIOS 4
+#endif
+
+/* A slip-radio given on the command line as siodev[:channel[:panid]] */
+struct slip_config_radio {
+  const char *siodev;
+  int channel;	/* -1 to keep the channel of the radio */
+  int pan_id;	/* -1 for the default PAN ID */
+};
+
+struct slip_radio_stats {
+  long bytes_sent;
+  long bytes_received;
+  unsigned long rx;
+  unsigned long rx_duplicates;
+  unsigned long tx;
+  unsigned long tx_errors;
+};
+extern struct slip_radio_stats slip_radio_stats[BORDER_ROUTER_MAX_RADIOS];
+
 int border_router_cmd_handler(const uint8_t *data, int len);
 int slip_config_handle_arguments(int argc, char **argv);
 void write_to_slip(const uint8_t *buf, int len);
+void write_to_radio(int radio, const uint8_t *buf, int len);
+void slip_set_send_delay(int radio, clock_time_t delay);
+int slip_radio_count(void);
+int slip_radio_current(void);
+void border_router_rdc_set_window(int radio, uint8_t window, uint16_t mtu);
+int border_router_rdc_get_window(int radio, uint8_t *outstanding);
 
 void border_router_set_prefix_64(const uip_ipaddr_t *prefix_64);
 void border_router_set_mac(const uint8_t *data);
@@ -52,8 +82,6 @@ void border_router_print_stat(void);
 
 void tun_init(void);
 
-int slip_init(void);
-int slip_set_fd(int maxfd, fd_set *rset, fd_set *wset);
-void slip_handle_fd(fd_set *rset, fd_set *wset);
+void slip_init(void);
 
 #endif /* BORDER_ROUTER_H_ */
@@ -46,12 +46,15 @@
 #include <sys/ioctl.h>
 #include <err.h>
 #include "contiki.h"
+#include "border-router.h"
 
 int slip_config_verbose = 0;
 const char *slip_config_ipaddr;
 int slip_config_flowcontrol = 0;
 int slip_config_timestamp = 0;
 const char *slip_config_siodev = NULL;
+struct slip_config_radio slip_config_radios[BORDER_ROUTER_MAX_RADIOS];
+int slip_config_radio_count = 0;
 const char *slip_config_host = NULL;
 const char *slip_config_port = NULL;
 char slip_config_tundev[32] = { "" };
@@ -62,6 +65,39 @@ uint16_t slip_config_basedelay = 0;
 #endif
 speed_t slip_config_b_rate = BAUDRATE;
 
+/*---------------------------------------------------------------------------*/
+static void
+add_radio(char *arg)
+{
+  struct slip_config_radio *radio;
+  char *p;
+
+  if(slip_config_radio_count >= BORDER_ROUTER_MAX_RADIOS) {
+    err(1, "at most %d radios", BORDER_ROUTER_MAX_RADIOS);
+  }
+  radio = &slip_config_radios[slip_config_radio_count++];
+  radio->channel = -1;
+  radio->pan_id = -1;
+
+  if(strncmp("/dev/", arg, 5) == 0) {
+    arg += 5;
+  }
+  radio->siodev = arg;
+  p = strchr(arg, ':');
+  if(p != NULL) {
+    *p++ = '\0';
+    if(*p != ':' && *p != '\0') {
+      radio->channel = atoi(p);
+    }
+    p = strchr(p, ':');
+    if(p != NULL) {
+      radio->pan_id = strtol(p + 1, NULL, 16) & 0xffff;
+    }
+  }
+  if(slip_config_siodev == NULL) {
+    slip_config_siodev = radio->siodev;
+  }
+}
 /*---------------------------------------------------------------------------*/
 int
 slip_config_handle_arguments(int argc, char **argv)
@@ -88,11 +124,7 @@ slip_config_handle_arguments(int argc, char **argv)
       break;
 
     case 's':
-      if(strncmp("/dev/", optarg, 5) == 0) {
-	slip_config_siodev = optarg + 5;
-      } else {
-	slip_config_siodev = optarg;
-      }
+      add_radio(optarg);
       break;
 
     case 't':
@@ -135,6 +167,10 @@ fprintf(stderr," -B baudrate    9600,19200,38400,57600,115200 (default 115200)\n
 fprintf(stderr," -H             Hardware CTS/RTS flow control (default disabled)\n");
 fprintf(stderr," -L             Log output format (adds time stamps)\n");
 fprintf(stderr," -s siodev      Serial device (default /dev/ttyUSB0)\n");
+fprintf(stderr," -s siodev:channel[:panid]\n");
+fprintf(stderr,"                Serial device with the radio on its own channel\n");
+fprintf(stderr,"                and PAN. Repeat -s for up to %d radios.\n",
+        BORDER_ROUTER_MAX_RADIOS);
 fprintf(stderr," -a host        Connect via TCP to server at <host>\n");
 fprintf(stderr," -p port        Connect via TCP to server at <host>:<port>\n");
 fprintf(stderr," -t tundev      Name of interface (default tun0)\n");
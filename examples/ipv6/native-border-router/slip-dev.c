@@ -54,11 +54,14 @@
 #include "net/netstack.h"
 #include "net/packetbuf.h"
 #include "cmd.h"
+#include "border-router.h"
 #include "border-router-cmds.h"
 
 extern int slip_config_verbose;
 extern int slip_config_flowcontrol;
 extern const char *slip_config_siodev;
+extern struct slip_config_radio slip_config_radios[];
+extern int slip_config_radio_count;
 extern const char *slip_config_host;
 extern const char *slip_config_port;
 extern uint16_t slip_config_basedelay;
@@ -72,13 +75,30 @@ extern speed_t slip_config_b_rate;
 
 int devopen(const char *dev, int flags);
 
-static FILE *inslip;
+/* The state of one slip-radio */
+struct slip_dev {
+  int fd;
+  FILE *in;
+  unsigned char inbuf[2048];
+  int inbufptr;
+  unsigned char buf[2048];
+  int end, begin, packet_end, packet_count;
+  /* A ctimer rather than a timer so that the main loop wakes up when
+     the delay is over and the next packet can be written. */
+  struct ctimer send_delay_timer;
+  /* delay between slip packets */
+  clock_time_t send_delay;
+};
+
+static struct slip_dev radios[BORDER_ROUTER_MAX_RADIOS];
+static int radio_count;
+/* The radio that the input being handled came from */
+static int current_radio;
 
 /* for statistics */
 long slip_sent = 0;
 long slip_received = 0;
-
-int slipfd = 0;
+struct slip_radio_stats slip_radio_stats[BORDER_ROUTER_MAX_RADIOS];
 
 //#define PROGRESS(s) fprintf(stderr, s)
 #define PROGRESS(s) do { } while(0)
@@ -173,26 +193,26 @@ slip_packet_input(unsigned char *data, int len)
  * Read from serial, when we have a packet call slip_packet_input. No output
  * buffering, input buffered by stdio.
  */
-void
-serial_input(FILE *inslip)
+static void
+serial_input(struct slip_dev *dev)
 {
-  static unsigned char inbuf[2048];
-  static int inbufptr = 0;
   int ret,i;
   unsigned char c;
 
+  current_radio = dev - radios;
+
 #ifdef linux
-  ret = fread(&c, 1, 1, inslip);
-  if(ret == -1 || ret == 0) err(1, "serial_input: read");
+  ret = fread(&c, 1, 1, dev->in);
+  if(ret == -1) err(1, "serial_input: read");
   goto after_fread;
 #endif
 
  read_more:
-  if(inbufptr >= sizeof(inbuf)) {
-     fprintf(stderr, "*** dropping large %d byte packet\n", inbufptr);
-     inbufptr = 0;
+  if(dev->inbufptr >= sizeof(dev->inbuf)) {
+     fprintf(stderr, "*** dropping large %d byte packet\n", dev->inbufptr);
+     dev->inbufptr = 0;
   }
-  ret = fread(&c, 1, 1, inslip);
+  ret = fread(&c, 1, 1, dev->in);
 #ifdef linux
  after_fread:
 #endif
@@ -200,35 +220,36 @@ serial_input(FILE *inslip)
     err(1, "serial_input: read");
   }
   if(ret == 0) {
-    clearerr(inslip);
+    clearerr(dev->in);
     return;
   }
   slip_received++;
+  slip_radio_stats[current_radio].bytes_received++;
   switch(c) {
   case SLIP_END:
-    if(inbufptr > 0) {
-      if(inbuf[0] == '!') {
+    if(dev->inbufptr > 0) {
+      if(dev->inbuf[0] == '!') {
 	command_context = CMD_CONTEXT_RADIO;
-	cmd_input(inbuf, inbufptr);
-      } else if(inbuf[0] == '?') {
+	cmd_input(dev->inbuf, dev->inbufptr);
+      } else if(dev->inbuf[0] == '?') {
 #define DEBUG_LINE_MARKER '\r'
-      } else if(inbuf[0] == DEBUG_LINE_MARKER) {
-	fwrite(inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(inbuf, inbufptr)) {
+      } else if(dev->inbuf[0] == DEBUG_LINE_MARKER) {
+	fwrite(dev->inbuf + 1, dev->inbufptr - 1, 1, stdout);
+      } else if(is_sensible_string(dev->inbuf, dev->inbufptr)) {
         if(slip_config_verbose == 1) {   /* strings already echoed below for verbose>1 */
-          fwrite(inbuf, inbufptr, 1, stdout);
+          fwrite(dev->inbuf, dev->inbufptr, 1, stdout);
         }
       } else {
         if(slip_config_verbose > 2) {
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
+          printf("Packet from SLIP of length %d - write TUN\n", dev->inbufptr);
           if(slip_config_verbose > 4) {
 #if WIRESHARK_IMPORT_FORMAT
             printf("0000");
-	    for(i = 0; i < inbufptr; i++) printf(" %02x", inbuf[i]);
+	    for(i = 0; i < dev->inbufptr; i++) printf(" %02x", dev->inbuf[i]);
 #else
             printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", inbuf[i]);
+            for(i = 0; i < dev->inbufptr; i++) {
+              printf("%02x", dev->inbuf[i]);
               if((i & 3) == 3) printf(" ");
               if((i & 15) == 15) printf("\n         ");
             }
@@ -236,17 +257,17 @@ serial_input(FILE *inslip)
             printf("\n");
           }
         }
-	slip_packet_input(inbuf, inbufptr);
+	slip_packet_input(dev->inbuf, dev->inbufptr);
       }
-      inbufptr = 0;
+      dev->inbufptr = 0;
     }
     break;
 
   case SLIP_ESC:
-    if(fread(&c, 1, 1, inslip) != 1) {
-      clearerr(inslip);
+    if(fread(&c, 1, 1, dev->in) != 1) {
+      clearerr(dev->in);
       /* Put ESC back and give up! */
-      ungetc(SLIP_ESC, inslip);
+      ungetc(SLIP_ESC, dev->in);
       return;
     }
 
@@ -260,7 +281,7 @@ serial_input(FILE *inslip)
     }
     /* FALLTHROUGH */
   default:
-    inbuf[inbufptr++] = c;
+    dev->inbuf[dev->inbufptr++] = c;
 
     /* Echo lines as they are received for verbose=2,3,5+ */
     /* Echo all printable characters for verbose==4 */
@@ -269,9 +290,9 @@ serial_input(FILE *inslip)
 	fwrite(&c, 1, 1, stdout);
       }
     } else if(slip_config_verbose >= 2) {
-      if(c == '\n' && is_sensible_string(inbuf, inbufptr)) {
-        fwrite(inbuf, inbufptr, 1, stdout);
-        inbufptr = 0;
+      if(c == '\n' && is_sensible_string(dev->inbuf, dev->inbufptr)) {
+        fwrite(dev->inbuf, dev->inbufptr, 1, stdout);
+        dev->inbufptr = 0;
       }
     }
     break;
@@ -280,80 +301,103 @@ serial_input(FILE *inslip)
   goto read_more;
 }
 
-unsigned char slip_buf[2048];
-int slip_end, slip_begin, slip_packet_end, slip_packet_count;
-static struct timer send_delay_timer;
-/* delay between slip packets */
-static clock_time_t send_delay = SEND_DELAY;
 /*---------------------------------------------------------------------------*/
 static void
-slip_send(int fd, unsigned char c)
+send_delay_expired(void *ptr)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_set_send_delay(int radio, clock_time_t delay)
+{
+  if(radio >= 0 && radio < radio_count) {
+    radios[radio].send_delay = delay;
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_radio_count(void)
+{
+  return radio_count;
+}
+/*---------------------------------------------------------------------------*/
+int
+slip_radio_current(void)
+{
+  return current_radio;
+}
+/*---------------------------------------------------------------------------*/
+static void
+slip_send(struct slip_dev *dev, unsigned char c)
 {
-  if(slip_end >= sizeof(slip_buf)) {
+  if(dev->end >= sizeof(dev->buf)) {
     err(1, "slip_send overflow");
   }
-  slip_buf[slip_end] = c;
-  slip_end++;
+  dev->buf[dev->end] = c;
+  dev->end++;
   slip_sent++;
+  slip_radio_stats[dev - radios].bytes_sent++;
   if(c == SLIP_END) {
     /* Full packet received. */
-    slip_packet_count++;
-    if(slip_packet_end == 0) {
-      slip_packet_end = slip_end;
+    dev->packet_count++;
+    if(dev->packet_end == 0) {
+      dev->packet_end = dev->end;
     }
   }
 }
 /*---------------------------------------------------------------------------*/
-int
-slip_empty()
+static int
+slip_empty(struct slip_dev *dev)
 {
-  return slip_packet_end == 0;
+  return dev->packet_end == 0;
 }
 /*---------------------------------------------------------------------------*/
-void
-slip_flushbuf(int fd)
+static void
+slip_flushbuf(struct slip_dev *dev)
 {
   int n;
 
-  if(slip_empty()) {
+  if(slip_empty(dev)) {
     return;
   }
 
-  n = write(fd, slip_buf + slip_begin, slip_packet_end - slip_begin);
+  n = write(dev->fd, dev->buf + dev->begin, dev->packet_end - dev->begin);
 
   if(n == -1 && errno != EAGAIN) {
     err(1, "slip_flushbuf write failed");
   } else if(n == -1) {
     PROGRESS("Q");		/* Outqueue is full! */
   } else {
-    slip_begin += n;
-    if(slip_begin == slip_packet_end) {
-      slip_packet_count--;
-      if(slip_end > slip_packet_end) {
-        memcpy(slip_buf, slip_buf + slip_packet_end,
-               slip_end - slip_packet_end);
+    dev->begin += n;
+    if(dev->begin == dev->packet_end) {
+      dev->packet_count--;
+      if(dev->end > dev->packet_end) {
+        memcpy(dev->buf, dev->buf + dev->packet_end,
+               dev->end - dev->packet_end);
       }
-      slip_end -= slip_packet_end;
-      slip_begin = slip_packet_end = 0;
-      if(slip_end > 0) {
+      dev->end -= dev->packet_end;
+      dev->begin = dev->packet_end = 0;
+      if(dev->end > 0) {
         /* Find end of next slip packet */
-        for(n = 1; n < slip_end; n++) {
-          if(slip_buf[n] == SLIP_END) {
-            slip_packet_end = n + 1;
+        for(n = 1; n < dev->end; n++) {
+          if(dev->buf[n] == SLIP_END) {
+            dev->packet_end = n + 1;
             break;
           }
         }
-        /* a delay between slip packets to avoid losing data */
-        if(send_delay > 0) {
-          timer_set(&send_delay_timer, send_delay);
-        }
+      }
+      /* a delay between slip packets to avoid losing data, also when
+         the next packet is not queued yet */
+      if(dev->send_delay > 0) {
+        ctimer_set(&dev->send_delay_timer, dev->send_delay,
+                   send_delay_expired, NULL);
       }
     }
   }
 }
 /*---------------------------------------------------------------------------*/
 static void
-write_to_serial(int outfd, const uint8_t *inbuf, int len)
+write_to_serial(struct slip_dev *dev, const uint8_t *inbuf, int len)
 {
   const uint8_t *p = inbuf;
   int i;
@@ -383,36 +427,44 @@ write_to_serial(int outfd, const uint8_t *inbuf, int len)
   /* It would be ``nice'' to send a SLIP_END here but it's not
    * really necessary.
    */
-  /* slip_send(outfd, SLIP_END); */
+  /* slip_send(dev, SLIP_END); */
 
   for(i = 0; i < len; i++) {
     switch(p[i]) {
     case SLIP_END:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_END);
+      slip_send(dev, SLIP_ESC);
+      slip_send(dev, SLIP_ESC_END);
       break;
     case SLIP_ESC:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_ESC);
+      slip_send(dev, SLIP_ESC);
+      slip_send(dev, SLIP_ESC_ESC);
       break;
     default:
-      slip_send(outfd, p[i]);
+      slip_send(dev, p[i]);
       break;
     }
   }
-  slip_send(outfd, SLIP_END);
+  slip_send(dev, SLIP_END);
   PROGRESS("t");
 }
 /*---------------------------------------------------------------------------*/
-/* writes an 802.15.4 packet to slip-radio */
+/* writes an 802.15.4 packet to a slip-radio */
 void
-write_to_slip(const uint8_t *buf, int len)
+write_to_radio(int radio, const uint8_t *buf, int len)
 {
-  if(slipfd > 0) {
-    write_to_serial(slipfd, buf, len);
+  if(radio >= 0 && radio < radio_count) {
+    write_to_serial(&radios[radio], buf, len);
   }
 }
 /*---------------------------------------------------------------------------*/
+/* writes a command to the first slip-radio, whose MAC address the
+   border router uses */
+void
+write_to_slip(const uint8_t *buf, int len)
+{
+  write_to_radio(0, buf, len);
+}
+/*---------------------------------------------------------------------------*/
 static void
 stty_telos(int fd)
 {
@@ -450,7 +502,8 @@ stty_telos(int fd)
   if(tcsetattr(fd, TCSAFLUSH, &tty) == -1) err(1, "tcsetattr");
 
   i = TIOCM_DTR;
-  if(ioctl(fd, TIOCMBIS, &i) == -1) err(1, "ioctl");
+  /* A pty has no modem control lines. */
+  if(ioctl(fd, TIOCMBIS, &i) == -1 && errno != ENOTTY) err(1, "ioctl");
 #endif
 
   usleep(10*1000);		/* Wait for hardware 10ms. */
@@ -462,85 +515,118 @@ stty_telos(int fd)
 static int
 set_fd(fd_set *rset, fd_set *wset)
 {
-  /* Anything to flush? */
-  if(!slip_empty() && (send_delay == 0 || timer_expired(&send_delay_timer))) {
-    FD_SET(slipfd, wset);
-  }
+  struct slip_dev *dev;
+  int i;
+
+  for(i = 0; i < radio_count; i++) {
+    dev = &radios[i];
+    /* Anything to flush? */
+    if(!slip_empty(dev) &&
+       (dev->send_delay == 0 || ctimer_expired(&dev->send_delay_timer))) {
+      FD_SET(dev->fd, wset);
+    }
 
-  FD_SET(slipfd, rset);	/* Read from slip ASAP! */
+    FD_SET(dev->fd, rset);	/* Read from slip ASAP! */
+  }
   return 1;
 }
 /*---------------------------------------------------------------------------*/
 static void
 handle_fd(fd_set *rset, fd_set *wset)
 {
-  if(FD_ISSET(slipfd, rset)) {
-    serial_input(inslip);
-  }
+  struct slip_dev *dev;
+  int i;
+
+  /* All radios share this callback, and the main loop calls it once
+     for each of their descriptors: clear a descriptor once it has been
+     serviced so that it is only serviced once per wakeup. */
+  for(i = 0; i < radio_count; i++) {
+    dev = &radios[i];
+    if(FD_ISSET(dev->fd, rset)) {
+      FD_CLR(dev->fd, rset);
+      serial_input(dev);
+    }
 
-  if(FD_ISSET(slipfd, wset)) {
-    slip_flushbuf(slipfd);
+    if(FD_ISSET(dev->fd, wset)) {
+      FD_CLR(dev->fd, wset);
+      slip_flushbuf(dev);
+    }
   }
 }
 /*---------------------------------------------------------------------------*/
 static const struct select_callback slip_callback = { set_fd, handle_fd };
 /*---------------------------------------------------------------------------*/
+static void
+add_radio(int fd)
+{
+  struct slip_dev *dev;
+
+  dev = &radios[radio_count++];
+  dev->fd = fd;
+  dev->send_delay = SEND_DELAY;
+  ctimer_stop(&dev->send_delay_timer);
+  select_set_callback(fd, &slip_callback);
+  slip_send(dev, SLIP_END);
+  dev->in = fdopen(fd, "r");
+  if(dev->in == NULL) {
+    err(1, "main: fdopen");
+  }
+}
+/*---------------------------------------------------------------------------*/
 void
 slip_init(void)
 {
+  int fd;
+  int i;
+
   setvbuf(stdout, NULL, _IOLBF, 0); /* Line buffered output. */
 
   if(slip_config_host != NULL) {
     if(slip_config_port == NULL) {
       slip_config_port = "60001";
     }
-    slipfd = connect_to_server(slip_config_host, slip_config_port);
-    if(slipfd == -1) {
+    fd = connect_to_server(slip_config_host, slip_config_port);
+    if(fd == -1) {
       err(1, "can't connect to ``%s:%s''", slip_config_host, slip_config_port);
     }
+    fprintf(stderr, "********SLIP opened to ``%s:%s''\n", slip_config_host,
+	    slip_config_port);
+    add_radio(fd);
 
-  } else if(slip_config_siodev != NULL) {
-    if(strcmp(slip_config_siodev, "null") == 0) {
-      /* Disable slip */
-      return;
-    }
-    slipfd = devopen(slip_config_siodev, O_RDWR | O_NONBLOCK);
-    if(slipfd == -1) {
-      err(1, "can't open siodev ``/dev/%s''", slip_config_siodev);
+  } else if(slip_config_radio_count > 0) {
+    for(i = 0; i < slip_config_radio_count; i++) {
+      if(strcmp(slip_config_radios[i].siodev, "null") == 0) {
+        /* Disable slip for this radio */
+        continue;
+      }
+      fd = devopen(slip_config_radios[i].siodev, O_RDWR | O_NONBLOCK);
+      if(fd == -1) {
+        err(1, "can't open siodev ``/dev/%s''", slip_config_radios[i].siodev);
+      }
+      fprintf(stderr, "********SLIP started on ``/dev/%s''\n",
+              slip_config_radios[i].siodev);
+      stty_telos(fd);
+      add_radio(fd);
     }
 
   } else {
     static const char *siodevs[] = {
       "ttyUSB0", "cuaU0", "ucom0" /* linux, fbsd6, fbsd5 */
     };
-    int i;
+    fd = -1;
     for(i = 0; i < 3; i++) {
       slip_config_siodev = siodevs[i];
-      slipfd = devopen(slip_config_siodev, O_RDWR | O_NONBLOCK);
-      if(slipfd != -1) {
+      fd = devopen(slip_config_siodev, O_RDWR | O_NONBLOCK);
+      if(fd != -1) {
 	break;
       }
     }
-    if(slipfd == -1) {
+    if(fd == -1) {
       err(1, "can't open siodev");
     }
-  }
-
-  select_set_callback(slipfd, &slip_callback);
-
-  if(slip_config_host != NULL) {
-    fprintf(stderr, "********SLIP opened to ``%s:%s''\n", slip_config_host,
-	    slip_config_port);
-  } else {
     fprintf(stderr, "********SLIP started on ``/dev/%s''\n", slip_config_siodev);
-    stty_telos(slipfd);
-  }
-
-  timer_set(&send_delay_timer, 0);
-  slip_send(slipfd, SLIP_END);
-  inslip = fdopen(slipfd, "r");
-  if(inslip == NULL) {
-    err(1, "main: fdopen");
+    stty_telos(fd);
+    add_radio(fd);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,341 @@
+#!/usr/bin/env python3
+#
+# Loopback test of the slip-radio protocol between the native border
+# router and an emulated slip-radio on the other end of a pty pair.
+#
+# The emulated radio hands the border router ICMPv6 echo requests
+# from a node, keeping --inflight of them outstanding, and counts the
+# echo replies that the border router sends back down over SLIP.
+# Transmitting a frame takes --tx-time ms on the emulated radio, which
+# has room for a single frame besides the one it transmits; frames
+# that arrive when it is full are lost, as on a real slip-radio.
+#
+# With --legacy the radio does not answer "?W" and the border router
+# falls back to "!S" commands spaced by its send delay. Otherwise the
+# windowed protocol with batched, CRC protected "!B" commands is used.
+#
+# With --radios N the border router drives N emulated radios, each on
+# its own channel with a node of its own. The echo requests go to the
+# nodes in turn and every reply has to come back on the radio of the
+# node that it is for.
+#
+# Needs to run as root since the border router opens a tun device:
+#
+#   sudo ./slip-radio-loopback.py [--legacy] [--radios 2] [-n 200]
+#
+
+import argparse
+import os
+import pty
+import select
+import struct
+import subprocess
+import sys
+import time
+import tty
+
+SLIP_END = 0o300
+SLIP_ESC = 0o333
+SLIP_ESC_END = 0o334
+SLIP_ESC_ESC = 0o335
+
+RADIO_MAC = bytes([0x00, 0x12, 0x4b, 0x00, 0x00, 0x00, 0x00, 0x01])
+NODE_MAC = bytes([0x00, 0x12, 0x74, 0x01, 0x00, 0x01, 0x01, 0x01])
+PAN_ID = 0xabcd
+MARKER = b'slip-radio-loopback'
+
+# What slip-radio.c reports with its default window on a mote with a
+# small uIP buffer
+WINDOW = 2
+MTU = 140
+
+MAC_TX_OK = 0
+MAC_TX_ERR = 4
+
+
+def crc16(data, acc=0):
+    """The CRC of core/lib/crc16.c"""
+    for b in data:
+        acc ^= b
+        acc = ((acc >> 8) | (acc << 8)) & 0xffff
+        acc ^= (acc & 0xff00) << 4
+        acc &= 0xffff
+        acc ^= (acc >> 8) >> 4
+        acc ^= (acc & 0xff00) >> 5
+    return acc
+
+
+def slip_encode(data):
+    out = bytearray([SLIP_END])
+    for b in data:
+        if b == SLIP_END:
+            out += bytes([SLIP_ESC, SLIP_ESC_END])
+        elif b == SLIP_ESC:
+            out += bytes([SLIP_ESC, SLIP_ESC_ESC])
+        else:
+            out.append(b)
+    out.append(SLIP_END)
+    return bytes(out)
+
+
+class SlipDecoder:
+    def __init__(self):
+        self.buf = bytearray()
+        self.esc = False
+
+    def feed(self, data):
+        frames = []
+        for b in data:
+            if self.esc:
+                self.esc = False
+                if b == SLIP_ESC_END:
+                    b = SLIP_END
+                elif b == SLIP_ESC_ESC:
+                    b = SLIP_ESC
+                self.buf.append(b)
+            elif b == SLIP_ESC:
+                self.esc = True
+            elif b == SLIP_END:
+                if self.buf:
+                    frames.append(bytes(self.buf))
+                self.buf = bytearray()
+            else:
+                self.buf.append(b)
+        return frames
+
+
+def iid(mac):
+    return bytes([mac[0] ^ 0x02]) + mac[1:]
+
+
+def checksum(src, dst, nxt, payload):
+    pseudo = src + dst + struct.pack('!IxxxB', len(payload), nxt)
+    data = pseudo + payload
+    if len(data) & 1:
+        data += b'\0'
+    s = sum(struct.unpack('!%dH' % (len(data) // 2), data))
+    while s >> 16:
+        s = (s & 0xffff) + (s >> 16)
+    return ~s & 0xffff
+
+
+def ipv6(src, dst, nxt, payload, hlim=64):
+    return struct.pack('!IHBB', 0x60000000, len(payload), nxt, hlim) + \
+        src + dst + payload
+
+
+def icmp6(src, dst, type, code, body):
+    msg = struct.pack('!BBH', type, code, 0) + body
+    c = checksum(src, dst, 58, msg)
+    return msg[:2] + struct.pack('!H', c) + msg[4:]
+
+
+def frame802154(seq, dst, src, payload):
+    # Data frame, PAN ID compression, long addresses
+    return struct.pack('<HBH', 0xcc41, seq & 0xff, PAN_ID) + \
+        dst[::-1] + src[::-1] + payload
+
+
+class Radio:
+    def __init__(self, index, fd, legacy, tx_time):
+        self.index = index
+        self.fd = fd
+        self.mac = RADIO_MAC[:7] + bytes([RADIO_MAC[7] + index])
+        self.node = NODE_MAC[:7] + bytes([NODE_MAC[7] + index])
+        self.channel = None
+        self.legacy = legacy
+        self.tx_time = tx_time
+        self.slip = SlipDecoder()
+        self.queue = []           # (sid, frame)
+        self.tx_done = None       # time the current frame is sent
+        self.seq = 0
+        self.replies = []
+        self.frames = 0
+        self.commands = 0
+        self.lost = 0
+        self.bad_crc = 0
+        self.window = False
+
+    def send(self, data):
+        os.write(self.fd, slip_encode(data))
+
+    def send_frame(self, payload):
+        self.seq += 1
+        self.send(frame802154(self.seq, self.mac, self.node, payload))
+
+    def enqueue(self, sid, data):
+        natts = data[0]
+        frame = data[1 + natts * 3:]
+        # One frame being transmitted and one waiting
+        if len(self.queue) >= WINDOW:
+            self.lost += 1
+            self.send(b'!R' + bytes([sid, MAC_TX_ERR, 0]))
+            return
+        self.queue.append((sid, frame))
+
+    def command(self, data):
+        self.commands += 1
+        if data[:2] == b'?M':
+            self.send(b'!M' + self.mac)
+        elif data[:2] == b'!M':
+            # The address of the first radio of the border router
+            self.mac = data[2:10]
+        elif data[:2] == b'!C':
+            self.channel = data[2]
+        elif data[:2] == b'?W':
+            if self.legacy:
+                self.send(b'EUnknown command')
+            else:
+                self.window = True
+                self.send(b'!W' + bytes([WINDOW, MTU >> 8, MTU & 0xff]))
+        elif data[:2] == b'!S':
+            self.enqueue(data[2], data[3:])
+        elif data[:2] == b'!B':
+            if len(data) > MTU:
+                self.lost += data[2]
+                return
+            if crc16(data[:-2]) != (data[-2] << 8 | data[-1]):
+                self.bad_crc += 1
+                return
+            pos = 3
+            for i in range(data[2]):
+                sid, flen = struct.unpack('!BH', data[pos:pos + 3])
+                self.enqueue(sid, data[pos + 3:pos + 3 + flen])
+                pos += 3 + flen
+
+    def timeout(self, now, timeout):
+        if self.queue and self.tx_done is None:
+            self.tx_done = now + self.tx_time
+        if self.tx_done is not None:
+            timeout = max(0, min(timeout, self.tx_done - now))
+        return timeout
+
+    def read(self):
+        for data in self.slip.feed(os.read(self.fd, 4096)):
+            if data[0] in b'!?':
+                self.command(data)
+
+    def transmit(self):
+        if self.tx_done is not None and time.time() >= self.tx_done:
+            sid, frame = self.queue.pop(0)
+            self.tx_done = None
+            self.frames += 1
+            pos = frame.find(MARKER)
+            if pos >= 2:
+                self.replies.append(struct.unpack('!H', frame[pos - 2:pos])[0])
+            self.send(b'!R' + bytes([sid, MAC_TX_OK, 1]))
+
+
+def poll(radios, timeout):
+    now = time.time()
+    for radio in radios:
+        timeout = radio.timeout(now, timeout)
+    r, w, x = select.select([radio.fd for radio in radios], [], [], timeout)
+    for radio in radios:
+        if radio.fd in r:
+            radio.read()
+        radio.transmit()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--legacy', action='store_true',
+                        help='emulate a radio without the windowed protocol')
+    parser.add_argument('-n', type=int, default=200,
+                        help='number of echo requests')
+    parser.add_argument('--inflight', type=int, default=8,
+                        help='number of echo requests in flight')
+    parser.add_argument('--tx-time', type=float, default=4,
+                        help='frame transmission time in ms')
+    parser.add_argument('--radios', type=int, default=1,
+                        help='number of radios')
+    parser.add_argument('--router', default='./border-router.native')
+    args = parser.parse_args()
+
+    radios = []
+    command = [args.router, '-t', 'tun-loopback']
+    for i in range(args.radios):
+        master, slave = pty.openpty()
+        tty.setraw(master)
+        radios.append(Radio(i, master, args.legacy, args.tx_time / 1000.0))
+        siodev = os.ttyname(slave)
+        if args.radios > 1:
+            siodev += ':%d' % (11 + i)
+        command += ['-s', siodev]
+    command.append('fd00::1/64')
+    router = subprocess.Popen(command, stdout=subprocess.DEVNULL,
+                              stderr=subprocess.DEVNULL)
+    status = 1
+    try:
+        # Wait until the border router has its MAC address and window
+        deadline = time.time() + 10
+        while (min(radio.commands for radio in radios) < 2 and
+               time.time() < deadline):
+            poll(radios, 0.1)
+        start = time.time() + 2
+        while time.time() < start:
+            poll(radios, 0.1)
+
+        dst = b'\xfe\x80' + b'\0' * 6 + iid(radios[0].mac)
+        for radio in radios:
+            radio.src = b'\xfe\x80' + b'\0' * 6 + iid(radio.node)
+            # A unicast RPL DIS makes the node a neighbor of the border
+            # router
+            dis = icmp6(radio.src, dst, 155, 0, b'\0\0')
+            radio.send_frame(b'\x41' + ipv6(radio.src, dst, 58, dis, 255))
+        settle = time.time() + 1
+        while time.time() < settle:
+            poll(radios, 0.1)
+
+        # Keep a number of echo requests in flight, like ping -l
+        start = time.time()
+        inflight = {}
+        sent = 0
+        received = 0
+        timeouts = 0
+        misrouted = 0
+        while received + timeouts < args.n:
+            now = time.time()
+            while sent < args.n and len(inflight) < args.inflight:
+                radio = radios[sent % len(radios)]
+                echo = icmp6(radio.src, dst, 128, 0,
+                             struct.pack('!HH', 1, sent) + MARKER)
+                radio.send_frame(b'\x41' + ipv6(radio.src, dst, 58, echo))
+                inflight[sent] = now
+                sent += 1
+            poll(radios, 0.1)
+            for radio in radios:
+                for i in radio.replies:
+                    if inflight.pop(i, None) is not None:
+                        received += 1
+                        if i % len(radios) != radio.index:
+                            misrouted += 1
+                radio.replies = []
+            for i, t in list(inflight.items()):
+                if now - t > 1:
+                    del inflight[i]
+                    timeouts += 1
+        elapsed = time.time() - start
+
+        lost = sum(radio.lost for radio in radios)
+        bad_crc = sum(radio.bad_crc for radio in radios)
+        print('%s protocol, %d radio(s): %d/%d echo replies in %.2f s '
+              '(%.0f replies/s), %d frames lost, %d bad CRC, %d misrouted' %
+              ('windowed' if radios[0].window else 'legacy', len(radios),
+               received, args.n, elapsed, received / elapsed,
+               lost, bad_crc, misrouted))
+        for radio in radios[1:]:
+            if radio.mac != radios[0].mac:
+                print('radio %d was not given the border router address' %
+                      radio.index)
+                misrouted += 1
+        if received == args.n and bad_crc == 0 and misrouted == 0:
+            status = 0
+    finally:
+        router.terminate()
+        router.wait()
+    sys.exit(status)
+
+
+if __name__ == '__main__':
+    main()
@@ -65,6 +65,13 @@
 #include "cmd.h"
 #include "border-router.h"
 
+/* The number of packets read from the tun device per wakeup. */
+#ifdef TUN_CONF_RX_BATCH
+#define TUN_RX_BATCH TUN_CONF_RX_BATCH
+#else
+#define TUN_RX_BATCH 16
+#endif
+
 extern const char *slip_config_ipaddr;
 extern char slip_config_tundev[32];
 extern uint16_t slip_config_basedelay;
@@ -208,6 +215,8 @@ tun_init()
 
   tunfd = tun_alloc(slip_config_tundev);
   if(tunfd == -1) err(1, "main: open");
+  /* handle_fd() reads until the device has no more packets. */
+  fcntl(tunfd, F_SETFL, fcntl(tunfd, F_GETFL) | O_NONBLOCK);
 
   select_set_callback(tunfd, &tun_select_callback);
 
@@ -227,6 +236,10 @@ tun_output(uint8_t *data, int len)
 {
   /* fprintf(stderr, "*** Writing to tun...%d\n", len); */
   if(write(tunfd, data, len) != len) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      /* The device queue is full, drop the packet. */
+      return -1;
+    }
     err(1, "serial_to_tun: write");
     return -1;
   }
@@ -237,8 +250,12 @@ int
 tun_input(unsigned char *data, int maxlen)
 {
   int size;
-  if((size = read(tunfd, data, maxlen)) == -1)
+  if((size = read(tunfd, data, maxlen)) == -1) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      return 0;
+    }
     err(1, "tun_input: read");
+  }
   return size;
 }
 
@@ -292,19 +309,28 @@ handle_fd(fd_set *rset, fd_set *wset)
 
   if(delaymsec==0) {
     int size;
+    int i;
 
     if(FD_ISSET(tunfd, rset)) {
-      size = tun_input(&uip_buf[UIP_LLH_LEN], sizeof(uip_buf));
-      /* printf("TUN data incoming read:%d\n", size); */
-      uip_len = size;
-      tcpip_input();
-
-      if(slip_config_basedelay) {
-        struct timeval tv;
-      	gettimeofday(&tv, NULL) ;
-      	delaymsec=slip_config_basedelay;
-      	delaystartsec =tv.tv_sec;
-      	delaystartmsec=tv.tv_usec/1000;
+      /* Drain a burst of packets per wakeup, unless outgoing packets
+         are to be spaced out by the base delay. */
+      for(i = 0; i < TUN_RX_BATCH; i++) {
+        size = tun_input(&uip_buf[UIP_LLH_LEN], sizeof(uip_buf));
+        /* printf("TUN data incoming read:%d\n", size); */
+        if(size <= 0) {
+          break;
+        }
+        uip_len = size;
+        tcpip_input();
+
+        if(slip_config_basedelay) {
+          struct timeval tv;
+          gettimeofday(&tv, NULL) ;
+          delaymsec=slip_config_basedelay;
+          delaystartsec =tv.tv_sec;
+          delaystartmsec=tv.tv_usec/1000;
+          break;
+        }
       }
     }
   }
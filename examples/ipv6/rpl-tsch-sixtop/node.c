@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2016, SICS Swedish ICT.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+/**
+ * \file
+ *         A RPL+TSCH node sending UDP packets to the root at a high rate,
+ *         for BURST_DURATION after joining, then staying idle.
+ *         Nodes negotiate dedicated cells to their parent with 6top and
+ *         SF-queue. The node with ID 1 is the root.
+ */
+
+#include "contiki.h"
+#include "node-id.h"
+#include "lib/random.h"
+#include "net/rpl/rpl.h"
+#include "net/ip/uip.h"
+#include "simple-udp.h"
+#include "net/mac/tsch/tsch.h"
+#include "net/mac/tsch/tsch-queue.h"
+#include "net/mac/tsch/sixtop/sixtop.h"
+#include "net/mac/tsch/sixtop/sf-queue.h"
+#include <stdio.h>
+#include <string.h>
+
+#define UDP_PORT 5678
+#define SEND_INTERVAL (CLOCK_SECOND / 4)
+#define BURST_DURATION (120 * CLOCK_SECOND)
+#define STATUS_INTERVAL (10 * CLOCK_SECOND)
+
+static struct simple_udp_connection udp_conn;
+static unsigned long rx_count;
+static struct timer burst_timer;
+static uint8_t burst_started;
+
+/*---------------------------------------------------------------------------*/
+PROCESS(node_process, "RPL+TSCH+6top Node");
+AUTOSTART_PROCESSES(&node_process);
+
+/*---------------------------------------------------------------------------*/
+static void
+udp_rx_callback(struct simple_udp_connection *c,
+                const uip_ipaddr_t *sender_addr,
+                uint16_t sender_port,
+                const uip_ipaddr_t *receiver_addr,
+                uint16_t receiver_port,
+                const uint8_t *data,
+                uint16_t datalen)
+{
+  rx_count++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_status(void)
+{
+  struct tsch_neighbor *n = tsch_queue_get_time_source();
+  if(node_id == 1) {
+    printf("Root: received %lu packets\n", rx_count);
+  } else if(n != NULL) {
+    printf("SF-queue: %s, %u Tx cells to parent\n",
+           burst_started && timer_expired(&burst_timer) ? "idle" : "sending",
+           sf_queue_num_tx_cells(&n->addr));
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(node_process, ev, data)
+{
+  static struct etimer send_timer;
+  static struct etimer status_timer;
+  static uint32_t seqno;
+  PROCESS_BEGIN();
+
+  if(node_id == 1) {
+    uip_ipaddr_t prefix;
+    uip_ipaddr_t global_ipaddr;
+    uip_ip6addr(&prefix, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+    memcpy(&global_ipaddr, &prefix, 16);
+    uip_ds6_set_addr_iid(&global_ipaddr, &uip_lladdr);
+    uip_ds6_addr_add(&global_ipaddr, 0, ADDR_AUTOCONF);
+    rpl_set_root(RPL_DEFAULT_INSTANCE, &global_ipaddr);
+    rpl_set_prefix(rpl_get_any_dag(), &prefix, 64);
+    rpl_repair_root(RPL_DEFAULT_INSTANCE);
+  }
+
+  sixtop_add_sf(&sf_queue);
+  NETSTACK_MAC.on();
+
+  simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, udp_rx_callback);
+
+  etimer_set(&send_timer, SEND_INTERVAL);
+  etimer_set(&status_timer, STATUS_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&send_timer) || etimer_expired(&status_timer));
+
+    if(etimer_expired(&send_timer)) {
+      rpl_dag_t *dag = rpl_get_any_dag();
+      etimer_reset(&send_timer);
+      if(node_id != 1 && dag != NULL && tsch_is_associated) {
+        if(!burst_started) {
+          timer_set(&burst_timer, BURST_DURATION);
+          burst_started = 1;
+        }
+        if(!timer_expired(&burst_timer)) {
+          seqno++;
+          simple_udp_sendto(&udp_conn, &seqno, sizeof(seqno), &dag->dag_id);
+        }
+      }
+    }
+
+    if(etimer_expired(&status_timer)) {
+      etimer_reset(&status_timer);
+      print_status();
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
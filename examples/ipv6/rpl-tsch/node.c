@@ -44,6 +44,10 @@
 #if WITH_ORCHESTRA
 #include "orchestra.h"
 #endif /* WITH_ORCHESTRA */
+#if WITH_ORCHESTRA_ADAPTIVE
+#include "simple-udp.h"
+#include "lib/random.h"
+#endif /* WITH_ORCHESTRA_ADAPTIVE */
 
 #define DEBUG DEBUG_PRINT
 #include "net/ip/uip-debug.h"
@@ -53,8 +57,24 @@
 #include "button-sensor.h"
 #endif /* CONFIG_VIA_BUTTON */
 
+#if WITH_ORCHESTRA_ADAPTIVE
+/* Once joined, nodes send a burst of packets to the root, long enough
+ * for the traffic-adaptive unicast rule to add cells and to remove them
+ * afterwards */
+#define LOAD_UDP_PORT 5678
+#define LOAD_SEND_INTERVAL (CLOCK_SECOND / 8)
+#define LOAD_BURST_DURATION (120 * CLOCK_SECOND)
+#define LOAD_STATUS_INTERVAL (10 * CLOCK_SECOND)
+
+static struct simple_udp_connection load_conn;
+static unsigned long load_rx_count;
+#endif /* WITH_ORCHESTRA_ADAPTIVE */
+
 /*---------------------------------------------------------------------------*/
 PROCESS(node_process, "RPL Node");
+#if WITH_ORCHESTRA_ADAPTIVE
+PROCESS(load_process, "Load burst");
+#endif /* WITH_ORCHESTRA_ADAPTIVE */
 #if CONFIG_VIA_BUTTON
 AUTOSTART_PROCESSES(&node_process, &sensors_process);
 #else /* CONFIG_VIA_BUTTON */
@@ -196,6 +216,9 @@ PROCESS_THREAD(node_process, ev, data)
 #if WITH_ORCHESTRA
   orchestra_init();
 #endif /* WITH_ORCHESTRA */
+#if WITH_ORCHESTRA_ADAPTIVE
+  process_start(&load_process, is_coordinator ? &is_coordinator : NULL);
+#endif /* WITH_ORCHESTRA_ADAPTIVE */
   
   /* Print out routing tables every minute */
   etimer_set(&et, CLOCK_SECOND * 60);
@@ -208,3 +231,70 @@ PROCESS_THREAD(node_process, ev, data)
   PROCESS_END();
 }
 /*---------------------------------------------------------------------------*/
+#if WITH_ORCHESTRA_ADAPTIVE
+static void
+load_rx_callback(struct simple_udp_connection *c,
+                 const uip_ipaddr_t *sender_addr,
+                 uint16_t sender_port,
+                 const uip_ipaddr_t *receiver_addr,
+                 uint16_t receiver_port,
+                 const uint8_t *data,
+                 uint16_t datalen)
+{
+  load_rx_count++;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(load_process, ev, data)
+{
+  static struct etimer send_timer;
+  static struct etimer status_timer;
+  static struct timer burst_timer;
+  static uint32_t seqno;
+  static int is_root;
+  rpl_dag_t *dag;
+  PROCESS_BEGIN();
+
+  is_root = data != NULL;
+  simple_udp_register(&load_conn, LOAD_UDP_PORT, NULL, LOAD_UDP_PORT, load_rx_callback);
+
+  if(!is_root) {
+    /* Wait until we have a parent to send to */
+    do {
+      etimer_set(&send_timer, CLOCK_SECOND);
+      PROCESS_YIELD_UNTIL(etimer_expired(&send_timer));
+      dag = rpl_get_any_dag();
+    } while(!tsch_is_associated || dag == NULL || dag->preferred_parent == NULL);
+  }
+
+  timer_set(&burst_timer, LOAD_BURST_DURATION);
+  etimer_set(&send_timer, LOAD_SEND_INTERVAL);
+  etimer_set(&status_timer, LOAD_STATUS_INTERVAL);
+  while(1) {
+    PROCESS_YIELD_UNTIL(etimer_expired(&send_timer) || etimer_expired(&status_timer));
+
+    if(etimer_expired(&send_timer)) {
+      /* Jitter the transmissions a little */
+      etimer_set(&send_timer, LOAD_SEND_INTERVAL / 2 + random_rand() % LOAD_SEND_INTERVAL);
+      dag = rpl_get_any_dag();
+      if(!is_root && !timer_expired(&burst_timer) && dag != NULL) {
+        seqno++;
+        simple_udp_sendto(&load_conn, &seqno, sizeof(seqno), &dag->dag_id);
+      }
+    }
+
+    if(etimer_expired(&status_timer)) {
+      etimer_reset(&status_timer);
+      if(is_root) {
+        printf("Load: received %lu packets\n", load_rx_count);
+      } else {
+        printf("Load: %s, %u extra cells to parent\n",
+               timer_expired(&burst_timer) ? "idle" : "sending",
+               orchestra_unicast_adaptive_num_tx_cells());
+      }
+    }
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+#endif /* WITH_ORCHESTRA_ADAPTIVE */
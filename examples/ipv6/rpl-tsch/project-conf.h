@@ -40,6 +40,11 @@
 #define WITH_ORCHESTRA 0
 #endif /* WITH_ORCHESTRA */
 
+/* Set to use the traffic-adaptive Orchestra unicast rule */
+#ifndef WITH_ORCHESTRA_ADAPTIVE
+#define WITH_ORCHESTRA_ADAPTIVE 0
+#endif /* WITH_ORCHESTRA_ADAPTIVE */
+
 /* Set to enable TSCH security */
 #ifndef WITH_SECURITY
 #define WITH_SECURITY 0
@@ -121,6 +126,15 @@
 #define TSCH_CALLBACK_PACKET_READY orchestra_callback_packet_ready
 #define NETSTACK_CONF_ROUTING_NEIGHBOR_ADDED_CALLBACK orchestra_callback_child_added
 #define NETSTACK_CONF_ROUTING_NEIGHBOR_REMOVED_CALLBACK orchestra_callback_child_removed
+#define TSCH_CALLBACK_EB_CREATE orchestra_callback_eb_create
+#define TSCH_CALLBACK_EB_RECEIVED orchestra_callback_eb_received
+
+#if WITH_ORCHESTRA_ADAPTIVE
+/* Sender-based unicast cells, added on demand to drain the queue to the parent */
+#define ORCHESTRA_CONF_RULES { &eb_per_time_source, &unicast_adaptive, &default_common }
+/* Listen to children's EBs, where they advertise their extra cells */
+#define ORCHESTRA_CONF_EBSF_RX_FROM_CHILDREN 1
+#endif /* WITH_ORCHESTRA_ADAPTIVE */
 
 #endif /* WITH_ORCHESTRA */
 
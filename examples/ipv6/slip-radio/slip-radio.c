@@ -41,6 +41,7 @@
 #include <string.h>
 #include "net/netstack.h"
 #include "net/packetbuf.h"
+#include "net/queuebuf.h"
 
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
@@ -54,10 +55,31 @@ extern const struct slip_radio_sensors SLIP_RADIO_CONF_SENSORS;
 
 void slip_send_packet(const uint8_t *ptr, int len);
 
- /* max 16 packets at the same time??? */
+/* max 16 packets at the same time??? */
 uint8_t packet_ids[16];
 int packet_pos;
 
+/* The number of frames the host may have outstanding in "!B" batches:
+   one being transmitted and one arriving over SLIP. */
+#ifdef SLIP_RADIO_CONF_WINDOW
+#define SLIP_RADIO_WINDOW SLIP_RADIO_CONF_WINDOW
+#else
+#define SLIP_RADIO_WINDOW 2
+#endif
+
+/* Batched frames waiting to be transmitted, in the order they were
+   received */
+struct tx_entry {
+  struct queuebuf *buf;
+  uint8_t sid;
+};
+static struct tx_entry tx_queue[SLIP_RADIO_WINDOW];
+static uint8_t tx_head;
+static uint8_t tx_count;
+static uint8_t tx_busy;
+
+PROCESS_NAME(slip_radio_process);
+
 static int slip_radio_cmd_handler(const uint8_t *data, int len);
 
 #if CONTIKI_TARGET_NOOLIBERRY
@@ -93,6 +115,139 @@ packet_sent(void *ptr, int status, int transmissions)
   buf[pos++] = status; /* one byte ? */
   buf[pos++] = transmissions;
   cmd_send(buf, pos);
+
+  /* A frame of a "!B" batch is done: send the next one */
+  if(tx_busy && ptr == &tx_queue[tx_head].sid) {
+    queuebuf_free(tx_queue[tx_head].buf);
+    tx_head = (tx_head + 1) % SLIP_RADIO_WINDOW;
+    tx_count--;
+    tx_busy = 0;
+    /* Send the next frame from the process */
+    process_poll(&slip_radio_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_next(void)
+{
+  struct tx_entry *e;
+
+  if(tx_busy || tx_count == 0) {
+    return;
+  }
+  e = &tx_queue[tx_head];
+  queuebuf_to_packetbuf(e->buf);
+
+  PRINTF("slip-radio: sending %u (%d bytes)\n", e->sid, packetbuf_datalen());
+
+  /* parse frame before sending to get addresses, etc. */
+  no_framer.parse();
+  tx_busy = 1;
+  NETSTACK_LLSEC.send(packet_sent, &e->sid);
+}
+/*---------------------------------------------------------------------------*/
+static void
+report_error(uint8_t sid)
+{
+  uint8_t buf[5];
+
+  buf[0] = '!';
+  buf[1] = 'R';
+  buf[2] = sid;
+  buf[3] = MAC_TX_ERR;
+  buf[4] = 0;
+  cmd_send(buf, sizeof(buf));
+}
+/*---------------------------------------------------------------------------*/
+/* Load a frame with serialized attributes into the packetbuf. */
+static int
+frame_to_packetbuf(const uint8_t *data, int len)
+{
+  int pos;
+
+  packetbuf_clear();
+  pos = packetutils_deserialize_atts(data, len);
+  if(pos < 0) {
+    PRINTF("slip-radio: illegal packet attributes\n");
+    return 0;
+  }
+  len -= pos;
+  if(len > PACKETBUF_SIZE) {
+    len = PACKETBUF_SIZE;
+  }
+  memcpy(packetbuf_dataptr(), &data[pos], len);
+  packetbuf_set_datalen(len);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* "!S": send the frame right away, the host paces these frames itself. */
+static void
+send_frame(uint8_t sid, const uint8_t *data, int len)
+{
+  packet_ids[packet_pos] = sid;
+
+  if(!frame_to_packetbuf(data, len)) {
+    return;
+  }
+
+  PRINTF("slip-radio: sending %u (%d bytes)\n", sid, packetbuf_datalen());
+
+  /* parse frame before sending to get addresses, etc. */
+  no_framer.parse();
+  NETSTACK_LLSEC.send(packet_sent, &packet_ids[packet_pos]);
+
+  packet_pos++;
+  if(packet_pos >= sizeof(packet_ids)) {
+    packet_pos = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Queue a frame of a "!B" batch for transmission. */
+static void
+queue_frame(uint8_t sid, const uint8_t *data, int len)
+{
+  struct tx_entry *e;
+
+  if(!frame_to_packetbuf(data, len)) {
+    report_error(sid);
+    return;
+  }
+
+  e = &tx_queue[(tx_head + tx_count) % SLIP_RADIO_WINDOW];
+  if(tx_count == SLIP_RADIO_WINDOW ||
+     (e->buf = queuebuf_new_from_packetbuf()) == NULL) {
+    PRINTF("slip-radio: queue full, dropping %u\n", sid);
+    report_error(sid);
+    return;
+  }
+  e->sid = sid;
+  tx_count++;
+  send_next();
+}
+/*---------------------------------------------------------------------------*/
+static void
+batch_input(const uint8_t *data, int len)
+{
+  int count;
+  int flen;
+  int pos;
+
+  if(!packetutils_batch_check_crc(data, len)) {
+    /* The host times out the frames of a corrupted batch */
+    PRINTF("slip-radio: bad batch CRC\n");
+    return;
+  }
+  len -= PACKETUTILS_BATCH_CRC_LEN;
+  count = data[2];
+  pos = PACKETUTILS_BATCH_HDR_LEN;
+  while(count-- > 0 && pos + PACKETUTILS_BATCH_FRAME_HDR_LEN <= len) {
+    flen = (data[pos + 1] << 8) | data[pos + 2];
+    if(pos + PACKETUTILS_BATCH_FRAME_HDR_LEN + flen > len) {
+      break;
+    }
+    queue_frame(data[pos], &data[pos + PACKETUTILS_BATCH_FRAME_HDR_LEN], flen);
+    pos += PACKETUTILS_BATCH_FRAME_HDR_LEN + flen;
+  }
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -103,35 +258,20 @@ slip_radio_cmd_handler(const uint8_t *data, int len)
     /* should send out stuff to the radio - ignore it as IP */
     /* --- s e n d --- */
     if(data[1] == 'S') {
-      int pos;
-      packet_ids[packet_pos] = data[2];
-
-      packetbuf_clear();
-      pos = packetutils_deserialize_atts(&data[3], len - 3);
-      if(pos < 0) {
-        PRINTF("slip-radio: illegal packet attributes\n");
-        return 1;
-      }
-      pos += 3;
-      len -= pos;
-      if(len > PACKETBUF_SIZE) {
-        len = PACKETBUF_SIZE;
-      }
-      memcpy(packetbuf_dataptr(), &data[pos], len);
-      packetbuf_set_datalen(len);
-
-      PRINTF("slip-radio: sending %u (%d bytes)\n",
-             data[2], packetbuf_datalen());
-
-      /* parse frame before sending to get addresses, etc. */
-      no_framer.parse();
-      NETSTACK_LLSEC.send(packet_sent, &packet_ids[packet_pos]);
-
-      packet_pos++;
-      if(packet_pos >= sizeof(packet_ids)) {
-	packet_pos = 0;
-      }
-
+      send_frame(data[2], &data[3], len - 3);
+      return 1;
+    } else if(data[1] == 'B') {
+      batch_input(data, len);
+      return 1;
+    } else if(data[1] == 'M' && len >= 2 + sizeof(uip_lladdr.addr)) {
+      /* A border router with several radios gives them one address */
+      memcpy(uip_lladdr.addr, &data[2], sizeof(uip_lladdr.addr));
+      linkaddr_set_node_addr((linkaddr_t *)uip_lladdr.addr);
+      NETSTACK_RADIO.set_object(RADIO_PARAM_64BIT_ADDR, &data[2],
+                                sizeof(uip_lladdr.addr));
+      return 1;
+    } else if(data[1] == 'P' && len >= 4) {
+      NETSTACK_RADIO.set_value(RADIO_PARAM_PAN_ID, (data[2] << 8) | data[3]);
       return 1;
     }
   } else if(uip_buf[0] == '?') {
@@ -146,6 +286,16 @@ slip_radio_cmd_handler(const uint8_t *data, int len)
       uip_len = 10;
       cmd_send(uip_buf, uip_len);
       return 1;
+    } else if(data[1] == 'W') {
+      /* The host supports the windowed protocol */
+      uip_buf[0] = '!';
+      uip_buf[1] = 'W';
+      uip_buf[2] = SLIP_RADIO_WINDOW;
+      uip_buf[3] = (UIP_BUFSIZE - UIP_LLH_LEN) >> 8;
+      uip_buf[4] = (UIP_BUFSIZE - UIP_LLH_LEN) & 0xff;
+      uip_len = 5;
+      cmd_send(uip_buf, uip_len);
+      return 1;
     }
   }
   return 0;
@@ -175,6 +325,7 @@ init(void)
   process_start(&slip_process, NULL);
   slip_set_input_callback(slip_input_callback);
   packet_pos = 0;
+  tx_head = tx_count = tx_busy = 0;
 }
 /*---------------------------------------------------------------------------*/
 #if !SLIP_RADIO_CONF_NO_PUTCHAR
@@ -227,6 +378,10 @@ PROCESS_THREAD(slip_radio_process, ev, data)
   while(1) {
     PROCESS_YIELD();
 
+    if(ev == PROCESS_EVENT_POLL) {
+      send_next();
+    }
+
     if(etimer_expired(&et)) {
       etimer_reset(&et);
 #ifdef SLIP_RADIO_CONF_SENSORS
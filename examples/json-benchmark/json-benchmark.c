@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	A benchmark of the JSON library on the native platform. It
+ *	writes a jsontree document through putchar() and through
+ *	chunked buffers, then parses a larger document in one piece
+ *	and in chunks of various sizes, checking that all ways give
+ *	the same result.
+ *
+ *	The buffered writer is there for chunked and block-wise
+ *	output, not for speed: walking the tree dominates, and both
+ *	writers are within the noise of each other here. Each result
+ *	is the best of BENCHMARK_RUNS runs to keep that noise down.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "contiki.h"
+#include "jsontree.h"
+#include "jsonparse.h"
+
+#ifndef BENCHMARK_ROUNDS
+#define BENCHMARK_ROUNDS	2000
+#endif
+
+#ifndef BENCHMARK_RUNS
+#define BENCHMARK_RUNS		5
+#endif
+
+/* Copies of the jsontree document in the document to parse. */
+#define DOC_COPIES		32
+#define DOC_SIZE		8192
+
+PROCESS(json_benchmark, "JSON benchmark");
+AUTOSTART_PROCESSES(&json_benchmark);
+
+static struct jsontree_string name = JSONTREE_STRING("node \"42\"");
+static struct jsontree_uint uptime = { JSON_TYPE_UINT, 123456 };
+static struct jsontree_int temperature = { JSON_TYPE_INT, -12 };
+static struct jsontree_uint channel = { JSON_TYPE_UINT, 26 };
+static struct jsontree_int power = { JSON_TYPE_INT, -3 };
+static struct jsontree_uint samples[16];
+
+JSONTREE_ARRAY(readings, 16);
+
+JSONTREE_OBJECT(radio_tree,
+                JSONTREE_PAIR("channel", &channel),
+                JSONTREE_PAIR("power", &power));
+
+JSONTREE_OBJECT(node_tree,
+                JSONTREE_PAIR("name", &name),
+                JSONTREE_PAIR("uptime", &uptime),
+                JSONTREE_PAIR("temp", &temperature),
+                JSONTREE_PAIR("radio", &radio_tree),
+                JSONTREE_PAIR("readings", &readings));
+
+static char doc[DOC_SIZE];
+static int doc_len;
+static char out[1024];
+static int out_len;
+
+static const int chunk_sizes[] = { 1, 16, 64, 512 };
+/*---------------------------------------------------------------------------*/
+static unsigned long
+elapsed_us(const struct timespec *from)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - from->tv_sec) * 1000000L +
+    (now.tv_nsec - from->tv_nsec) / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+best_us(const struct timespec *from, unsigned long best)
+{
+  unsigned long us;
+
+  us = elapsed_us(from);
+  return us < best ? us : best;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(const char *what, unsigned long bytes, unsigned long us)
+{
+  if(us == 0) {
+    us = 1;
+  }
+  printf("%-24s %8lu bytes in %7lu us: %5lu.%02lu MB/s\n", what, bytes, us,
+         bytes / us, bytes * 100 / us % 100);
+}
+/*---------------------------------------------------------------------------*/
+static int
+out_putchar(int c)
+{
+  if(out_len < sizeof(out)) {
+    out[out_len++] = c;
+  }
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+static int
+out_flush(struct jsontree_buffer *buffer)
+{
+  if(out_len + buffer->len > sizeof(out)) {
+    return 0;
+  }
+  memcpy(&out[out_len], buffer->data, buffer->len);
+  out_len += buffer->len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_tree(struct jsontree_buffer *buffer)
+{
+  struct jsontree_context js_ctx;
+
+  out_len = 0;
+  jsontree_setup(&js_ctx, (struct jsontree_value *)&node_tree, out_putchar);
+  if(buffer != NULL) {
+    jsontree_set_buffer(&js_ctx, buffer);
+  }
+  while(jsontree_print_next(&js_ctx));
+  if(buffer != NULL) {
+    jsontree_buffer_flush(buffer);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Sums up the tokens and values so that the parses can be compared. */
+static unsigned long
+account(struct jsonparse_state *state, int type)
+{
+  if(type == JSON_TYPE_NUMBER) {
+    return type + jsonparse_get_value_as_int(state);
+  } else if(type == JSON_TYPE_STRING || type == JSON_TYPE_PAIR_NAME) {
+    return type + jsonparse_get_len(state);
+  }
+  return type;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+parse_whole(void)
+{
+  struct jsonparse_state state;
+  unsigned long sum = 0;
+  int type;
+
+  jsonparse_setup(&state, doc, doc_len);
+  while((type = jsonparse_next(&state)) != 0) {
+    sum += account(&state, type);
+  }
+  return state.error ? 0 : sum;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+parse_chunked(int chunk_size)
+{
+  static struct jsonparse_stream stream;
+  unsigned long sum = 0;
+  int type, pos, n;
+
+  jsonparse_stream_setup(&stream);
+  pos = 0;
+  while((type = jsonparse_stream_next(&stream)) != 0) {
+    if(type == JSONPARSE_NEED_MORE) {
+      n = doc_len - pos < chunk_size ? doc_len - pos : chunk_size;
+      jsonparse_stream_feed(&stream, &doc[pos], n);
+      pos += n;
+      if(pos == doc_len) {
+        jsonparse_stream_finish(&stream);
+      }
+    } else {
+      sum += account(&stream.state, type);
+    }
+  }
+  return stream.state.error ? 0 : sum;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(json_benchmark, ev, data)
+{
+  static char chunk[64];
+  struct jsontree_buffer buffer;
+  struct jsontree_context js_ctx;
+  struct timespec start;
+  unsigned long sum, expected, us;
+  char what[32];
+  int i, j, run;
+
+  PROCESS_BEGIN();
+
+  for(i = 0; i < 16; i++) {
+    samples[i].type = JSON_TYPE_UINT;
+    samples[i].value = i * 997;
+    readings.values[i] = (struct jsontree_value *)&samples[i];
+  }
+
+  /* Writer: putchar() against 64-byte chunks */
+  write_tree(NULL);
+  memcpy(doc, out, out_len);
+  j = out_len;
+  us = (unsigned long)-1;
+  for(run = 0; run < BENCHMARK_RUNS; run++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCHMARK_ROUNDS; i++) {
+      write_tree(NULL);
+    }
+    us = best_us(&start, us);
+  }
+  report("jsontree putchar", (unsigned long)j * BENCHMARK_ROUNDS, us);
+
+  us = (unsigned long)-1;
+  for(run = 0; run < BENCHMARK_RUNS; run++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCHMARK_ROUNDS; i++) {
+      jsontree_buffer_init(&buffer, chunk, sizeof(chunk), out_flush);
+      write_tree(&buffer);
+    }
+    us = best_us(&start, us);
+  }
+  report("jsontree 64-byte chunks", (unsigned long)j * BENCHMARK_ROUNDS, us);
+  if(out_len != j || memcmp(doc, out, j) != 0) {
+    printf("Buffered output differs\n");
+    exit(1);
+  }
+
+  /* A reset context writes through its putchar() again */
+  jsontree_setup(&js_ctx, (struct jsontree_value *)&node_tree, out_putchar);
+  jsontree_buffer_init(&buffer, chunk, sizeof(chunk), NULL);
+  jsontree_set_buffer(&js_ctx, &buffer);
+  jsontree_reset(&js_ctx);
+  out_len = 0;
+  while(jsontree_print_next(&js_ctx));
+  if(out_len != j || memcmp(doc, out, j) != 0) {
+    printf("Output after reset differs\n");
+    exit(1);
+  }
+
+  /* The second block of a 32-byte block2 transfer */
+  jsontree_buffer_init(&buffer, chunk, 32, NULL);
+  buffer.skip = 32;
+  write_tree(&buffer);
+  if(buffer.len != 32 || !buffer.full || memcmp(chunk, &doc[32], 32) != 0) {
+    printf("Block output differs\n");
+    exit(1);
+  }
+
+  /* Parser: a document of DOC_COPIES trees */
+  doc_len = 0;
+  doc[doc_len++] = '[';
+  for(i = 0; i < DOC_COPIES; i++) {
+    write_tree(NULL);
+    memcpy(&doc[doc_len], out, out_len);
+    doc_len += out_len;
+    doc[doc_len++] = i < DOC_COPIES - 1 ? ',' : ']';
+    doc[doc_len++] = '\n';
+  }
+  doc[doc_len] = '\0';
+
+  expected = parse_whole();
+  us = (unsigned long)-1;
+  for(run = 0; run < BENCHMARK_RUNS; run++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < BENCHMARK_ROUNDS / 10; i++) {
+      parse_whole();
+    }
+    us = best_us(&start, us);
+  }
+  report("jsonparse whole", (unsigned long)doc_len * (BENCHMARK_ROUNDS / 10),
+         us);
+
+  for(j = 0; j < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); j++) {
+    sum = parse_chunked(chunk_sizes[j]);
+    if(sum != expected || expected == 0) {
+      printf("Chunked parse (%d) differs: %lu != %lu\n",
+             chunk_sizes[j], sum, expected);
+      exit(1);
+    }
+    us = (unsigned long)-1;
+    for(run = 0; run < BENCHMARK_RUNS; run++) {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for(i = 0; i < BENCHMARK_ROUNDS / 10; i++) {
+        parse_chunked(chunk_sizes[j]);
+      }
+      us = best_us(&start, us);
+    }
+    snprintf(what, sizeof(what), "jsonparse %d-byte chunks", chunk_sizes[j]);
+    report(what, (unsigned long)doc_len * (BENCHMARK_ROUNDS / 10), us);
+  }
+
+  printf("Benchmark finished\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
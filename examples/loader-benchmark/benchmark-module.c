@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	A self-contained module for the ELF loader benchmark. Every
+ *	function and variable is global, so each relocation requires a
+ *	symbol lookup by name. The module is built for a 32-bit host
+ *	and does not include any Contiki headers.
+ */
+
+struct process;
+
+#define BENCHMARK_FUNCTIONS(F) \
+  F(0, 1) F(1, 2) F(2, 3) F(3, 4) F(4, 5) F(5, 6) F(6, 7) F(7, 8) \
+  F(8, 9) F(9, 10) F(10, 11) F(11, 12) F(12, 13) F(13, 14) F(14, 15) \
+  F(15, 16) F(16, 17) F(17, 18) F(18, 19) F(19, 20) F(20, 21) \
+  F(21, 22) F(22, 23) F(23, 24) F(24, 25) F(25, 26) F(26, 27) \
+  F(27, 28) F(28, 29) F(29, 30) F(30, 31) F(31, 0)
+
+#define DECLARE(n, next) \
+  extern int benchmark_value_##n;                               \
+  extern const int benchmark_constant_##n;                      \
+  int benchmark_function_##n(int x);
+#define DEFINE(n, next)                                         \
+  int benchmark_value_##n = n;                                  \
+  const int benchmark_constant_##n = n * 3;                     \
+  int                                                           \
+  benchmark_function_##n(int x)                                 \
+  {                                                             \
+    if(x <= 0) {                                                \
+      return benchmark_value_##n + benchmark_constant_##n;      \
+    }                                                           \
+    benchmark_value_##n += benchmark_value_##next;               \
+    return benchmark_function_##next(x - 1) +                   \
+      benchmark_function_0(x - 2) + benchmark_constant_##next;  \
+  }
+
+BENCHMARK_FUNCTIONS(DECLARE)
+BENCHMARK_FUNCTIONS(DEFINE)
+
+struct process * const autostart_processes[] = {0};
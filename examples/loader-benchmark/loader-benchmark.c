@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	A benchmark of the time the ELF loader takes to load and
+ *	relocate a module. The module, benchmark-module.elf, is copied
+ *	to a scratch file before every load because the x86 relocator
+ *	patches the file in place.
+ */
+
+#include <stdio.h>
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "loader/elfloader.h"
+
+#ifndef BENCHMARK_LOADS
+#define BENCHMARK_LOADS		200
+#endif
+
+#define MODULE_FILE		"benchmark-module.elf"
+#define SCRATCH_FILE		"benchmark-module.tmp"
+
+PROCESS(loader_benchmark, "ELF loader benchmark");
+AUTOSTART_PROCESSES(&loader_benchmark);
+/*---------------------------------------------------------------------------*/
+static int
+copy_module(int out)
+{
+  static char buf[256];
+  int in;
+  int len;
+
+  in = cfs_open(MODULE_FILE, CFS_READ);
+  if(in < 0) {
+    return -1;
+  }
+  while((len = cfs_read(in, buf, sizeof(buf))) > 0) {
+    cfs_write(out, buf, len);
+  }
+  cfs_close(in);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(loader_benchmark, ev, data)
+{
+  static clock_time_t elapsed;
+  static clock_time_t start;
+  static unsigned i;
+  int fd;
+  int ret;
+
+  PROCESS_BEGIN();
+
+  printf("Loading %s %u times, symbol table cache %u bytes\n",
+         MODULE_FILE, BENCHMARK_LOADS, ELFLOADER_SYMTAB_CACHE_SIZE);
+
+  elfloader_init();
+  elapsed = 0;
+  ret = ELFLOADER_OK;
+  for(i = 0; i < BENCHMARK_LOADS; i++) {
+    fd = cfs_open(SCRATCH_FILE, CFS_READ | CFS_WRITE);
+    if(fd < 0 || copy_module(fd) < 0) {
+      printf("Failed to copy %s\n", MODULE_FILE);
+      ret = -1;
+      break;
+    }
+    start = clock_time();
+    ret = elfloader_load(fd);
+    elapsed += clock_time() - start;
+    cfs_close(fd);
+    if(ret != ELFLOADER_OK) {
+      printf("Load failed: %d %s\n", ret, elfloader_unknown);
+      break;
+    }
+  }
+  cfs_remove(SCRATCH_FILE);
+
+  if(ret == ELFLOADER_OK) {
+    printf("%u loads in %lu ms, %lu us per load\n", BENCHMARK_LOADS,
+           (unsigned long)(elapsed * 1000 / CLOCK_SECOND),
+           (unsigned long)(elapsed * 1000000UL / CLOCK_SECOND / BENCHMARK_LOADS));
+  }
+  printf("Benchmark finished\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,14 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Large enough for the benchmark module. */
+#define ELFLOADER_CONF_DATAMEMORY_SIZE	0x1000
+#define ELFLOADER_CONF_TEXTMEMORY_SIZE	0x4000
+
+/* Build with DEFINES=ELFLOADER_CONF_SYMTAB_CACHE_SIZE=0 to measure
+   loading without the symbol table cache. */
+#ifndef ELFLOADER_CONF_SYMTAB_CACHE_SIZE
+#define ELFLOADER_CONF_SYMTAB_CACHE_SIZE	0x2000
+#endif
+
+#endif /* PROJECT_CONF_H_ */
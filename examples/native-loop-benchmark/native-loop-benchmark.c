@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ *	A benchmark of the native platform main loop. A child process
+ *	writes time stamps into a pipe that the main loop waits on, and
+ *	the benchmark measures the time until the process that is
+ *	polled from the select callback gets to run. It then idles on an
+ *	etimer and reports how much CPU time the main loop used.
+ *
+ *	Build with DEFINES=SELECT_CONF_EPOLL=1 to measure the epoll()
+ *	based loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "contiki.h"
+
+#ifndef BENCHMARK_SAMPLES
+#define BENCHMARK_SAMPLES	500
+#endif
+
+/* Interval between the samples, in microseconds. */
+#ifndef BENCHMARK_INTERVAL
+#define BENCHMARK_INTERVAL	4000
+#endif
+
+/* How long to idle, in seconds. */
+#ifndef BENCHMARK_IDLE
+#define BENCHMARK_IDLE		5
+#endif
+
+PROCESS(native_loop_benchmark, "Native main loop benchmark");
+AUTOSTART_PROCESSES(&native_loop_benchmark);
+
+static int pipefd[2];
+static struct timespec sent;
+static unsigned long samples;
+static unsigned long total_us;
+static unsigned long max_us;
+/*---------------------------------------------------------------------------*/
+static unsigned long
+elapsed_us(const struct timespec *from, const struct timespec *to)
+{
+  return (to->tv_sec - from->tv_sec) * 1000000L +
+    (to->tv_nsec - from->tv_nsec) / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned long
+cpu_us(void)
+{
+  struct rusage ru;
+
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec * 1000000L + ru.ru_utime.tv_usec +
+    ru.ru_stime.tv_sec * 1000000L + ru.ru_stime.tv_usec;
+}
+/*---------------------------------------------------------------------------*/
+static void
+writer(void)
+{
+  struct timespec now;
+  int i;
+
+  for(i = 0; i < BENCHMARK_SAMPLES; i++) {
+    usleep(BENCHMARK_INTERVAL);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(write(pipefd[1], &now, sizeof(now)) != sizeof(now)) {
+      break;
+    }
+  }
+  _exit(0);
+}
+/*---------------------------------------------------------------------------*/
+static int
+pipe_set_fd(fd_set *rset, fd_set *wset)
+{
+  FD_SET(pipefd[0], rset);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+pipe_handle_fd(fd_set *rset, fd_set *wset)
+{
+  int len;
+
+  if(FD_ISSET(pipefd[0], rset)) {
+    len = read(pipefd[0], &sent, sizeof(sent));
+    if(len == sizeof(sent)) {
+      process_poll(&native_loop_benchmark);
+    } else if(len <= 0) {
+      select_set_callback(pipefd[0], NULL);
+      close(pipefd[0]);
+      process_post(&native_loop_benchmark, PROCESS_EVENT_CONTINUE, NULL);
+    }
+  }
+}
+static const struct select_callback pipe_callback = {
+  pipe_set_fd, pipe_handle_fd
+};
+/*---------------------------------------------------------------------------*/
+static void
+pollhandler(void)
+{
+  struct timespec now;
+  unsigned long us;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  us = elapsed_us(&sent, &now);
+  total_us += us;
+  if(us > max_us) {
+    max_us = us;
+  }
+  samples++;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(native_loop_benchmark, ev, data)
+{
+  static struct etimer et;
+  static struct timespec start;
+  static unsigned long start_cpu;
+  struct timespec now;
+  unsigned long wall;
+
+  PROCESS_POLLHANDLER(pollhandler());
+
+  PROCESS_BEGIN();
+
+  printf("Measuring %u wakeups, %u us apart\n",
+         BENCHMARK_SAMPLES, BENCHMARK_INTERVAL);
+
+  if(pipe(pipefd) < 0) {
+    perror("pipe");
+    PROCESS_EXIT();
+  }
+  if(fork() == 0) {
+    close(pipefd[0]);
+    writer();
+  }
+  close(pipefd[1]);
+  select_set_callback(pipefd[0], &pipe_callback);
+
+  PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);
+  wait(NULL);
+
+  if(samples > 0) {
+    printf("Latency: %lu samples, average %lu us, max %lu us\n",
+           samples, total_us / samples, max_us);
+  }
+
+  printf("Idling for %u seconds\n", BENCHMARK_IDLE);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  start_cpu = cpu_us();
+  etimer_set(&et, BENCHMARK_IDLE * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  wall = elapsed_us(&start, &now);
+  printf("Idle CPU: %lu us in %lu ms (%lu.%02lu%%)\n",
+         cpu_us() - start_cpu, wall / 1000,
+         (cpu_us() - start_cpu) * 100 / wall,
+         (cpu_us() - start_cpu) * 10000 / wall % 100);
+
+  printf("Benchmark finished\n");
+  exit(0);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -44,6 +44,24 @@ struct select_callback {
 };
 int select_set_callback(int fd, const struct select_callback *callback);
 
+/* Use an epoll() based main loop (Linux only) that sleeps until the
+   next timer deadline or file descriptor event. The rtimer is then
+   driven by a timerfd in the main loop instead of by SIGALRM. It cuts
+   idle CPU use, but wakes up later than the select() loop, so it is
+   off by default. */
+#ifndef SELECT_CONF_EPOLL
+#define SELECT_CONF_EPOLL 0
+#endif /* SELECT_CONF_EPOLL */
+
+#ifndef RTIMER_ARCH_CONF_TIMERFD
+#define RTIMER_ARCH_CONF_TIMERFD SELECT_CONF_EPOLL
+#endif
+
+/* The tap driver registers its descriptor with the main loop. */
+#ifndef TAPDEV_CONF_SELECT_CALLBACK
+#define TAPDEV_CONF_SELECT_CALLBACK 1
+#endif
+
 #define CC_CONF_REGISTER_ARGS          1
 #define CC_CONF_FUNCTION_POINTER_ARGS  1
 #define CC_CONF_VA_ARGS                1
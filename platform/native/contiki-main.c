@@ -43,6 +43,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/select.h>
@@ -54,6 +55,7 @@
 
 #include "contiki.h"
 #include "net/netstack.h"
+#include "sys/tickless.h"
 
 #include "ctk/ctk.h"
 #include "ctk/ctk-curses.h"
@@ -75,12 +77,42 @@
 #ifdef SELECT_CONF_MAX
 #define SELECT_MAX SELECT_CONF_MAX
 #else
-#define SELECT_MAX 8
+#define SELECT_MAX 16
 #endif
 
+#ifdef SELECT_CONF_EPOLL
+#define SELECT_EPOLL SELECT_CONF_EPOLL
+#else
+#define SELECT_EPOLL 0
+#endif
+
+/* Upper bound on how long the main loop sleeps, in clock ticks, also
+   when no timer is pending. */
+#ifdef SELECT_CONF_MAX_SLEEP
+#define SELECT_MAX_SLEEP SELECT_CONF_MAX_SLEEP
+#elif WITH_GUI
+/* Keep checking for console resizes. */
+#define SELECT_MAX_SLEEP (CLOCK_SECOND / 10)
+#else
+#define SELECT_MAX_SLEEP CLOCK_SECOND
+#endif
+
+#if SELECT_EPOLL
+#include <sys/epoll.h>
+#endif /* SELECT_EPOLL */
+
 static const struct select_callback *select_callback[SELECT_MAX];
 static int select_max = 0;
 
+#if SELECT_EPOLL
+static int epoll_fd = -1;
+/* The events each descriptor is currently registered for. */
+static uint32_t epoll_registered[SELECT_MAX];
+/* Set for descriptors that epoll cannot wait on, such as regular files
+   and /dev/null on stdin. select() always reports them as ready. */
+static uint8_t epoll_unpollable[SELECT_MAX];
+#endif /* SELECT_EPOLL */
+
 SENSORS(&pir_sensor, &vib_sensor, &button_sensor);
 
 static uint8_t serial_id[] = {0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08};
@@ -88,6 +120,116 @@ static uint8_t serial_id[] = {0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08};
 static uint16_t node_id = 0x0102;
 #endif /* !NETSTACK_CONF_WITH_IPV6 */
 /*---------------------------------------------------------------------------*/
+#if SELECT_EPOLL
+static void
+epoll_register(int fd, int add)
+{
+  struct epoll_event ev;
+
+  if(epoll_fd < 0) {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(epoll_fd < 0) {
+      perror("epoll_create1");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  epoll_unpollable[fd] = 0;
+  epoll_registered[fd] = 0;
+  memset(&ev, 0, sizeof(ev));
+  ev.data.fd = fd;
+  if(add) {
+    /* The interest set is filled in from set_fd() by the main loop. */
+    if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      if(errno == EPERM) {
+        epoll_unpollable[fd] = 1;
+      } else if(errno != EEXIST) {
+        perror("epoll_ctl");
+      }
+    }
+  } else {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Ask the callbacks which events they want, update the registrations
+   that changed and return non-zero if any unpollable descriptor wants
+   to be serviced. */
+static int
+epoll_update(void)
+{
+  struct epoll_event ev;
+  fd_set fdr;
+  fd_set fdw;
+  uint32_t events;
+  int unpollable;
+  int i;
+
+  unpollable = 0;
+  for(i = 0; i <= select_max; i++) {
+    if(select_callback[i] == NULL) {
+      continue;
+    }
+    FD_ZERO(&fdr);
+    FD_ZERO(&fdw);
+    events = 0;
+    if(select_callback[i]->set_fd(&fdr, &fdw)) {
+      if(FD_ISSET(i, &fdr)) {
+        events |= EPOLLIN;
+      }
+      if(FD_ISSET(i, &fdw)) {
+        events |= EPOLLOUT;
+      }
+    }
+    if(epoll_unpollable[i]) {
+      unpollable |= events != 0;
+    } else if(events != epoll_registered[i]) {
+      memset(&ev, 0, sizeof(ev));
+      ev.events = events;
+      ev.data.fd = i;
+      if(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, i, &ev) == 0) {
+        epoll_registered[i] = events;
+      }
+    }
+  }
+  return unpollable;
+}
+/*---------------------------------------------------------------------------*/
+static void
+epoll_handle(int fd, uint32_t events)
+{
+  fd_set fdr;
+  fd_set fdw;
+
+  FD_ZERO(&fdr);
+  FD_ZERO(&fdw);
+  if(events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+    FD_SET(fd, &fdr);
+  }
+  if(events & (EPOLLOUT | EPOLLERR)) {
+    FD_SET(fd, &fdw);
+  }
+  if(fd >= 0 && fd < SELECT_MAX && select_callback[fd] != NULL) {
+    select_callback[fd]->handle_fd(&fdr, &fdw);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Milliseconds until the system next has to run, or 0 if it has work
+   to do now. Never more than SELECT_MAX_SLEEP. */
+static int
+next_timeout(void)
+{
+  clock_time_t delta;
+
+  delta = tickless_next_wakeup();
+  if(delta > SELECT_MAX_SLEEP) {
+    delta = SELECT_MAX_SLEEP;
+  }
+  /* Round up so that we do not wake up just before the deadline. */
+  return (delta * 1000 + CLOCK_SECOND - 1) / CLOCK_SECOND;
+}
+#endif /* SELECT_EPOLL */
+/*---------------------------------------------------------------------------*/
 int
 select_set_callback(int fd, const struct select_callback *callback)
 {
@@ -101,6 +243,10 @@ select_set_callback(int fd, const struct select_callback *callback)
 
     select_callback[fd] = callback;
 
+#if SELECT_EPOLL
+    epoll_register(fd, callback != NULL);
+#endif /* SELECT_EPOLL */
+
     /* Update fd max */
     if(callback != NULL) {
       if(fd > select_max) {
@@ -130,9 +276,15 @@ static void
 stdin_handle_fd(fd_set *rset, fd_set *wset)
 {
   char c;
+  ssize_t n;
   if(FD_ISSET(STDIN_FILENO, rset)) {
-    if(read(STDIN_FILENO, &c, 1) > 0) {
+    n = read(STDIN_FILENO, &c, 1);
+    if(n > 0) {
       serial_line_input_byte(c);
+    } else if(n == 0) {
+      /* End of input, e.g. stdin redirected from /dev/null: stop
+         polling it instead of waking up for it over and over. */
+      select_set_callback(STDIN_FILENO, NULL);
     }
   }
 }
@@ -251,6 +403,36 @@ main(int argc, char **argv)
 
   select_set_callback(STDIN_FILENO, &stdin_fd);
   while(1) {
+#if SELECT_EPOLL
+    struct epoll_event events[SELECT_MAX];
+    int i;
+    int n;
+    int timeout;
+
+    timeout = process_run() ? 0 : next_timeout();
+    if(epoll_update()) {
+      timeout = 0;
+    }
+
+    n = epoll_wait(epoll_fd, events, SELECT_MAX, timeout);
+    if(n < 0) {
+      if(errno != EINTR) {
+        perror("epoll_wait");
+      }
+    } else {
+      /* Service every descriptor that became ready in this wakeup. */
+      for(i = 0; i < n; i++) {
+        epoll_handle(events[i].data.fd, events[i].events);
+      }
+      for(i = 0; i <= select_max; i++) {
+        if(epoll_unpollable[i] && select_callback[i] != NULL) {
+          epoll_handle(i, EPOLLIN | EPOLLOUT);
+        }
+      }
+    }
+
+    tickless_poll_expired();
+#else /* SELECT_EPOLL */
     fd_set fdr;
     fd_set fdw;
     int maxfd;
@@ -287,6 +469,7 @@ main(int argc, char **argv)
     }
 
     etimer_request_poll();
+#endif /* SELECT_EPOLL */
 
 #if WITH_GUI
     if(console_resize()) {
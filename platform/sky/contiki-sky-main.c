@@ -53,6 +53,7 @@
 #include "cfs-coffee-arch.h"
 #include "cfs/cfs-coffee.h"
 #include "sys/autostart.h"
+#include "sys/tickless.h"
 
 #if UIP_CONF_ROUTER
 
@@ -441,6 +442,9 @@ main(int argc, char **argv)
       }
 #endif
       
+      /* Skip the clock ticks until the next timer, if enabled. */
+      tickless_idle_enter();
+
       /* Re-enable interrupts and go to sleep atomically. */
       ENERGEST_SWITCH(ENERGEST_TYPE_CPU, ENERGEST_TYPE_LPM);
       /* We only want to measure the processing done in IRQs when we
@@ -463,6 +467,7 @@ main(int argc, char **argv)
 	 done during the LPM and store it for next time around.  */
       dint();
       irq_energest = energest_type_time(ENERGEST_TYPE_IRQ);
+      tickless_idle_exit();
       eint();
       watchdog_start();
       ENERGEST_SWITCH(ENERGEST_TYPE_LPM, ENERGEST_TYPE_CPU);
@@ -0,0 +1,37 @@
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+
+#include <stdio.h>
+
+#define UDP_PORT 61618
+
+static struct simple_udp_connection connection;
+
+/*---------------------------------------------------------------------------*/
+PROCESS(udp_process, "Reassembly receiver");
+AUTOSTART_PROCESSES(&udp_process);
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  if(datalen >= 2) {
+    printf("Reassembled %c round %u length %u\n", data[0], data[1], datalen);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(udp_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  simple_udp_register(&connection, UDP_PORT, NULL, UDP_PORT, receiver);
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -5,3 +5,8 @@
 #undef UIP_CONF_BUFFER_SIZE
 #define UIP_CONF_BUFFER_SIZE BUFSIZE
 #endif /* BUFSIZE */
+
+#ifdef WITH_REASSEMBLY
+#undef UIP_CONF_IPV6_REASSEMBLY
+#define UIP_CONF_IPV6_REASSEMBLY 1
+#endif /* WITH_REASSEMBLY */
@@ -0,0 +1,116 @@
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Sends pairs of UDP datagrams to all nodes, each split into IPv6
+ * fragments by hand, with the fragments of the two datagrams
+ * interleaved. The receiver must reassemble both.
+ */
+
+#define UDP_PORT 61618
+
+#define SEND_INTERVAL		(4 * CLOCK_SECOND)
+
+/* Fragments carry 48 bytes of the UDP datagram, so that each one fits
+   in a single 802.15.4 frame */
+#define FRAG_LEN      48
+#define FRAG_COUNT    3
+#define DATAGRAM_LEN  (FRAG_LEN * FRAG_COUNT)
+
+#define UIP_IP_BUF    ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+#define UIP_FRAG_BUF  ((struct uip_frag_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+#define UIP_UDP_BUF   ((struct uip_udp_hdr *)&uip_buf[UIP_LLH_LEN + UIP_IPH_LEN])
+
+static uint8_t datagram[2][DATAGRAM_LEN];
+static uint32_t frag_id;
+
+/*---------------------------------------------------------------------------*/
+PROCESS(frag_process, "IPv6 fragment sender");
+AUTOSTART_PROCESSES(&frag_process);
+/*---------------------------------------------------------------------------*/
+static void
+ip_header(uint8_t proto, uint16_t payload_len)
+{
+  memset(UIP_IP_BUF, 0, UIP_IPH_LEN);
+  UIP_IP_BUF->vtc = 0x60;
+  UIP_IP_BUF->len[0] = payload_len >> 8;
+  UIP_IP_BUF->len[1] = payload_len & 0xff;
+  UIP_IP_BUF->proto = proto;
+  UIP_IP_BUF->ttl = 64;
+  uip_create_linklocal_allnodes_mcast(&UIP_IP_BUF->destipaddr);
+  uip_ds6_select_src(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+}
+/*---------------------------------------------------------------------------*/
+/* Builds the UDP datagram, with its checksum, in datagram[i] */
+static void
+build_datagram(int i, char tag, uint8_t round)
+{
+  uint16_t sum;
+  uint8_t *payload = (uint8_t *)UIP_UDP_BUF + UIP_UDPH_LEN;
+
+  ip_header(UIP_PROTO_UDP, DATAGRAM_LEN);
+  UIP_UDP_BUF->srcport = UIP_HTONS(UDP_PORT);
+  UIP_UDP_BUF->destport = UIP_HTONS(UDP_PORT);
+  UIP_UDP_BUF->udplen = UIP_HTONS(DATAGRAM_LEN);
+  UIP_UDP_BUF->udpchksum = 0;
+  memset(payload, tag, DATAGRAM_LEN - UIP_UDPH_LEN);
+  payload[1] = round;
+  uip_ext_len = 0;
+  uip_len = UIP_IPH_LEN + DATAGRAM_LEN;
+  sum = ~(uip_udpchksum());
+  UIP_UDP_BUF->udpchksum = sum == 0 ? 0xffff : sum;
+  memcpy(datagram[i], UIP_UDP_BUF, DATAGRAM_LEN);
+  uip_clear_buf();
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_fragment(int i, int index)
+{
+  uint16_t offset = index * FRAG_LEN;
+  uint16_t more = index < FRAG_COUNT - 1 ? 1 : 0;
+
+  ip_header(UIP_PROTO_FRAG, UIP_FRAGH_LEN + FRAG_LEN);
+  UIP_FRAG_BUF->next = UIP_PROTO_UDP;
+  UIP_FRAG_BUF->res = 0;
+  UIP_FRAG_BUF->offsetresmore = uip_htons(offset | more);
+  UIP_FRAG_BUF->id = uip_htonl(frag_id + i);
+  memcpy((uint8_t *)UIP_FRAG_BUF + UIP_FRAGH_LEN, datagram[i] + offset, FRAG_LEN);
+  uip_len = UIP_IPH_LEN + UIP_FRAGH_LEN + FRAG_LEN;
+  tcpip_ipv6_output();
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(frag_process, ev, data)
+{
+  static struct etimer periodic_timer;
+  static uint8_t round;
+  int index;
+
+  PROCESS_BEGIN();
+
+  etimer_set(&periodic_timer, 20 * CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+  etimer_set(&periodic_timer, SEND_INTERVAL);
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+    etimer_reset(&periodic_timer);
+
+    round++;
+    printf("Sending round %u\n", round);
+    build_datagram(0, 'A', round);
+    build_datagram(1, 'B', round);
+    /* A1 B1 A2 B2 A3 B3: two reassemblies from the same source at once */
+    for(index = 0; index < FRAG_COUNT; index++) {
+      send_fragment(0, index);
+      send_fragment(1, index);
+    }
+    frag_id += 2;
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
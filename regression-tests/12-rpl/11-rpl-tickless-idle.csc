@@ -0,0 +1,176 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<simconf>
+  <project EXPORT="discard">[APPS_DIR]/mspsim</project>
+  <simulation>
+    <title>RPL tickless idle (Sky)</title>
+    <randomseed>123456</randomseed>
+    <motedelay_us>1000000</motedelay_us>
+    <radiomedium>
+      org.contikios.cooja.radiomediums.UDGM
+      <transmitting_range>50.0</transmitting_range>
+      <interference_range>100.0</interference_range>
+      <success_ratio_tx>1.0</success_ratio_tx>
+      <success_ratio_rx>1.0</success_ratio_rx>
+    </radiomedium>
+    <events>
+      <logoutput>40000</logoutput>
+    </events>
+    <motetype>
+      org.contikios.cooja.mspmote.SkyMoteType
+      <identifier>sky1</identifier>
+      <description>RPL node without tickless idle, and the root</description>
+      <source EXPORT="discard">[CONTIKI_DIR]/regression-tests/12-rpl/code/tickless/tickless-node.c</source>
+      <commands EXPORT="discard">make TARGET=sky clean
+make ticking-node.sky TARGET=sky</commands>
+      <firmware EXPORT="copy">[CONTIKI_DIR]/regression-tests/12-rpl/code/tickless/ticking-node.sky</firmware>
+      <moteinterface>org.contikios.cooja.interfaces.Position</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.IPAddress</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Mote2MoteRelations</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspClock</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspMoteID</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyButton</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyFlash</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.Msp802154Radio</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspSerial</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyLED</moteinterface>
+    </motetype>
+    <motetype>
+      org.contikios.cooja.mspmote.SkyMoteType
+      <identifier>sky2</identifier>
+      <description>Tickless RPL node</description>
+      <source EXPORT="discard">[CONTIKI_DIR]/regression-tests/12-rpl/code/tickless/tickless-node.c</source>
+      <commands EXPORT="discard">make TARGET=sky clean
+make tickless-node.sky TARGET=sky DEFINES=WITH_TICKLESS=1</commands>
+      <firmware EXPORT="copy">[CONTIKI_DIR]/regression-tests/12-rpl/code/tickless/tickless-node.sky</firmware>
+      <moteinterface>org.contikios.cooja.interfaces.Position</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.IPAddress</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Mote2MoteRelations</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspClock</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspMoteID</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyButton</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyFlash</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.Msp802154Radio</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspSerial</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyLED</moteinterface>
+    </motetype>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>0.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>1</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>20.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>2</id>
+      </interface_config>
+      <motetype_identifier>sky2</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>0.0</x>
+        <y>20.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>3</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+  </simulation>
+  <plugin>
+    org.contikios.cooja.plugins.ScriptRunner
+    <plugin_config>
+      <script>TIMEOUT(600000); /* Joining plus three 10 s reports, with room to spare */&#xD;
+&#xD;
+/* Node 2 is built with tickless idle, node 3 is the same kind of idle&#xD;
+   RPL node without it, whose clock ticks CLOCK_SECOND = 128 times per&#xD;
+   second. Tickless idle must cut the clock wakeups to a fraction of&#xD;
+   that. ContikiMAC channel checks run on the rtimer, and the ds6&#xD;
+   maintenance only wakes up for its next expiry, so an idle joined&#xD;
+   node should be left with a few etimer wakeups per second: the&#xD;
+   10 s report, RPL's Trickle timers and neighbor reachability. The&#xD;
+   test only asks for a quarter of the baseline, i.e. fewer than&#xD;
+   about 32 wakeups/s. Each report averages over 10 s, and the&#xD;
+   figures compared are from at least the third report after&#xD;
+   joining, when the fast DIOs of the first seconds are over. */&#xD;
+TICKLESS = 2;&#xD;
+BASELINE = 3;&#xD;
+MAX_RATIO = 4;&#xD;
+REPORTS_NEEDED = 3;&#xD;
+reports = new Array();&#xD;
+wakeups = new Array();&#xD;
+cpu = new Array();&#xD;
+reports[TICKLESS] = 0;&#xD;
+reports[BASELINE] = 0;&#xD;
+&#xD;
+while(true) {&#xD;
+  YIELD();&#xD;
+  if((id != TICKLESS &amp;&amp; id != BASELINE) || !msg.startsWith("Tickless:")) {&#xD;
+    continue;&#xD;
+  }&#xD;
+  log.log(id + ": " + msg + "\n");&#xD;
+  /* The nodes report only once they have joined. Keep the figures&#xD;
+     of the last report of each node. */&#xD;
+  data = msg.split(" ");&#xD;
+  wakeups[id] = parseInt(data[2]);&#xD;
+  cpu[id] = parseInt(data[6]);&#xD;
+  reports[id]++;&#xD;
+  if(reports[TICKLESS] &lt; REPORTS_NEEDED || reports[BASELINE] &lt; REPORTS_NEEDED) {&#xD;
+    continue;&#xD;
+  }&#xD;
+  log.log("Clock wakeups/s: " + wakeups[TICKLESS] + " tickless, " +&#xD;
+          wakeups[BASELINE] + " without; cpu " + cpu[TICKLESS] + " vs " +&#xD;
+          cpu[BASELINE] + "\n");&#xD;
+  if(wakeups[TICKLESS] * MAX_RATIO &gt;= wakeups[BASELINE]) {&#xD;
+    log.log("Tickless idle did not cut the clock wakeups\n");&#xD;
+    log.testFailed();&#xD;
+  }&#xD;
+  log.testOK();&#xD;
+}</script>
+      <active>true</active>
+    </plugin_config>
+    <width>541</width>
+    <z>0</z>
+    <height>448</height>
+    <location_x>299</location_x>
+    <location_y>7</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.SimControl
+    <width>280</width>
+    <z>2</z>
+    <height>160</height>
+    <location_x>7</location_x>
+    <location_y>10</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.LogListener
+    <plugin_config>
+      <filter />
+    </plugin_config>
+    <width>680</width>
+    <z>1</z>
+    <height>240</height>
+    <location_x>51</location_x>
+    <location_y>288</location_y>
+  </plugin>
+</simconf>
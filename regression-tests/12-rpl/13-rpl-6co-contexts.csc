@@ -0,0 +1,194 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<simconf>
+  <project EXPORT="discard">[APPS_DIR]/mspsim</project>
+  <simulation>
+    <title>RPL 6LoWPAN context distribution (Sky)</title>
+    <randomseed>123456</randomseed>
+    <motedelay_us>1000000</motedelay_us>
+    <radiomedium>
+      org.contikios.cooja.radiomediums.UDGM
+      <transmitting_range>50.0</transmitting_range>
+      <interference_range>100.0</interference_range>
+      <success_ratio_tx>1.0</success_ratio_tx>
+      <success_ratio_rx>1.0</success_ratio_rx>
+    </radiomedium>
+    <events>
+      <logoutput>40000</logoutput>
+    </events>
+    <motetype>
+      org.contikios.cooja.mspmote.SkyMoteType
+      <identifier>sky1</identifier>
+      <description>6CO root, learns the contexts</description>
+      <source EXPORT="discard">[CONTIKI_DIR]/regression-tests/12-rpl/code/6co-contexts/context-root.c</source>
+      <commands EXPORT="discard">make TARGET=sky clean
+make context-root.sky TARGET=sky DEFINES=CONTEXT_ROOT=1</commands>
+      <firmware EXPORT="copy">[CONTIKI_DIR]/regression-tests/12-rpl/code/6co-contexts/context-root.sky</firmware>
+      <moteinterface>org.contikios.cooja.interfaces.Position</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.IPAddress</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Mote2MoteRelations</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspClock</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspMoteID</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyButton</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyFlash</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.Msp802154Radio</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspSerial</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyLED</moteinterface>
+    </motetype>
+    <motetype>
+      org.contikios.cooja.mspmote.SkyMoteType
+      <identifier>sky2</identifier>
+      <description>6LoWPAN context node</description>
+      <source EXPORT="discard">[CONTIKI_DIR]/regression-tests/12-rpl/code/6co-contexts/context-node.c</source>
+      <commands EXPORT="discard">make TARGET=sky clean
+make context-node.sky TARGET=sky</commands>
+      <firmware EXPORT="copy">[CONTIKI_DIR]/regression-tests/12-rpl/code/6co-contexts/context-node.sky</firmware>
+      <moteinterface>org.contikios.cooja.interfaces.Position</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.IPAddress</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Mote2MoteRelations</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspClock</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspMoteID</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyButton</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyFlash</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.Msp802154Radio</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspSerial</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyLED</moteinterface>
+    </motetype>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>0.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>1</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>40.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>2</id>
+      </interface_config>
+      <motetype_identifier>sky2</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>80.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>3</id>
+      </interface_config>
+      <motetype_identifier>sky2</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>120.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>4</id>
+      </interface_config>
+      <motetype_identifier>sky2</motetype_identifier>
+    </mote>
+  </simulation>
+  <plugin>
+    org.contikios.cooja.plugins.ScriptRunner
+    <plugin_config>
+      <script>TIMEOUT(900000);&#xD;
+&#xD;
+NODES = 4;&#xD;
+/* The root learns the context after a minute or two and nodes get&#xD;
+   it in the DIOs of their parents. Report the header sizes after that. */&#xD;
+CHECK_TIME = 360000000;&#xD;
+context = new Array();&#xD;
+before = new Array();&#xD;
+after = new Array();&#xD;
+&#xD;
+while(true) {&#xD;
+ YIELD();&#xD;
+ if(!msg.startsWith("CTX: context")) {&#xD;
+   continue;&#xD;
+ }&#xD;
+ data = msg.split(" ");&#xD;
+ context[id] = parseInt(data[2]);&#xD;
+ hdr = parseInt(data[4]);&#xD;
+ if(hdr &gt; 0) {&#xD;
+   if(context[id] == 0 &amp;&amp; before[id] == undefined) {&#xD;
+     before[id] = hdr;&#xD;
+   } else if(context[id] == 1) {&#xD;
+     after[id] = hdr;&#xD;
+   }&#xD;
+ }&#xD;
+&#xD;
+ if(time &lt; CHECK_TIME) {&#xD;
+   continue;&#xD;
+ }&#xD;
+&#xD;
+ done = true;&#xD;
+ for(i = 2; i &lt;= NODES; i++) {&#xD;
+   if(context[i] != 1 || before[i] == undefined || after[i] == undefined) {&#xD;
+     done = false;&#xD;
+     break;&#xD;
+   }&#xD;
+ }&#xD;
+ if(!done) {&#xD;
+   continue;&#xD;
+ }&#xD;
+&#xD;
+ for(i = 2; i &lt;= NODES; i++) {&#xD;
+   log.log("Node " + i + ": average header " + before[i] / 10 +&#xD;
+           " bytes without the context, " + after[i] / 10 + " bytes with it\n");&#xD;
+   if(after[i] &gt;= before[i]) {&#xD;
+     log.log("The context did not shrink the headers of node " + i + "\n");&#xD;
+     log.testFailed();&#xD;
+   }&#xD;
+ }&#xD;
+ log.testOK();&#xD;
+}</script>
+      <active>true</active>
+    </plugin_config>
+    <width>541</width>
+    <z>0</z>
+    <height>448</height>
+    <location_x>299</location_x>
+    <location_y>7</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.SimControl
+    <width>280</width>
+    <z>2</z>
+    <height>160</height>
+    <location_x>7</location_x>
+    <location_y>10</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.LogListener
+    <plugin_config>
+      <filter />
+    </plugin_config>
+    <width>680</width>
+    <z>1</z>
+    <height>240</height>
+    <location_x>51</location_x>
+    <location_y>288</location_y>
+  </plugin>
+</simconf>
@@ -0,0 +1,173 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<simconf>
+  <project EXPORT="discard">[APPS_DIR]/mspsim</project>
+  <simulation>
+    <title>RPL 6LoWPAN-GHC compression (Sky)</title>
+    <randomseed>123456</randomseed>
+    <motedelay_us>1000000</motedelay_us>
+    <radiomedium>
+      org.contikios.cooja.radiomediums.UDGM
+      <transmitting_range>50.0</transmitting_range>
+      <interference_range>100.0</interference_range>
+      <success_ratio_tx>1.0</success_ratio_tx>
+      <success_ratio_rx>1.0</success_ratio_rx>
+    </radiomedium>
+    <events>
+      <logoutput>40000</logoutput>
+    </events>
+    <motetype>
+      org.contikios.cooja.mspmote.SkyMoteType
+      <identifier>sky1</identifier>
+      <description>6LoWPAN-GHC node</description>
+      <source EXPORT="discard">[CONTIKI_DIR]/regression-tests/12-rpl/code/ghc/ghc-node.c</source>
+      <commands EXPORT="discard">make TARGET=sky clean
+make ghc-node.sky TARGET=sky</commands>
+      <firmware EXPORT="copy">[CONTIKI_DIR]/regression-tests/12-rpl/code/ghc/ghc-node.sky</firmware>
+      <moteinterface>org.contikios.cooja.interfaces.Position</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.IPAddress</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Mote2MoteRelations</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspClock</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspMoteID</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyButton</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyFlash</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.Msp802154Radio</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspSerial</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyLED</moteinterface>
+    </motetype>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>0.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>1</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>40.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>2</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>80.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>3</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>120.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>4</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+  </simulation>
+  <plugin>
+    org.contikios.cooja.plugins.ScriptRunner
+    <plugin_config>
+      <script>TIMEOUT(900000);&#xD;
+&#xD;
+NODES = 4;&#xD;
+/* Every node must have sent GHC compressed packets, and the root must&#xD;
+   have received intact records from all other nodes. */&#xD;
+packets = new Array();&#xD;
+bytes = new Array();&#xD;
+uncomp = new Array();&#xD;
+received = new Array();&#xD;
+&#xD;
+while(true) {&#xD;
+ YIELD();&#xD;
+ if(msg.startsWith("GHC: bad")) {&#xD;
+   log.log("Node " + id + ": " + msg + "\n");&#xD;
+   log.testFailed();&#xD;
+ }&#xD;
+ if(msg.startsWith("GHC: record from")) {&#xD;
+   received[parseInt(msg.split(" ")[3])] = true;&#xD;
+   continue;&#xD;
+ }&#xD;
+ if(!msg.startsWith("GHC: packets")) {&#xD;
+   continue;&#xD;
+ }&#xD;
+ data = msg.split(" ");&#xD;
+ packets[id] = parseInt(data[2]);&#xD;
+ bytes[id] = parseInt(data[4]);&#xD;
+ uncomp[id] = parseInt(data[6]);&#xD;
+&#xD;
+ done = true;&#xD;
+ for(i = 1; i &lt;= NODES; i++) {&#xD;
+   if(!(packets[i] &gt; 0) || (i &gt; 1 &amp;&amp; received[i] != true)) {&#xD;
+     done = false;&#xD;
+     break;&#xD;
+   }&#xD;
+ }&#xD;
+ if(!done) {&#xD;
+   continue;&#xD;
+ }&#xD;
+&#xD;
+ for(i = 1; i &lt;= NODES; i++) {&#xD;
+   log.log("Node " + i + ": " + packets[i] + " GHC packets, " + uncomp[i] +&#xD;
+           " payload bytes compressed to " + bytes[i] + "\n");&#xD;
+   if(bytes[i] &gt;= uncomp[i]) {&#xD;
+     log.log("GHC did not shrink the payloads of node " + i + "\n");&#xD;
+     log.testFailed();&#xD;
+   }&#xD;
+ }&#xD;
+ log.testOK();&#xD;
+}</script>
+      <active>true</active>
+    </plugin_config>
+    <width>541</width>
+    <z>0</z>
+    <height>448</height>
+    <location_x>299</location_x>
+    <location_y>7</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.SimControl
+    <width>280</width>
+    <z>2</z>
+    <height>160</height>
+    <location_x>7</location_x>
+    <location_y>10</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.LogListener
+    <plugin_config>
+      <filter />
+    </plugin_config>
+    <width>680</width>
+    <z>1</z>
+    <height>240</height>
+    <location_x>51</location_x>
+    <location_y>288</location_y>
+  </plugin>
+</simconf>
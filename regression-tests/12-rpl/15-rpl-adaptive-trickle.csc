@@ -0,0 +1,228 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<simconf>
+  <project EXPORT="discard">[APPS_DIR]/mspsim</project>
+  <simulation>
+    <title>RPL adaptive DIO redundancy (Sky)</title>
+    <randomseed>123456</randomseed>
+    <motedelay_us>1000000</motedelay_us>
+    <radiomedium>
+      org.contikios.cooja.radiomediums.UDGM
+      <transmitting_range>50.0</transmitting_range>
+      <interference_range>100.0</interference_range>
+      <success_ratio_tx>1.0</success_ratio_tx>
+      <success_ratio_rx>1.0</success_ratio_rx>
+    </radiomedium>
+    <events>
+      <logoutput>40000</logoutput>
+    </events>
+    <motetype>
+      org.contikios.cooja.mspmote.SkyMoteType
+      <identifier>sky1</identifier>
+      <description>Trickle node</description>
+      <source EXPORT="discard">[CONTIKI_DIR]/regression-tests/12-rpl/code/adaptive-trickle/trickle-node.c</source>
+      <commands EXPORT="discard">make TARGET=sky clean
+make trickle-node.sky TARGET=sky</commands>
+      <firmware EXPORT="copy">[CONTIKI_DIR]/regression-tests/12-rpl/code/adaptive-trickle/trickle-node.sky</firmware>
+      <moteinterface>org.contikios.cooja.interfaces.Position</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.IPAddress</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Mote2MoteRelations</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspClock</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspMoteID</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyButton</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyFlash</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.Msp802154Radio</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.MspSerial</moteinterface>
+      <moteinterface>org.contikios.cooja.mspmote.interfaces.SkyLED</moteinterface>
+    </motetype>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>0.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>1</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>20.0</x>
+        <y>0.0</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>2</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>12.5</x>
+        <y>15.6</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>3</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>-4.5</x>
+        <y>19.5</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>4</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>-18.0</x>
+        <y>8.7</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>5</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>-18.0</x>
+        <y>-8.7</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>6</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>-4.5</x>
+        <y>-19.5</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>7</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+    <mote>
+      <breakpoints />
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>12.5</x>
+        <y>-15.6</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.mspmote.interfaces.MspMoteID
+        <id>8</id>
+      </interface_config>
+      <motetype_identifier>sky1</motetype_identifier>
+    </mote>
+  </simulation>
+  <plugin>
+    org.contikios.cooja.plugins.ScriptRunner
+    <plugin_config>
+      <script>TIMEOUT(1200000);&#xD;
+&#xD;
+NODES = 8;&#xD;
+/* All nodes hear each other. Once every node has been through a few&#xD;
+   Trickle intervals, the joined nodes must have lowered their local&#xD;
+   DIO redundancy below the advertised one (10), and the network as a&#xD;
+   whole must have suppressed DIOs. */&#xD;
+k = new Array();&#xD;
+sent = new Array();&#xD;
+suppressed = new Array();&#xD;
+&#xD;
+while(true) {&#xD;
+ YIELD();&#xD;
+ if(!msg.startsWith("DIO: k")) {&#xD;
+   continue;&#xD;
+ }&#xD;
+ data = msg.split(" ");&#xD;
+ k[id] = parseInt(data[2]);&#xD;
+ sent[id] = parseInt(data[4]);&#xD;
+ suppressed[id] = parseInt(data[6]);&#xD;
+&#xD;
+ done = true;&#xD;
+ for(i = 1; i &lt;= NODES; i++) {&#xD;
+   if(!(sent[i] + suppressed[i] &gt;= 6)) {&#xD;
+     done = false;&#xD;
+     break;&#xD;
+   }&#xD;
+ }&#xD;
+ if(!done) {&#xD;
+   continue;&#xD;
+ }&#xD;
+&#xD;
+ total = 0;&#xD;
+ for(i = 1; i &lt;= NODES; i++) {&#xD;
+   log.log("Node " + i + ": k " + k[i] + ", " + sent[i] + " DIOs sent, " +&#xD;
+           suppressed[i] + " suppressed\n");&#xD;
+   total += suppressed[i];&#xD;
+   if(i &gt; 1 &amp;&amp; k[i] &gt;= 10) {&#xD;
+     log.log("Node " + i + " did not adapt its DIO redundancy\n");&#xD;
+     log.testFailed();&#xD;
+   }&#xD;
+ }&#xD;
+ if(total == 0) {&#xD;
+   log.log("No DIO was suppressed\n");&#xD;
+   log.testFailed();&#xD;
+ }&#xD;
+ log.testOK();&#xD;
+}</script>
+      <active>true</active>
+    </plugin_config>
+    <width>541</width>
+    <z>0</z>
+    <height>448</height>
+    <location_x>299</location_x>
+    <location_y>7</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.SimControl
+    <width>280</width>
+    <z>2</z>
+    <height>160</height>
+    <location_x>7</location_x>
+    <location_y>10</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.LogListener
+    <plugin_config>
+      <filter />
+    </plugin_config>
+    <width>680</width>
+    <z>1</z>
+    <height>240</height>
+    <location_x>51</location_x>
+    <location_y>288</location_y>
+  </plugin>
+</simconf>
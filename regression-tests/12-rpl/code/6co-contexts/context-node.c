@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * RPL node that sends UDP packets to the root and reports the average
+ * size of the 6LoWPAN headers it compressed, and whether it has the
+ * context that the root learned for the DAG prefix.
+ */
+
+#include "contiki.h"
+#include "sys/etimer.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/ip/simple-udp.h"
+
+#include "net/rpl/rpl.h"
+
+#include <stdio.h>
+
+#define UDP_PORT        1234
+#define SEND_INTERVAL   (10 * CLOCK_SECOND)
+#define REPORT_INTERVAL (60 * CLOCK_SECOND)
+
+static struct simple_udp_connection udp_conn;
+/*---------------------------------------------------------------------------*/
+PROCESS(context_node_process, "Context node");
+AUTOSTART_PROCESSES(&context_node_process);
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(context_node_process, ev, data)
+{
+  static struct etimer send_timer;
+  static struct etimer report_timer;
+  static unsigned long last_packets;
+  static unsigned long last_bytes;
+  const struct sicslowpan_addr_context *context;
+  rpl_dag_t *dag;
+  unsigned long packets;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, receiver);
+
+  etimer_set(&send_timer, SEND_INTERVAL);
+  etimer_set(&report_timer, REPORT_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+
+    dag = rpl_get_any_dag();
+    if(data == &send_timer) {
+      etimer_reset(&send_timer);
+      if(dag != NULL && dag->preferred_parent != NULL) {
+        simple_udp_sendto(&udp_conn, "hello", 5, &dag->dag_id);
+      }
+      continue;
+    }
+    etimer_reset(&report_timer);
+
+    /* Average header size since the last report, in 1/10 bytes */
+    packets = sicslowpan_stats.iphc_packets - last_packets;
+    last_packets = sicslowpan_stats.iphc_packets;
+    if(packets == 0 || dag == NULL || dag->preferred_parent == NULL) {
+      last_bytes = sicslowpan_stats.iphc_hdr_bytes;
+      continue;
+    }
+    context = sicslowpan_context_get(1);
+    printf("CTX: context %d hdr %lu\n",
+           context != NULL &&
+           (context->flags & SICSLOWPAN_CONTEXT_FLAG_COMPRESS) != 0,
+           10 * (sicslowpan_stats.iphc_hdr_bytes - last_bytes) / packets);
+    last_bytes = sicslowpan_stats.iphc_hdr_bytes;
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,20 @@
+#undef SICSLOWPAN_CONF_STATS
+#define SICSLOWPAN_CONF_STATS 1
+
+#undef RPL_CONF_WITH_6CO
+#define RPL_CONF_WITH_6CO 1
+
+/* Room for the preconfigured context and the one the root learns for
+   the DAG prefix. */
+#undef SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS
+#define SICSLOWPAN_CONF_MAX_ADDR_CONTEXTS 3
+
+#undef SICSLOWPAN_CONF_CONTEXT_ACTIVATION_DELAY
+#define SICSLOWPAN_CONF_CONTEXT_ACTIVATION_DELAY 1
+
+/* Only the root, which announces the DAG prefix, learns contexts. The
+   other nodes take them from the DIOs. */
+#if CONTEXT_ROOT
+#undef SICSLOWPAN_CONF_CONTEXT_LEARNING
+#define SICSLOWPAN_CONF_CONTEXT_LEARNING 1
+#endif /* CONTEXT_ROOT */
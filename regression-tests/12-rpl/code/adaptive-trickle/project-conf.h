@@ -0,0 +1,5 @@
+#undef TRICKLE_TIMER_CONF_STATS
+#define TRICKLE_TIMER_CONF_STATS 1
+
+#undef RPL_CONF_DIO_ADAPTIVE_REDUNDANCY
+#define RPL_CONF_DIO_ADAPTIVE_REDUNDANCY 1
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * RPL node that periodically reports the state and the counters of its
+ * DIO Trickle timer.
+ */
+
+#include "contiki.h"
+#include "sys/etimer.h"
+#include "sys/node-id.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ip/uip-debug.h"
+
+#include "net/rpl/rpl.h"
+
+#include <stdio.h>
+
+#define REPORT_INTERVAL (60 * CLOCK_SECOND)
+/*---------------------------------------------------------------------------*/
+PROCESS(trickle_node_process, "Trickle node");
+AUTOSTART_PROCESSES(&trickle_node_process);
+/*---------------------------------------------------------------------------*/
+static void
+create_rpl_dag(void)
+{
+  uip_ipaddr_t ipaddr;
+
+  uip_ip6addr(&ipaddr, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_MANUAL);
+
+  rpl_set_root(RPL_DEFAULT_INSTANCE, &ipaddr);
+  rpl_set_prefix(rpl_get_any_dag(), &ipaddr, 64);
+  printf("Created a new RPL dag\n");
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(trickle_node_process, ev, data)
+{
+  static struct etimer report_timer;
+  rpl_dag_t *dag;
+  struct trickle_timer *tt;
+
+  PROCESS_BEGIN();
+
+  if(node_id == 1) {
+    create_rpl_dag();
+  }
+
+  etimer_set(&report_timer, REPORT_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&report_timer));
+    etimer_reset(&report_timer);
+
+    dag = rpl_get_any_dag();
+    if(dag == NULL) {
+      continue;
+    }
+    tt = &dag->instance->dio_timer;
+    printf("DIO: k %u sent %u suppressed %u resets %u\n",
+           tt->k, tt->tx, tt->suppressed, tt->resets);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
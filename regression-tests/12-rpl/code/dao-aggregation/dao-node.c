@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * RPL node that reports how many DAOs and DAO targets it has sent.
+ * Node 1 is the root and triggers a global repair, after which every
+ * node re-registers its route at about the same time.
+ */
+
+#include "contiki.h"
+#include "sys/etimer.h"
+#include "sys/node-id.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ip/uip-debug.h"
+
+#include "net/rpl/rpl.h"
+#include "net/rpl/rpl-private.h"
+
+#include <stdio.h>
+
+#define REPORT_INTERVAL (10 * CLOCK_SECOND)
+#define REPAIR_TIME     (120 * CLOCK_SECOND)
+
+/*---------------------------------------------------------------------------*/
+PROCESS(dao_node_process, "DAO node");
+AUTOSTART_PROCESSES(&dao_node_process);
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t *
+set_global_address(void)
+{
+  static uip_ipaddr_t ipaddr;
+
+  uip_ip6addr(&ipaddr, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_AUTOCONF);
+
+  return &ipaddr;
+}
+/*---------------------------------------------------------------------------*/
+static void
+create_rpl_dag(uip_ipaddr_t *ipaddr)
+{
+  rpl_dag_t *dag;
+  uip_ipaddr_t prefix;
+
+  rpl_set_root(RPL_DEFAULT_INSTANCE, ipaddr);
+  dag = rpl_get_any_dag();
+  uip_ip6addr(&prefix, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  rpl_set_prefix(dag, &prefix, 64);
+  printf("Created a new RPL dag\n");
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(dao_node_process, ev, data)
+{
+  static struct etimer et;
+  static struct etimer repair;
+  rpl_instance_t *instance;
+  uip_ipaddr_t *ipaddr;
+
+  PROCESS_BEGIN();
+
+  ipaddr = set_global_address();
+  if(node_id == 1) {
+    create_rpl_dag(ipaddr);
+    etimer_set(&repair, REPAIR_TIME);
+  }
+
+  etimer_set(&et, REPORT_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+
+    if(data == &repair) {
+      printf("DAO: global repair\n");
+      rpl_repair_root(RPL_DEFAULT_INSTANCE);
+      continue;
+    }
+    etimer_reset(&et);
+
+    /* Report only once in the DAG */
+    if(node_id != 1 && uip_ds6_defrt_choose() == NULL) {
+      continue;
+    }
+    instance = rpl_get_instance(RPL_DEFAULT_INSTANCE);
+    printf("DAO: routes %u sent %u targets %u forwarded %u dio %u\n",
+           uip_ds6_route_num_routes(),
+           rpl_stats.dao_sent, rpl_stats.dao_targets_sent,
+           rpl_stats.dao_targets_forwarded,
+           instance != NULL ? instance->dio_totsend : 0);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
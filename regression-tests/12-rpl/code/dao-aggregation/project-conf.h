@@ -0,0 +1,10 @@
+#undef RPL_CONF_STATS
+#define RPL_CONF_STATS 1
+
+#undef RPL_CONF_WITH_DAO_ACK
+#define RPL_CONF_WITH_DAO_ACK 1
+
+/* Collect the targets of children long enough for the DAOs sent
+   after a global repair to be aggregated on their way up. */
+#undef RPL_CONF_DAO_AGGREGATION_DELAY
+#define RPL_CONF_DAO_AGGREGATION_DELAY (2 * CLOCK_SECOND)
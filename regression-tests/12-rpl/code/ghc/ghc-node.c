@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * RPL node that sends sensor-like records to the root and reports how
+ * much 6LoWPAN-GHC shrank the payloads it sent. The root checks that
+ * the records decompress to what was sent.
+ */
+
+#include "contiki.h"
+#include "sys/etimer.h"
+#include "sys/node-id.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ipv6/sicslowpan.h"
+#include "net/ip/simple-udp.h"
+#include "net/ip/uip-debug.h"
+
+#include "net/rpl/rpl.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define UDP_PORT        1234
+#define SEND_INTERVAL   (10 * CLOCK_SECOND)
+#define REPORT_INTERVAL (60 * CLOCK_SECOND)
+
+#define RECORD_LEN      48
+
+static struct simple_udp_connection udp_conn;
+/*---------------------------------------------------------------------------*/
+PROCESS(ghc_node_process, "GHC node");
+AUTOSTART_PROCESSES(&ghc_node_process);
+/*---------------------------------------------------------------------------*/
+/* A record with a header, zero padding and a repeated field */
+static void
+make_record(uint8_t *buf, uint8_t id, uint8_t seqno)
+{
+  memset(buf, 0, RECORD_LEN);
+  memcpy(buf, "sensor", 6);
+  buf[6] = id;
+  buf[7] = seqno;
+  memcpy(buf + 16, "temp=21;temp=21;temp=21;", 24);
+}
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  uint8_t expected[RECORD_LEN];
+
+  if(datalen != RECORD_LEN) {
+    printf("GHC: bad length %u\n", datalen);
+    return;
+  }
+  make_record(expected, data[6], data[7]);
+  if(memcmp(expected, data, RECORD_LEN) != 0) {
+    printf("GHC: bad record from %u\n", data[6]);
+    return;
+  }
+  printf("GHC: record from %u\n", data[6]);
+}
+/*---------------------------------------------------------------------------*/
+static void
+create_rpl_dag(void)
+{
+  uip_ipaddr_t ipaddr;
+
+  uip_ip6addr(&ipaddr, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_MANUAL);
+
+  rpl_set_root(RPL_DEFAULT_INSTANCE, &ipaddr);
+  rpl_set_prefix(rpl_get_any_dag(), &ipaddr, 64);
+  printf("Created a new RPL dag\n");
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(ghc_node_process, ev, data)
+{
+  static struct etimer send_timer;
+  static struct etimer report_timer;
+  static uint8_t seqno;
+  uint8_t record[RECORD_LEN];
+  rpl_dag_t *dag;
+
+  PROCESS_BEGIN();
+
+  simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, receiver);
+
+  if(node_id == 1) {
+    create_rpl_dag();
+  }
+
+  etimer_set(&send_timer, SEND_INTERVAL);
+  etimer_set(&report_timer, REPORT_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+
+    if(data == &send_timer) {
+      etimer_reset(&send_timer);
+      dag = rpl_get_any_dag();
+      if(node_id != 1 && dag != NULL && dag->preferred_parent != NULL) {
+        make_record(record, node_id, seqno++);
+        simple_udp_sendto(&udp_conn, record, RECORD_LEN, &dag->dag_id);
+      }
+      continue;
+    }
+    etimer_reset(&report_timer);
+
+    printf("GHC: packets %lu bytes %lu uncomp %lu\n",
+           sicslowpan_stats.ghc_packets, sicslowpan_stats.ghc_bytes,
+           sicslowpan_stats.ghc_uncomp_bytes);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
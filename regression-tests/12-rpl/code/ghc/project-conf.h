@@ -0,0 +1,10 @@
+#undef SICSLOWPAN_CONF_STATS
+#define SICSLOWPAN_CONF_STATS 1
+
+#undef SICSLOWPAN_CONF_GHC
+#define SICSLOWPAN_CONF_GHC 1
+
+/* RPL does not use the ND exchange in which the 6CIO is carried; all
+   nodes in the simulation run GHC. */
+#undef SICSLOWPAN_CONF_GHC_ALL_NEIGHBORS
+#define SICSLOWPAN_CONF_GHC_ALL_NEIGHBORS 1
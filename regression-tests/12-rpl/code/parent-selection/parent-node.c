@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * RPL node for the parent selection test. Node 3 is the root, node 2
+ * sends a packet to node 1 every minute and the other nodes forward
+ * them. Every node reports the parent selection work of each of its
+ * DIO intervals, and whether it keeps a candidate parent cached after
+ * that parent stopped being a candidate.
+ */
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "sys/etimer.h"
+#include "sys/node-id.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ip/simple-udp.h"
+#include "net/ip/uip-debug.h"
+
+#include "net/rpl/rpl.h"
+#include "net/rpl/rpl-private.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define UDP_PORT        1234
+#define SEND_INTERVAL   (60 * CLOCK_SECOND)
+#define CHECK_INTERVAL  (10 * CLOCK_SECOND)
+
+#define RECEIVER_ID     1
+#define SENDER_ID       2
+#define ROOT_ID         3
+
+static struct simple_udp_connection udp_conn;
+/*---------------------------------------------------------------------------*/
+PROCESS(parent_node_process, "Parent selection node");
+AUTOSTART_PROCESSES(&parent_node_process);
+/*---------------------------------------------------------------------------*/
+static void
+receiver(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  printf("Data received from ");
+  uip_debug_ipaddr_print(sender_addr);
+  printf(" on port %d from port %d with length %d: '%s'\n",
+         receiver_port, sender_port, datalen, data);
+}
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t *
+set_global_address(void)
+{
+  static uip_ipaddr_t ipaddr;
+
+  uip_ip6addr(&ipaddr, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_AUTOCONF);
+
+  return &ipaddr;
+}
+/*---------------------------------------------------------------------------*/
+static void
+create_rpl_dag(uip_ipaddr_t *ipaddr)
+{
+  rpl_dag_t *dag;
+  uip_ipaddr_t prefix;
+
+  rpl_set_root(RPL_DEFAULT_INSTANCE, ipaddr);
+  dag = rpl_get_any_dag();
+  uip_ip6addr(&prefix, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  rpl_set_prefix(dag, &prefix, 64);
+  printf("Created a new RPL dag\n");
+}
+/*---------------------------------------------------------------------------*/
+/* Whether a candidate parent that the DAG has cached is no longer a
+   candidate, although no update of it is pending */
+static int
+is_stale(rpl_dag_t *dag, rpl_parent_t *p, uint8_t valid)
+{
+  return (dag->candidates_valid & valid) && p != NULL &&
+    (p->dag != dag || p->rank == INFINITE_RANK) &&
+    !(p->flags & RPL_PARENT_FLAG_UPDATED);
+}
+/*---------------------------------------------------------------------------*/
+static void
+check_candidates(void)
+{
+  rpl_dag_t *dag;
+
+  dag = rpl_get_any_dag();
+  if(dag == NULL) {
+    return;
+  }
+  if(is_stale(dag, dag->best_candidate, RPL_DAG_CANDIDATE_BEST_VALID) ||
+     is_stale(dag, dag->second_candidate, RPL_DAG_CANDIDATE_SECOND_VALID)) {
+    printf("Parent: stale candidate\n");
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+parent_node_dio_interval(uint8_t dio_interval)
+{
+  static uint16_t last_evaluations, last_scans, last_updates;
+
+  /* The counters are cumulative, report the work since the last
+     interval */
+  printf("Parent: interval %u evaluations %u scans %u updates %u\n",
+         dio_interval,
+         (uint16_t)(rpl_stats.parent_evaluations - last_evaluations),
+         (uint16_t)(rpl_stats.parent_scans - last_scans),
+         (uint16_t)(rpl_stats.path_metric_updates - last_updates));
+  last_evaluations = rpl_stats.parent_evaluations;
+  last_scans = rpl_stats.parent_scans;
+  last_updates = rpl_stats.path_metric_updates;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(parent_node_process, ev, data)
+{
+  static struct etimer check_timer;
+  static struct etimer send_timer;
+  static unsigned int message_number;
+  char buf[20];
+  uip_ipaddr_t addr;
+  uip_ipaddr_t *ipaddr;
+
+  PROCESS_BEGIN();
+
+  ipaddr = set_global_address();
+  if(node_id == ROOT_ID) {
+    create_rpl_dag(ipaddr);
+  }
+
+  simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, receiver);
+
+  etimer_set(&check_timer, CHECK_INTERVAL);
+  etimer_set(&send_timer, SEND_INTERVAL + random_rand() % SEND_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_TIMER);
+
+    if(data == &check_timer) {
+      etimer_reset(&check_timer);
+      check_candidates();
+      continue;
+    }
+    etimer_reset(&send_timer);
+    if(node_id != SENDER_ID) {
+      continue;
+    }
+
+    uip_ip6addr(&addr, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0,
+                0x0200 + RECEIVER_ID, RECEIVER_ID, RECEIVER_ID, RECEIVER_ID);
+    printf("Sending unicast to ");
+    uip_debug_ipaddr_print(&addr);
+    printf("\n");
+    sprintf(buf, "Message %d", message_number);
+    message_number++;
+    simple_udp_sendto(&udp_conn, buf, strlen(buf) + 1, &addr);
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,7 @@
+#undef RPL_CONF_STATS
+#define RPL_CONF_STATS 1
+
+/* Report the parent selection work of every DIO interval */
+#define RPL_CALLBACK_NEW_DIO_INTERVAL parent_node_dio_interval
+
+#define TCPIP_CONF_ANNOTATE_TRANSMISSIONS 1
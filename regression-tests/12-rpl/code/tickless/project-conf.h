@@ -0,0 +1,11 @@
+/* The node under test is built with WITH_TICKLESS=1, the root and the
+   node it is compared with are not. */
+#if WITH_TICKLESS
+#undef TICKLESS_CONF_ENABLED
+#define TICKLESS_CONF_ENABLED 1
+
+/* The msp430 rtimer has its own compare interrupt, so ContikiMAC
+   channel checks do not need to cut the clock sleeps short. */
+#undef TICKLESS_CONF_WITH_RTIMER
+#define TICKLESS_CONF_WITH_RTIMER 0
+#endif /* WITH_TICKLESS */
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * An otherwise idle RPL node that reports how often the clock
+ * interrupt fires. With tickless idle enabled, the node should sleep
+ * through most of the CLOCK_SECOND ticks per second. Node 1 is the
+ * root.
+ */
+
+#include "contiki.h"
+#include "sys/etimer.h"
+#include "sys/energest.h"
+#include "sys/node-id.h"
+#include "sys/tickless.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include "net/ip/uip-debug.h"
+
+#include "net/rpl/rpl.h"
+
+#include <stdio.h>
+
+#define REPORT_INTERVAL (10 * CLOCK_SECOND)
+
+/*---------------------------------------------------------------------------*/
+PROCESS(tickless_node_process, "Tickless node");
+AUTOSTART_PROCESSES(&tickless_node_process);
+/*---------------------------------------------------------------------------*/
+static uip_ipaddr_t *
+set_global_address(void)
+{
+  static uip_ipaddr_t ipaddr;
+
+  uip_ip6addr(&ipaddr, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  uip_ds6_set_addr_iid(&ipaddr, &uip_lladdr);
+  uip_ds6_addr_add(&ipaddr, 0, ADDR_AUTOCONF);
+
+  return &ipaddr;
+}
+/*---------------------------------------------------------------------------*/
+static void
+create_rpl_dag(uip_ipaddr_t *ipaddr)
+{
+  rpl_dag_t *dag;
+  uip_ipaddr_t prefix;
+
+  rpl_set_root(RPL_DEFAULT_INSTANCE, ipaddr);
+  dag = rpl_get_any_dag();
+  uip_ip6addr(&prefix, UIP_DS6_DEFAULT_PREFIX, 0, 0, 0, 0, 0, 0, 0);
+  rpl_set_prefix(dag, &prefix, 64);
+  printf("Created a new RPL dag\n");
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(tickless_node_process, ev, data)
+{
+  static struct etimer et;
+  static unsigned long last_interrupts, last_cpu, last_lpm, last_irq;
+  unsigned long interrupts, cpu, lpm, irq;
+  uip_ipaddr_t *ipaddr;
+
+  PROCESS_BEGIN();
+
+  ipaddr = set_global_address();
+  if(node_id == 1) {
+    create_rpl_dag(ipaddr);
+  }
+
+  etimer_set(&et, REPORT_INTERVAL);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    etimer_reset(&et);
+
+    energest_flush();
+    interrupts = tickless_stats.clock_interrupts;
+    cpu = energest_type_time(ENERGEST_TYPE_CPU);
+    lpm = energest_type_time(ENERGEST_TYPE_LPM);
+    irq = energest_type_time(ENERGEST_TYPE_IRQ);
+
+    /* Report only once in the DAG */
+    if(node_id == 1 || uip_ds6_defrt_choose() != NULL) {
+      printf("Tickless: wakeups/s %lu sleeps %lu cpu %lu lpm %lu irq %lu\n",
+             (interrupts - last_interrupts) / (REPORT_INTERVAL / CLOCK_SECOND),
+             tickless_stats.sleeps,
+             cpu - last_cpu, lpm - last_lpm, irq - last_irq);
+    }
+
+    last_interrupts = interrupts;
+    last_cpu = cpu;
+    last_lpm = lpm;
+    last_irq = irq;
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,9 @@
+/* Count the runs of the uip-ds6 maintenance */
+#undef UIP_CONF_STATISTICS
+#define UIP_CONF_STATISTICS 1
+
+/* Room for every node of the 25-node grid at the root */
+#undef UIP_CONF_MAX_ROUTES
+#define UIP_CONF_MAX_ROUTES 25
+#undef NBR_TABLE_CONF_MAX_NEIGHBORS
+#define NBR_TABLE_CONF_MAX_NEIGHBORS 10
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2016, Swedish Institute of Computer Science
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Generate a delta between two code module images for codeprop, see
+ * apps/codeprop/codeprop-delta.h for the format. The delta is sent
+ * with the codeprop tool like a normal module:
+ *
+ *   codeprop-delta old.ce new.ce update.delta
+ *   codeprop 172.16.1.1 update.delta
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_IMAGE_SIZE 0xffff
+
+#define MIN_COPY       4
+#define MAX_SHORT_COPY (0x3f + MIN_COPY)
+#define MAX_LONG_COPY  (0x3fff + MIN_COPY)
+#define MAX_INSERT     0x80
+
+#define HASH_SIZE      4096
+#define MAX_CANDIDATES 256
+
+static unsigned char base[MAX_IMAGE_SIZE];
+static unsigned char new[MAX_IMAGE_SIZE];
+static int hash_head[HASH_SIZE];
+static int hash_next[MAX_IMAGE_SIZE];
+
+static unsigned long copied, inserted;
+/*---------------------------------------------------------------------------*/
+/* Same as crc16_add() in core/lib/crc16.c. */
+static unsigned short
+crc16_add(unsigned char b, unsigned short acc)
+{
+  acc ^= b;
+  acc  = (acc >> 8) | (acc << 8);
+  acc ^= (acc & 0xff00) << 4;
+  acc ^= (acc >> 8) >> 4;
+  acc ^= (acc & 0xff00) >> 5;
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+crc16_data(const unsigned char *data, int len)
+{
+  unsigned short acc = 0;
+
+  while(len-- > 0) {
+    acc = crc16_add(*data++, acc);
+  }
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+static int
+read_image(const char *name, unsigned char *buf)
+{
+  FILE *f;
+  int len;
+
+  f = fopen(name, "rb");
+  if(f == NULL) {
+    perror(name);
+    exit(1);
+  }
+  len = fread(buf, 1, MAX_IMAGE_SIZE, f);
+  if(!feof(f)) {
+    fprintf(stderr, "%s: larger than %d bytes\n", name, MAX_IMAGE_SIZE);
+    exit(1);
+  }
+  fclose(f);
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned
+hash(const unsigned char *p)
+{
+  return ((p[0] << 9) ^ (p[1] << 6) ^ (p[2] << 3) ^ p[3]) % HASH_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+index_base(int len)
+{
+  int i;
+
+  memset(hash_head, -1, sizeof(hash_head));
+  /* Insert backwards so that the chains run from low to high offsets. */
+  for(i = len - MIN_COPY; i >= 0; i--) {
+    hash_next[i] = hash_head[hash(&base[i])];
+    hash_head[hash(&base[i])] = i;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+longest_match(int base_len, const unsigned char *p, int left, int *offset)
+{
+  int candidate;
+  int candidates;
+  int best;
+  int n;
+
+  best = 0;
+  if(left < MIN_COPY) {
+    return 0;
+  }
+  if(left > MAX_LONG_COPY) {
+    left = MAX_LONG_COPY;
+  }
+  candidates = 0;
+  for(candidate = hash_head[hash(p)];
+      candidate >= 0 && candidates < MAX_CANDIDATES;
+      candidate = hash_next[candidate], candidates++) {
+    for(n = 0; n < left && candidate + n < base_len &&
+          base[candidate + n] == p[n]; n++);
+    if(n > best) {
+      best = n;
+      *offset = candidate;
+    }
+  }
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+static void
+flush_insert(FILE *out, const unsigned char *p, int len)
+{
+  int n;
+
+  while(len > 0) {
+    n = len > MAX_INSERT ? MAX_INSERT : len;
+    fputc(n - 1, out);
+    fwrite(p, 1, n, out);
+    inserted += n;
+    p += n;
+    len -= n;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_copy(FILE *out, int offset, int len)
+{
+  if(len <= MAX_SHORT_COPY) {
+    fputc(0x80 | (len - MIN_COPY), out);
+  } else {
+    fputc(0xc0 | ((len - MIN_COPY) >> 8), out);
+    fputc((len - MIN_COPY) & 0xff, out);
+  }
+  fputc(offset >> 8, out);
+  fputc(offset & 0xff, out);
+  copied += len;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  FILE *out;
+  int base_len, new_len;
+  int pos, insert_start;
+  int offset;
+  int len;
+  unsigned short crc;
+  long delta_len;
+
+  if(argc != 4) {
+    fprintf(stderr, "usage: %s base-image new-image delta\n", argv[0]);
+    exit(1);
+  }
+
+  base_len = read_image(argv[1], base);
+  new_len = read_image(argv[2], new);
+  index_base(base_len);
+
+  out = fopen(argv[3], "wb");
+  if(out == NULL) {
+    perror(argv[3]);
+    exit(1);
+  }
+
+  fputc('C', out);
+  fputc('D', out);
+  fputc(base_len >> 8, out);
+  fputc(base_len & 0xff, out);
+  crc = crc16_data(base, base_len);
+  fputc(crc >> 8, out);
+  fputc(crc & 0xff, out);
+  fputc(new_len >> 8, out);
+  fputc(new_len & 0xff, out);
+  crc = crc16_data(new, new_len);
+  fputc(crc >> 8, out);
+  fputc(crc & 0xff, out);
+
+  insert_start = 0;
+  for(pos = 0; pos < new_len;) {
+    len = longest_match(base_len, &new[pos], new_len - pos, &offset);
+    if(len >= MIN_COPY) {
+      flush_insert(out, &new[insert_start], pos - insert_start);
+      put_copy(out, offset, len);
+      pos += len;
+      insert_start = pos;
+    } else {
+      pos++;
+    }
+  }
+  flush_insert(out, &new[insert_start], pos - insert_start);
+
+  delta_len = ftell(out);
+  fclose(out);
+
+  printf("%s: %ld bytes for a %d byte image (%lu copied, %lu inserted)\n",
+         argv[3], delta_len, new_len, copied, inserted);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -2,3 +2,8 @@
 
 const int symbols_nelts = 0;
 const struct symbols symbols[] = {{0,0}};
+
+const unsigned short symbols_hash_nbuckets = 0;
+const unsigned short symbols_hash_nslots = 0;
+const unsigned short symbols_hash_displacement[] = {0};
+const unsigned short symbols_hash_slots[] = {0xffff};
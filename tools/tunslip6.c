@@ -35,6 +35,10 @@
  /* Below define allows importing saved output into Wireshark as "Raw IP" packet type */
 #define WIRESHARK_IMPORT_FORMAT 1
 
+#ifdef linux
+#define _GNU_SOURCE /* posix_openpt() and friends */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -48,6 +52,9 @@
 #include <signal.h>
 #include <termios.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -56,6 +63,10 @@
 
 #include <err.h>
 
+#ifdef linux
+#include <linux/serial.h>
+#endif
+
 #include "tools-utils.h"
 
 #ifndef BAUDRATE
@@ -78,6 +89,10 @@ void write_to_serial(int outfd, void *inbuf, int len);
 void slip_send(int fd, unsigned char c);
 void slip_send_char(int fd, unsigned char c);
 
+/* Number of packets to send in loopback measurement mode, 0 if off */
+int loopback_count = 0;
+void loopback_input(const unsigned char *buf, int len);
+
 #define PROGRESS(s) if(showprogress) fprintf(stderr, s)
 
 char tundev[1024] = { "" };
@@ -164,249 +179,367 @@ is_sensible_string(const unsigned char *s, int len)
   return 1;
 }
 
-/*
- * Read from serial, when we have a packet write it to tun. No output
- * buffering, input buffered by stdio.
- */
+/* Bytes that need attention while decoding: SLIP_END, SLIP_ESC and,
+   when lines are echoed as they are received, '\n'. All other bytes
+   are copied in runs. */
+static unsigned char slip_decode_special[256];
+/* The second byte of the escape sequence for bytes that have to be
+   escaped when encoding, 0 for those that are sent as they are. */
+static unsigned char slip_escape[256];
+
 void
-serial_to_tun(FILE *inslip, int outfd)
+slip_init_tables(void)
 {
-  static union {
-    unsigned char inbuf[2000];
-  } uip;
-  static int inbufptr = 0;
-  int ret,i;
-  unsigned char c;
+  memset(slip_decode_special, 0, sizeof(slip_decode_special));
+  slip_decode_special[SLIP_END] = 1;
+  slip_decode_special[SLIP_ESC] = 1;
+  if((verbose==2) || (verbose==3) || (verbose>4)) {
+    slip_decode_special['\n'] = 1;
+  }
 
-#ifdef linux
-  ret = fread(&c, 1, 1, inslip);
-  if(ret == -1 || ret == 0) err(1, "serial_to_tun: read");
-  goto after_fread;
-#endif
+  memset(slip_escape, 0, sizeof(slip_escape));
+  slip_escape[SLIP_END] = SLIP_ESC_END;
+  slip_escape[SLIP_ESC] = SLIP_ESC_ESC;
+  if(flowcontrol_xonxoff) {
+    slip_escape[XON] = SLIP_ESC_XON;
+    slip_escape[XOFF] = SLIP_ESC_XOFF;
+  }
+}
+
+static struct {
+  unsigned char inbuf[2000];
+} uip;
+static int inbufptr = 0;
 
- read_more:
+static void
+slip_drop_check(void)
+{
   if(inbufptr >= sizeof(uip.inbuf)) {
      if(timestamp) stamptime();
      fprintf(stderr, "*** dropping large %d byte packet\n",inbufptr);
 	 inbufptr = 0;
   }
-  ret = fread(&c, 1, 1, inslip);
-#ifdef linux
- after_fread:
-#endif
-  if(ret == -1) {
-    err(1, "serial_to_tun: read");
+}
+
+static void
+slip_echo_printable(const unsigned char *p, int len)
+{
+  int i;
+  unsigned char c;
+
+  for(i = 0; i < len; i++) {
+    c = p[i];
+    if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
+      fwrite(&c, 1, 1, stdout);
+      if(c=='\n') if(timestamp) stamptime();
+    }
   }
-  if(ret == 0) {
-    clearerr(inslip);
-    return;
+}
+
+static void
+slip_input_byte(unsigned char c)
+{
+  slip_drop_check();
+  uip.inbuf[inbufptr++] = c;
+
+  /* Echo lines as they are received for verbose=2,3,5+ */
+  /* Echo all printable characters for verbose==4 */
+  if((verbose==2) || (verbose==3) || (verbose>4)) {
+    if(c=='\n') {
+      if(is_sensible_string(uip.inbuf, inbufptr)) {
+        if (timestamp) stamptime();
+        fwrite(uip.inbuf, inbufptr, 1, stdout);
+        inbufptr=0;
+      }
+    }
+  } else if(verbose==4) {
+    slip_echo_printable(&c, 1);
   }
-  PROGRESS(".");
-  switch(c) {
-  case SLIP_END:
-    if(inbufptr > 0) {
-      if(uip.inbuf[0] == '!') {
-	if(uip.inbuf[1] == 'M') {
-	  /* Read gateway MAC address and autoconfigure tap0 interface */
-	  char macs[24];
-	  int i, pos;
-	  for(i = 0, pos = 0; i < 16; i++) {
-	    macs[pos++] = uip.inbuf[2 + i];
-	    if((i & 1) == 1 && i < 14) {
-	      macs[pos++] = ':';
-	    }
-	  }
-          if(timestamp) stamptime();
-	  macs[pos] = '\0';
-//	  printf("*** Gateway's MAC address: %s\n", macs);
-	  fprintf(stderr,"*** Gateway's MAC address: %s\n", macs);
-          if (timestamp) stamptime();
-	  ssystem("ifconfig %s down", tundev);
-          if (timestamp) stamptime();
-	  ssystem("ifconfig %s hw ether %s", tundev, &macs[6]);
-          if (timestamp) stamptime();
-	  ssystem("ifconfig %s up", tundev);
+}
+
+static void
+slip_input_run(const unsigned char *p, int len)
+{
+  int n;
+
+  if(verbose==4) {
+    slip_echo_printable(p, len);
+  }
+  while(len > 0) {
+    slip_drop_check();
+    n = sizeof(uip.inbuf) - inbufptr;
+    if(n > len) {
+      n = len;
+    }
+    memcpy(uip.inbuf + inbufptr, p, n);
+    inbufptr += n;
+    p += n;
+    len -= n;
+  }
+}
+
+static void
+slip_packet_input(int outfd)
+{
+  int i;
+
+  if(uip.inbuf[0] == '!') {
+    if(uip.inbuf[1] == 'M') {
+      /* Read gateway MAC address and autoconfigure tap0 interface */
+      char macs[24];
+      int i, pos;
+      for(i = 0, pos = 0; i < 16; i++) {
+	macs[pos++] = uip.inbuf[2 + i];
+	if((i & 1) == 1 && i < 14) {
+	  macs[pos++] = ':';
 	}
-      } else if(uip.inbuf[0] == '?') {
-	if(uip.inbuf[1] == 'P') {
-          /* Prefix info requested */
-          struct in6_addr addr;
-	  int i;
-	  char *s = strchr(ipaddr, '/');
-	  if(s != NULL) {
-	    *s = '\0';
-	  }
-          inet_pton(AF_INET6, ipaddr, &addr);
-          if(timestamp) stamptime();
-          fprintf(stderr,"*** Address:%s => %02x%02x:%02x%02x:%02x%02x:%02x%02x\n",
-		 ipaddr,
-		 addr.s6_addr[0], addr.s6_addr[1],
-		 addr.s6_addr[2], addr.s6_addr[3],
-		 addr.s6_addr[4], addr.s6_addr[5],
-		 addr.s6_addr[6], addr.s6_addr[7]);
-	  slip_send(slipfd, '!');
-	  slip_send(slipfd, 'P');
-	  for(i = 0; i < 8; i++) {
-	    /* need to call the slip_send_char for stuffing */
-	    slip_send_char(slipfd, addr.s6_addr[i]);
-	  }
-	  slip_send(slipfd, SLIP_END);
-        }
+      }
+      if(timestamp) stamptime();
+      macs[pos] = '\0';
+//	  printf("*** Gateway's MAC address: %s\n", macs);
+      fprintf(stderr,"*** Gateway's MAC address: %s\n", macs);
+      if (timestamp) stamptime();
+      ssystem("ifconfig %s down", tundev);
+      if (timestamp) stamptime();
+      ssystem("ifconfig %s hw ether %s", tundev, &macs[6]);
+      if (timestamp) stamptime();
+      ssystem("ifconfig %s up", tundev);
+    }
+  } else if(uip.inbuf[0] == '?') {
+    if(uip.inbuf[1] == 'P') {
+      /* Prefix info requested */
+      struct in6_addr addr;
+      int i;
+      char *s = strchr(ipaddr, '/');
+      if(s != NULL) {
+	*s = '\0';
+      }
+      inet_pton(AF_INET6, ipaddr, &addr);
+      if(timestamp) stamptime();
+      fprintf(stderr,"*** Address:%s => %02x%02x:%02x%02x:%02x%02x:%02x%02x\n",
+	     ipaddr,
+	     addr.s6_addr[0], addr.s6_addr[1],
+	     addr.s6_addr[2], addr.s6_addr[3],
+	     addr.s6_addr[4], addr.s6_addr[5],
+	     addr.s6_addr[6], addr.s6_addr[7]);
+      slip_send(slipfd, '!');
+      slip_send(slipfd, 'P');
+      for(i = 0; i < 8; i++) {
+	/* need to call the slip_send_char for stuffing */
+	slip_send_char(slipfd, addr.s6_addr[i]);
+      }
+      slip_send(slipfd, SLIP_END);
+    }
 #define DEBUG_LINE_MARKER '\r'
-      } else if(uip.inbuf[0] == DEBUG_LINE_MARKER) {
-	fwrite(uip.inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(uip.inbuf, inbufptr)) {
-        if(verbose==1) {   /* strings already echoed below for verbose>1 */
-          if (timestamp) stamptime();
-          fwrite(uip.inbuf, inbufptr, 1, stdout);
-        }
-      } else {
-        if(verbose>2) {
-          if (timestamp) stamptime();
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
-          if (verbose>4) {
+  } else if(uip.inbuf[0] == DEBUG_LINE_MARKER) {
+    fwrite(uip.inbuf + 1, inbufptr - 1, 1, stdout);
+  } else if(is_sensible_string(uip.inbuf, inbufptr)) {
+    if(verbose==1) {   /* strings already echoed below for verbose>1 */
+      if (timestamp) stamptime();
+      fwrite(uip.inbuf, inbufptr, 1, stdout);
+    }
+  } else {
+    if(verbose>2) {
+      if (timestamp) stamptime();
+      printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
+      if (verbose>4) {
 #if WIRESHARK_IMPORT_FORMAT
-            printf("0000");
-	        for(i = 0; i < inbufptr; i++) printf(" %02x",uip.inbuf[i]);
+        printf("0000");
+	    for(i = 0; i < inbufptr; i++) printf(" %02x",uip.inbuf[i]);
 #else
-            printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", uip.inbuf[i]);
-              if((i & 3) == 3) printf(" ");
-              if((i & 15) == 15) printf("\n         ");
-            }
-#endif
-            printf("\n");
-          }
+        printf("         ");
+        for(i = 0; i < inbufptr; i++) {
+          printf("%02x", uip.inbuf[i]);
+          if((i & 3) == 3) printf(" ");
+          if((i & 15) == 15) printf("\n         ");
         }
-	if(write(outfd, uip.inbuf, inbufptr) != inbufptr) {
-	  err(1, "serial_to_tun: write");
-	}
+#endif
+        printf("\n");
       }
-      inbufptr = 0;
     }
-    break;
+    if(loopback_count > 0) {
+      loopback_input(uip.inbuf, inbufptr);
+    } else if(write(outfd, uip.inbuf, inbufptr) != inbufptr) {
+      err(1, "serial_to_tun: write");
+    }
+  }
+}
 
-  case SLIP_ESC:
-    if(fread(&c, 1, 1, inslip) != 1) {
-      clearerr(inslip);
-      /* Put ESC back and give up! */
-      ungetc(SLIP_ESC, inslip);
+/*
+ * Read from serial, when we have a packet write it to tun. No output
+ * buffering. The input is read in blocks and decoded in runs of bytes
+ * that need no unescaping.
+ */
+void
+serial_to_tun(int infd, int outfd)
+{
+  static int esc = 0;
+  unsigned char buf[4096];
+  unsigned char *p, *end, *run;
+  unsigned char c;
+  int ret;
+
+  ret = read(infd, buf, sizeof(buf));
+  if(ret == -1) {
+    if(errno == EAGAIN || errno == EINTR) {
       return;
     }
+    err(1, "serial_to_tun: read");
+  }
+  if(ret == 0) {
+#ifdef linux
+    errx(1, "serial_to_tun: read: end of file");
+#else
+    return;
+#endif
+  }
+  PROGRESS(".");
 
-    switch(c) {
-    case SLIP_ESC_END:
-      c = SLIP_END;
-      break;
-    case SLIP_ESC_ESC:
-      c = SLIP_ESC;
-      break;
-    case SLIP_ESC_XON:
-      c = XON;
-      break;
-    case SLIP_ESC_XOFF:
-      c = XOFF;
-      break;
-    }
-    /* FALLTHROUGH */
-  default:
-    uip.inbuf[inbufptr++] = c;
-
-    /* Echo lines as they are received for verbose=2,3,5+ */
-    /* Echo all printable characters for verbose==4 */
-    if((verbose==2) || (verbose==3) || (verbose>4)) {
-      if(c=='\n') {
-        if(is_sensible_string(uip.inbuf, inbufptr)) {
-          if (timestamp) stamptime();
-          fwrite(uip.inbuf, inbufptr, 1, stdout);
-          inbufptr=0;
-        }
-      }
-    } else if(verbose==4) {
-      if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
-	fwrite(&c, 1, 1, stdout);
-        if(c=='\n') if(timestamp) stamptime();
+  p = buf;
+  end = buf + ret;
+  while(p < end) {
+    if(esc) {
+      esc = 0;
+      c = *p++;
+      switch(c) {
+      case SLIP_ESC_END:
+        c = SLIP_END;
+        break;
+      case SLIP_ESC_ESC:
+        c = SLIP_ESC;
+        break;
+      case SLIP_ESC_XON:
+        c = XON;
+        break;
+      case SLIP_ESC_XOFF:
+        c = XOFF;
+        break;
       }
+      slip_input_byte(c);
+      continue;
     }
 
-    break;
-  }
+    run = p;
+    while(p < end && !slip_decode_special[*p]) {
+      p++;
+    }
+    if(p > run) {
+      slip_input_run(run, p - run);
+      continue;
+    }
 
-  goto read_more;
+    c = *p++;
+    if(c == SLIP_END) {
+      if(inbufptr > 0) {
+        slip_packet_input(outfd);
+        inbufptr = 0;
+      }
+    } else if(c == SLIP_ESC) {
+      esc = 1;
+    } else {
+      slip_input_byte(c);
+    }
+  }
 }
 
-unsigned char slip_buf[2000];
-int slip_end, slip_begin;
+/* Output ring buffer. Room for several encoded packets so that the
+   serial line is kept busy while the next ones are read from tun. */
+#ifndef SLIP_BUF_SIZE
+#define SLIP_BUF_SIZE 16384
+#endif
+/* The largest packet read from tun, with every byte escaped */
+#define SLIP_MAX_ENCODED (2 * 2000 + 1)
+
+unsigned char slip_buf[SLIP_BUF_SIZE];
+int slip_end, slip_begin, slip_len;
 
 void
 slip_send_char(int fd, unsigned char c)
 {
-  switch(c) {
-  case SLIP_END:
+  if(slip_escape[c]) {
     slip_send(fd, SLIP_ESC);
-    slip_send(fd, SLIP_ESC_END);
-    break;
-  case SLIP_ESC:
-    slip_send(fd, SLIP_ESC);
-    slip_send(fd, SLIP_ESC_ESC);
-    break;
-  case XON:
-    if(flowcontrol_xonxoff) {
-      slip_send(fd, SLIP_ESC);
-      slip_send(fd, SLIP_ESC_XON);
-    } else {
-      slip_send(fd, c);
-    }
-    break;
-  case XOFF:
-    if(flowcontrol_xonxoff) {
-      slip_send(fd, SLIP_ESC);
-      slip_send(fd, SLIP_ESC_XOFF);
-    } else {
-      slip_send(fd, c);
-    }
-    break;
-  default:
+    slip_send(fd, slip_escape[c]);
+  } else {
     slip_send(fd, c);
-    break;
   }
 }
 
 void
 slip_send(int fd, unsigned char c)
 {
-  if(slip_end >= sizeof(slip_buf)) {
+  if(slip_len >= sizeof(slip_buf)) {
     err(1, "slip_send overflow");
   }
   slip_buf[slip_end] = c;
-  slip_end++;
+  slip_end = (slip_end + 1) % sizeof(slip_buf);
+  slip_len++;
+}
+
+static void
+slip_send_block(const unsigned char *p, int len)
+{
+  int n;
+
+  if(slip_len + len > sizeof(slip_buf)) {
+    err(1, "slip_send overflow");
+  }
+  slip_len += len;
+  while(len > 0) {
+    n = sizeof(slip_buf) - slip_end;
+    if(n > len) {
+      n = len;
+    }
+    memcpy(slip_buf + slip_end, p, n);
+    slip_end = (slip_end + n) % sizeof(slip_buf);
+    p += n;
+    len -= n;
+  }
 }
 
 int
 slip_empty()
 {
-  return slip_end == 0;
+  return slip_len == 0;
+}
+
+/* Whether another packet from tun fits in the output buffer */
+int
+slip_has_room()
+{
+  return sizeof(slip_buf) - slip_len >= SLIP_MAX_ENCODED;
 }
 
 void
 slip_flushbuf(int fd)
 {
+  struct iovec iov[2];
   int n;
 
   if(slip_empty()) {
     return;
   }
 
-  n = write(fd, slip_buf + slip_begin, (slip_end - slip_begin));
+  /* Everything that is queued, in at most two pieces if it wraps */
+  iov[0].iov_base = slip_buf + slip_begin;
+  if(slip_begin + slip_len <= sizeof(slip_buf)) {
+    iov[0].iov_len = slip_len;
+    n = 1;
+  } else {
+    iov[0].iov_len = sizeof(slip_buf) - slip_begin;
+    iov[1].iov_base = slip_buf;
+    iov[1].iov_len = slip_len - iov[0].iov_len;
+    n = 2;
+  }
+  n = writev(fd, iov, n);
 
   if(n == -1 && errno != EAGAIN) {
     err(1, "slip_flushbuf write failed");
   } else if(n == -1) {
     PROGRESS("Q");		/* Outqueueis full! */
   } else {
-    slip_begin += n;
-    if(slip_begin == slip_end) {
+    slip_begin = (slip_begin + n) % sizeof(slip_buf);
+    slip_len -= n;
+    if(slip_len == 0) {
       slip_begin = slip_end = 0;
     }
   }
@@ -416,7 +549,7 @@ void
 write_to_serial(int outfd, void *inbuf, int len)
 {
   u_int8_t *p = inbuf;
-  int i;
+  int i, j;
 
   if(verbose>2) {
     if (timestamp) stamptime();
@@ -442,35 +575,13 @@ write_to_serial(int outfd, void *inbuf, int len)
    */
   /* slip_send(outfd, SLIP_END); */
 
-  for(i = 0; i < len; i++) {
-    switch(p[i]) {
-    case SLIP_END:
+  /* Copy the runs between bytes that need escaping in one go */
+  for(i = 0; i < len; i = j + 1) {
+    for(j = i; j < len && !slip_escape[p[j]]; j++);
+    slip_send_block(p + i, j - i);
+    if(j < len) {
       slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_END);
-      break;
-    case SLIP_ESC:
-      slip_send(outfd, SLIP_ESC);
-      slip_send(outfd, SLIP_ESC_ESC);
-      break;
-    case XON:
-      if(flowcontrol_xonxoff) {
-        slip_send(outfd, SLIP_ESC);
-        slip_send(outfd, SLIP_ESC_XON);
-      } else {
-        slip_send(outfd, p[i]);
-      }
-      break;
-    case XOFF:
-      if(flowcontrol_xonxoff) {
-        slip_send(outfd, SLIP_ESC);
-        slip_send(outfd, SLIP_ESC_XOFF);
-      } else {
-        slip_send(outfd, p[i]);
-      }
-      break;
-    default:
-      slip_send(outfd, p[i]);
-      break;
+      slip_send(outfd, slip_escape[p[j]]);
     }
   }
   slip_send(outfd, SLIP_END);
@@ -489,7 +600,12 @@ tun_to_serial(int infd, int outfd)
   } uip;
   int size;
 
-  if((size = read(infd, uip.inbuf, 2000)) == -1) err(1, "tun_to_serial: read");
+  if((size = read(infd, uip.inbuf, 2000)) == -1) {
+    if(errno == EAGAIN) {
+      return 0;
+    }
+    err(1, "tun_to_serial: read");
+  }
 
   write_to_serial(outfd, uip.inbuf, size);
   return size;
@@ -536,8 +652,21 @@ stty_telos(int fd)
   tty.c_cflag |= CLOCAL;
   if(tcsetattr(fd, TCSAFLUSH, &tty) == -1) err(1, "tcsetattr");
 
+#ifdef linux
+  {
+    /* Have USB-serial drivers pass on input right away instead of
+       after their latency timer. Not all drivers support it. */
+    struct serial_struct ss;
+    if(ioctl(fd, TIOCGSERIAL, &ss) == 0) {
+      ss.flags |= ASYNC_LOW_LATENCY;
+      ioctl(fd, TIOCSSERIAL, &ss);
+    }
+  }
+#endif
+
   i = TIOCM_DTR;
-  if(ioctl(fd, TIOCMBIS, &i) == -1) err(1, "ioctl");
+  /* A pty has no modem control lines. */
+  if(ioctl(fd, TIOCMBIS, &i) == -1 && errno != ENOTTY) err(1, "ioctl");
 #endif
 
   usleep(10*1000);		/* Wait for hardware 10ms. */
@@ -742,6 +871,142 @@ ifconf(const char *tundev, const char *ipaddr)
   ssystem("ifconfig %s\n", tundev);
 }
 
+/*
+ * Loopback measurement mode (-l). The serial device is replaced by a
+ * pty whose other end echoes everything back, so that the packets
+ * that are encoded come back through the decoder. No tun device is
+ * needed. Reports the throughput and round trip time of the SLIP path.
+ */
+#define LOOPBACK_PACKET_SIZE 1280
+#define LOOPBACK_WINDOW 8
+
+static int loopback_sent, loopback_received, loopback_errors;
+static long long loopback_start, loopback_min = -1, loopback_max;
+static long long loopback_total;
+
+static long long
+usecs(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+int
+loopback_open(void)
+{
+  struct termios tty;
+  unsigned char buf[4096];
+  int master, slave, n;
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master == -1 || grantpt(master) == -1 || unlockpt(master) == -1) {
+    err(1, "loopback: pty");
+  }
+  slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  if(slave == -1) err(1, "loopback: open %s", ptsname(master));
+  if(tcgetattr(slave, &tty) == -1) err(1, "tcgetattr");
+  cfmakeraw(&tty);
+  if(tcsetattr(slave, TCSANOW, &tty) == -1) err(1, "tcsetattr");
+
+  switch(fork()) {
+  case -1:
+    err(1, "loopback: fork");
+  case 0:
+    /* The other end: echo until tunslip6 goes away */
+    close(master);
+    while((n = read(slave, buf, sizeof(buf))) > 0) {
+      if(write(slave, buf, n) != n) {
+        break;
+      }
+    }
+    _exit(0);
+  }
+  close(slave);
+  if(fcntl(master, F_SETFL, O_NONBLOCK) == -1) err(1, "fcntl");
+  return master;
+}
+
+void
+loopback_report(void)
+{
+  double elapsed = (usecs() - loopback_start) / 1000000.0;
+
+  fprintf(stderr, "%d/%d packets of %d bytes in %.3f s: %.0f packets/s, "
+          "%.1f kbyte/s\n", loopback_received, loopback_count,
+          LOOPBACK_PACKET_SIZE, elapsed, loopback_received / elapsed,
+          loopback_received * (double)LOOPBACK_PACKET_SIZE / 1024 / elapsed);
+  if(loopback_received > 0) {
+    fprintf(stderr, "round trip min/avg/max %.3f/%.3f/%.3f ms, "
+            "%d packets in flight\n", loopback_min / 1000.0,
+            loopback_total / 1000.0 / loopback_received,
+            loopback_max / 1000.0, LOOPBACK_WINDOW);
+  }
+  if(loopback_errors > 0) {
+    fprintf(stderr, "%d corrupted packets\n", loopback_errors);
+  }
+}
+
+void
+loopback_send(void)
+{
+  unsigned char buf[LOOPBACK_PACKET_SIZE];
+  long long now;
+  int i;
+
+  while(loopback_sent < loopback_count &&
+        loopback_sent - loopback_received - loopback_errors < LOOPBACK_WINDOW &&
+        slip_has_room()) {
+    /* An IPv6 version byte, then every byte value including those
+       that need escaping */
+    buf[0] = 0x60;
+    for(i = 1; i < sizeof(buf); i++) {
+      buf[i] = i;
+    }
+    now = usecs();
+    memcpy(buf + 1, &loopback_sent, sizeof(loopback_sent));
+    memcpy(buf + 1 + sizeof(loopback_sent), &now, sizeof(now));
+    write_to_serial(slipfd, buf, sizeof(buf));
+    loopback_sent++;
+  }
+}
+
+void
+loopback_input(const unsigned char *buf, int len)
+{
+  long long sent, rtt;
+  int seq, i;
+
+  if(len != LOOPBACK_PACKET_SIZE) {
+    loopback_errors++;
+  } else {
+    memcpy(&seq, buf + 1, sizeof(seq));
+    memcpy(&sent, buf + 1 + sizeof(seq), sizeof(sent));
+    for(i = 1 + sizeof(seq) + sizeof(sent); i < len; i++) {
+      if(buf[i] != (unsigned char)i) {
+        break;
+      }
+    }
+    if(i < len || seq != loopback_received + loopback_errors) {
+      loopback_errors++;
+    } else {
+      loopback_received++;
+      rtt = usecs() - sent;
+      loopback_total += rtt;
+      if(loopback_min < 0 || rtt < loopback_min) {
+        loopback_min = rtt;
+      }
+      if(rtt > loopback_max) {
+        loopback_max = rtt;
+      }
+    }
+  }
+  if(loopback_received + loopback_errors >= loopback_count) {
+    loopback_report();
+    exit(loopback_errors > 0);
+  }
+}
+
 int
 main(int argc, char **argv)
 {
@@ -749,7 +1014,7 @@ main(int argc, char **argv)
   int tunfd, maxfd;
   int ret;
   fd_set rset, wset;
-  FILE *inslip;
+  struct timeval tv;
   const char *siodev = NULL;
   const char *host = NULL;
   const char *port = NULL;
@@ -762,7 +1027,7 @@ main(int argc, char **argv)
   prog = argv[0];
   setvbuf(stdout, NULL, _IOLBF, 0); /* Line buffered output. */
 
-  while((c = getopt(argc, argv, "B:HILPhXM:s:t:v::d::a:p:T")) != -1) {
+  while((c = getopt(argc, argv, "B:HILPhXM:s:t:v::d::a:p:Tl::")) != -1) {
     switch(c) {
     case 'B':
       baudrate = atoi(optarg);
@@ -833,6 +1098,11 @@ main(int argc, char **argv)
       tap = 1;
       break;
 
+    case 'l':
+      loopback_count = 10000;
+      if (optarg) loopback_count = atoi(optarg);
+      break;
+
     case '?':
     case 'h':
     default:
@@ -865,6 +1135,9 @@ fprintf(stderr,"                Actual delay is basedelay*(#6LowPAN fragments) m
 fprintf(stderr,"                -d is equivalent to -d10.\n");
 fprintf(stderr," -a serveraddr  \n");
 fprintf(stderr," -p serverport  \n");
+fprintf(stderr," -l[count]      Measure throughput and latency over a pty loopback\n");
+fprintf(stderr,"                instead of using a serial device and tun interface.\n");
+fprintf(stderr,"                Sends count packets, -l is equivalent to -l10000.\n");
 exit(1);
       break;
     }
@@ -872,10 +1145,11 @@ exit(1);
   argc -= (optind - 1);
   argv += (optind - 1);
 
-  if(argc != 2 && argc != 3) {
+  if((argc != 2 && argc != 3) && !(loopback_count > 0 && argc == 1)) {
     err(1, "usage: %s [-B baudrate] [-H] [-L] [-s siodev] [-t tundev] [-T] [-v verbosity] [-d delay] [-a serveraddress] [-p serverport] ipaddress", prog);
   }
-  ipaddr = argv[1];
+  ipaddr = argc > 1 ? argv[1] : "";
+  slip_init_tables();
 
   if(baudrate != -2) { /* -2: use default baudrate */
     b_rate = select_baudrate(baudrate);
@@ -884,7 +1158,10 @@ exit(1);
     }
   }
 
-  if(host != NULL) {
+  if(loopback_count > 0) {
+    slipfd = loopback_open();
+    fprintf(stderr, "********SLIP loopback on ``%s''\n", ptsname(slipfd));
+  } else if(host != NULL) {
     struct addrinfo hints, *servinfo, *p;
     int rv;
     char s[INET6_ADDRSTRLEN];
@@ -957,21 +1234,26 @@ exit(1);
     stty_telos(slipfd);
   }
   slip_send(slipfd, SLIP_END);
-  inslip = fdopen(slipfd, "r");
-  if(inslip == NULL) err(1, "main: fdopen");
 
-  tunfd = tun_alloc(tundev, tap);
-  if(tunfd == -1) err(1, "main: open /dev/tun");
-  if (timestamp) stamptime();
-  fprintf(stderr, "opened %s device ``/dev/%s''\n",
-          tap ? "tap" : "tun", tundev);
-
-  atexit(cleanup);
-  signal(SIGHUP, sigcleanup);
-  signal(SIGTERM, sigcleanup);
-  signal(SIGINT, sigcleanup);
-  signal(SIGALRM, sigalarm);
-  ifconf(tundev, ipaddr);
+  if(loopback_count > 0) {
+    tunfd = -1;
+    loopback_start = usecs();
+  } else {
+    tunfd = tun_alloc(tundev, tap);
+    if(tunfd == -1) err(1, "main: open /dev/tun");
+    /* So that all packets that tun has queued can be read in one go */
+    if(fcntl(tunfd, F_SETFL, O_NONBLOCK) == -1) err(1, "main: fcntl");
+    if (timestamp) stamptime();
+    fprintf(stderr, "opened %s device ``/dev/%s''\n",
+            tap ? "tap" : "tun", tundev);
+
+    atexit(cleanup);
+    signal(SIGHUP, sigcleanup);
+    signal(SIGTERM, sigcleanup);
+    signal(SIGINT, sigcleanup);
+    signal(SIGALRM, sigalarm);
+    ifconf(tundev, ipaddr);
+  }
 
   while(1) {
     maxfd = 0;
@@ -988,6 +1270,10 @@ exit(1);
       got_sigalarm = 0;
     }
 
+    if(loopback_count > 0) {
+      loopback_send();
+    }
+
     if(!slip_empty()) {		/* Anything to flush? */
       FD_SET(slipfd, &wset);
     }
@@ -995,18 +1281,26 @@ exit(1);
     FD_SET(slipfd, &rset);	/* Read from slip ASAP! */
     if(slipfd > maxfd) maxfd = slipfd;
 
-    /* We only have one packet at a time queued for slip output. */
-    if(slip_empty()) {
+    /* Queue packets for slip output while there is room, or only one
+       at a time with a delay between them. */
+    if(tunfd != -1 && (basedelay ? slip_empty() : slip_has_room())) {
       FD_SET(tunfd, &rset);
       if(tunfd > maxfd) maxfd = tunfd;
     }
 
-    ret = select(maxfd + 1, &rset, &wset, NULL, NULL);
+    /* In loopback mode, give up when nothing comes back */
+    tv.tv_sec = 1;
+    tv.tv_usec = 0;
+    ret = select(maxfd + 1, &rset, &wset, NULL,
+                 loopback_count > 0 ? &tv : NULL);
     if(ret == -1 && errno != EINTR) {
       err(1, "select");
+    } else if(ret == 0 && loopback_count > 0) {
+      loopback_report();
+      errx(1, "loopback: timeout");
     } else if(ret > 0) {
       if(FD_ISSET(slipfd, &rset)) {
-        serial_to_tun(inslip, tunfd);
+        serial_to_tun(slipfd, tunfd);
       }
 
       if(FD_ISSET(slipfd, &wset)) {
@@ -1026,8 +1320,11 @@ exit(1);
       }
       if(delaymsec==0) {
         int size;
-        if(slip_empty() && FD_ISSET(tunfd, &rset)) {
-          size=tun_to_serial(tunfd, slipfd);
+        if(tunfd != -1 && FD_ISSET(tunfd, &rset) &&
+           (basedelay ? slip_empty() : slip_has_room())) {
+          do {
+            size=tun_to_serial(tunfd, slipfd);
+          } while(size > 0 && !basedelay && slip_has_room());
           slip_flushbuf(slipfd);
           if(ipa_enable) sigalarm_reset();
           if(basedelay) {